@@ -13,11 +13,10 @@
 
 #include "SteerLib.h"
 #include "Logger.h"
+#include "obstacles/GJK_EPA.h"
 
+class CollisionAgent;
 
-// globally accessible to the CollisionAI plugin
-extern SteerLib::EngineInterface * gEngine;
-extern SteerLib::GridDatabase2D * gSpatialDatabase;
 
 namespace CollisionAIGlobals {
 
@@ -34,17 +33,35 @@ namespace CollisionAIGlobals {
 	};
 
 
-	extern unsigned int gLongTermPlanningPhaseInterval;
-	extern unsigned int gMidTermPlanningPhaseInterval;
-	extern unsigned int gShortTermPlanningPhaseInterval;
-	extern unsigned int gPredictivePhaseInterval;
-	extern unsigned int gReactivePhaseInterval;
-	extern unsigned int gPerceptivePhaseInterval;
-	extern bool gUseDynamicPhaseScheduling;
-	extern bool gShowStats;
-	extern bool gShowAllStats;
+	/**
+	 * @brief Options and performance profilers of one CollisionAIModule instance.
+	 *
+	 * Each SimulationEngine creates its own instance of the module, so engines running in
+	 * different threads never share a context.  Agents are given the context of the module that created them.
+	 */
+	struct CollisionAIContext {
+		unsigned int longTermPlanningPhaseInterval;
+		unsigned int midTermPlanningPhaseInterval;
+		unsigned int shortTermPlanningPhaseInterval;
+		unsigned int predictivePhaseInterval;
+		unsigned int reactivePhaseInterval;
+		unsigned int perceptivePhaseInterval;
+		bool useDynamicPhaseScheduling;
+		bool showStats;
+		bool showAllStats;
+
+		PhaseProfilers phaseProfilers;
+	};
+
 
-	extern PhaseProfilers * gPhaseProfilers;
+	/// Two obstacles that overlap, found by CollisionAIModule::preprocessSimulation().
+	struct ObstacleCollision {
+		/// The indices of the obstacles, in the order of EngineInterface::getObstacles(); first < second.
+		unsigned int first;
+		unsigned int second;
+		float penetrationDepth;
+		Util::Vector penetrationVector;
+	};
 }
 
 
@@ -81,11 +98,46 @@ public:
 
 	void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
 	void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+	bool usesPreprocessFrame() { return false; }
+	bool usesPostprocessFrame() { return false; }
 	void preprocessSimulation();
 	void initializeSimulation();
 	void cleanupSimulation();
 
 protected:
+	/// One range of candidate pairs, tested by one task of the narrow phase.
+	struct NarrowPhaseTask {
+		CollisionAIModule * module;
+		unsigned int firstPair;
+		unsigned int lastPair;
+		std::vector<CollisionAIGlobals::ObstacleCollision> collisions;
+	};
+
+	/**
+	 * @brief The broad phase: finds the pairs of obstacles whose bounding boxes overlap, with sweep and prune along x.
+	 *
+	 * Obstacles without convex pieces (boxes and circles, which return no vertices) are left out, since GJK_EPA cannot test them.
+	 * The pairs are sorted, so the collisions are reported in the same order as testing every pair would.
+	 */
+	void _findCandidatePairs();
+	/// Task function that runs GJK_EPA::intersect() on the candidate pairs of one NarrowPhaseTask.
+	static void _runNarrowPhaseTask(unsigned int threadIndex, void * data);
+
+	SteerLib::EngineInterface * _engine;
+	CollisionAIGlobals::CollisionAIContext _context;
+	/// The worker threads of the narrow phase, or NULL if it runs on the calling thread.
+	Util::ThreadedTaskManager * _threadPool;
+	unsigned int _numThreads;
+	/// The convex decomposition of each obstacle, in the order of EngineInterface::getObstacles(); either the one a PolygonObstacle keeps, or one in _decomposedShapes.
+	std::vector<const SteerLib::ConvexDecomposition*> _obstacleShapes;
+	std::vector<SteerLib::ConvexDecomposition> _decomposedShapes;
+	/// Pairs of obstacle indices whose bounds overlap, sorted.
+	std::vector< std::pair<unsigned int, unsigned int> > _candidatePairs;
+	std::vector<NarrowPhaseTask> _narrowPhaseTasks;
+	/// The obstacles that overlap, sorted by first and then second.
+	std::vector<CollisionAIGlobals::ObstacleCollision> _obstacleCollisions;
+	/// The agents of this module, recycled across simulations.
+	Util::ObjectPool<CollisionAgent> _agentPool;
 	std::string logFilename; // = "AI.log";
 	bool logStats; // = false;
 	Logger * _logger;
@@ -67,6 +67,9 @@ protected:
 	void _doEulerStep(const Util::Vector & steeringDecisionForce, float dt);
 
 	bool _enabled;
+	/// The engine and spatial database that this agent was given in reset().
+	SteerLib::EngineInterface * _engine;
+	SteerLib::GridDatabase2D * _spatialDatabase;
 	Util::Point __position;
 	Util::Vector _velocity;
 	Util::Vector _forward; // normalized version of velocity
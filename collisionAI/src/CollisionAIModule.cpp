@@ -8,6 +8,7 @@
 /// @brief Implements the CollisionAIModule plugin.
 
 
+#include <algorithm>
 #include "SteerLib.h"
 #include "SimulationPlugin.h"
 #include "CollisionAIModule.h"
@@ -16,28 +17,9 @@
 #include "LogObject.h"
 #include "LogManager.h"
 
-#include "obstacles/GJK_EPA.h"
+#include "obstacles/PolygonObstacle.h"
 
 
-// globally accessible to the CollisionAI plugin
-SteerLib::EngineInterface*  gEngine;
-SteerLib::GridDatabase2D*   gSpatialDatabase;
-
-namespace CollisionAIGlobals
-{
-	unsigned int gLongTermPlanningPhaseInterval;
-	unsigned int gMidTermPlanningPhaseInterval;
-	unsigned int gShortTermPlanningPhaseInterval;
-	unsigned int gPredictivePhaseInterval;
-	unsigned int gReactivePhaseInterval;
-	unsigned int gPerceptivePhaseInterval;
-	bool gUseDynamicPhaseScheduling;
-	bool gShowStats;
-	bool gShowAllStats;
-
-	PhaseProfilers * gPhaseProfilers;
-}
-
 using namespace CollisionAIGlobals;
 
 PLUGIN_API SteerLib::ModuleInterface * createModule()
@@ -53,13 +35,20 @@ PLUGIN_API void destroyModule( SteerLib::ModuleInterface*  module )
 
 void CollisionAIModule::init( const SteerLib::OptionDictionary & options, SteerLib::EngineInterface * engineInfo )
 {
-	gEngine = engineInfo;
-	gSpatialDatabase = engineInfo->getSpatialDatabase();
-
-	gUseDynamicPhaseScheduling = false;
-	gShowStats = false;
+	_engine = engineInfo;
+
+	_context.longTermPlanningPhaseInterval = 0;
+	_context.midTermPlanningPhaseInterval = 0;
+	_context.shortTermPlanningPhaseInterval = 0;
+	_context.predictivePhaseInterval = 0;
+	_context.reactivePhaseInterval = 0;
+	_context.perceptivePhaseInterval = 0;
+	_context.useDynamicPhaseScheduling = false;
+	_context.showStats = false;
 	logStats = false;
-	gShowAllStats = false;
+	_context.showAllStats = false;
+	_threadPool = NULL;
+	_numThreads = 1;
     logFilename = "CollisionAI.log";
 
 	SteerLib::OptionDictionary::const_iterator optionIter;
@@ -67,7 +56,7 @@ void CollisionAIModule::init( const SteerLib::OptionDictionary & options, SteerL
 		std::stringstream value((*optionIter).second);
 		if ((*optionIter).first == "")
 		{
-			value >> gLongTermPlanningPhaseInterval;
+			value >> _context.longTermPlanningPhaseInterval;
 		}
 		else if ((*optionIter).first == "ailogFileName")
 		{
@@ -76,11 +65,15 @@ void CollisionAIModule::init( const SteerLib::OptionDictionary & options, SteerL
 		}
 		else if ((*optionIter).first == "stats")
 		{
-			gShowStats = Util::getBoolFromString(value.str());
+			_context.showStats = Util::getBoolFromString(value.str());
 		}
 		else if ((*optionIter).first == "allstats")
 		{
-			gShowAllStats = Util::getBoolFromString(value.str());
+			_context.showAllStats = Util::getBoolFromString(value.str());
+		}
+		else if ((*optionIter).first == "threads")
+		{
+			value >> _numThreads;
 		}
 		else
 		{
@@ -88,6 +81,13 @@ void CollisionAIModule::init( const SteerLib::OptionDictionary & options, SteerL
 		}
 	}
 
+	if (_numThreads == 0) {
+		throw Util::GenericException("Collision AI module: the number of threads must be at least 1.");
+	}
+	if (_numThreads > 1) {
+		_threadPool = new Util::ThreadedTaskManager(_numThreads);
+	}
+
 	if( logStats )
 	{
 
@@ -120,47 +120,140 @@ void CollisionAIModule::initializeSimulation()
 	//
 	// initialize the performance profilers
 	//
-	gPhaseProfilers = new PhaseProfilers;
-	gPhaseProfilers->aiProfiler.reset();
-	gPhaseProfilers->longTermPhaseProfiler.reset();
-	gPhaseProfilers->midTermPhaseProfiler.reset();
-	gPhaseProfilers->shortTermPhaseProfiler.reset();
-	gPhaseProfilers->perceptivePhaseProfiler.reset();
-	gPhaseProfilers->predictivePhaseProfiler.reset();
-	gPhaseProfilers->reactivePhaseProfiler.reset();
-	gPhaseProfilers->steeringPhaseProfiler.reset();
+	_context.phaseProfilers.aiProfiler.reset();
+	_context.phaseProfilers.longTermPhaseProfiler.reset();
+	_context.phaseProfilers.midTermPhaseProfiler.reset();
+	_context.phaseProfilers.shortTermPhaseProfiler.reset();
+	_context.phaseProfilers.perceptivePhaseProfiler.reset();
+	_context.phaseProfilers.predictivePhaseProfiler.reset();
+	_context.phaseProfilers.reactivePhaseProfiler.reset();
+	_context.phaseProfilers.steeringPhaseProfiler.reset();
 
 }
 
 void CollisionAIModule::preprocessSimulation()
 {
-    std::set<SteerLib::ObstacleInterface*> _obstacles = gEngine->getObstacles();
-
-    std::vector<std::vector<Util::Vector>> polyVects;
-    std::vector<Util::Vector> vects;
-
-    std::set<SteerLib::ObstacleInterface*>::iterator obstacleIter;
-
-    for ( obstacleIter = _obstacles.begin(); obstacleIter != _obstacles.end(); ++obstacleIter )
-    {
-        (*obstacleIter)->returnVertices( vects );
-
-         polyVects.push_back( vects );
-         vects.clear();
-    }
-
-    for ( size_t i = 0; i < polyVects.size(); ++i )
-    {
-        for ( size_t j = i + 1; j < polyVects.size(); ++j )
-        {
-            Util::Vector penetration_vector;
-			float penetration_depth;
-            if ( SteerLib::GJK_EPA::intersect( penetration_depth, penetration_vector, polyVects[i], polyVects[j] ) )
-                std::cerr<<" Collision detected between polygon No."<<i<<" and No."<<j<< " with a penetration depth of "<< penetration_depth << " and penetration vector of "<<penetration_vector<<std::endl;
-            else
-                std::cerr<<" NO collision detected between polygon No."<<i<<" and No."<<j<<std::endl;
-        }
-    }
+	const std::set<SteerLib::ObstacleInterface*> & obstacles = _engine->getObstacles();
+	_obstacleShapes.assign(obstacles.size(), NULL);
+	_decomposedShapes.assign(obstacles.size(), SteerLib::ConvexDecomposition());
+
+	// polygon obstacles keep their own decomposition; any other obstacle with vertices is decomposed here, once.
+	std::vector<Util::Vector> vertices;
+	unsigned int index = 0;
+	for (std::set<SteerLib::ObstacleInterface*>::const_iterator obstacleIter = obstacles.begin(); obstacleIter != obstacles.end(); ++obstacleIter, ++index)
+	{
+		PolygonObstacle * polygon = dynamic_cast<PolygonObstacle*>(*obstacleIter);
+		if (polygon != NULL)
+		{
+			_obstacleShapes[index] = &polygon->getConvexDecomposition();
+			continue;
+		}
+		vertices.clear();
+		(*obstacleIter)->returnVertices( vertices );
+		SteerLib::GJK_EPA::decompose( vertices, _decomposedShapes[index] );
+		_obstacleShapes[index] = &_decomposedShapes[index];
+	}
+
+	_findCandidatePairs();
+
+	// the narrow phase: contiguous ranges of candidate pairs, one per thread, each collecting its own collisions.
+	_obstacleCollisions.clear();
+	unsigned int numTasks = std::min((_threadPool != NULL) ? _numThreads : 1u, (unsigned int)_candidatePairs.size());
+	_narrowPhaseTasks.resize(numTasks);
+	for (unsigned int t = 0; t < numTasks; t++)
+	{
+		_narrowPhaseTasks[t].module = this;
+		_narrowPhaseTasks[t].firstPair = (unsigned int)((t * _candidatePairs.size()) / numTasks);
+		_narrowPhaseTasks[t].lastPair = (unsigned int)(((t+1) * _candidatePairs.size()) / numTasks);
+		_narrowPhaseTasks[t].collisions.clear();
+	}
+
+	if ((_threadPool != NULL) && (numTasks > 1))
+	{
+		for (unsigned int t = 0; t < numTasks; t++)
+		{
+			Util::Task task;
+			task.function = CollisionAIModule::_runNarrowPhaseTask;
+			task.data = &_narrowPhaseTasks[t];
+			_threadPool->addTask(task, (t == numTasks-1));
+		}
+		_threadPool->waitForAllTasksToComplete();
+	}
+	else if (numTasks == 1)
+	{
+		_runNarrowPhaseTask(0, &_narrowPhaseTasks[0]);
+	}
+
+	// the tasks cover the sorted pairs in order, so their collisions are sorted too.
+	for (unsigned int t = 0; t < numTasks; t++)
+	{
+		_obstacleCollisions.insert(_obstacleCollisions.end(), _narrowPhaseTasks[t].collisions.begin(), _narrowPhaseTasks[t].collisions.end());
+	}
+
+	// the result stays in _obstacleCollisions; large scenes have too many colliding pairs to print each one by default.
+	if (_context.showStats || _context.showAllStats)
+	{
+		std::cout << " " << _obstacleCollisions.size() << " colliding pairs among " << obstacles.size() << " obstacles, "
+			<< _candidatePairs.size() << " pairs tested with GJK/EPA." << std::endl;
+	}
+
+	if (_context.showAllStats)
+	{
+		for (size_t i = 0; i < _obstacleCollisions.size(); ++i)
+		{
+			const ObstacleCollision & collision = _obstacleCollisions[i];
+			std::cout << " Collision detected between polygon No." << collision.first << " and No." << collision.second << " with a penetration depth of " << collision.penetrationDepth << " and penetration vector of " << collision.penetrationVector << std::endl;
+		}
+	}
+}
+
+
+void CollisionAIModule::_findCandidatePairs()
+{
+	std::vector< std::pair<float, unsigned int> > sortedByXMin;
+	for (unsigned int i = 0; i < _obstacleShapes.size(); ++i)
+	{
+		if (_obstacleShapes[i]->getNumPieces() > 0)
+		{
+			sortedByXMin.push_back(std::make_pair(_obstacleShapes[i]->getBounds().xmin, i));
+		}
+	}
+	std::sort(sortedByXMin.begin(), sortedByXMin.end());
+
+	// touching bounds count as overlapping, so that GJK_EPA decides about shapes that only touch.
+	_candidatePairs.clear();
+	for (size_t a = 0; a < sortedByXMin.size(); ++a)
+	{
+		const Util::AxisAlignedBox & boundsA = _obstacleShapes[sortedByXMin[a].second]->getBounds();
+		for (size_t b = a + 1; (b < sortedByXMin.size()) && (sortedByXMin[b].first <= boundsA.xmax); ++b)
+		{
+			const Util::AxisAlignedBox & boundsB = _obstacleShapes[sortedByXMin[b].second]->getBounds();
+			if ((boundsB.zmin <= boundsA.zmax) && (boundsA.zmin <= boundsB.zmax))
+			{
+				unsigned int first = std::min(sortedByXMin[a].second, sortedByXMin[b].second);
+				unsigned int second = std::max(sortedByXMin[a].second, sortedByXMin[b].second);
+				_candidatePairs.push_back(std::make_pair(first, second));
+			}
+		}
+	}
+	std::sort(_candidatePairs.begin(), _candidatePairs.end());
+}
+
+
+void CollisionAIModule::_runNarrowPhaseTask(unsigned int threadIndex, void * data)
+{
+	NarrowPhaseTask * task = (NarrowPhaseTask *)data;
+	CollisionAIModule * module = task->module;
+	for (unsigned int p = task->firstPair; p < task->lastPair; ++p)
+	{
+		ObstacleCollision collision;
+		collision.first = module->_candidatePairs[p].first;
+		collision.second = module->_candidatePairs[p].second;
+		if ( SteerLib::GJK_EPA::intersect( collision.penetrationDepth, collision.penetrationVector, *module->_obstacleShapes[collision.first], *module->_obstacleShapes[collision.second] ) )
+		{
+			task->collisions.push_back(collision);
+		}
+	}
 }
 
 void CollisionAIModule::preprocessFrame(float timeStamp, float dt, unsigned int frameNumber)
@@ -180,27 +273,27 @@ void CollisionAIModule::cleanupSimulation()
 	{
 		LogObject logObject;
 
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getNumTimesExecuted());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTicksAccumulated());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMinTicks());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMaxTicks());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMinExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMaxExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getAverageExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTime());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTickFrequency());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getNumTimesExecuted());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTicksAccumulated());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMinTicks());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxTicks());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMinExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getAverageExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTime());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTickFrequency());
 
 		_logger->writeLogObject(logObject);
 
 		// cleanup profileing metrics for next simulation/scenario
-		gPhaseProfilers->aiProfiler.reset();
-		gPhaseProfilers->longTermPhaseProfiler.reset();
-		gPhaseProfilers->midTermPhaseProfiler.reset();
-		gPhaseProfilers->shortTermPhaseProfiler.reset();
-		gPhaseProfilers->perceptivePhaseProfiler.reset();
-		gPhaseProfilers->predictivePhaseProfiler.reset();
-		gPhaseProfilers->reactivePhaseProfiler.reset();
-		gPhaseProfilers->steeringPhaseProfiler.reset();
+		_context.phaseProfilers.aiProfiler.reset();
+		_context.phaseProfilers.longTermPhaseProfiler.reset();
+		_context.phaseProfilers.midTermPhaseProfiler.reset();
+		_context.phaseProfilers.shortTermPhaseProfiler.reset();
+		_context.phaseProfilers.perceptivePhaseProfiler.reset();
+		_context.phaseProfilers.predictivePhaseProfiler.reset();
+		_context.phaseProfilers.reactivePhaseProfiler.reset();
+		_context.phaseProfilers.steeringPhaseProfiler.reset();
 	}
 
 	// kdTree_->deleteObstacleTree(kdTree_->obstacleTree_);
@@ -208,15 +301,18 @@ void CollisionAIModule::cleanupSimulation()
 
 void CollisionAIModule::finish()
 {
-	// nothing to do here
+	if (_threadPool != NULL) {
+		delete _threadPool;
+		_threadPool = NULL;
+	}
 }
 
 SteerLib::AgentInterface * CollisionAIModule::createAgent()
 {
-    return new CollisionAgent;
+    return _agentPool.create();
 }
 
 void CollisionAIModule::destroyAgent( SteerLib::AgentInterface * agent )
 {
-	delete agent;
+	_agentPool.destroy(dynamic_cast<CollisionAgent*>(agent));
 }
@@ -19,25 +19,30 @@
 CollisionAgent::CollisionAgent()
 {
 	_enabled = false;
+	_engine = NULL;
+	_spatialDatabase = NULL;
 }
 
 CollisionAgent::~CollisionAgent()
 {
 	if (_enabled) {
 		Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-		gSpatialDatabase->removeObject( this, bounds);
+		_spatialDatabase->removeObject( this, bounds);
 	}
 }
 
 void CollisionAgent::disable()
 {
 	Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-	gSpatialDatabase->removeObject( this, bounds);
+	_spatialDatabase->removeObject( this, bounds);
 	_enabled = false;
 }
 
 void CollisionAgent::reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo)
 {
+	_engine = engineInfo;
+	_spatialDatabase = engineInfo->getSpatialDatabase();
+
     // nothing to do here
 }
 
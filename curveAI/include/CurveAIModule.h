@@ -13,11 +13,9 @@
 #include "SteerLib.h"
 #include "Logger.h"
 
+class CurveAgent;
 
 
-// globally accessible to the curveAI plugin
-extern SteerLib::EngineInterface * gEngine;
-extern SteerLib::GridDatabase2D * gSpatialDatabase;
 
 namespace CurveAIGlobals {
 
@@ -34,17 +32,25 @@ namespace CurveAIGlobals {
 	};
 
 
-	extern unsigned int gLongTermPlanningPhaseInterval;
-	extern unsigned int gMidTermPlanningPhaseInterval;
-	extern unsigned int gShortTermPlanningPhaseInterval;
-	extern unsigned int gPredictivePhaseInterval;
-	extern unsigned int gReactivePhaseInterval;
-	extern unsigned int gPerceptivePhaseInterval;
-	extern bool gUseDynamicPhaseScheduling;
-	extern bool gShowStats;
-	extern bool gShowAllStats;
-
-	extern PhaseProfilers * gPhaseProfilers;
+	/**
+	 * @brief Options and performance profilers of one CurveAIModule instance.
+	 *
+	 * Each SimulationEngine creates its own instance of the module, so engines running in
+	 * different threads never share a context.  Agents are given the context of the module that created them.
+	 */
+	struct CurveAIContext {
+		unsigned int longTermPlanningPhaseInterval;
+		unsigned int midTermPlanningPhaseInterval;
+		unsigned int shortTermPlanningPhaseInterval;
+		unsigned int predictivePhaseInterval;
+		unsigned int reactivePhaseInterval;
+		unsigned int perceptivePhaseInterval;
+		bool useDynamicPhaseScheduling;
+		bool showStats;
+		bool showAllStats;
+
+		PhaseProfilers phaseProfilers;
+	};
 }
 
 
@@ -81,11 +87,17 @@ public:
 
 	void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
 	void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+	bool usesPreprocessFrame() { return false; }
+	bool usesPostprocessFrame() { return false; }
 	void preprocessSimulation();
 	void initializeSimulation();
 	void cleanupSimulation();
 
 protected:
+	SteerLib::EngineInterface * _engine;
+	CurveAIGlobals::CurveAIContext _context;
+	/// The agents of this module, recycled across simulations.
+	Util::ObjectPool<CurveAgent> _agentPool;
 	std::string logFilename; // = "AI.log";
 	bool logStats; // = false;
 	Logger * _logger;
@@ -18,7 +18,7 @@
 class CurveAgent : public SteerLib::AgentInterface
 {
 public:
-	CurveAgent();
+	CurveAgent(CurveAIGlobals::CurveAIContext * context);
 	~CurveAgent();
 	void reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo);
 	void updateAI(float timeStamp, float dt, unsigned int frameNumber);
@@ -55,6 +55,11 @@ protected:
 	/// Updates position, velocity, and orientation of the agent, given the force and dt time step.
 	void _doEulerStep(const Util::Vector & steeringDecisionForce, float dt);
 	bool _enabled;
+	/// The context of the module that created this agent.
+	CurveAIGlobals::CurveAIContext * _context;
+	/// The engine and spatial database that this agent was given in reset().
+	SteerLib::EngineInterface * _engine;
+	SteerLib::GridDatabase2D * _spatialDatabase;
 	Util::Point __startPosition;
 	Util::Point __position;
 	Util::Vector _velocity;
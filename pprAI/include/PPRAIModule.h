@@ -33,62 +33,34 @@ namespace PPRGlobals {
 	};
 
 
-	extern SteerLib::EngineInterface * gEngine;
-	extern SteerLib::GridDatabase2D * gSpatialDatabase;
-	extern unsigned int gLongTermPlanningPhaseInterval;
-	extern unsigned int gMidTermPlanningPhaseInterval;
-	extern unsigned int gShortTermPlanningPhaseInterval;
-	extern unsigned int gPredictivePhaseInterval;
-	extern unsigned int gReactivePhaseInterval;
-	extern unsigned int gPerceptivePhaseInterval;
-	extern bool gUseDynamicPhaseScheduling;
-	extern bool gShowStats;
-	extern bool gShowAllStats;
-
-
-	// Adding a bunch of parameters so they can be changed via input
-	extern float ped_max_speed;
-	extern float ped_typical_speed ;
-	extern float ped_max_force  ;
-	extern float ped_max_speed_factor  ;
-	extern float ped_faster_speed_factor ;
-	extern float ped_slightly_faster_speed_factor;
-	extern float ped_typical_speed_factor   ;
-	extern float ped_slightly_slower_speed_factor;
-	extern float ped_slower_speed_factor;
-	extern float ped_cornering_turn_rate;
-	extern float ped_adjustment_turn_rate;
-	extern float ped_faster_avoidance_turn_rate;
-	extern float ped_typical_avoidance_turn_rate;
-	extern float ped_braking_rate ;
-	extern float ped_comfort_zone   ;
-	extern float ped_query_radius  ;
-	extern float ped_similar_direction_dot_product_threshold;
-	extern float ped_same_direction_dot_product_threshold;
-	extern float ped_oncoming_prediction_threshold;
-	extern float ped_oncoming_reaction_threshold;
-	extern float ped_wrong_direction_dot_product_threshold;
-	extern float ped_threat_distance_threshold;
-	extern float ped_threat_min_time_threshold;
-	extern float ped_threat_max_time_threshold;
-	extern float ped_predictive_anticipation_factor ;
-	extern float ped_reactive_anticipation_factor;
-	extern float ped_crowd_influence_factor;
-	extern float ped_facing_static_object_threshold;
-	extern float ped_ordinary_steering_strength;
-	extern float ped_oncoming_threat_avoidance_strength;
-	extern float ped_cross_threat_avoidance_strength;
-	extern float ped_max_turning_rate;
-	extern int ped_feeling_crowded_threshold;
-	extern float ped_scoot_rate ;
-	extern float ped_reached_target_distance_threshold ;
-	extern float ped_dynamic_collision_padding;
-	extern int ped_furthest_local_target_distance;
-	extern int ped_next_waypoint_distance;
-	extern int ped_max_num_waypoints;
-
-
-	extern PhaseProfilers * gPhaseProfilers;
+	/**
+	 * @brief Options, default agent parameters and performance profilers of one PPRAIModule instance.
+	 *
+	 * Each SimulationEngine creates its own instance of the module, so engines running in
+	 * different threads never share a context.  Agents are given the context of the module that created them.
+	 */
+	struct PPRAIContext {
+		unsigned int longTermPlanningPhaseInterval;
+		unsigned int midTermPlanningPhaseInterval;
+		unsigned int shortTermPlanningPhaseInterval;
+		unsigned int predictivePhaseInterval;
+		unsigned int reactivePhaseInterval;
+		unsigned int perceptivePhaseInterval;
+
+		bool useDynamicPhaseScheduling;
+		/// The snapshot of the "batch" mode, or NULL if each agent queries the spatial database in its perceptive phase.
+		PPRPerception * perception;
+		/// The worker threads of the parallel mode, or NULL if each agent runs its phases in updateAI().
+		Util::ThreadedTaskManager * phaseThreadPool;
+		bool showStats;
+		bool logStats;
+		bool showAllStats;
+
+		/// The parameters new agents start with, set from the module options.
+		PPRParameters parameters;
+
+		PhaseProfilers phaseProfilers;
+	};
 }
 
 class PPRAIModule : public SteerLib::ModuleInterface
@@ -105,12 +77,84 @@ public:
 	void init( const SteerLib::OptionDictionary & options, SteerLib::EngineInterface * engineInfo );
 	void finish();
 	SteerLib::AgentInterface * createAgent();
-	void destroyAgent( SteerLib::AgentInterface * agent ) { if (agent) delete agent;  agent = NULL; }
+	void destroyAgent( SteerLib::AgentInterface * agent ) { _agentPool.destroy(dynamic_cast<PPRAgent*>(agent)); }
 
 	void initializeSimulation();
+	void preprocessSimulation();
 	void cleanupSimulation();
+	void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+	/// Only the batch and parallel modes and the phase budgets do any work before the agents are updated.
+	bool usesPreprocessFrame() { return (_context.perception != NULL) || (_context.phaseThreadPool != NULL) || _usesPhaseBudgets; }
+	bool usesPostprocessFrame() { return false; }
 
 private:
+	/// One range of agents, whose phases are run by one task of the parallel mode.
+	struct PhaseTask {
+		PPRAIModule * module;
+		unsigned int firstAgent;
+		unsigned int lastAgent;
+	};
+
+	/**
+	 * @brief Runs the phases of all agents of this frame, one phase at a time, on the worker threads.
+	 *
+	 * Each phase is run for all agents before the next phase starts, and is profiled as a whole with the profiler of the phase.
+	 * Steering is left to updateAI(), which the engine calls for one agent after the other, so the agents only
+	 * move and update the spatial database after all phases are done.  Until then, the phases of one agent only read the
+	 * position, velocity and orientation of other agents, which do not change, so the result does not depend on the
+	 * number of threads.
+	 */
+	void _runPhasesInParallel(float timeStamp, float dt, unsigned int frameNumber);
+	/// Task function that runs the current phase for the agents of one PhaseTask.
+	static void _runPhaseTask(unsigned int threadIndex, void * data);
+	Util::PerformanceProfiler * _getPhaseProfiler(PPRAgent::PhaseEnum phase);
+
+	/**
+	 * @brief Postpones phases that are due on this frame, so that each budgeted phase takes about as long as its budget.
+	 *
+	 * The cost of one agent's phase is measured with the profiler of the phase: the time it accumulated during the last frame,
+	 * divided by the number of agents that ran the phase, smoothed over frames.  When more agents are due than the budget
+	 * allows, the agents with threats or without a valid path go first, then the agents that waited longest; the rest are
+	 * postponed to the next frame.  An urgent agent goes ahead of agents that waited up to PPR_BUDGET_URGENCY_FRAMES frames
+	 * longer than it, so that no agent is postponed forever.  Agents whose phases never ran are never postponed, and the
+	 * snapshot of the batch mode does not count against the perceptive budget.
+	 */
+	void _applyPhaseBudgets(unsigned int currentFrameNumber);
+
+	SteerLib::EngineInterface * _engine;
+	PPRGlobals::PPRAIContext _context;
+	/// The agents of this module, recycled across simulations.
+	Util::ObjectPool<PPRAgent> _agentPool;
+	/// The agent snapshot used when the "batch" option is set.
+	PPRPerception _perception;
+	/// @name The parallel mode
+	//@{
+	unsigned int _numPhaseThreads;
+	/// The agents whose phases run on the worker threads in this frame.
+	std::vector<PPRAgent*> _parallelAgents;
+	std::vector<PhaseTask> _phaseTasks;
+	PPRAgent::PhaseEnum _currentPhase;
+	//@}
+	/// @name The phase budgets
+	//@{
+	/// One agent that is due to run a budgeted phase, and how much it should go before the others.
+	struct BudgetedAgent {
+		PPRAgent * agent;
+		unsigned int priority;
+		bool operator<(const BudgetedAgent & other) const { return priority > other.priority; }
+	};
+	bool _usesPhaseBudgets;
+	/// The time each phase may take per frame, in milliseconds; 0 if the phase is not budgeted.
+	float _phaseBudget[PPRAgent::NUM_PHASES];
+	/// The measured time one agent's phase takes, in milliseconds; 0 until it was measured.
+	float _phaseCostPerAgent[PPRAgent::NUM_PHASES];
+	long long _phaseTicksAtLastFrame[PPRAgent::NUM_PHASES];
+	/// The number of agents that were allowed to run each phase on the last frame.
+	unsigned int _phaseAgentsScheduled[PPRAgent::NUM_PHASES];
+	std::vector<BudgetedAgent> _dueAgents;
+	/// The part of the perceptive phase profiler's time spent taking the snapshot of the batch mode.
+	Util::PerformanceProfiler _snapshotProfiler;
+	//@}
 	bool logToFie;
 	std::string logFilename;
 	Logger * _pprLogger;
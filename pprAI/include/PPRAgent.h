@@ -11,6 +11,8 @@
 
 #include "SteerLib.h"
 #include "PPRParameters.h"
+#include "PPRPerception.h"
+#include "PPRThreatList.h"
 
 // #define USE_ANNOTATIONS
 
@@ -26,35 +28,15 @@
 class PPRAgent;
 
 namespace PPRGlobals {
-	// NOTE this is forward declared for an inline function defined below
-	// other declarations for this namespace belong in PPRAIModule.h
-	extern SteerLib::EngineInterface * gEngine;
+	// NOTE this is forward declared for the agent's pointer to it; it is declared in PPRAIModule.h
+	struct PPRAIContext;
 }
 
-
 //======================================================================================
 // helper data structures
 //======================================================================================
 
 
-//
-// PredictedThreat - data that describes a threat that was found by the predictive phase.
-//
-struct PredictedThreat {
-	enum ThreatTypeEnum { THREAT_TYPE_UNKNOWN, THREAT_TYPE_ONCOMING, THREAT_TYPE_CROSSING_SOON, THREAT_TYPE_CROSSING_LATE };
-
-	// the agent that the threat is predicted on
-	SteerLib::AgentInterface * threatGuy;
-	// interval of time that the threat is expected
-	float minTime, maxTime, originalMaxTime;
-	// the type of threat it is
-	ThreatTypeEnum threatType;
-	// indicates whether the threat is imminent, or already avoided, but still cannot steer normally.
-	bool imminent;
-	bool oncomingToRightSide;
-};
-
-
 //
 // FeelerInfo - the "t" parameters and object references that result from tracing the agent's "feelers" in the reactive phase.
 //
@@ -84,7 +66,7 @@ class PPRAgent : public SteerLib::AgentInterface
 {
 public:
 	// AgentInterface functionality:
-	PPRAgent();
+	PPRAgent(PPRGlobals::PPRAIContext * context);
 	~PPRAgent();
 	void reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo);
 	void updateAI(float timeStamp, float dt, unsigned int frameNumber);
@@ -126,6 +108,10 @@ public:
 		REACTIVE_SITUATION_STATIC_OBJECTS_ZERO_AGENTS,  REACTIVE_SITUATION_STATIC_OBJECTS_ONE_AGENT,  REACTIVE_SITUATION_STATIC_OBJECTS_TWO_AGENTS, 
 		REACTIVE_SITUATION_NO_THREATS,  REACTIVE_SITUATION_UNKNOWN };
 
+	// the scheduled phases, in the order updateAI() runs them; PPRAIModule runs each one across all agents in the parallel mode.
+	enum PhaseEnum { PHASE_LONG_TERM_PLANNING,  PHASE_MID_TERM_PLANNING,  PHASE_SHORT_TERM_PLANNING,
+		PHASE_PERCEPTIVE,  PHASE_PREDICTIVE,  PHASE_REACTIVE,  NUM_PHASES };
+
 	// native functionality:
 	SteeringStateEnum steeringState() { return _steeringState; }
 	Util::Vector velocity() const { return _forward * _currentSpeed; }
@@ -134,7 +120,7 @@ public:
 	Util::Vector localTargetDirection() { return _finalSteeringCommand.targetDirection; }
 	void setParameters(SteerLib::Behaviour behave);
 	bool isSelected() { 
-		return PPRGlobals::gEngine->isAgentSelected(this);
+		return _engine->isAgentSelected(this);
 	}
 
 
@@ -152,6 +138,18 @@ protected:
 	void runPredictivePhase();
 	void runReactivePhase();
 
+	// the phases of one frame, split up so that PPRAIModule can run each phase across all agents before the next one.
+	void beginPhases(float timeStamp, float dt, unsigned int frameNumber);
+	void runScheduledPhase(PhaseEnum phase);
+	void scheduleNextPhases();
+	// the profiler of a phase, or NULL when the module profiles the phase of all agents at once.
+	Util::PerformanceProfiler * phaseProfiler(Util::PerformanceProfiler & profiler);
+	// the frame a phase is scheduled to run next and the last frame it ran, for the phase budgets of PPRAIModule.
+	unsigned int & nextFrameToRunPhase(PhaseEnum phase);
+	unsigned int lastFramePhaseWasCalled(PhaseEnum phase);
+	// true if the agent has threats to deal with or no valid path to its local target, so its phases should not be postponed.
+	bool needsUrgentPhaseUpdate();
+
 	// given a steering command, these functions do the actual steering.
 	void doSteering();
 	void doDynamicsSteering();
@@ -161,11 +159,15 @@ protected:
 	// helper functions
 	bool updateReactiveFeelers( FeelerInfo & feelers );  // returns false if the 3 front rays don't intersect anything, even if the rside/lside rays do.
 	void collectObjectsInVisualField();
+	void collectAgentsFromSnapshot(unsigned int currentFrameNumber);
+	// true if the last perceptive phase found any agents or static objects.
+	bool hasNeighbors() { return (!_neighbors.empty()) || (!_perceivedAgents.empty()) || _perceivedObstacles; }
+	void predictThreat(const PerceivedAgent & other, const Util::Vector & directionToLocalTarget, bool & threatListChanged, float & threat_min_t, float & threat_max_t);
 	bool reachedCurrentGoal();
 	bool reachedCurrentWaypoint();
 	bool reachedLocalTarget();
-	bool threatListContainsAgent(SteerLib::AgentInterface * agent, unsigned int &index);
-	inline bool threatListContainsAgent(SteerLib::AgentInterface * agent) { unsigned int dummy; return threatListContainsAgent(agent, dummy); }
+	inline bool threatListContainsAgent(SteerLib::AgentInterface * agent, unsigned int &index) { return _threatList.find(agent, index); }
+	inline bool threatListContainsAgent(SteerLib::AgentInterface * agent) { return _threatList.contains(agent); }
 	void disable();
 	void drawPlannedPath();
 
@@ -187,13 +189,17 @@ protected:
 	// PERCEPTION PHASE
 	std::set<SteerLib::SpatialDatabaseItemPtr> _neighbors;
 	unsigned int _numAgentsInVisualField;  // different than _neighbors.size(), which includes static objects.
+	// in the "batch" mode, the agents in the visual field are kept here instead of in _neighbors, and only whether there are any static objects is known.
+	std::vector<PerceivedNeighbor> _perceivedAgents;
+	bool _perceivedObstacles;
+	unsigned int _lastFramePerceivedInBatch;
 
 	// PREDICTION PHASE
 	float _timeToWait;
 	float _minThreatTime;
 	float _maxThreatTime;
 	int _mostImminentThreatIndex;
-	std::vector<PredictedThreat> _threatList;
+	PPRThreatList _threatList;
 	Util::Vector _crowdControlDirection;
 	SteeringStateEnum _steeringState;
 
@@ -218,6 +224,8 @@ protected:
 	unsigned int _lastFramePerceptiveWasCalled;
 	unsigned int _lastFramePredictiveWasCalled;
 	unsigned int _lastFrameReactiveWasCalled;
+	// the last frame beginPhases() was called for; updateAI() only runs the phases itself if the module did not.
+	unsigned int _lastFramePhasesWereRun;
 
 	// used for dynamic adaptation of schedules
 	unsigned int _framesToNextLongTermPlanning;
@@ -245,6 +253,11 @@ protected:
 
 	// OTHER STATE
 	bool _enabled;
+	// the context of the module that created this agent.
+	PPRGlobals::PPRAIContext * _context;
+	// the engine and spatial database that this agent was given in reset().
+	SteerLib::EngineInterface * _engine;
+	SteerLib::GridDatabase2D * _spatialDatabase;
 	
 	// TODO THESE VALUES SHOULD BE MOVED TO PPRGlobals namespace, they are just wasting space per agent.
 	// there is one issue with _currentFrameNumber that has to be checked first, though.
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+#ifndef __PPR_PERCEPTION_H__
+#define __PPR_PERCEPTION_H__
+
+/// @file PPRPerception.h
+/// @brief Declares the PPRPerception class, the per-frame agent snapshot used by the batched perceptive phase of pprAI.
+
+#include <vector>
+#include "SteerLib.h"
+
+
+//
+// PerceivedAgent - the state of one agent at the start of a frame, as the predictive and reactive phases read it.
+//
+struct PerceivedAgent {
+	SteerLib::AgentInterface * agent;
+	size_t id;
+	Util::Point position;
+	Util::Vector velocity;
+	Util::Vector forward;
+	// the target of the agent's current goal.
+	Util::Point goalLocation;
+	float radius;
+	bool enabled;
+};
+
+
+//
+// PerceivedNeighbor - an agent found by the perceptive phase, and where to find its state in the snapshot.
+//
+struct PerceivedNeighbor {
+	SteerLib::AgentInterface * agent;
+	// the index of the agent in the snapshot; only a hint, because the snapshot is taken again every frame.
+	unsigned int index;
+};
+
+
+/**
+ * @brief A snapshot of all agents, taken once per frame, and the visual field queries of the batched perceptive phase.
+ *
+ * When the pprAI module runs with the "batch" option, the module calls #update() once per frame before
+ * any agent is updated.  The snapshot copies the state of every agent of the engine into a PerceivedAgent,
+ * so that reading a neighbor is an array access instead of several virtual calls, and bins the enabled agents
+ * into a uniform grid whose cells are as large as the query radius of the module.  The module then runs the
+ * perceptive phase of all its agents that are due on this frame in one pass with #collectAgentsInVisualField(),
+ * which keeps the same three conditions as GridDatabase2D::getItemsInVisualField(): within the query radius,
+ * not behind the agent, and in line of sight.
+ *
+ * Agents are stored in the same order as EngineInterface::getAgents(), so the index a PerceivedNeighbor keeps
+ * remains valid from frame to frame unless agents are added or removed; #findAgent() falls back to a binary search otherwise.
+ *
+ * Besides the agents in the visual field, the perceptive phase only tells whether there are any obstacles in the
+ * spatial database cells a query covers, which is all the reactive phase needs to schedule itself.
+ *
+ * The reactive phase traces its feelers with #traceFeelers() instead of GridDatabase2D::trace(): all feelers of an
+ * agent are tested at once against the agents and obstacles binned around them, four at a time with SSE2 where available,
+ * instead of walking the spatial database grid once per feeler.  The obstacles are copied and binned once per simulation
+ * by #buildObstacles(); axis-aligned boxes are kept as flat arrays of bounds, any other obstacle is tested through its
+ * own intersects().
+ */
+class PPRPerception
+{
+public:
+	PPRPerception();
+
+	/// Records which spatial database cells contain obstacles; called once the obstacles of the simulation exist.
+	void buildObstacles(const std::set<SteerLib::ObstacleInterface*> & obstacles, SteerLib::GridDatabase2D * spatialDatabase);
+	/// Takes the snapshot of all agents for this frame; queries use a grid over the spatial database with cells of the given size.
+	void update(const std::vector<SteerLib::AgentInterface*> & agents, SteerLib::GridDatabase2D * spatialDatabase, float cellSize);
+	/// Forgets all agents and obstacles; called when the simulation is cleaned up.
+	void clear();
+
+	/**
+	 * @brief Finds the agents in the visual field of an agent, replacing the contents of neighbors.
+	 *
+	 * The neighbors are sorted by pointer, the order of the std::set that the per-agent perceptive phase fills.
+	 * Returns true if there are obstacles in the spatial database cells around the agent.
+	 */
+	bool collectAgentsInVisualField(SteerLib::AgentInterface * self, const Util::Point & position, const Util::Vector & facingDirection, float radius,
+		std::vector<PerceivedNeighbor> & neighbors) const;
+
+	/// Returns the state of a neighbor in this frame's snapshot, updating its index if needed; NULL if the agent is not in the snapshot.
+	const PerceivedAgent * findAgent(PerceivedNeighbor & neighbor) const;
+
+	/**
+	 * @brief Traces several rays of one agent at once, with the same results as GridDatabase2D::trace() on each of them.
+	 *
+	 * The rays must be initialized with Ray::initWithLengthInterval().  For each ray, t and hitObject are set to the
+	 * closest agent or obstacle it hits, other than self; rays that hit nothing get INFINITY and NULL.  Agents are
+	 * traced at their position in the snapshot.
+	 */
+	void traceFeelers(SteerLib::AgentInterface * self, const Util::Ray * rays, unsigned int numRays, float * t, SteerLib::SpatialDatabaseItemPtr * hitObjects) const;
+
+	size_t getNumAgents() const { return _agents.size(); }
+
+protected:
+	/// Converts a range of positions along one axis to the range of spatial database cells it covers, clamped to the grid.
+	bool _getCellRange(float minValue, float maxValue, float origin, float gridSize, unsigned int numCells, unsigned int & minIndex, unsigned int & maxIndex) const;
+	/// Returns the grid cell along one axis of the agent snapshot.
+	unsigned int _getBin(float value, float origin, unsigned int numBins) const;
+	/// Bins the obstacles from #buildObstacles() into the grid of the agent snapshot.
+	void _binObstacles();
+
+	SteerLib::GridDatabase2D * _spatialDatabase;
+
+	/// The agents, in the order of EngineInterface::getAgents().
+	std::vector<PerceivedAgent> _agents;
+	/// Pairs of (agent, index into _agents), sorted by agent.
+	std::vector< std::pair<SteerLib::AgentInterface*, unsigned int> > _sortedAgents;
+
+	/// @name The uniform grid of the enabled agents
+	//@{
+	float _binSize;
+	float _binOriginX, _binOriginZ;
+	unsigned int _numBinsX, _numBinsZ;
+	/// The indices of the enabled agents, sorted by grid cell; the agents of cell c are [_binStart[c], _binStart[c+1]).
+	std::vector<unsigned int> _binAgents;
+	std::vector<unsigned int> _binStart;
+	float _maxAgentRadius;
+	//@}
+
+	/// @name The obstacles traced by the feelers
+	//@{
+	std::vector<SteerLib::ObstacleInterface*> _obstacles;
+	/// Whether each obstacle is an axis-aligned box, which is traced with the bounds below instead of its intersects().
+	std::vector<bool> _obstacleIsBox;
+	std::vector<float> _obstacleXMin;
+	std::vector<float> _obstacleXMax;
+	std::vector<float> _obstacleZMin;
+	std::vector<float> _obstacleZMax;
+	/// The indices of the obstacles overlapping each grid cell; an obstacle is listed in every cell its bounds overlap.
+	std::vector<unsigned int> _binObstacleIndices;
+	std::vector<unsigned int> _binObstacleStart;
+	//@}
+
+	/// Summed area table of the spatial database cells that contain obstacles, (numCellsX+1) * (numCellsZ+1) entries.
+	std::vector<unsigned int> _obstacleCellSums;
+};
+
+
+#endif
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+#ifndef __PPR_THREAT_LIST_H__
+#define __PPR_THREAT_LIST_H__
+
+/// @file PPRThreatList.h
+/// @brief Declares PredictedThreat and the PPRThreatList class, the threats an agent keeps between predictive phases.
+
+#include <cassert>
+#include <algorithm>
+#include "SteerLib.h"
+
+// the most threats an agent keeps; when there are more, the ones furthest in the future are dropped.
+#define PPR_MAX_THREATS 16
+// the number of slots of the membership table, a power of two at least twice PPR_MAX_THREATS.
+#define PPR_THREAT_TABLE_SIZE 32
+
+
+//
+// PredictedThreat - data that describes a threat that was found by the predictive phase.
+//
+struct PredictedThreat {
+	enum ThreatTypeEnum { THREAT_TYPE_UNKNOWN, THREAT_TYPE_ONCOMING, THREAT_TYPE_CROSSING_SOON, THREAT_TYPE_CROSSING_LATE };
+
+	// the agent that the threat is predicted on
+	SteerLib::AgentInterface * threatGuy;
+	// interval of time that the threat is expected
+	float minTime, maxTime, originalMaxTime;
+	// the type of threat it is
+	ThreatTypeEnum threatType;
+	// indicates whether the threat is imminent, or already avoided, but still cannot steer normally.
+	bool imminent;
+	bool oncomingToRightSide;
+};
+
+
+/**
+ * @brief The threats of one agent, in a fixed-capacity heap ordered by the time the collision starts (PredictedThreat::minTime).
+ *
+ * Threats are indexed like an array, 0 to size()-1, and #top() is the threat expected first.  Indices change whenever a
+ * threat is added or removed, or its minTime changes and #update() restores the order.
+ *
+ * Whether an agent is already a threat is answered by a small open-addressing table from agent to heap index, instead of
+ * searching the list.  Slots of the table are only valid if their stamp is the current one, so #clear() and removing
+ * threats only need to change the stamp (and re-insert the threats that remain) rather than wipe the table.
+ *
+ * With more than PPR_MAX_THREATS threats, #insert() keeps the PPR_MAX_THREATS that are expected soonest.
+ */
+class PPRThreatList
+{
+public:
+	PPRThreatList() : _size(0), _stamp(1) {
+		for (unsigned int i = 0; i < PPR_THREAT_TABLE_SIZE; i++) {
+			_table[i].stamp = 0;
+		}
+	}
+
+	unsigned int size() const { return _size; }
+	bool empty() const { return _size == 0; }
+	PredictedThreat & operator[](unsigned int index) { assert(index < _size); return _threats[index]; }
+	const PredictedThreat & operator[](unsigned int index) const { assert(index < _size); return _threats[index]; }
+	/// The threat with the earliest minTime.
+	const PredictedThreat & top() const { assert(_size > 0); return _threats[0]; }
+
+	void clear() {
+		_size = 0;
+		_nextStamp();
+	}
+
+	/// Returns true if the agent is a threat, and its index in index.
+	bool find(const SteerLib::AgentInterface * agent, unsigned int & index) const {
+		for (unsigned int slot = _hash(agent); _table[slot].stamp == _stamp; slot = (slot + 1) & (PPR_THREAT_TABLE_SIZE - 1)) {
+			if (_table[slot].agent == agent) {
+				index = _table[slot].index;
+				return true;
+			}
+		}
+		return false;
+	}
+	bool contains(const SteerLib::AgentInterface * agent) const { unsigned int dummy; return find(agent, dummy); }
+
+	/// Adds a threat on an agent that is not a threat yet.
+	void insert(const PredictedThreat & threat) {
+		assert(!contains(threat.threatGuy));
+		if (_size == PPR_MAX_THREATS) {
+			// the latest threat is one of the leaves of the heap.
+			unsigned int latest = PPR_MAX_THREATS / 2;
+			for (unsigned int i = latest + 1; i < _size; i++) {
+				if (_threats[i].minTime > _threats[latest].minTime) latest = i;
+			}
+			if (threat.minTime >= _threats[latest].minTime) {
+				return;
+			}
+			_removeAt(latest);
+		}
+		_threats[_size] = threat;
+		_addToTable(threat.threatGuy, _size);
+		_size++;
+		_siftUp(_size - 1);
+	}
+
+	/// Restores the order after the minTime of a threat was changed.
+	void update(unsigned int index) {
+		assert(index < _size);
+		_siftDown(_siftUp(index));
+	}
+
+	/// Removes all threats whose maxTime is before the given time.
+	void removeExpired(float currentTime) {
+		unsigned int numKept = 0;
+		for (unsigned int i = 0; i < _size; i++) {
+			if (currentTime <= _threats[i].maxTime) {
+				_threats[numKept++] = _threats[i];
+			}
+		}
+		if (numKept != _size) {
+			_size = numKept;
+			_rebuild();
+		}
+	}
+
+protected:
+	struct TableSlot {
+		const SteerLib::AgentInterface * agent;
+		unsigned int stamp;
+		unsigned int index;
+	};
+
+	static unsigned int _hash(const SteerLib::AgentInterface * agent) {
+		// agents are allocated at least 16 bytes apart, so the low bits carry no information.
+		size_t bits = reinterpret_cast<size_t>(agent) >> 4;
+		return (unsigned int)((bits * 2654435761u) >> 8) & (PPR_THREAT_TABLE_SIZE - 1);
+	}
+
+	TableSlot & _findSlot(const SteerLib::AgentInterface * agent) {
+		unsigned int slot = _hash(agent);
+		while (_table[slot].agent != agent) {
+			assert(_table[slot].stamp == _stamp);
+			slot = (slot + 1) & (PPR_THREAT_TABLE_SIZE - 1);
+		}
+		return _table[slot];
+	}
+
+	void _addToTable(const SteerLib::AgentInterface * agent, unsigned int index) {
+		unsigned int slot = _hash(agent);
+		while (_table[slot].stamp == _stamp) {
+			slot = (slot + 1) & (PPR_THREAT_TABLE_SIZE - 1);
+		}
+		_table[slot].agent = agent;
+		_table[slot].stamp = _stamp;
+		_table[slot].index = index;
+	}
+
+	void _nextStamp() {
+		_stamp++;
+		if (_stamp == 0) {
+			// wrapped around; no slot may keep a stamp that becomes current again.
+			for (unsigned int i = 0; i < PPR_THREAT_TABLE_SIZE; i++) {
+				_table[i].stamp = 0;
+			}
+			_stamp = 1;
+		}
+	}
+
+	/// Invalidates the table and fills it and the heap again from the first _size threats.
+	void _rebuild() {
+		_nextStamp();
+		for (unsigned int i = 0; i < _size; i++) {
+			_addToTable(_threats[i].threatGuy, i);
+		}
+		for (unsigned int i = _size / 2; i > 0; i--) {
+			_siftDown(i - 1);
+		}
+	}
+
+	void _removeAt(unsigned int index) {
+		_threats[index] = _threats[_size - 1];
+		_size--;
+		_rebuild();
+	}
+
+	void _swap(unsigned int a, unsigned int b) {
+		std::swap(_threats[a], _threats[b]);
+		_findSlot(_threats[a].threatGuy).index = a;
+		_findSlot(_threats[b].threatGuy).index = b;
+	}
+
+	unsigned int _siftUp(unsigned int index) {
+		while ((index > 0) && (_threats[index].minTime < _threats[(index - 1) / 2].minTime)) {
+			_swap(index, (index - 1) / 2);
+			index = (index - 1) / 2;
+		}
+		return index;
+	}
+
+	unsigned int _siftDown(unsigned int index) {
+		for (;;) {
+			unsigned int smallest = index;
+			unsigned int left = 2 * index + 1;
+			unsigned int right = left + 1;
+			if ((left < _size) && (_threats[left].minTime < _threats[smallest].minTime)) smallest = left;
+			if ((right < _size) && (_threats[right].minTime < _threats[smallest].minTime)) smallest = right;
+			if (smallest == index) return index;
+			_swap(index, smallest);
+			index = smallest;
+		}
+	}
+
+	PredictedThreat _threats[PPR_MAX_THREATS];
+	unsigned int _size;
+	TableSlot _table[PPR_THREAT_TABLE_SIZE];
+	unsigned int _stamp;
+};
+
+
+#endif
@@ -30,52 +30,17 @@ using std::min;
 //
 // constructor
 //
-PPRAgent::PPRAgent()
+PPRAgent::PPRAgent(PPRGlobals::PPRAIContext * context)
 {
-	_PPRParams.ped_max_speed = ped_max_speed;
-	_PPRParams.ped_typical_speed   = ped_typical_speed  ;
-	_PPRParams.ped_max_force    = ped_max_force   ;
-	_PPRParams.ped_max_speed_factor    = ped_max_speed_factor   ;
-	_PPRParams.ped_faster_speed_factor   = ped_faster_speed_factor  ;
-	_PPRParams.ped_slightly_faster_speed_factor  = ped_slightly_faster_speed_factor ;
-	_PPRParams.ped_typical_speed_factor     = ped_typical_speed_factor    ;
-	_PPRParams.ped_slightly_slower_speed_factor  = ped_slightly_slower_speed_factor ;
-	_PPRParams.ped_slower_speed_factor  = ped_slower_speed_factor ;
-	_PPRParams.ped_cornering_turn_rate  = ped_cornering_turn_rate ;
-	_PPRParams.ped_adjustment_turn_rate  = ped_adjustment_turn_rate ;
-	_PPRParams.ped_faster_avoidance_turn_rate  = ped_faster_avoidance_turn_rate ;
-	_PPRParams.ped_typical_avoidance_turn_rate  = ped_typical_avoidance_turn_rate ;
-	_PPRParams.ped_braking_rate   = ped_braking_rate  ;
-	_PPRParams.ped_comfort_zone     = ped_comfort_zone    ;
-	_PPRParams.ped_query_radius    = ped_query_radius   ;
-	_PPRParams.ped_similar_direction_dot_product_threshold  = ped_similar_direction_dot_product_threshold ;
-	_PPRParams.ped_same_direction_dot_product_threshold  = ped_same_direction_dot_product_threshold ;
-	_PPRParams.ped_oncoming_prediction_threshold  = ped_oncoming_prediction_threshold ;
-	_PPRParams.ped_oncoming_reaction_threshold  = ped_oncoming_reaction_threshold ;
-	_PPRParams.ped_wrong_direction_dot_product_threshold  = ped_wrong_direction_dot_product_threshold ;
-	_PPRParams.ped_threat_distance_threshold  = ped_threat_distance_threshold ;
-	_PPRParams.ped_threat_min_time_threshold  = ped_threat_min_time_threshold ;
-	_PPRParams.ped_threat_max_time_threshold  = ped_threat_max_time_threshold ;
-	_PPRParams.ped_predictive_anticipation_factor   = ped_predictive_anticipation_factor  ;
-	_PPRParams.ped_reactive_anticipation_factor  = ped_reactive_anticipation_factor ;
-	_PPRParams.ped_crowd_influence_factor  = ped_crowd_influence_factor ;
-	_PPRParams.ped_facing_static_object_threshold  = ped_facing_static_object_threshold ;
-	_PPRParams.ped_ordinary_steering_strength  = ped_ordinary_steering_strength ;
-	_PPRParams.ped_oncoming_threat_avoidance_strength  = ped_oncoming_threat_avoidance_strength ;
-	_PPRParams.ped_cross_threat_avoidance_strength  = ped_cross_threat_avoidance_strength ;
-	_PPRParams.ped_max_turning_rate  = ped_max_turning_rate ;
-	_PPRParams.ped_feeling_crowded_threshold  = ped_feeling_crowded_threshold ;
-	_PPRParams.ped_scoot_rate   = ped_scoot_rate  ;
-	_PPRParams.ped_reached_target_distance_threshold   = ped_reached_target_distance_threshold  ;
-	_PPRParams.ped_dynamic_collision_padding  = ped_dynamic_collision_padding ;
-	_PPRParams.ped_furthest_local_target_distance  = ped_furthest_local_target_distance ;
-	_PPRParams.ped_next_waypoint_distance  = ped_next_waypoint_distance ;
-	_PPRParams.ped_max_num_waypoints  = ped_max_num_waypoints ;
+	_context = context;
+	_PPRParams = context->parameters;
 
 
 	// std::cout << "next waypoint dist = " << _PPRParams.ped_next_waypoint_distance << std::endl;
 	_midTermPath = new int[_PPRParams.ped_next_waypoint_distance+2];
 	_enabled = false;
+	_engine = NULL;
+	_spatialDatabase = NULL;
 	_id=0;
 }
 
@@ -88,7 +53,7 @@ PPRAgent::~PPRAgent()
 {
 	if (_enabled) {
 		Util::AxisAlignedBox bounds(_position.x-_radius, _position.x+_radius, 0.0f, 0.0f, _position.z-_radius, _position.z+_radius);
-		gSpatialDatabase->removeObject( this, bounds);
+		_spatialDatabase->removeObject( this, bounds);
 	}
 }
 
@@ -104,6 +69,8 @@ void PPRAgent::setParameters(Behaviour behave)
 //
 void PPRAgent::reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo)
 {
+	_engine = engineInfo;
+	_spatialDatabase = engineInfo->getSpatialDatabase();
 
 	// _enabled = true;
 	AxisAlignedBox oldBounds(_position.x-_radius, _position.x+_radius, 0.0f, 0.0f, _position.z-_radius, _position.z+_radius);
@@ -115,10 +82,10 @@ void PPRAgent::reset(const SteerLib::AgentInitialConditions & initialConditions,
 
 
 	if (!_enabled) {
-		gSpatialDatabase->addObject( dynamic_cast<SpatialDatabaseItemPtr>(this), newBounds);
+		_spatialDatabase->addObject( dynamic_cast<SpatialDatabaseItemPtr>(this), newBounds);
 	}
 	else {
-		gSpatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
+		_spatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
 	}
 	_enabled = true;
 
@@ -158,6 +125,10 @@ void PPRAgent::reset(const SteerLib::AgentInitialConditions & initialConditions,
 
 	// PERCEPTION PHASE
 	_neighbors.clear();
+	_perceivedAgents.clear();
+	_perceivedObstacles = false;
+	_lastFramePerceivedInBatch = (unsigned int)-1;
+	_lastFramePhasesWereRun = (unsigned int)-1;
 	_numAgentsInVisualField = 0;
 
 	// PREDICTION PHASE
@@ -244,7 +215,7 @@ void PPRAgent::addGoal(const SteerLib::AgentGoalInfo & newGoal) {
 		if (_currentGoal.targetIsRandom) {
 
 			Util::AxisAlignedBox aab = Util::AxisAlignedBox(-100.0f, 100.0f, 0.0f, 0.0f, -100.0f, 100.0f);
-			_currentGoal.targetLocation = gSpatialDatabase->randomPositionInRegionWithoutCollisions(aab, 1.0f, true);
+			_currentGoal.targetLocation = _spatialDatabase->randomPositionInRegionWithoutCollisions(aab, 1.0f, true);
 		}
 	}
 }
@@ -259,68 +230,107 @@ void PPRAgent::updateAI(float timeStamp, float dt, unsigned int frameNumber)
 	// std::cout << "updating PPR Agent" << std::endl;
 	if (!_enabled) return;
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->aiProfiler );
+	AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.aiProfiler );
 
 	Util::Point oldPosition = position();
 
-	// initialize some vars for this update step
-	// todo, this should eventually be removed after addressing the small issue with _currentFrameNumber.
-	_currentTimeStamp = timeStamp;
-	_currentFrameNumber = frameNumber-1; // starting at 0 just because we didn't want to remove this while trying to reliably get a new chunk of code in.  TODO, change this later if it seems OK and appropriate...
-	_dt = dt;
-
-
-
 	//
-	// run any phases that were scheduled for this frame.
+	// run any phases that were scheduled for this frame, unless PPRAIModule::preprocessFrame() already ran them in parallel.
 	//
-
-	if (_currentFrameNumber >= _nextFrameToRunLongTermPlanningPhase) {
-		runLongTermPlanningPhase();
-		_lastFrameLongTermWasCalled = _currentFrameNumber;
-	}
-
-
-	if (_currentFrameNumber >= _nextFrameToRunMidTermPlanningPhase) {
-		runMidTermPlanningPhase();
-		_lastFrameMidTermWasCalled = _currentFrameNumber;
+	if (_lastFramePhasesWereRun != frameNumber-1) {
+		beginPhases(timeStamp, dt, frameNumber);
+		for (unsigned int phase = 0; phase < NUM_PHASES; phase++) {
+			runScheduledPhase((PhaseEnum)phase);
+		}
 	}
 
+	scheduleNextPhases();
 
-	if (_currentFrameNumber >= _nextFrameToRunShortTermPlanningPhase) {
-		runShortTermPlanningPhase();
-		_lastFrameShortTermWasCalled = _currentFrameNumber;
-	}
-
+	// always do locomotion
+	doSteering();
 
-	if (_currentFrameNumber >= _nextFrameToRunPerceptivePhase) {
-		runPerceptivePhase();
-		_lastFramePerceptiveWasCalled = _currentFrameNumber;
-	}
+	// DrawLib::drawLine(position(), oldPosition);
+}
 
 
-	if (_currentFrameNumber >= _nextFrameToRunPredictivePhase) {
+//
+// beginPhases()
+//
+void PPRAgent::beginPhases(float timeStamp, float dt, unsigned int frameNumber)
+{
+	// initialize some vars for this update step
+	// todo, this should eventually be removed after addressing the small issue with _currentFrameNumber.
+	_currentTimeStamp = timeStamp;
+	_currentFrameNumber = frameNumber-1; // starting at 0 just because we didn't want to remove this while trying to reliably get a new chunk of code in.  TODO, change this later if it seems OK and appropriate...
+	_dt = dt;
+	_lastFramePhasesWereRun = _currentFrameNumber;
+}
 
-		// MUBBASIR FOR REACTIVE APPROACH 
-		runPredictivePhase();
 
+//
+// runScheduledPhase() - runs one phase if it was scheduled for this frame.
+//
+void PPRAgent::runScheduledPhase(PhaseEnum phase)
+{
+	switch (phase) {
+		case PHASE_LONG_TERM_PLANNING:
+			if (_currentFrameNumber >= _nextFrameToRunLongTermPlanningPhase) {
+				runLongTermPlanningPhase();
+				_lastFrameLongTermWasCalled = _currentFrameNumber;
+			}
+			break;
+		case PHASE_MID_TERM_PLANNING:
+			if (_currentFrameNumber >= _nextFrameToRunMidTermPlanningPhase) {
+				runMidTermPlanningPhase();
+				_lastFrameMidTermWasCalled = _currentFrameNumber;
+			}
+			break;
+		case PHASE_SHORT_TERM_PLANNING:
+			if (_currentFrameNumber >= _nextFrameToRunShortTermPlanningPhase) {
+				runShortTermPlanningPhase();
+				_lastFrameShortTermWasCalled = _currentFrameNumber;
+			}
+			break;
+		case PHASE_PERCEPTIVE:
+			if (_currentFrameNumber >= _nextFrameToRunPerceptivePhase) {
+				runPerceptivePhase();
+				_lastFramePerceptiveWasCalled = _currentFrameNumber;
+			}
+			break;
+		case PHASE_PREDICTIVE:
+			if (_currentFrameNumber >= _nextFrameToRunPredictivePhase) {
 
-		_lastFramePredictiveWasCalled = _currentFrameNumber;
-	}
+				// MUBBASIR FOR REACTIVE APPROACH 
+				runPredictivePhase();
 
 
-	if (_currentFrameNumber >= _nextFrameToRunReactivePhase) {
+				_lastFramePredictiveWasCalled = _currentFrameNumber;
+			}
+			break;
+		case PHASE_REACTIVE:
+			if (_currentFrameNumber >= _nextFrameToRunReactivePhase) {
 
-		// clearing the decision is not absolutely necessary, but significantly helps debugging,
-		// and avoids accidental re-use of the previous command.
-		_finalSteeringCommand.clear();
+				// clearing the decision is not absolutely necessary, but significantly helps debugging,
+				// and avoids accidental re-use of the previous command.
+				_finalSteeringCommand.clear();
 
-		runReactivePhase();
-		_lastFrameReactiveWasCalled = _currentFrameNumber;
+				runReactivePhase();
+				_lastFrameReactiveWasCalled = _currentFrameNumber;
+			}
+			break;
+		default:
+			assert(false);
+			break;
 	}
+}
+
 
-		
-	if (gUseDynamicPhaseScheduling) {
+//
+// scheduleNextPhases()
+//
+void PPRAgent::scheduleNextPhases()
+{
+	if (_context->useDynamicPhaseScheduling) {
 		_nextFrameToRunLongTermPlanningPhase = _lastFrameLongTermWasCalled + _framesToNextLongTermPlanning;
 		_nextFrameToRunMidTermPlanningPhase = _lastFrameMidTermWasCalled + _framesToNextMidTermPlanning;
 		_nextFrameToRunShortTermPlanningPhase = _lastFrameShortTermWasCalled + _framesToNextShortTermPlanning;
@@ -329,19 +339,64 @@ void PPRAgent::updateAI(float timeStamp, float dt, unsigned int frameNumber)
 		_nextFrameToRunReactivePhase = _lastFrameReactiveWasCalled + _framesToNextReactivePhase;
 	}
 	else {
-		_nextFrameToRunLongTermPlanningPhase = _lastFrameLongTermWasCalled + gLongTermPlanningPhaseInterval;
-		_nextFrameToRunMidTermPlanningPhase = _lastFrameMidTermWasCalled + gMidTermPlanningPhaseInterval;
-		_nextFrameToRunShortTermPlanningPhase = _lastFrameShortTermWasCalled + gShortTermPlanningPhaseInterval;
-		_nextFrameToRunPerceptivePhase = _lastFramePerceptiveWasCalled + gPerceptivePhaseInterval;
-		_nextFrameToRunPredictivePhase = _lastFramePredictiveWasCalled + gPredictivePhaseInterval;
-		_nextFrameToRunReactivePhase = _lastFrameReactiveWasCalled + gReactivePhaseInterval;
+		_nextFrameToRunLongTermPlanningPhase = _lastFrameLongTermWasCalled + _context->longTermPlanningPhaseInterval;
+		_nextFrameToRunMidTermPlanningPhase = _lastFrameMidTermWasCalled + _context->midTermPlanningPhaseInterval;
+		_nextFrameToRunShortTermPlanningPhase = _lastFrameShortTermWasCalled + _context->shortTermPlanningPhaseInterval;
+		_nextFrameToRunPerceptivePhase = _lastFramePerceptiveWasCalled + _context->perceptivePhaseInterval;
+		_nextFrameToRunPredictivePhase = _lastFramePredictiveWasCalled + _context->predictivePhaseInterval;
+		_nextFrameToRunReactivePhase = _lastFrameReactiveWasCalled + _context->reactivePhaseInterval;
 	}
+}
 
 
-	// always do locomotion
-	doSteering();
+//
+// nextFrameToRunPhase()
+//
+unsigned int & PPRAgent::nextFrameToRunPhase(PhaseEnum phase)
+{
+	switch (phase) {
+		case PHASE_LONG_TERM_PLANNING: return _nextFrameToRunLongTermPlanningPhase;
+		case PHASE_MID_TERM_PLANNING: return _nextFrameToRunMidTermPlanningPhase;
+		case PHASE_SHORT_TERM_PLANNING: return _nextFrameToRunShortTermPlanningPhase;
+		case PHASE_PERCEPTIVE: return _nextFrameToRunPerceptivePhase;
+		case PHASE_PREDICTIVE: return _nextFrameToRunPredictivePhase;
+		default: assert(phase == PHASE_REACTIVE); return _nextFrameToRunReactivePhase;
+	}
+}
 
-	// DrawLib::drawLine(position(), oldPosition);
+
+//
+// lastFramePhaseWasCalled()
+//
+unsigned int PPRAgent::lastFramePhaseWasCalled(PhaseEnum phase)
+{
+	switch (phase) {
+		case PHASE_LONG_TERM_PLANNING: return _lastFrameLongTermWasCalled;
+		case PHASE_MID_TERM_PLANNING: return _lastFrameMidTermWasCalled;
+		case PHASE_SHORT_TERM_PLANNING: return _lastFrameShortTermWasCalled;
+		case PHASE_PERCEPTIVE: return _lastFramePerceptiveWasCalled;
+		case PHASE_PREDICTIVE: return _lastFramePredictiveWasCalled;
+		default: assert(phase == PHASE_REACTIVE); return _lastFrameReactiveWasCalled;
+	}
+}
+
+
+//
+// needsUrgentPhaseUpdate()
+//
+bool PPRAgent::needsUrgentPhaseUpdate()
+{
+	return (!_threatList.empty()) || (_midTermPathSize == 0) || reachedLocalTarget();
+}
+
+
+//
+// phaseProfiler()
+//
+Util::PerformanceProfiler * PPRAgent::phaseProfiler(Util::PerformanceProfiler & profiler)
+{
+	// the profilers are not thread-safe, so in the parallel mode only the module profiles the phases, once per frame.
+	return (_context->phaseThreadPool == NULL) ? &profiler : NULL;
 }
 
 
@@ -370,7 +425,7 @@ void PPRAgent::runCognitivePhase()
 	// if the goal asks for a random target, then randomly assign the target location
 	if (_currentGoal.targetIsRandom) {
 		AxisAlignedBox aab = AxisAlignedBox(-100.0f, 100.0f, 0.0f, 0.0f, -100.0f, 100.0f);
-		_currentGoal.targetLocation = gSpatialDatabase->randomPositionInRegionWithoutCollisions(aab, 1.0f, true);
+		_currentGoal.targetLocation = _spatialDatabase->randomPositionInRegionWithoutCollisions(aab, 1.0f, true);
 	}
 }
 
@@ -398,17 +453,17 @@ void PPRAgent::runLongTermPlanningPhase()
 		if (!_enabled) return;
 	}
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->longTermPhaseProfiler );
+	AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.longTermPhaseProfiler) );
 
 	//==========================================================================
 
-	int myIndexPosition = gSpatialDatabase->getCellIndexFromLocation(_position);
-	int goalIndex = gSpatialDatabase->getCellIndexFromLocation(_currentGoal.targetLocation);
+	int myIndexPosition = _spatialDatabase->getCellIndexFromLocation(_position);
+	int goalIndex = _spatialDatabase->getCellIndexFromLocation(_currentGoal.targetLocation);
 
 	if (myIndexPosition != -1) {
 
 		// run the main a-star search here
-		gSpatialDatabase->planPath(myIndexPosition, goalIndex, longTermPath);
+		_spatialDatabase->planPath(myIndexPosition, goalIndex, longTermPath);
 
 
 		// set up the waypoints along this path.
@@ -433,7 +488,7 @@ void PPRAgent::runLongTermPlanningPhase()
 
 				// every time we successfully popped that many nodes in the path, we can add the next one as a waypoint.
 				Point waypoint;
-				gSpatialDatabase->getLocationFromIndex(mostRecentNode,waypoint);
+				_spatialDatabase->getLocationFromIndex(mostRecentNode,waypoint);
 				_waypoints.push_back(waypoint);
 			}
 
@@ -447,7 +502,7 @@ void PPRAgent::runLongTermPlanningPhase()
 			int nextWaypointIndex = ((int)longTermAStar.getPath().size())-1 - _PPRParams.ped_next_waypoint_distance;
 			while (nextWaypointIndex > 0) {
 				Point waypoint;
-				gSpatialDatabase->getLocationFromIndex(longTermAStar.getPath()[nextWaypointIndex],waypoint);
+				_spatialDatabase->getLocationFromIndex(longTermAStar.getPath()[nextWaypointIndex],waypoint);
 				_waypoints.push_back(waypoint);
 				nextWaypointIndex -= _PPRParams.ped_next_waypoint_distance;
 			}
@@ -496,7 +551,7 @@ void PPRAgent::runMidTermPlanningPhase()
 		if (!_enabled) return;
 	}
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->midTermPhaseProfiler );
+	AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.midTermPhaseProfiler) );
 
 	// if we reached the current waypoint, then increment to the next waypoint
 	if (reachedCurrentWaypoint()) {
@@ -507,10 +562,10 @@ void PPRAgent::runMidTermPlanningPhase()
 	}
 
 	// compute a local a-star from your current location to the waypoint.
-	int myIndexPosition = gSpatialDatabase->getCellIndexFromLocation(_position.x, _position.z);
-	int waypointIndexPosition = gSpatialDatabase->getCellIndexFromLocation(_waypoints[_currentWaypointIndex].x, _waypoints[_currentWaypointIndex].z);
+	int myIndexPosition = _spatialDatabase->getCellIndexFromLocation(_position.x, _position.z);
+	int waypointIndexPosition = _spatialDatabase->getCellIndexFromLocation(_waypoints[_currentWaypointIndex].x, _waypoints[_currentWaypointIndex].z);
 
-	gSpatialDatabase->planPath(myIndexPosition, waypointIndexPosition,midTermPathStack);
+	_spatialDatabase->planPath(myIndexPosition, waypointIndexPosition,midTermPathStack);
 
 	// copy the local AStar path to your array
 	_midTermPathSize = (int)midTermPathStack.size();
@@ -575,8 +630,8 @@ void PPRAgent::runShortTermPlanningPhase()
 	}
 
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->shortTermPhaseProfiler );
-	int myIndexPosition = gSpatialDatabase->getCellIndexFromLocation(_position.x, _position.z);
+	AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.shortTermPhaseProfiler) );
+	int myIndexPosition = _spatialDatabase->getCellIndexFromLocation(_position.x, _position.z);
 
 
 	closestPathNode = 0;
@@ -593,7 +648,7 @@ void PPRAgent::runShortTermPlanningPhase()
 #endif
 		for (unsigned int i=0; i<_midTermPathSize; i++) {
 			Point tempTargetLocation;
-			gSpatialDatabase->getLocationFromIndex( _midTermPath[i], tempTargetLocation);
+			_spatialDatabase->getLocationFromIndex( _midTermPath[i], tempTargetLocation);
 			Vector temp = tempTargetLocation-_position;
 			float distSquared = temp.lengthSquared();
 			if (distSquared < minDistSquared) {
@@ -612,17 +667,17 @@ void PPRAgent::runShortTermPlanningPhase()
 			unsigned int localTargetIndex = closestPathNode;
 			unsigned int furthestTargetIndex = min(_midTermPathSize-1, closestPathNode + _PPRParams.ped_furthest_local_target_distance);
 			unsigned int localTargetCellID = _midTermPath[localTargetIndex];
-			gSpatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
+			_spatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
 			Ray lineOfSightTest1, lineOfSightTest2;
 			lineOfSightTest1.initWithUnitInterval(_position + _radius*_rightSide, _localTargetLocation - (_position + _radius*_rightSide));
 			lineOfSightTest2.initWithUnitInterval(_position - _radius*_rightSide, _localTargetLocation - (_position - _radius*_rightSide));
 			while ( (localTargetIndex <= furthestTargetIndex)
-				&& (!gSpatialDatabase->trace(lineOfSightTest1,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true))
-				&& (!gSpatialDatabase->trace(lineOfSightTest2,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true)))
+				&& (!_spatialDatabase->trace(lineOfSightTest1,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true))
+				&& (!_spatialDatabase->trace(lineOfSightTest2,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true)))
 			{
 				localTargetIndex++;
 				localTargetCellID = _midTermPath[localTargetIndex];
-				gSpatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
+				_spatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
 				lineOfSightTest1.initWithUnitInterval(_position + _radius*_rightSide, _localTargetLocation - (_position + _radius*_rightSide));
 				lineOfSightTest2.initWithUnitInterval(_position - _radius*_rightSide, _localTargetLocation - (_position - _radius*_rightSide));
 			}
@@ -638,7 +693,7 @@ void PPRAgent::runShortTermPlanningPhase()
 			{
 				// if localTargetIndex is valid
 				localTargetCellID = _midTermPath[localTargetIndex];
-				gSpatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
+				_spatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
 				if ((_localTargetLocation - _waypoints[_currentWaypointIndex]).length() < 2.0f * _PPRParams.ped_reached_target_distance_threshold)
 				{
 					_localTargetLocation = _waypoints[_currentWaypointIndex];
@@ -650,7 +705,7 @@ void PPRAgent::runShortTermPlanningPhase()
 			else {
 				// if localTargetIndex is pointing backwards, then just aim for 2 nodes ahead of the current closestPathNode.
 				localTargetCellID = _midTermPath[closestPathNode+2];
-				gSpatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
+				_spatialDatabase->getLocationFromIndex( localTargetCellID, _localTargetLocation );
 			}
 		}
 		else
@@ -683,7 +738,7 @@ void PPRAgent::runShortTermPlanningPhase()
 		else if (closestPathNode == _midTermPathSize-1) {
 			// this case is reached when you're very close to your goal, and the planned path is very short.
 			// in this case, just point towards the closest node.
-			gSpatialDatabase->getLocationFromIndex( closestPathNode, _localTargetLocation);
+			_spatialDatabase->getLocationFromIndex( closestPathNode, _localTargetLocation);
 		}
 		else {
 			// this case should never be reached
@@ -693,7 +748,7 @@ void PPRAgent::runShortTermPlanningPhase()
 	}
 
 
-	if (gUseDynamicPhaseScheduling) {
+	if (_context->useDynamicPhaseScheduling) {
 		// decimating short-term planning
 		float distanceHeuristic = (_position - _localTargetLocation).length() - 5.0f;
 		if (distanceHeuristic <= 0.0f) {
@@ -719,10 +774,17 @@ void PPRAgent::runPerceptivePhase()
 {
 	if (!_enabled) return;
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->perceptivePhaseProfiler );
-	collectObjectsInVisualField();
+	if (_context->perception == NULL) {
+		AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.perceptivePhaseProfiler) );
+		collectObjectsInVisualField();
+	}
+	else if (_lastFramePerceivedInBatch != _currentFrameNumber) {
+		// the batched pass of the module skipped this agent (e.g. it was not due yet at the start of the frame), so query the snapshot now.
+		AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.perceptivePhaseProfiler) );
+		collectAgentsFromSnapshot(_currentFrameNumber);
+	}
 
-	if (gUseDynamicPhaseScheduling) {
+	if (_context->useDynamicPhaseScheduling) {
 		if (_currentSpeed <= 0.4f) {
 			_framesToNextPerceptivePhase = 65;
 		}
@@ -743,10 +805,9 @@ void PPRAgent::runPredictivePhase()
 {
 	if (!_enabled) return;
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->predictivePhaseProfiler );
+	AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.predictivePhaseProfiler) );
 
 	bool threatListChanged = false;
-	bool alreadyExists = false;
 
 	// threat_min_t and threat_max_t are not really used except for annotation.
 	float threat_min_t, threat_max_t;
@@ -763,18 +824,7 @@ void PPRAgent::runPredictivePhase()
 	//========================================================
 	// clean through the threat-list, removing any items that are out-dated.
 	//========================================================
-	for (unsigned int i=0; i<_threatList.size();) {
-		if (_currentTimeStamp > _threatList[i].maxTime) {
-			// swap the last item into this slot, and truncate the list.
-			// this works even on the very last item, where we swap with itself.
-			//cerr << "REMOVING threat " << i << ", " << _threatList[i].maxTime << " < " << _currentTimeStamp << " (original time " << _threatList[i].originalMaxTime << ")" << endl;
-			std::swap(_threatList[i], _threatList.back());
-			_threatList.pop_back();
-		}
-		else {
-			i++;
-		}
-	}
+	_threatList.removeExpired(_currentTimeStamp);
 
 	//========================================================
 	// determine which _neighbors might be threats and 
@@ -782,160 +832,56 @@ void PPRAgent::runPredictivePhase()
 	//========================================================
 	if (_steeringState != STEERING_STATE_TURN_TOWARDS_TARGET) {	// ignore threats in the STEERING_STATE_TURN_TOWARDS_TARGET state.
 
-		for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbor = _neighbors.begin(); neighbor != _neighbors.end(); ++neighbor) {
-		//for (unsigned int i=0; i<_neighbors.size(); i++) {
+		if (_context->perception != NULL) {
+			// the agents found by the batched perceptive phase, read from this frame's snapshot instead of through the agent interface.
+			for (unsigned int i=0; i<_perceivedAgents.size(); i++) {
+				_numAgentsInVisualField++;
 
-			// ignore items that are not AI agents.
-			if (!(*neighbor)->isAgent())
-				continue;
+				// ignore disabled pedestrians.
+				const PerceivedAgent * other = _context->perception->findAgent(_perceivedAgents[i]);
+				if ((other == NULL) || (!other->enabled))
+					continue;
 
-			SteerLib::AgentInterface * otherGuy = dynamic_cast<SteerLib::AgentInterface *>(*neighbor);
+				predictThreat(*other, directionToLocalTarget, threatListChanged, threat_min_t, threat_max_t);
+			}
+		}
+		else {
+			for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbor = _neighbors.begin(); neighbor != _neighbors.end(); ++neighbor) {
+			//for (unsigned int i=0; i<_neighbors.size(); i++) {
 
-			//Vector aff = _position - otherGuy->position();
-			//if (aff.lengthlength) _numAgentsInVisualField++;
-			_numAgentsInVisualField++;
+				// ignore items that are not AI agents.
+				if (!(*neighbor)->isAgent())
+					continue;
 
+				SteerLib::AgentInterface * otherGuy = dynamic_cast<SteerLib::AgentInterface *>(*neighbor);
 
-			// ignore disabled pedestrians.
-			if (!otherGuy->enabled())
-				continue;
+				//Vector aff = _position - otherGuy->position();
+				//if (aff.lengthlength) _numAgentsInVisualField++;
+				_numAgentsInVisualField++;
 
-			// ignore pedestrians that are currently changing their direction significantly.
-			// TODO cast to PPR maybe and see if should skip
-			/*if (otherGuy->steeringState() == STEERING_STATE_TURN_TOWARDS_TARGET)
-				continue;*/
 
+				// ignore disabled pedestrians.
+				if (!otherGuy->enabled())
+					continue;
 
-			// TODO?: add: if the other guy has you in his threatlist, in the space-time planning state, that means you realize he sees you,
-			//       then you can safely ignore him?
-			// if he didnt see you and then gets put on the threatlist, that means he will get interrupted anyway and deal with you as a threat.
+				// ignore pedestrians that are currently changing their direction significantly.
+				// TODO cast to PPR maybe and see if should skip
+				/*if (otherGuy->steeringState() == STEERING_STATE_TURN_TOWARDS_TARGET)
+					continue;*/
 
-			unsigned int threatIndex=0;
-			alreadyExists = threatListContainsAgent(otherGuy,threatIndex);
 
-			Vector dV = _velocity - otherGuy->velocity();
-			Vector dO = _position - otherGuy->position();
-			float distanceThreshold = _radius + otherGuy->radius() + _PPRParams.ped_dynamic_collision_padding;
-			float A = dot(dV,dV);
-			float B = 2.0f*dot(dV,dO);
-			float C = dot(dO,dO) - (distanceThreshold*distanceThreshold);
-			float discriminant = (B*B) - (4.0f*A*C);
+				// TODO?: add: if the other guy has you in his threatlist, in the space-time planning state, that means you realize he sees you,
+				//       then you can safely ignore him?
+				// if he didnt see you and then gets put on the threatlist, that means he will get interrupted anyway and deal with you as a threat.
 
-			if (!alreadyExists) {
-				if (discriminant > 0) { // then these two agents are predicted to collide
-					float minTimeOfThreat, maxTimeOfThreat;
-					float sqrtDiscrim = sqrtf(discriminant);
-					float inv2A = 0.5f / A;
-					minTimeOfThreat = (-B - sqrtDiscrim)*inv2A;
-					maxTimeOfThreat = (-B + sqrtDiscrim)*inv2A;
-
-					if ((minTimeOfThreat < 0) && (maxTimeOfThreat > 0)) {
-						// this would imply that we already ARE in a collision!!
-						// TODO: what todo in this situation?
-						// note, we do not necessarily reach this code for ALL agent-agent collisions, because of scheduling phases.
-					}
-					else if ((minTimeOfThreat > _PPRParams.ped_threat_min_time_threshold) && (maxTimeOfThreat < _PPRParams.ped_threat_max_time_threshold)) {
-						//cerr << "NEW THREAT!!!\n";
-						PredictedThreat newThreat;
-						newThreat.maxTime = _currentTimeStamp + maxTimeOfThreat;
-						newThreat.originalMaxTime = _currentTimeStamp + maxTimeOfThreat;
-						newThreat.minTime = _currentTimeStamp + minTimeOfThreat;
-						newThreat.threatGuy = otherGuy;
-						newThreat.threatType = PredictedThreat::THREAT_TYPE_UNKNOWN; // just in case, might help debugging;
-						newThreat.imminent = true;
-						newThreat.oncomingToRightSide = false;
-
-						float cosTheta = dot(_forward,otherGuy->forward());
-						if (cosTheta > _PPRParams.ped_similar_direction_dot_product_threshold) {
-							// otherGuy is facing a similar direction as you
-							// in the current implementation, this is not considered a 
-							// threat, and reactive steering handles it.
-						} 
-						else if (cosTheta < _PPRParams.ped_oncoming_prediction_threshold) {
-							// otherGuy is oncoming.
-							float whichSideOfTarget = directionToLocalTarget.x * (otherGuy->position().x-_localTargetLocation.x) + directionToLocalTarget.z * (otherGuy->position().z-_localTargetLocation.z);
-							float whichSideOfLocation = directionToLocalTarget.x * (otherGuy->position().x-position().x) + directionToLocalTarget.z * (otherGuy->position().z-position().z);
-							newThreat.threatType = PredictedThreat::THREAT_TYPE_ONCOMING;
-							if ((whichSideOfTarget<0.0f)&&(whichSideOfLocation>0.0f)) { // this checks if the agent is actually in-between you and your local target.
-								threatListChanged = true;
-								Vector dirToOtherGuy = otherGuy->position() - _position;
-								if ((dot(dirToOtherGuy, _rightSide) > 0.0f) && (dot(-dirToOtherGuy,rightSideInXZPlane(otherGuy->forward())) > 0.0f))
-								{
-									newThreat.oncomingToRightSide = true;
-								}
-								_threatList.push_back(newThreat);
-							}
-						}
-						else {
-							float my_t = 0.0f, his_t = 0.0f;
-							Ray myRay, hisRay, rayToOtherGuy;
-							myRay.initWithLengthInterval(_position, _forward);
-							hisRay.initWithLengthInterval(otherGuy->position(),otherGuy->forward());
-							rayToOtherGuy.initWithLengthInterval( _position, otherGuy->position()-position());
-							intersectTwoRays2D( myRay.pos, myRay.dir, my_t, hisRay.pos, hisRay.dir, his_t);
-
-							if (my_t < rayToOtherGuy.maxt) {  // if expected threat is actually further away than the agent, its not actually a threat.
-								float tempt1=0.0f, tempt2=0.0f;
-								// NOTE CAREFULLY: localTargetLocation-position() is correct here - it should not be normalized.
-								// intersectTwoRays2D(_position, _localTargetLocation - _position, tempt1, otherGuy->position(), otherGuy->localTargetLocation() - otherGuy->position(), tempt2);
-								intersectTwoRays2D(_position, _localTargetLocation - _position, tempt1, otherGuy->position(), otherGuy->currentGoal().targetLocation - otherGuy->position(), tempt2);
-								if ( (tempt1>0.0f) && (tempt1<1.0f) && (tempt2>0.0f) && (tempt2<1.0f) ) { // if paths actually cross - i.e. if its not a fake-out where the agent's goal is before the threat.
-									if (my_t < his_t) {
-										newThreat.threatType = PredictedThreat::THREAT_TYPE_CROSSING_SOON;
-										threatListChanged = true;
-										_threatList.push_back(newThreat);
-										threat_min_t = min(minTimeOfThreat*_currentSpeed, threat_min_t);
-										threat_max_t = max(maxTimeOfThreat*_currentSpeed, threat_max_t);
-									}
-									else {
-										newThreat.threatType = PredictedThreat::THREAT_TYPE_CROSSING_LATE;
-										threatListChanged = true;
-										_threatList.push_back(newThreat);
-										threat_min_t = min(minTimeOfThreat*_currentSpeed, threat_min_t);
-										threat_max_t = max(maxTimeOfThreat*_currentSpeed, threat_max_t);
-									}
-								}
-							}
-						}
-					} else {
-						// either threat is in the past, or its too far into the future.
-						// here, the threat it doesnt already exist, and here
-						// we the predicted intersection is outside of the time interval
-						// we care about, so don't worry about it this agent.
-					}
-				}
-				else {
-					// discriminant indicates no soln, which means no intersection predicted.
-				}
-			}
-			else {
-				// threat already existed, update it
-				if (discriminant > 0) { // then these two agents are predicted to collide
-					float minTimeOfThreat, maxTimeOfThreat;
-					float sqrtDiscrim = sqrtf(discriminant);
-					float inv2A = 0.5f / A;
-					minTimeOfThreat = (-B - sqrtDiscrim)*inv2A;
-					maxTimeOfThreat = (-B + sqrtDiscrim)*inv2A;
-					if ((minTimeOfThreat < 0) && (maxTimeOfThreat > 0)) {
-						// collided with a threat that we already predicted
-						// doh!
-					}
-					else if ((minTimeOfThreat > _PPRParams.ped_threat_min_time_threshold) && (maxTimeOfThreat < _PPRParams.ped_threat_max_time_threshold)) {
-						// still imminent, update the threat where it exists in the _threatList.
-						_threatList[threatIndex].maxTime = _currentTimeStamp + maxTimeOfThreat;
-						_threatList[threatIndex].minTime = _currentTimeStamp + minTimeOfThreat;
-						//cerr << "COLLISION IS STILL IMMINENT\n";
-						_threatList[threatIndex].imminent = true;
-					}
-					else {
-						// outside of the time interval we care about, so no longer imminent.
-						_threatList[threatIndex].imminent = false;
-					}
-				}
-				else {
-					// no intersection predicted, so no longer imminent.
-					_threatList[threatIndex].imminent = false;
-				}
+				PerceivedAgent other;
+				other.agent = otherGuy;
+				other.position = otherGuy->position();
+				other.velocity = otherGuy->velocity();
+				other.forward = otherGuy->forward();
+				other.goalLocation = otherGuy->currentGoal().targetLocation;
+				other.radius = otherGuy->radius();
+				predictThreat(other, directionToLocalTarget, threatListChanged, threat_min_t, threat_max_t);
 			}
 		}
 	}
@@ -1018,6 +964,154 @@ void PPRAgent::runPredictivePhase()
 }
 
 
+//
+// predictCollisionInterval() - the closed-form time interval during which two discs moving at constant velocities overlap.
+//
+// returns false if they never do; otherwise minTime and maxTime are the roots of |dO + t*dV| = distanceThreshold.
+//
+static inline bool predictCollisionInterval(const Vector & dV, const Vector & dO, float distanceThreshold, float & minTime, float & maxTime)
+{
+	float A = dot(dV,dV);
+	float B = 2.0f*dot(dV,dO);
+	float C = dot(dO,dO) - (distanceThreshold*distanceThreshold);
+	float discriminant = (B*B) - (4.0f*A*C);
+	if (!(discriminant > 0)) {
+		return false;
+	}
+	float sqrtDiscrim = sqrtf(discriminant);
+	float inv2A = 0.5f / A;
+	minTime = (-B - sqrtDiscrim)*inv2A;
+	maxTime = (-B + sqrtDiscrim)*inv2A;
+	return true;
+}
+
+
+//
+// predictThreat() - predicts whether we will collide with a neighbor, and adds or updates its entry in the _threatList.
+//
+void PPRAgent::predictThreat(const PerceivedAgent & other, const Vector & directionToLocalTarget, bool & threatListChanged, float & threat_min_t, float & threat_max_t)
+{
+	float minTimeOfThreat = 0.0f, maxTimeOfThreat = 0.0f;
+	float distanceThreshold = _radius + other.radius + _PPRParams.ped_dynamic_collision_padding;
+	bool collisionPredicted = predictCollisionInterval(_velocity - other.velocity, _position - other.position, distanceThreshold, minTimeOfThreat, maxTimeOfThreat);
+	bool inThreatWindow = collisionPredicted && (minTimeOfThreat > _PPRParams.ped_threat_min_time_threshold) && (maxTimeOfThreat < _PPRParams.ped_threat_max_time_threshold);
+
+	// most neighbors are neither a threat yet nor about to become one; they cost nothing more than the kernel above.
+	unsigned int threatIndex=0;
+	if ((!inThreatWindow) && (_threatList.empty())) {
+		return;
+	}
+	bool alreadyExists = threatListContainsAgent(other.agent,threatIndex);
+
+	if (!alreadyExists) {
+		if (collisionPredicted) { // then these two agents are predicted to collide
+			if ((minTimeOfThreat < 0) && (maxTimeOfThreat > 0)) {
+				// this would imply that we already ARE in a collision!!
+				// TODO: what todo in this situation?
+				// note, we do not necessarily reach this code for ALL agent-agent collisions, because of scheduling phases.
+			}
+			else if ((minTimeOfThreat > _PPRParams.ped_threat_min_time_threshold) && (maxTimeOfThreat < _PPRParams.ped_threat_max_time_threshold)) {
+				//cerr << "NEW THREAT!!!\n";
+				PredictedThreat newThreat;
+				newThreat.maxTime = _currentTimeStamp + maxTimeOfThreat;
+				newThreat.originalMaxTime = _currentTimeStamp + maxTimeOfThreat;
+				newThreat.minTime = _currentTimeStamp + minTimeOfThreat;
+				newThreat.threatGuy = other.agent;
+				newThreat.threatType = PredictedThreat::THREAT_TYPE_UNKNOWN; // just in case, might help debugging;
+				newThreat.imminent = true;
+				newThreat.oncomingToRightSide = false;
+
+				float cosTheta = dot(_forward,other.forward);
+				if (cosTheta > _PPRParams.ped_similar_direction_dot_product_threshold) {
+					// otherGuy is facing a similar direction as you
+					// in the current implementation, this is not considered a 
+					// threat, and reactive steering handles it.
+				} 
+				else if (cosTheta < _PPRParams.ped_oncoming_prediction_threshold) {
+					// otherGuy is oncoming.
+					float whichSideOfTarget = directionToLocalTarget.x * (other.position.x-_localTargetLocation.x) + directionToLocalTarget.z * (other.position.z-_localTargetLocation.z);
+					float whichSideOfLocation = directionToLocalTarget.x * (other.position.x-position().x) + directionToLocalTarget.z * (other.position.z-position().z);
+					newThreat.threatType = PredictedThreat::THREAT_TYPE_ONCOMING;
+					if ((whichSideOfTarget<0.0f)&&(whichSideOfLocation>0.0f)) { // this checks if the agent is actually in-between you and your local target.
+						threatListChanged = true;
+						Vector dirToOtherGuy = other.position - _position;
+						if ((dot(dirToOtherGuy, _rightSide) > 0.0f) && (dot(-dirToOtherGuy,rightSideInXZPlane(other.forward)) > 0.0f))
+						{
+							newThreat.oncomingToRightSide = true;
+						}
+						_threatList.insert(newThreat);
+					}
+				}
+				else {
+					float my_t = 0.0f, his_t = 0.0f;
+					Ray myRay, hisRay, rayToOtherGuy;
+					myRay.initWithLengthInterval(_position, _forward);
+					hisRay.initWithLengthInterval(other.position,other.forward);
+					rayToOtherGuy.initWithLengthInterval( _position, other.position-position());
+					intersectTwoRays2D( myRay.pos, myRay.dir, my_t, hisRay.pos, hisRay.dir, his_t);
+
+					if (my_t < rayToOtherGuy.maxt) {  // if expected threat is actually further away than the agent, its not actually a threat.
+						float tempt1=0.0f, tempt2=0.0f;
+						// NOTE CAREFULLY: localTargetLocation-position() is correct here - it should not be normalized.
+						// intersectTwoRays2D(_position, _localTargetLocation - _position, tempt1, other.position, otherGuy->localTargetLocation() - other.position, tempt2);
+						intersectTwoRays2D(_position, _localTargetLocation - _position, tempt1, other.position, other.goalLocation - other.position, tempt2);
+						if ( (tempt1>0.0f) && (tempt1<1.0f) && (tempt2>0.0f) && (tempt2<1.0f) ) { // if paths actually cross - i.e. if its not a fake-out where the agent's goal is before the threat.
+							if (my_t < his_t) {
+								newThreat.threatType = PredictedThreat::THREAT_TYPE_CROSSING_SOON;
+								threatListChanged = true;
+								_threatList.insert(newThreat);
+								threat_min_t = min(minTimeOfThreat*_currentSpeed, threat_min_t);
+								threat_max_t = max(maxTimeOfThreat*_currentSpeed, threat_max_t);
+							}
+							else {
+								newThreat.threatType = PredictedThreat::THREAT_TYPE_CROSSING_LATE;
+								threatListChanged = true;
+								_threatList.insert(newThreat);
+								threat_min_t = min(minTimeOfThreat*_currentSpeed, threat_min_t);
+								threat_max_t = max(maxTimeOfThreat*_currentSpeed, threat_max_t);
+							}
+						}
+					}
+				}
+			} else {
+				// either threat is in the past, or its too far into the future.
+				// here, the threat it doesnt already exist, and here
+				// we the predicted intersection is outside of the time interval
+				// we care about, so don't worry about it this agent.
+			}
+		}
+		else {
+			// discriminant indicates no soln, which means no intersection predicted.
+		}
+	}
+	else {
+		// threat already existed, update it
+		if (collisionPredicted) { // then these two agents are predicted to collide
+			if ((minTimeOfThreat < 0) && (maxTimeOfThreat > 0)) {
+				// collided with a threat that we already predicted
+				// doh!
+			}
+			else if ((minTimeOfThreat > _PPRParams.ped_threat_min_time_threshold) && (maxTimeOfThreat < _PPRParams.ped_threat_max_time_threshold)) {
+				// still imminent, update the threat where it exists in the _threatList.
+				_threatList[threatIndex].maxTime = _currentTimeStamp + maxTimeOfThreat;
+				_threatList[threatIndex].minTime = _currentTimeStamp + minTimeOfThreat;
+				//cerr << "COLLISION IS STILL IMMINENT\n";
+				_threatList[threatIndex].imminent = true;
+				_threatList.update(threatIndex);
+			}
+			else {
+				// outside of the time interval we care about, so no longer imminent.
+				_threatList[threatIndex].imminent = false;
+			}
+		}
+		else {
+			// no intersection predicted, so no longer imminent.
+			_threatList[threatIndex].imminent = false;
+		}
+	}
+}
+
+
 //
 // runReactivePhase()
 //
@@ -1031,7 +1125,7 @@ void PPRAgent::runReactivePhase()
 		if (!_enabled) return;
 	}
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->reactivePhaseProfiler );
+	AutomaticFunctionProfiler profileThisFunction( phaseProfiler(_context->phaseProfilers.reactivePhaseProfiler) );
 
 	FeelerInfo feelers;
 
@@ -1729,13 +1823,13 @@ void PPRAgent::runReactivePhase()
 		}
 		_finalSteeringCommand.aimForTargetDirection = true;
 		_finalSteeringCommand.aimForTargetSpeed = true;
-		_finalSteeringCommand.targetSpeed = ped_typical_speed_factor*_currentGoal.desiredSpeed;
+		_finalSteeringCommand.targetSpeed = _context->parameters.ped_typical_speed_factor*_currentGoal.desiredSpeed;
 	}
 
 
 	_finalSteeringCommand.steeringMode = SteeringCommand::LOCOMOTION_MODE_COMMAND;
 
-	if (gUseDynamicPhaseScheduling) {
+	if (_context->useDynamicPhaseScheduling) {
 	
 		// potentially give a break to perception
 		if (hitSomething) {
@@ -1751,7 +1845,7 @@ void PPRAgent::runReactivePhase()
 		if (hitSomething) {
 			_framesToNextReactivePhase = 1;
 		}
-		else if (_neighbors.size() == 0) {
+		else if (!hasNeighbors()) {
 			_framesToNextReactivePhase = 4;
 		}
 		else if (_threatList.size() == 0) {
@@ -1773,7 +1867,7 @@ void PPRAgent::doSteering()
 	if (!_enabled) return;
 
 
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->steeringPhaseProfiler );
+	AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.steeringPhaseProfiler );
 
 	switch ( _finalSteeringCommand.steeringMode) {
 		case SteeringCommand::LOCOMOTION_MODE_COMMAND:
@@ -1813,7 +1907,7 @@ void PPRAgent::doEulerStepWithForce(const Vector & force)
 	// update the database with the new agent's setup
 	AxisAlignedBox oldBounds = AxisAlignedBox(_position.x - _radius, _position.x + _radius, 0.0f, 0.0f, _position.z - _radius, _position.z + _radius);
 	AxisAlignedBox newBounds = AxisAlignedBox(newPosition.x - _radius, newPosition.x + _radius, 0.0f, 0.0f, newPosition.z - _radius, newPosition.z + _radius);
-	gSpatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
+	_spatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
 
 	_position = newPosition;
 }
@@ -1954,12 +2048,22 @@ void PPRAgent::doCommandBasedSteering()
 void PPRAgent::collectObjectsInVisualField()
 {
 	_neighbors.clear();
-	gSpatialDatabase->getItemsInVisualField(_neighbors, _position.x-_PPRParams.ped_query_radius, _position.x+_PPRParams.ped_query_radius,
+	_spatialDatabase->getItemsInVisualField(_neighbors, _position.x-_PPRParams.ped_query_radius, _position.x+_PPRParams.ped_query_radius,
 		_position.z-_PPRParams.ped_query_radius, _position.z+_PPRParams.ped_query_radius, dynamic_cast<SpatialDatabaseItemPtr>(this),
 		_position, _forward, (float)(_PPRParams.ped_query_radius*_PPRParams.ped_query_radius));
 }
 
 
+//
+// collectAgentsFromSnapshot() - the perceptive phase of the "batch" mode, which queries the module's snapshot of this frame instead of the spatial database.
+//
+void PPRAgent::collectAgentsFromSnapshot(unsigned int currentFrameNumber)
+{
+	_perceivedObstacles = _context->perception->collectAgentsInVisualField(this, _position, _forward, _PPRParams.ped_query_radius, _perceivedAgents);
+	_lastFramePerceivedInBatch = currentFrameNumber;
+}
+
+
 //
 // reachedCurrentGoal()
 //
@@ -2004,21 +2108,6 @@ bool PPRAgent::reachedLocalTarget()
 }
 
 
-//
-// threatListContainsAgent()
-//
-bool PPRAgent::threatListContainsAgent(SteerLib::AgentInterface * agent, unsigned int & index)
-{
-	for (unsigned int i=0; i < _threatList.size(); i++) {
-		if (_threatList[i].threatGuy == agent) {
-			index = i;
-			return true;
-		}
-	}
-	return false;
-}
-
-
 //
 // 	updateReactiveFeelers()
 //
@@ -2032,18 +2121,32 @@ bool PPRAgent::updateReactiveFeelers( FeelerInfo & feelers )
 
 	// Adjusting feeler length to compensate for issues with pprAI not being able to choose which direction to turn and
 	// proceeding through an obstacle. SHould make these parameters.
-	myRay.initWithLengthInterval(_position, _forward * (_PPRParams.ped_typical_speed*ped_reactive_anticipation_factor) * 1.1f);
+	myRay.initWithLengthInterval(_position, _forward * (_PPRParams.ped_typical_speed*_context->parameters.ped_reactive_anticipation_factor) * 1.1f);
 	myRightRay.initWithLengthInterval( _position + _radius * _rightSide ,  ((_forward * 0.75f) + 0.1f*_rightSide)* (_PPRParams.ped_typical_speed*_PPRParams.ped_reactive_anticipation_factor));
 	myLeftRay.initWithLengthInterval( _position - _radius * _rightSide,  ((_forward * 0.75f) - 0.1f*_rightSide)* (_PPRParams.ped_typical_speed*_PPRParams.ped_reactive_anticipation_factor));
 	myRSideRay.initWithLengthInterval( _position + _radius * _rightSide,  (0.05f * _forward + 0.1f * _rightSide)* (_PPRParams.ped_typical_speed*_PPRParams.ped_reactive_anticipation_factor));
 	myLSideRay.initWithLengthInterval( _position - _radius * _rightSide,  (0.05f * _forward - 0.1f * _rightSide)* (_PPRParams.ped_typical_speed*_PPRParams.ped_reactive_anticipation_factor));
 
-	SpatialDatabaseItemPtr me = dynamic_cast<SpatialDatabaseItemPtr>(this);
-	gSpatialDatabase->trace(myRay,      feelers.t_front, feelers.object_front, me, false);
-	gSpatialDatabase->trace(myRightRay, feelers.t_right, feelers.object_right, me, false);
-	gSpatialDatabase->trace(myLeftRay,  feelers.t_left,  feelers.object_left,  me, false);
-	gSpatialDatabase->trace(myRSideRay, feelers.t_rside, feelers.object_rside, me, false);
-	gSpatialDatabase->trace(myLSideRay, feelers.t_lside, feelers.object_lside, me, false);
+	if (_context->perception != NULL) {
+		// the "batch" mode traces all feelers at once against the module's snapshot.
+		Ray rays[5] = { myRay, myRightRay, myLeftRay, myRSideRay, myLSideRay };
+		float t[5];
+		SpatialDatabaseItemPtr objects[5];
+		_context->perception->traceFeelers(this, rays, 5, t, objects);
+		feelers.t_front = t[0];  feelers.object_front = objects[0];
+		feelers.t_right = t[1];  feelers.object_right = objects[1];
+		feelers.t_left  = t[2];  feelers.object_left  = objects[2];
+		feelers.t_rside = t[3];  feelers.object_rside = objects[3];
+		feelers.t_lside = t[4];  feelers.object_lside = objects[4];
+	}
+	else {
+		SpatialDatabaseItemPtr me = dynamic_cast<SpatialDatabaseItemPtr>(this);
+		_spatialDatabase->trace(myRay,      feelers.t_front, feelers.object_front, me, false);
+		_spatialDatabase->trace(myRightRay, feelers.t_right, feelers.object_right, me, false);
+		_spatialDatabase->trace(myLeftRay,  feelers.t_left,  feelers.object_left,  me, false);
+		_spatialDatabase->trace(myRSideRay, feelers.t_rside, feelers.object_rside, me, false);
+		_spatialDatabase->trace(myLSideRay, feelers.t_lside, feelers.object_lside, me, false);
+	}
 
 #ifdef USE_ANNOTATIONS
 	__myRay = myRay;
@@ -2080,7 +2183,7 @@ void PPRAgent::disable()
 
 	//  1. remove from database
 	AxisAlignedBox b = AxisAlignedBox(_position.x - _radius, _position.x + _radius, 0.0f, 0.0f, _position.z - _radius, _position.z + _radius);
-	gSpatialDatabase->removeObject(dynamic_cast<SpatialDatabaseItemPtr>(this), b);
+	_spatialDatabase->removeObject(dynamic_cast<SpatialDatabaseItemPtr>(this), b);
 
 	//  2. set enabled = false
 	_enabled = false;
@@ -2110,10 +2213,10 @@ void PPRAgent::drawPlannedPath()
 		for (unsigned int i=0; i < longTermPath.size() - 1; i++) {
 			Vector xOffset,zOffset;
 			Point center,nextCenter;
-			xOffset.x = 0.5f * gSpatialDatabase->getCellSizeX();
-			zOffset.z = 0.5f * gSpatialDatabase->getCellSizeZ();
-			gSpatialDatabase->getLocationFromIndex(longTermPath._Get_container()[i], center); // DOes not work on LInux
-			gSpatialDatabase->getLocationFromIndex(longTermPath._Get_container()[i+1], nextCenter);
+			xOffset.x = 0.5f * _spatialDatabase->getCellSizeX();
+			zOffset.z = 0.5f * _spatialDatabase->getCellSizeZ();
+			_spatialDatabase->getLocationFromIndex(longTermPath._Get_container()[i], center); // DOes not work on LInux
+			_spatialDatabase->getLocationFromIndex(longTermPath._Get_container()[i+1], nextCenter);
 			center.y = 0.01f;
 			nextCenter.y = 0.01f;
 			DrawLib::glColor(gDarkBlue);
@@ -2139,10 +2242,10 @@ void PPRAgent::drawPlannedPath()
 		for (unsigned int i=0; i < longTermPath.size() - 1; i++) {
 			Vector xOffset,zOffset;
 			Point center,nextCenter;
-			xOffset.x = 0.5f * gSpatialDatabase->getCellSizeX();
-			zOffset.z = 0.5f * gSpatialDatabase->getCellSizeZ();
-			gSpatialDatabase->getLocationFromIndex(ltpath->at(i), center);
-			gSpatialDatabase->getLocationFromIndex(ltpath->at(i+1), nextCenter);
+			xOffset.x = 0.5f * _spatialDatabase->getCellSizeX();
+			zOffset.z = 0.5f * _spatialDatabase->getCellSizeZ();
+			_spatialDatabase->getLocationFromIndex(ltpath->at(i), center);
+			_spatialDatabase->getLocationFromIndex(ltpath->at(i+1), nextCenter);
 			center.y = 0.01f;
 			nextCenter.y = 0.01f;
 			DrawLib::glColor(gDarkBlue);
@@ -2163,10 +2266,10 @@ void PPRAgent::drawPlannedPath()
 		for (unsigned int i=0; i < _midTermPathSize - 1; i++) {
 			Vector xOffset,zOffset;
 			Point center,nextCenter;
-			xOffset.x = 0.5f * gSpatialDatabase->getCellSizeX();
-			zOffset.z = 0.5f * gSpatialDatabase->getCellSizeZ();
-			gSpatialDatabase->getLocationFromIndex(_midTermPath[i], center);
-			gSpatialDatabase->getLocationFromIndex(_midTermPath[i+1], nextCenter);
+			xOffset.x = 0.5f * _spatialDatabase->getCellSizeX();
+			zOffset.z = 0.5f * _spatialDatabase->getCellSizeZ();
+			_spatialDatabase->getLocationFromIndex(_midTermPath[i], center);
+			_spatialDatabase->getLocationFromIndex(_midTermPath[i+1], nextCenter);
 			center.y = 0.02f;
 			nextCenter.y = 0.02f;
 			DrawLib::glColor(gBlue);
@@ -2176,7 +2279,7 @@ void PPRAgent::drawPlannedPath()
 
 	// draw a marker on the closest node you are to the mid-term path (computed from short-term planning)
 	Point closestNodeOnPath;
-	gSpatialDatabase->getLocationFromIndex(_midTermPath[__closestPathNode],closestNodeOnPath);
+	_spatialDatabase->getLocationFromIndex(_midTermPath[__closestPathNode],closestNodeOnPath);
 	DrawLib::drawHighlight(closestNodeOnPath + Util::Vector(0, -0.25, 0), Vector(1.0f, 0.0f, 0.0f), 0.5f, gBlue);
 	//drawXZCircle(0.30f, closestNodeOnPath, gBlue, 10);
 
@@ -2201,7 +2304,7 @@ void PPRAgent::draw()
 
 #ifdef ENABLE_GUI
 	if (!_enabled) return;
-	AutomaticFunctionProfiler profileThisFunction( &PPRGlobals::gPhaseProfilers->drawProfiler );
+	AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.drawProfiler );
 
 	/*
 	std::cout << "max speed is " << _PPRParams.ped_max_speed << " and quert radius is " <<
@@ -2307,6 +2410,9 @@ void PPRAgent::draw()
 		//for (unsigned int i=0; i<_neighbors.size(); i++) {
 			if ((*neighbor)->isAgent()) DrawLib::drawLine(_position + verticalOffset, AGENT_PTR((*neighbor))->position() + verticalOffset);
 		}
+		for (unsigned int i=0; i<_perceivedAgents.size(); i++) {
+			DrawLib::drawLine(_position + verticalOffset, _perceivedAgents[i].agent->position() + verticalOffset);
+		}
 		drawPlannedPath();
 
 		// draw lines from sides to local goal:
@@ -2326,7 +2432,7 @@ void PPRAgent::draw()
 #endif  // ifndef USE_ANNOTATIONS
 	// Draw collisions when they happen.
 	std::set<SteerLib::SpatialDatabaseItemPtr> __neighbors;
-	gSpatialDatabase->getItemsInRange(__neighbors, this->position().x-(this->_radius * 3), this->position().x+(this->_radius * 3),
+	_spatialDatabase->getItemsInRange(__neighbors, this->position().x-(this->_radius * 3), this->position().x+(this->_radius * 3),
 			this->position().z-(this->_radius * 3), this->position().z+(this->_radius * 3), dynamic_cast<SpatialDatabaseItemPtr>(this));
 
 	for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbor = __neighbors.begin();  neighbor != __neighbors.end();  neighbor++)
@@ -0,0 +1,542 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+/// @file PPRPerception.cpp
+/// @brief Implements the PPRPerception class.
+
+#include <algorithm>
+#include <cmath>
+#include "PPRPerception.h"
+
+using namespace Util;
+using namespace SteerLib;
+
+// the largest number of grid cells along each axis of the agent snapshot.
+#define MAX_BINS_PER_AXIS 256
+
+// the number of agents or boxes the feeler kernels test at a time; a multiple of 4.
+#define FEELER_CHUNK_SIZE 64
+
+// SSE2 is part of every x86-64 processor, so the feeler kernels need no run-time check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PPR_FEELERS_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+	struct NeighborPointerLess {
+		bool operator()(const PerceivedNeighbor & a, const PerceivedNeighbor & b) const { return a.agent < b.agent; }
+	};
+
+
+	//
+	// The feeler kernels.  Both compute exactly what Util::rayIntersectsCircle2D() and Util::rayIntersectsBox2D() compute,
+	// operation for operation, so that the hits are the same as GridDatabase2D::trace(); the vector version only needs
+	// IEEE single precision, which SSE2 is.  A hit replaces the closest one so far only if it is strictly closer, as in trace().
+	//
+
+	inline void keepClosestHit(float hitT, SteerLib::SpatialDatabaseItemPtr item, float & t, SteerLib::SpatialDatabaseItemPtr & hitObject)
+	{
+		if (hitT < t) {
+			t = hitT;
+			hitObject = item;
+		}
+	}
+
+	// the ray parameter of the hit with a circle, or INFINITY.
+	inline float traceCircle(const Util::Ray & r, float centerX, float centerZ, float radius)
+	{
+		float A = r.dir.x*r.dir.x + r.dir.z*r.dir.z;
+		float diffX = r.pos.x - centerX;
+		float diffZ = r.pos.z - centerZ;
+		float B = 2.0f * (r.dir.x*diffX + r.dir.z*diffZ);
+		float C = (diffX*diffX + diffZ*diffZ) - radius*radius;
+		float discrim = (B*B - 4*A*C);
+		if (discrim < 0.0f) return INFINITY;
+		float sqrtDiscrim = sqrtf(discrim);
+		float t0 = (-B - sqrtDiscrim) / (2.0f*A);
+		float t1 = (-B + sqrtDiscrim) / (2.0f*A);
+		if ((t0 > r.mint) && (t0 < r.maxt)) return t0;
+		if ((t1 > r.mint) && (t1 < r.maxt)) return t1;
+		return INFINITY;
+	}
+
+	// the ray parameter of the hit with an axis-aligned box, or INFINITY.
+	inline float traceBox(const Util::Ray & r, float xmin, float xmax, float zmin, float zmax)
+	{
+		float t;
+		return Util::rayIntersectsBox2D(xmin, xmax, zmin, zmax, r, t) ? t : INFINITY;
+	}
+
+	void traceCircles(const Util::Ray * rays, unsigned int numRays, const float * centerX, const float * centerZ, const float * radius,
+		SteerLib::SpatialDatabaseItemPtr const * items, unsigned int count, float * t, SteerLib::SpatialDatabaseItemPtr * hitObjects)
+	{
+		for (unsigned int r = 0; r < numRays; r++) {
+			const Util::Ray & ray = rays[r];
+			unsigned int i = 0;
+#ifdef PPR_FEELERS_USE_SSE2
+			// the dot products are 2D because all rays and agents lie in the y = 0 plane, where they equal Util::dot().
+			const float A = ray.dir.x*ray.dir.x + ray.dir.z*ray.dir.z;
+			const __m128 dirX = _mm_set1_ps(ray.dir.x);
+			const __m128 dirZ = _mm_set1_ps(ray.dir.z);
+			const __m128 posX = _mm_set1_ps(ray.pos.x);
+			const __m128 posZ = _mm_set1_ps(ray.pos.z);
+			const __m128 twoA = _mm_set1_ps(2.0f*A);
+			const __m128 fourA = _mm_set1_ps(4*A);
+			const __m128 mint = _mm_set1_ps(ray.mint);
+			const __m128 maxt = _mm_set1_ps(ray.maxt);
+			const __m128 infinity = _mm_set1_ps(INFINITY);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 signBit = _mm_set1_ps(-0.0f);
+			float laneT[4];
+			for (; i + 4 <= count; i += 4) {
+				__m128 diffX = _mm_sub_ps(posX, _mm_loadu_ps(centerX + i));
+				__m128 diffZ = _mm_sub_ps(posZ, _mm_loadu_ps(centerZ + i));
+				__m128 radii = _mm_loadu_ps(radius + i);
+				__m128 B = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_add_ps(_mm_mul_ps(dirX, diffX), _mm_mul_ps(dirZ, diffZ)));
+				__m128 C = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffZ, diffZ)), _mm_mul_ps(radii, radii));
+				__m128 discrim = _mm_sub_ps(_mm_mul_ps(B, B), _mm_mul_ps(fourA, C));
+				__m128 sqrtDiscrim = _mm_sqrt_ps(discrim);
+				__m128 minusB = _mm_xor_ps(B, signBit);
+				__m128 t0 = _mm_div_ps(_mm_sub_ps(minusB, sqrtDiscrim), twoA);
+				__m128 t1 = _mm_div_ps(_mm_add_ps(minusB, sqrtDiscrim), twoA);
+				__m128 t0Valid = _mm_and_ps(_mm_cmpgt_ps(t0, mint), _mm_cmplt_ps(t0, maxt));
+				__m128 t1Valid = _mm_and_ps(_mm_cmpgt_ps(t1, mint), _mm_cmplt_ps(t1, maxt));
+				__m128 hit = _mm_or_ps(_mm_and_ps(t1Valid, t1), _mm_andnot_ps(t1Valid, infinity));
+				hit = _mm_or_ps(_mm_and_ps(t0Valid, t0), _mm_andnot_ps(t0Valid, hit));
+				__m128 noHit = _mm_cmplt_ps(discrim, zero);
+				hit = _mm_or_ps(_mm_and_ps(noHit, infinity), _mm_andnot_ps(noHit, hit));
+				if (_mm_movemask_ps(_mm_cmplt_ps(hit, infinity)) == 0) continue;
+				_mm_storeu_ps(laneT, hit);
+				for (unsigned int lane = 0; lane < 4; lane++) {
+					keepClosestHit(laneT[lane], items[i + lane], t[r], hitObjects[r]);
+				}
+			}
+#endif
+			for (; i < count; i++) {
+				keepClosestHit(traceCircle(ray, centerX[i], centerZ[i], radius[i]), items[i], t[r], hitObjects[r]);
+			}
+		}
+	}
+
+	// the near and far parameters of one slab, with the same handling of NaN (a ray parallel to a slab face) as rayIntersectsBox2D().
+#ifdef PPR_FEELERS_USE_SSE2
+	inline void clipSlab(__m128 tnear, __m128 tfar, __m128 & mint, __m128 & maxt)
+	{
+		__m128 swapped = _mm_cmpgt_ps(tnear, tfar);
+		__m128 lo = _mm_or_ps(_mm_and_ps(swapped, tfar), _mm_andnot_ps(swapped, tnear));
+		__m128 hi = _mm_or_ps(_mm_and_ps(swapped, tnear), _mm_andnot_ps(swapped, tfar));
+		__m128 raiseMin = _mm_cmpgt_ps(lo, mint);
+		mint = _mm_or_ps(_mm_and_ps(raiseMin, lo), _mm_andnot_ps(raiseMin, mint));
+		__m128 lowerMax = _mm_cmplt_ps(hi, maxt);
+		maxt = _mm_or_ps(_mm_and_ps(lowerMax, hi), _mm_andnot_ps(lowerMax, maxt));
+	}
+#endif
+
+	void traceBoxes(const Util::Ray * rays, unsigned int numRays, const float * xmin, const float * xmax, const float * zmin, const float * zmax,
+		SteerLib::SpatialDatabaseItemPtr const * items, unsigned int count, float * t, SteerLib::SpatialDatabaseItemPtr * hitObjects)
+	{
+		for (unsigned int r = 0; r < numRays; r++) {
+			const Util::Ray & ray = rays[r];
+			unsigned int i = 0;
+#ifdef PPR_FEELERS_USE_SSE2
+			const __m128 posX = _mm_set1_ps(ray.pos.x);
+			const __m128 posZ = _mm_set1_ps(ray.pos.z);
+			const __m128 invRayDirX = _mm_set1_ps(1.0f / ray.dir.x);
+			const __m128 invRayDirZ = _mm_set1_ps(1.0f / ray.dir.z);
+			const __m128 infinity = _mm_set1_ps(INFINITY);
+			float laneT[4];
+			for (; i + 4 <= count; i += 4) {
+				__m128 mint = _mm_set1_ps(ray.mint);
+				__m128 maxt = _mm_set1_ps(ray.maxt);
+				clipSlab(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xmin + i), posX), invRayDirX), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xmax + i), posX), invRayDirX), mint, maxt);
+				__m128 missX = _mm_cmpgt_ps(mint, maxt);
+				clipSlab(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(zmin + i), posZ), invRayDirZ), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(zmax + i), posZ), invRayDirZ), mint, maxt);
+				__m128 miss = _mm_or_ps(missX, _mm_cmpgt_ps(mint, maxt));
+				__m128 hit = _mm_or_ps(_mm_and_ps(miss, infinity), _mm_andnot_ps(miss, mint));
+				if (_mm_movemask_ps(_mm_cmplt_ps(hit, infinity)) == 0) continue;
+				_mm_storeu_ps(laneT, hit);
+				for (unsigned int lane = 0; lane < 4; lane++) {
+					keepClosestHit(laneT[lane], items[i + lane], t[r], hitObjects[r]);
+				}
+			}
+#endif
+			for (; i < count; i++) {
+				keepClosestHit(traceBox(ray, xmin[i], xmax[i], zmin[i], zmax[i]), items[i], t[r], hitObjects[r]);
+			}
+		}
+	}
+}
+
+
+PPRPerception::PPRPerception()
+{
+	_spatialDatabase = NULL;
+	_binSize = 1.0f;
+	_binOriginX = _binOriginZ = 0.0f;
+	_numBinsX = _numBinsZ = 0;
+	_maxAgentRadius = 0.0f;
+}
+
+
+void PPRPerception::clear()
+{
+	_spatialDatabase = NULL;
+	_agents.clear();
+	_sortedAgents.clear();
+	_binAgents.clear();
+	_binStart.clear();
+	_numBinsX = _numBinsZ = 0;
+	_maxAgentRadius = 0.0f;
+	_obstacleCellSums.clear();
+	_obstacles.clear();
+	_obstacleIsBox.clear();
+	_obstacleXMin.clear();
+	_obstacleXMax.clear();
+	_obstacleZMin.clear();
+	_obstacleZMax.clear();
+	_binObstacleIndices.clear();
+	_binObstacleStart.clear();
+}
+
+
+bool PPRPerception::_getCellRange(float minValue, float maxValue, float origin, float gridSize, unsigned int numCells, unsigned int & minIndex, unsigned int & maxIndex) const
+{
+	// the same comparisons as GridDatabase2D::_clampSpatialBoundsToIndexRange(), so a range that only touches the edge of the grid is outside it.
+	if ((maxValue <= origin) || (minValue >= origin + gridSize)) {
+		return false;
+	}
+	float cellsPerUnit = numCells / gridSize;
+	minIndex = (minValue < origin) ? 0 : std::min(numCells - 1, (unsigned int)floorf((minValue - origin) * cellsPerUnit));
+	if (maxValue >= origin + gridSize) {
+		maxIndex = numCells - 1;
+	}
+	else {
+		int index = (int)ceilf((maxValue - origin) * cellsPerUnit) - 1;
+		maxIndex = (unsigned int)std::max((int)minIndex, index);
+	}
+	return true;
+}
+
+
+unsigned int PPRPerception::_getBin(float value, float origin, unsigned int numBins) const
+{
+	float bin = floorf((value - origin) / _binSize);
+	if (bin < 0.0f) return 0;
+	if (bin >= (float)numBins) return numBins - 1;
+	return (unsigned int)bin;
+}
+
+
+void PPRPerception::buildObstacles(const std::set<SteerLib::ObstacleInterface*> & obstacles, SteerLib::GridDatabase2D * spatialDatabase)
+{
+	unsigned int numCellsX = spatialDatabase->getNumCellsX();
+	unsigned int numCellsZ = spatialDatabase->getNumCellsZ();
+	std::vector<unsigned char> hasObstacle(numCellsX * numCellsZ, 0);
+
+	_obstacles.clear();
+	_obstacleIsBox.clear();
+	_obstacleXMin.clear();
+	_obstacleXMax.clear();
+	_obstacleZMin.clear();
+	_obstacleZMax.clear();
+	// binned by the next update(), once the grid of the snapshot is known.
+	_binObstacleStart.clear();
+
+	for (std::set<SteerLib::ObstacleInterface*>::const_iterator iter = obstacles.begin(); iter != obstacles.end(); ++iter) {
+		const Util::AxisAlignedBox & bounds = (*iter)->getBounds();
+		_obstacles.push_back(*iter);
+		_obstacleIsBox.push_back(dynamic_cast<SteerLib::BoxObstacle*>(*iter) != NULL);
+		_obstacleXMin.push_back(bounds.xmin);
+		_obstacleXMax.push_back(bounds.xmax);
+		_obstacleZMin.push_back(bounds.zmin);
+		_obstacleZMax.push_back(bounds.zmax);
+
+		unsigned int xMin, xMax, zMin, zMax;
+		if (!_getCellRange(bounds.xmin, bounds.xmax, spatialDatabase->getOriginX(), spatialDatabase->getGridSizeX(), numCellsX, xMin, xMax) ||
+			!_getCellRange(bounds.zmin, bounds.zmax, spatialDatabase->getOriginZ(), spatialDatabase->getGridSizeZ(), numCellsZ, zMin, zMax)) {
+			continue;
+		}
+		for (unsigned int x = xMin; x <= xMax; x++) {
+			for (unsigned int z = zMin; z <= zMax; z++) {
+				hasObstacle[x * numCellsZ + z] = 1;
+			}
+		}
+	}
+
+	// _obstacleCellSums[x * (numCellsZ+1) + z] is the number of cells with obstacles in [0,x) x [0,z).
+	_obstacleCellSums.assign((numCellsX + 1) * (numCellsZ + 1), 0);
+	for (unsigned int x = 1; x <= numCellsX; x++) {
+		for (unsigned int z = 1; z <= numCellsZ; z++) {
+			_obstacleCellSums[x * (numCellsZ + 1) + z] = hasObstacle[(x-1) * numCellsZ + (z-1)]
+				+ _obstacleCellSums[(x-1) * (numCellsZ + 1) + z]
+				+ _obstacleCellSums[x * (numCellsZ + 1) + (z-1)]
+				- _obstacleCellSums[(x-1) * (numCellsZ + 1) + (z-1)];
+		}
+	}
+}
+
+
+void PPRPerception::update(const std::vector<SteerLib::AgentInterface*> & agents, SteerLib::GridDatabase2D * spatialDatabase, float cellSize)
+{
+	_spatialDatabase = spatialDatabase;
+
+	//
+	// copy the state of all agents; disabled agents keep their slot, so that indices do not shift when agents finish.
+	//
+	_agents.resize(agents.size());
+	_sortedAgents.resize(agents.size());
+	for (unsigned int i = 0; i < agents.size(); i++) {
+		SteerLib::AgentInterface * agent = agents[i];
+		PerceivedAgent & state = _agents[i];
+		state.agent = agent;
+		state.enabled = agent->enabled();
+		if (state.enabled) {
+			state.id = agent->id();
+			state.position = agent->position();
+			state.velocity = agent->velocity();
+			state.forward = agent->forward();
+			state.goalLocation = agent->currentGoal().targetLocation;
+			state.radius = agent->radius();
+		}
+		_sortedAgents[i] = std::make_pair(agent, i);
+	}
+	std::sort(_sortedAgents.begin(), _sortedAgents.end());
+
+	//
+	// bin the enabled agents into a grid over the spatial database, with a counting sort.
+	//
+	float gridSizeX = spatialDatabase->getGridSizeX();
+	float gridSizeZ = spatialDatabase->getGridSizeZ();
+	_binSize = std::max(cellSize, std::max(gridSizeX, gridSizeZ) / MAX_BINS_PER_AXIS);
+	_binOriginX = spatialDatabase->getOriginX();
+	_binOriginZ = spatialDatabase->getOriginZ();
+	_numBinsX = std::max(1u, (unsigned int)ceilf(gridSizeX / _binSize));
+	_numBinsZ = std::max(1u, (unsigned int)ceilf(gridSizeZ / _binSize));
+
+	_maxAgentRadius = 0.0f;
+	_binStart.assign(_numBinsX * _numBinsZ + 1, 0);
+	for (unsigned int i = 0; i < _agents.size(); i++) {
+		if (!_agents[i].enabled) continue;
+		_maxAgentRadius = std::max(_maxAgentRadius, _agents[i].radius);
+		unsigned int bin = _getBin(_agents[i].position.x, _binOriginX, _numBinsX) * _numBinsZ + _getBin(_agents[i].position.z, _binOriginZ, _numBinsZ);
+		_binStart[bin + 1]++;
+	}
+	for (unsigned int bin = 0; bin < _numBinsX * _numBinsZ; bin++) {
+		_binStart[bin + 1] += _binStart[bin];
+	}
+	_binAgents.resize(_binStart.back());
+	std::vector<unsigned int> nextSlot(_binStart.begin(), _binStart.end() - 1);
+	for (unsigned int i = 0; i < _agents.size(); i++) {
+		if (!_agents[i].enabled) continue;
+		unsigned int bin = _getBin(_agents[i].position.x, _binOriginX, _numBinsX) * _numBinsZ + _getBin(_agents[i].position.z, _binOriginZ, _numBinsZ);
+		_binAgents[nextSlot[bin]++] = i;
+	}
+
+	// the grid only changes with the spatial database, so the obstacles are binned on the first frame of a simulation.
+	if (_binObstacleStart.size() != _numBinsX * _numBinsZ + 1) {
+		_binObstacles();
+	}
+}
+
+
+void PPRPerception::_binObstacles()
+{
+	unsigned int numBins = _numBinsX * _numBinsZ;
+	_binObstacleStart.assign(numBins + 1, 0);
+	for (int pass = 0; pass < 2; pass++) {
+		// the first pass counts the obstacles of each cell, the second one fills them in.
+		std::vector<unsigned int> nextSlot;
+		if (pass == 1) {
+			for (unsigned int bin = 0; bin < numBins; bin++) {
+				_binObstacleStart[bin + 1] += _binObstacleStart[bin];
+			}
+			_binObstacleIndices.resize(_binObstacleStart.back());
+			nextSlot.assign(_binObstacleStart.begin(), _binObstacleStart.end() - 1);
+		}
+		for (unsigned int k = 0; k < _obstacles.size(); k++) {
+			unsigned int xMin = _getBin(_obstacleXMin[k], _binOriginX, _numBinsX);
+			unsigned int xMax = _getBin(_obstacleXMax[k], _binOriginX, _numBinsX);
+			unsigned int zMin = _getBin(_obstacleZMin[k], _binOriginZ, _numBinsZ);
+			unsigned int zMax = _getBin(_obstacleZMax[k], _binOriginZ, _numBinsZ);
+			for (unsigned int x = xMin; x <= xMax; x++) {
+				for (unsigned int bin = x * _numBinsZ + zMin; bin <= x * _numBinsZ + zMax; bin++) {
+					if (pass == 0) {
+						_binObstacleStart[bin + 1]++;
+					}
+					else {
+						_binObstacleIndices[nextSlot[bin]++] = k;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+bool PPRPerception::collectAgentsInVisualField(SteerLib::AgentInterface * self, const Util::Point & position, const Util::Vector & facingDirection, float radius,
+	std::vector<PerceivedNeighbor> & neighbors) const
+{
+	neighbors.clear();
+	if (_numBinsX == 0) {
+		return false;
+	}
+
+	float radiusSquared = radius * radius;
+	unsigned int xMin = _getBin(position.x - radius, _binOriginX, _numBinsX);
+	unsigned int xMax = _getBin(position.x + radius, _binOriginX, _numBinsX);
+	unsigned int zMin = _getBin(position.z - radius, _binOriginZ, _numBinsZ);
+	unsigned int zMax = _getBin(position.z + radius, _binOriginZ, _numBinsZ);
+
+	for (unsigned int x = xMin; x <= xMax; x++) {
+		for (unsigned int bin = x * _numBinsZ + zMin; bin <= x * _numBinsZ + zMax; bin++) {
+			for (unsigned int k = _binStart[bin]; k < _binStart[bin + 1]; k++) {
+				const PerceivedAgent & other = _agents[_binAgents[k]];
+				if (other.agent == self)
+					continue;
+
+				// (1) if the agent is outside of the radius of the visual field, then forget it
+				Util::Vector directionToOtherAgent = other.position - position;
+				if (directionToOtherAgent.lengthSquared() > radiusSquared)
+					continue;
+
+				// (2) check whether the agent is in front of us; only the sign of the cosine matters, so nothing is normalized.
+				if (dot(directionToOtherAgent, facingDirection) < 0.0f)
+					continue;
+
+				// (3) line-of-sight, the most expensive check.
+				if (!_spatialDatabase->hasLineOfSight(position, other.position, other.agent, self))
+					continue;
+
+				PerceivedNeighbor neighbor;
+				neighbor.agent = other.agent;
+				neighbor.index = _binAgents[k];
+				neighbors.push_back(neighbor);
+			}
+		}
+	}
+	std::sort(neighbors.begin(), neighbors.end(), NeighborPointerLess());
+
+	if (_obstacleCellSums.empty()) {
+		return false;
+	}
+	unsigned int numCellsX = _spatialDatabase->getNumCellsX();
+	unsigned int numCellsZ = _spatialDatabase->getNumCellsZ();
+	unsigned int cellXMin, cellXMax, cellZMin, cellZMax;
+	if (!_getCellRange(position.x - radius, position.x + radius, _spatialDatabase->getOriginX(), _spatialDatabase->getGridSizeX(), numCellsX, cellXMin, cellXMax) ||
+		!_getCellRange(position.z - radius, position.z + radius, _spatialDatabase->getOriginZ(), _spatialDatabase->getGridSizeZ(), numCellsZ, cellZMin, cellZMax)) {
+		return false;
+	}
+	unsigned int rowLength = numCellsZ + 1;
+	unsigned int numCellsWithObstacles = _obstacleCellSums[(cellXMax+1) * rowLength + (cellZMax+1)] - _obstacleCellSums[cellXMin * rowLength + (cellZMax+1)]
+		- _obstacleCellSums[(cellXMax+1) * rowLength + cellZMin] + _obstacleCellSums[cellXMin * rowLength + cellZMin];
+	return (numCellsWithObstacles > 0);
+}
+
+
+const PerceivedAgent * PPRPerception::findAgent(PerceivedNeighbor & neighbor) const
+{
+	if ((neighbor.index < _agents.size()) && (_agents[neighbor.index].agent == neighbor.agent)) {
+		return &_agents[neighbor.index];
+	}
+
+	std::vector< std::pair<SteerLib::AgentInterface*, unsigned int> >::const_iterator found =
+		std::lower_bound(_sortedAgents.begin(), _sortedAgents.end(), std::make_pair(neighbor.agent, 0u));
+	if ((found == _sortedAgents.end()) || (found->first != neighbor.agent)) {
+		return NULL;
+	}
+	neighbor.index = found->second;
+	return &_agents[neighbor.index];
+}
+
+
+void PPRPerception::traceFeelers(SteerLib::AgentInterface * self, const Util::Ray * rays, unsigned int numRays, float * t, SteerLib::SpatialDatabaseItemPtr * hitObjects) const
+{
+	for (unsigned int r = 0; r < numRays; r++) {
+		t[r] = INFINITY;
+		hitObjects[r] = NULL;
+	}
+	// trace() finds nothing for a ray that starts outside the spatial database; feelers all start next to the agent.
+	if ((_numBinsX == 0) || (numRays == 0) || (_spatialDatabase->getCellIndexFromLocation(rays[0].pos.x, rays[0].pos.z) == -1)) {
+		return;
+	}
+
+	// the box around all rays, grown by the largest agent radius so that it holds the center of every agent a ray can hit.
+	float xmin = INFINITY, xmax = -INFINITY, zmin = INFINITY, zmax = -INFINITY;
+	for (unsigned int r = 0; r < numRays; r++) {
+		Util::Point end = rays[r].eval(rays[r].maxt);
+		xmin = std::min(xmin, std::min(rays[r].pos.x, end.x));
+		xmax = std::max(xmax, std::max(rays[r].pos.x, end.x));
+		zmin = std::min(zmin, std::min(rays[r].pos.z, end.z));
+		zmax = std::max(zmax, std::max(rays[r].pos.z, end.z));
+	}
+	unsigned int xMinBin = _getBin(xmin - _maxAgentRadius, _binOriginX, _numBinsX);
+	unsigned int xMaxBin = _getBin(xmax + _maxAgentRadius, _binOriginX, _numBinsX);
+	unsigned int zMinBin = _getBin(zmin - _maxAgentRadius, _binOriginZ, _numBinsZ);
+	unsigned int zMaxBin = _getBin(zmax + _maxAgentRadius, _binOriginZ, _numBinsZ);
+
+	//
+	// agents, gathered in chunks into flat arrays for the kernel.
+	//
+	float centerX[FEELER_CHUNK_SIZE], centerZ[FEELER_CHUNK_SIZE], radius[FEELER_CHUNK_SIZE];
+	SteerLib::SpatialDatabaseItemPtr items[FEELER_CHUNK_SIZE];
+	unsigned int count = 0;
+	for (unsigned int x = xMinBin; x <= xMaxBin; x++) {
+		for (unsigned int bin = x * _numBinsZ + zMinBin; bin <= x * _numBinsZ + zMaxBin; bin++) {
+			for (unsigned int k = _binStart[bin]; k < _binStart[bin + 1]; k++) {
+				const PerceivedAgent & other = _agents[_binAgents[k]];
+				if (other.agent == self)
+					continue;
+				centerX[count] = other.position.x;
+				centerZ[count] = other.position.z;
+				radius[count] = other.radius;
+				items[count] = other.agent;
+				if (++count == FEELER_CHUNK_SIZE) {
+					traceCircles(rays, numRays, centerX, centerZ, radius, items, count, t, hitObjects);
+					count = 0;
+				}
+			}
+		}
+	}
+	if (count > 0) {
+		traceCircles(rays, numRays, centerX, centerZ, radius, items, count, t, hitObjects);
+	}
+
+	//
+	// obstacles; an obstacle spanning several cells is simply tested once per cell, which cannot change the closest hit.
+	// only the cells around the rays themselves are needed, but the agents' cells are a superset and usually the same cells.
+	//
+	float boxXMin[FEELER_CHUNK_SIZE], boxXMax[FEELER_CHUNK_SIZE], boxZMin[FEELER_CHUNK_SIZE], boxZMax[FEELER_CHUNK_SIZE];
+	count = 0;
+	for (unsigned int x = xMinBin; x <= xMaxBin; x++) {
+		for (unsigned int bin = x * _numBinsZ + zMinBin; bin <= x * _numBinsZ + zMaxBin; bin++) {
+			for (unsigned int j = _binObstacleStart[bin]; j < _binObstacleStart[bin + 1]; j++) {
+				unsigned int k = _binObstacleIndices[j];
+				if (!_obstacleIsBox[k]) {
+					for (unsigned int r = 0; r < numRays; r++) {
+						float hitT;
+						if (_obstacles[k]->intersects(rays[r], hitT)) {
+							keepClosestHit(hitT, _obstacles[k], t[r], hitObjects[r]);
+						}
+					}
+					continue;
+				}
+				boxXMin[count] = _obstacleXMin[k];
+				boxXMax[count] = _obstacleXMax[k];
+				boxZMin[count] = _obstacleZMin[k];
+				boxZMax[count] = _obstacleZMax[k];
+				items[count] = _obstacles[k];
+				if (++count == FEELER_CHUNK_SIZE) {
+					traceBoxes(rays, numRays, boxXMin, boxXMax, boxZMin, boxZMax, items, count, t, hitObjects);
+					count = 0;
+				}
+			}
+		}
+	}
+	if (count > 0) {
+		traceBoxes(rays, numRays, boxXMin, boxXMax, boxZMin, boxZMax, items, count, t, hitObjects);
+	}
+}
@@ -12,12 +12,11 @@
 
 #include "SteerLib.h"
 #include "Logger.h"
+#include "SearchPath.h"
 
+class SearchAgent;
 
 
-// globally accessible to the SearchAI plugin
-extern SteerLib::EngineInterface * gEngine;
-extern SteerLib::GridDatabase2D * gSpatialDatabase;
 
 namespace SearchAIGlobals {
 
@@ -34,17 +33,27 @@ namespace SearchAIGlobals {
 	};
 
 
-	extern unsigned int gLongTermPlanningPhaseInterval;
-	extern unsigned int gMidTermPlanningPhaseInterval;
-	extern unsigned int gShortTermPlanningPhaseInterval;
-	extern unsigned int gPredictivePhaseInterval;
-	extern unsigned int gReactivePhaseInterval;
-	extern unsigned int gPerceptivePhaseInterval;
-	extern bool gUseDynamicPhaseScheduling;
-	extern bool gShowStats;
-	extern bool gShowAllStats;
-
-	extern PhaseProfilers * gPhaseProfilers;
+	/**
+	 * @brief Options and performance profilers of one SearchAIModule instance.
+	 *
+	 * Each SimulationEngine creates its own instance of the module, so engines running in
+	 * different threads never share a context.  Agents are given the context of the module that created them.
+	 */
+	struct SearchAIContext {
+		unsigned int longTermPlanningPhaseInterval;
+		unsigned int midTermPlanningPhaseInterval;
+		unsigned int shortTermPlanningPhaseInterval;
+		unsigned int predictivePhaseInterval;
+		unsigned int reactivePhaseInterval;
+		unsigned int perceptivePhaseInterval;
+		bool useDynamicPhaseScheduling;
+		bool showStats;
+		bool showAllStats;
+
+		PhaseProfilers phaseProfilers;
+		/// The paths of all agents of the module, planned in SearchAIModule::preprocessSimulation().
+		SearchPathBuffer paths;
+	};
 }
 
 
@@ -81,11 +90,17 @@ public:
 
 	void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
 	void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+	bool usesPreprocessFrame() { return false; }
+	bool usesPostprocessFrame() { return false; }
 	void preprocessSimulation();
 	void initializeSimulation();
 	void cleanupSimulation();
 
 protected:
+	SteerLib::EngineInterface * _engine;
+	SearchAIGlobals::SearchAIContext _context;
+	/// The agents of this module, recycled across simulations.
+	Util::ObjectPool<SearchAgent> _agentPool;
 	std::string logFilename; // = "AI.log";
 	bool logStats; // = false;
 	Logger * _logger;
@@ -28,7 +28,7 @@
 class SearchAgent : public SteerLib::AgentInterface
 {
 public:
-	SearchAgent();
+	SearchAgent(SearchAIGlobals::SearchAIContext * context);
 	~SearchAgent();
 	void reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo);
 	void updateAI(float timeStamp, float dt, unsigned int frameNumber);
@@ -62,22 +62,37 @@ public:
 	
 
 	/*
-	computePlan calls the A* function to compute the path and store in in the global __path variable.
+	computePlan calls the A* function to compute the path to the first goal, simplifies it and stores it in the path buffer of the module,
+	unless an agent of the module already planned between the same grid cells.
 	*/
 	void computePlan();
 	SteerLib::AStarPlanner astar;
 
 protected:
+	/// Removes the points of a path that lie on a straight line, then every point that the path can skip without leaving traversable cells.
+	void _simplifyPath(std::vector<Util::Point> & path);
+	/// Returns true if every cell along the segment can be traversed, according to the A* planner.
+	bool _segmentCanBeTraversed(const Util::Point & start, const Util::Point & end);
+	/// Returns the point the agent walks to after the waypoint with the given index of its path; past the path, the goal.
+	const Util::Point & _getWaypoint(unsigned int index) const;
 
 	bool _enabled;
+	/// The context of the module that created this agent.
+	SearchAIGlobals::SearchAIContext * _context;
+	/// The engine and spatial database that this agent was given in reset().
+	SteerLib::EngineInterface * _engine;
+	SteerLib::GridDatabase2D * _spatialDatabase;
 	Util::Point __position;
 	Util::Vector _velocity;
 	Util::Vector _forward; // normalized version of velocity
 	float _radius;
 	std::queue<SteerLib::AgentGoalInfo> _goalQueue;
-	std::vector<Util::Point> __path;
-	Util::Point __next_waypoint;
-	int last_waypoint=0;
+	/// The path of the agent in the path buffer of its module (SEARCH_NO_PATH if it has none), and the next of its points to walk to.
+	/// The agent walks from its start through the inner points of the path, then to its goal, so the first and last cell centers are skipped.
+	unsigned int _path;
+	unsigned int _nextWaypoint;
+	/// The distance walked per second, so that the whole path takes DURATION seconds.
+	float _speed;
 };
 
 #endif
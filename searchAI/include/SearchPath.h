@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+#ifndef __SEARCH_PATH_H__
+#define __SEARCH_PATH_H__
+
+/// @file SearchPath.h
+/// @brief Declares the SearchPathBuffer class, the planned paths that the agents of one SearchAIModule share.
+
+#include <map>
+#include <vector>
+#include "SteerLib.h"
+
+// the index of a path that was never planned, or could not be found.
+#define SEARCH_NO_PATH ((unsigned int)-1)
+
+
+/**
+ * @brief The paths planned by the agents of one SearchAIModule, stored back to back in one buffer.
+ *
+ * A path is added once, already simplified, when an agent plans, and never changes afterwards; agents only keep
+ * the index of their path and a cursor into it, so following a path allocates nothing.  The A* search from one
+ * grid cell to another always finds the same path, so paths are also looked up by their start and goal cells,
+ * and agents that start and end in the same cells share one path instead of searching again.
+ *
+ * Indices of points stay valid as paths are added; #clear() forgets all paths when the simulation is cleaned up.
+ */
+class SearchPathBuffer
+{
+public:
+	/// Returns true if a path between these two cells was added, and its index in path.
+	bool findPath(int startCell, int goalCell, unsigned int & path) const {
+		std::map< std::pair<int,int>, unsigned int >::const_iterator found = _pathOfCells.find(std::make_pair(startCell, goalCell));
+		if (found == _pathOfCells.end()) {
+			return false;
+		}
+		path = found->second;
+		return true;
+	}
+
+	/// Adds a path between two cells; its points are copied into the buffer.  Returns the index of the path.
+	unsigned int addPath(int startCell, int goalCell, const std::vector<Util::Point> & points) {
+		if (_pathStart.empty()) {
+			_pathStart.push_back(0);
+		}
+		unsigned int path = (unsigned int)_pathStart.size() - 1;
+		_points.insert(_points.end(), points.begin(), points.end());
+		_pathStart.push_back((unsigned int)_points.size());
+		_pathOfCells[std::make_pair(startCell, goalCell)] = path;
+		return path;
+	}
+
+	/// Forgets all paths.
+	void clear() {
+		_points.clear();
+		_pathStart.clear();
+		_pathOfCells.clear();
+	}
+
+	/// Path p has the points [getPathBegin(p), getPathEnd(p)).
+	unsigned int getPathBegin(unsigned int path) const { return _pathStart[path]; }
+	unsigned int getPathEnd(unsigned int path) const { return _pathStart[path + 1]; }
+	const Util::Point & getPoint(unsigned int index) const { return _points[index]; }
+
+protected:
+	std::vector<Util::Point> _points;
+	/// Path p has the points [_pathStart[p], _pathStart[p+1]).
+	std::vector<unsigned int> _pathStart;
+	std::map< std::pair<int,int>, unsigned int > _pathOfCells;
+};
+
+
+#endif
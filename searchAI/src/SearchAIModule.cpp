@@ -16,25 +16,6 @@
 #include "LogManager.h"
 
 
-// globally accessible to the SearchAI plugin
-SteerLib::EngineInterface * gEngine;
-SteerLib::GridDatabase2D * gSpatialDatabase;
-
-namespace SearchAIGlobals
-{
-	unsigned int gLongTermPlanningPhaseInterval;
-	unsigned int gMidTermPlanningPhaseInterval;
-	unsigned int gShortTermPlanningPhaseInterval;
-	unsigned int gPredictivePhaseInterval;
-	unsigned int gReactivePhaseInterval;
-	unsigned int gPerceptivePhaseInterval;
-	bool gUseDynamicPhaseScheduling;
-	bool gShowStats;
-	bool gShowAllStats;
-
-	PhaseProfilers * gPhaseProfilers;
-}
-
 using namespace SearchAIGlobals;
 
 PLUGIN_API SteerLib::ModuleInterface * createModule()
@@ -50,13 +31,18 @@ PLUGIN_API void destroyModule( SteerLib::ModuleInterface*  module )
 
 void SearchAIModule::init( const SteerLib::OptionDictionary & options, SteerLib::EngineInterface * engineInfo )
 {
-	gEngine = engineInfo;
-	gSpatialDatabase = engineInfo->getSpatialDatabase();
-
-	gUseDynamicPhaseScheduling = false;
-	gShowStats = false;
+	_engine = engineInfo;
+
+	_context.longTermPlanningPhaseInterval = 0;
+	_context.midTermPlanningPhaseInterval = 0;
+	_context.shortTermPlanningPhaseInterval = 0;
+	_context.predictivePhaseInterval = 0;
+	_context.reactivePhaseInterval = 0;
+	_context.perceptivePhaseInterval = 0;
+	_context.useDynamicPhaseScheduling = false;
+	_context.showStats = false;
 	logStats = false;
-	gShowAllStats = false;
+	_context.showAllStats = false;
 	logFilename = "SearchAI.log";
 
 	SteerLib::OptionDictionary::const_iterator optionIter;
@@ -64,7 +50,7 @@ void SearchAIModule::init( const SteerLib::OptionDictionary & options, SteerLib:
 		std::stringstream value((*optionIter).second);
 		if ((*optionIter).first == "")
 		{
-			value >> gLongTermPlanningPhaseInterval;
+			value >> _context.longTermPlanningPhaseInterval;
 		}
 		else if ((*optionIter).first == "ailogFileName")
 		{
@@ -73,11 +59,11 @@ void SearchAIModule::init( const SteerLib::OptionDictionary & options, SteerLib:
 		}
 		else if ((*optionIter).first == "stats")
 		{
-			gShowStats = Util::getBoolFromString(value.str());
+			_context.showStats = Util::getBoolFromString(value.str());
 		}
 		else if ((*optionIter).first == "allstats")
 		{
-			gShowAllStats = Util::getBoolFromString(value.str());
+			_context.showAllStats = Util::getBoolFromString(value.str());
 		}
 		else
 		{
@@ -117,16 +103,14 @@ void SearchAIModule::initializeSimulation()
 	//
 	// initialize the performance profilers
 	//
-	gPhaseProfilers = new PhaseProfilers;
-	gPhaseProfilers->aiProfiler.reset();
-	gPhaseProfilers->longTermPhaseProfiler.reset();
-	gPhaseProfilers->midTermPhaseProfiler.reset();
-	gPhaseProfilers->shortTermPhaseProfiler.reset();
-	gPhaseProfilers->perceptivePhaseProfiler.reset();
-	gPhaseProfilers->predictivePhaseProfiler.reset();
-	gPhaseProfilers->reactivePhaseProfiler.reset();
-	gPhaseProfilers->steeringPhaseProfiler.reset();
-	std::cout<<"\ninitialize simulation\n";
+	_context.phaseProfilers.aiProfiler.reset();
+	_context.phaseProfilers.longTermPhaseProfiler.reset();
+	_context.phaseProfilers.midTermPhaseProfiler.reset();
+	_context.phaseProfilers.shortTermPhaseProfiler.reset();
+	_context.phaseProfilers.perceptivePhaseProfiler.reset();
+	_context.phaseProfilers.predictivePhaseProfiler.reset();
+	_context.phaseProfilers.reactivePhaseProfiler.reset();
+	_context.phaseProfilers.steeringPhaseProfiler.reset();
 
 }
 
@@ -137,11 +121,9 @@ void SearchAIModule::preprocessSimulation()
 		return;
 	else
 		planned_once = false;
-	std::cout<<"\nPreprocess simulation\n";
-	std::vector<SteerLib::AgentInterface*> _agents = gEngine->getAgents();
+	const std::vector<SteerLib::AgentInterface*> & _agents = _engine->getAgents();
 	for (int i =0; i<_agents.size(); ++i)
 	{
-		std::cout<<"\nAgent :: "<<i<<"/"<<_agents.size()-1;
 		((SearchAgent*)_agents[i])->computePlan();
 	}
 }
@@ -162,32 +144,33 @@ void SearchAIModule::postprocessFrame(float timeStamp, float dt, unsigned int fr
 
 void SearchAIModule::cleanupSimulation()
 {
+	_context.paths.clear();
 
 	if ( logStats )
 	{
 		LogObject logObject;
 
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getNumTimesExecuted());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTicksAccumulated());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMinTicks());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMaxTicks());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMinExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getMaxExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getAverageExecutionTimeMills());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTime());
-		logObject.addLogData(gPhaseProfilers->aiProfiler.getTickFrequency());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getNumTimesExecuted());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTicksAccumulated());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMinTicks());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxTicks());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMinExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getAverageExecutionTimeMills());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTime());
+		logObject.addLogData(_context.phaseProfilers.aiProfiler.getTickFrequency());
 
 		_logger->writeLogObject(logObject);
 
 		// cleanup profileing metrics for next simulation/scenario
-		gPhaseProfilers->aiProfiler.reset();
-		gPhaseProfilers->longTermPhaseProfiler.reset();
-		gPhaseProfilers->midTermPhaseProfiler.reset();
-		gPhaseProfilers->shortTermPhaseProfiler.reset();
-		gPhaseProfilers->perceptivePhaseProfiler.reset();
-		gPhaseProfilers->predictivePhaseProfiler.reset();
-		gPhaseProfilers->reactivePhaseProfiler.reset();
-		gPhaseProfilers->steeringPhaseProfiler.reset();
+		_context.phaseProfilers.aiProfiler.reset();
+		_context.phaseProfilers.longTermPhaseProfiler.reset();
+		_context.phaseProfilers.midTermPhaseProfiler.reset();
+		_context.phaseProfilers.shortTermPhaseProfiler.reset();
+		_context.phaseProfilers.perceptivePhaseProfiler.reset();
+		_context.phaseProfilers.predictivePhaseProfiler.reset();
+		_context.phaseProfilers.reactivePhaseProfiler.reset();
+		_context.phaseProfilers.steeringPhaseProfiler.reset();
 	}
 
 	// kdTree_->deleteObstacleTree(kdTree_->obstacleTree_);
@@ -200,10 +183,10 @@ void SearchAIModule::finish()
 
 SteerLib::AgentInterface * SearchAIModule::createAgent()
 {
-	return new SearchAgent; 
+	return _agentPool.create(&_context);
 }
 
 void SearchAIModule::destroyAgent( SteerLib::AgentInterface * agent )
 {
-	delete agent;
+	_agentPool.destroy(dynamic_cast<SearchAgent*>(agent));
 }
@@ -7,6 +7,8 @@
 #include "SearchAgent.h"
 #include "SearchAIModule.h"
 #include "util/Color.h"
+#include <algorithm>
+#include <cmath>
 
 /// @file SearchAgent.cpp
 /// @brief Implements the SearchAgent class.
@@ -17,31 +19,39 @@
 #define GOAL_REGION 0.1f
 #define DURATION 15
 
-SearchAgent::SearchAgent()
+SearchAgent::SearchAgent(SearchAIGlobals::SearchAIContext * context)
 {
+	_context = context;
 	_enabled = false;
+	_engine = NULL;
+	_spatialDatabase = NULL;
+	_path = SEARCH_NO_PATH;
+	_nextWaypoint = 0;
+	_speed = 0.0f;
 }
 
 SearchAgent::~SearchAgent()
 {
 	if (_enabled) {
 		Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-		gSpatialDatabase->removeObject( this, bounds);
+		_spatialDatabase->removeObject( this, bounds);
 	}
 }
 
 void SearchAgent::disable()
 {
 	Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-	gSpatialDatabase->removeObject( this, bounds);
+	_spatialDatabase->removeObject( this, bounds);
 	_enabled = false;
 }
 
 void SearchAgent::reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo)
 {
+	_engine = engineInfo;
+	_spatialDatabase = engineInfo->getSpatialDatabase();
+
 	// compute the "old" bounding box of the agent before it is reset.  its OK that it will be invalid if the agent was previously disabled
 	// because the value is not used in that case.
-	std::cout<<"Reset is called";
 	Util::AxisAlignedBox oldBounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
 
 	// initialize the agent based on the initial conditions
@@ -49,17 +59,18 @@ void SearchAgent::reset(const SteerLib::AgentInitialConditions & initialConditio
 	_forward = initialConditions.direction;
 	_radius = initialConditions.radius;
 	_velocity = initialConditions.speed * Util::normalize(initialConditions.direction);
+	_path = SEARCH_NO_PATH;
 
 	// compute the "new" bounding box of the agent
 	Util::AxisAlignedBox newBounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
 
 	if (!_enabled) {
 		// if the agent was not enabled, then it does not already exist in the database, so add it.
-		gSpatialDatabase->addObject( this, newBounds);
+		_spatialDatabase->addObject( this, newBounds);
 	}
 	else {
 		// if the agent was enabled, then the agent already existed in the database, so update it instead of adding it.
-		gSpatialDatabase->updateObject( this, oldBounds, newBounds);
+		_spatialDatabase->updateObject( this, oldBounds, newBounds);
 	}
 
 	_enabled = true;
@@ -74,7 +85,7 @@ void SearchAgent::reset(const SteerLib::AgentInitialConditions & initialConditio
 			_goalQueue.push(initialConditions.goals[i]);
 			if (initialConditions.goals[i].targetIsRandom) {
 				// if the goal is random, we must randomly generate the goal.
-				_goalQueue.back().targetLocation = gSpatialDatabase->randomPositionWithoutCollisions(1.0f, true);
+				_goalQueue.back().targetLocation = _spatialDatabase->randomPositionWithoutCollisions(1.0f, true);
 			}
 		}
 		else {
@@ -90,49 +101,132 @@ void SearchAgent::reset(const SteerLib::AgentInitialConditions & initialConditio
 
 void SearchAgent::computePlan()
 {
-	std::cout<<"\nComputing agent plan ";
-	Util::Point global_goal = _goalQueue.front().targetLocation;
-	if(astar.computePath(__path, __position, _goalQueue.front().targetLocation, gSpatialDatabase))
-	{
+	const Util::Point & goal = _goalQueue.front().targetLocation;
+	int startCell = _spatialDatabase->getCellIndexFromLocation(__position);
+	int goalCell = _spatialDatabase->getCellIndexFromLocation(goal);
 
-		while(!_goalQueue.empty())
-			_goalQueue.pop();
-		
-		for(int i=0;i<__path.size();++i)
+	SearchPathBuffer & paths = _context->paths;
+	if (!paths.findPath(startCell, goalCell, _path))
+	{
+		std::vector<Util::Point> path;
+		if (!astar.computePath(path, __position, goal, _spatialDatabase))
 		{
-			SteerLib::AgentGoalInfo goal_path_pt;
-			goal_path_pt.targetLocation = __path[i];
-			_goalQueue.push(goal_path_pt);
+			_path = SEARCH_NO_PATH;
+			return;
 		}
-		SteerLib::AgentGoalInfo goal_path_pt;
-		goal_path_pt.targetLocation = global_goal;
-		_goalQueue.push(goal_path_pt);
+		_simplifyPath(path);
+		_path = paths.addPath(startCell, goalCell, path);
 	}
-	// else
-	// {
-	// 	for(int i = 0;i<20;++i)
-	// 		_goalQueue.push(_goalQueue.front());
-	// }
 
+	// the inner points of the path, then the goal; see _getWaypoint().
+	_nextWaypoint = std::min(paths.getPathBegin(_path) + 1, paths.getPathEnd(_path) - 1);
+	float length = 0.0f;
+	Util::Point previous = __position;
+	for (unsigned int i = _nextWaypoint; i < paths.getPathEnd(_path); i++)
+	{
+		length += (_getWaypoint(i) - previous).length();
+		previous = _getWaypoint(i);
+	}
+	_speed = length / DURATION;
+}
+
+
+void SearchAgent::_simplifyPath(std::vector<Util::Point> & path)
+{
+	if (path.size() < 3)
+		return;
 
+	// the cells of an A* path are neighbors, so a straight run is a sequence of equal steps.
+	unsigned int numKept = 1;
+	for (unsigned int i = 1; i + 1 < path.size(); i++)
+	{
+		Util::Vector before = path[i] - path[numKept-1];
+		Util::Vector after = path[i+1] - path[i];
+		if (before.x * after.z - before.z * after.x != 0.0f || before.x * after.x + before.z * after.z <= 0.0f)
+			path[numKept++] = path[i];
+	}
+	path[numKept++] = path.back();
+	path.resize(numKept);
+
+	// string pulling: from each kept point, go straight to the furthest later point that can be reached through traversable cells.
+	numKept = 1;
+	unsigned int anchor = 0;
+	while (anchor + 1 < path.size())
+	{
+		unsigned int furthest = (unsigned int)path.size() - 1;
+		while (furthest > anchor + 1 && !_segmentCanBeTraversed(path[anchor], path[furthest]))
+			furthest--;
+		path[numKept++] = path[furthest];
+		anchor = furthest;
+	}
+	path.resize(numKept);
+}
+
+
+bool SearchAgent::_segmentCanBeTraversed(const Util::Point & start, const Util::Point & end)
+{
+	// half a cell between samples, so that no cell the segment crosses is skipped by more than a corner.
+	float step = 0.5f * std::min(_spatialDatabase->getCellSizeX(), _spatialDatabase->getCellSizeZ());
+	Util::Vector segment = end - start;
+	unsigned int numSamples = (unsigned int)ceilf(segment.length() / step);
+	for (unsigned int i = 1; i < numSamples; i++)
+	{
+		Util::Point sample = start + segment * ((float)i / (float)numSamples);
+		if (!astar.canBeTraversed(_spatialDatabase->getCellIndexFromLocation(sample)))
+			return false;
+	}
+	return true;
+}
+
+
+const Util::Point & SearchAgent::_getWaypoint(unsigned int index) const
+{
+	// the last point of the path is the center of the goal cell, which the agent skips to walk straight to the goal.
+	if (index + 1 >= _context->paths.getPathEnd(_path))
+		return _goalQueue.front().targetLocation;
+	return _context->paths.getPoint(index);
 }
 
 
 void SearchAgent::updateAI(float timeStamp, float dt, unsigned int frameNumber)
 {
-	Util::AutomaticFunctionProfiler profileThisFunction( &SearchAIGlobals::gPhaseProfilers->aiProfiler );
+	Util::AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.aiProfiler );
 
-	
-	double steps = (DURATION/(double)__path.size());
-	if(timeStamp*dt > last_waypoint*steps)
-	{	
-		if(!_goalQueue.empty())
+	if (_path == SEARCH_NO_PATH)
+		return;
+
+	// walk _speed * dt along the path, past as many waypoints as that reaches.
+	unsigned int pathEnd = _context->paths.getPathEnd(_path);
+	float distanceLeft = _speed * dt;
+	Util::Point newPosition = __position;
+	while (_nextWaypoint < pathEnd)
+	{
+		const Util::Point & waypoint = _getWaypoint(_nextWaypoint);
+		Util::Vector toWaypoint = waypoint - newPosition;
+		float distance = toWaypoint.length();
+		if (distance > distanceLeft)
 		{
-			__position = _goalQueue.front().targetLocation;
-			std::cout<<"Waypoint: "<< __position;
-			_goalQueue.pop();
-			last_waypoint++;
+			newPosition = newPosition + toWaypoint * (distanceLeft / distance);
+			break;
 		}
+		newPosition = waypoint;
+		distanceLeft -= distance;
+		_nextWaypoint++;
+	}
+
+	Util::Vector moved = newPosition - __position;
+	if (moved.lengthSquared() > 0.0f)
+	{
+		Util::AxisAlignedBox oldBounds(__position.x - _radius, __position.x + _radius, 0.0f, 0.0f, __position.z - _radius, __position.z + _radius);
+		Util::AxisAlignedBox newBounds(newPosition.x - _radius, newPosition.x + _radius, 0.0f, 0.0f, newPosition.z - _radius, newPosition.z + _radius);
+		_spatialDatabase->updateObject(this, oldBounds, newBounds);
+		_forward = Util::normalize(moved);
+		__position = newPosition;
+	}
+
+	if (_nextWaypoint == pathEnd)
+	{
+		disable();
 	}
 }
 
@@ -141,13 +235,13 @@ void SearchAgent::draw()
 {
 #ifdef ENABLE_GUI
 	// if the agent is selected, do some annotations just for demonstration
-	if (gEngine->isAgentSelected(this)) {
+	if (_engine->isAgentSelected(this)) {
 		Util::Ray ray;
 		ray.initWithUnitInterval(__position, _forward);
 		float t = 0.0f;
 		SteerLib::SpatialDatabaseItem * objectFound;
 		Util::DrawLib::drawLine(ray.pos, ray.eval(1.0f));
-		if (gSpatialDatabase->trace(ray, t, objectFound, this, false)) {
+		if (_spatialDatabase->trace(ray, t, objectFound, this, false)) {
 			Util::DrawLib::drawAgentDisc(__position, _forward, _radius, Util::gBlue);
 		}
 		else {
@@ -161,11 +255,12 @@ void SearchAgent::draw()
 		Util::DrawLib::drawFlag(_goalQueue.front().targetLocation);
 	}
 	
-	if(__path.size()>0)
+	if(_path != SEARCH_NO_PATH)
 	{
-		for(int i = 1; i<__path.size(); ++i)
-			Util::DrawLib::drawLine(__path[i-1], __path[i], Util::Color(1.0f, 0.0f, 0.0f), 2);
-		Util::DrawLib::drawCircle(__path[__path.size()-1], Util::Color(0.0f, 1.0f, 0.0f));
+		const SearchPathBuffer & paths = _context->paths;
+		for(unsigned int i = paths.getPathBegin(_path) + 1; i < paths.getPathEnd(_path); ++i)
+			Util::DrawLib::drawLine(paths.getPoint(i-1), paths.getPoint(i), Util::Color(1.0f, 0.0f, 0.0f), 2);
+		Util::DrawLib::drawCircle(paths.getPoint(paths.getPathEnd(_path)-1), Util::Color(0.0f, 1.0f, 0.0f));
 	}
 #endif
 }
@@ -28,7 +28,7 @@
 class SimpleAgent : public SteerLib::AgentInterface
 {
 public:
-	SimpleAgent();
+	SimpleAgent(SimpleAIGlobals::SimpleAIContext * context);
 	~SimpleAgent();
 	void reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo);
 	void updateAI(float timeStamp, float dt, unsigned int frameNumber);
@@ -45,6 +45,8 @@ public:
 	const std::queue<SteerLib::AgentGoalInfo> & agentGoals() const { throw Util::GenericException("agentGoals() not implemented yet"); }
 	void addGoal(const SteerLib::AgentGoalInfo & newGoal) { throw Util::GenericException("addGoals() not implemented yet for SimpleAgent"); }
 	void clearGoals() { throw Util::GenericException("clearGoals() not implemented yet for SimpleAgent"); }
+	/// The Euler step uses the dt given to updateAI(), so reduced-rate updates are safe.
+	bool supportsLevelOfDetail() { return true; }
 
 	void insertAgentNeighbor(const SteerLib::AgentInterface *agent, float &rangeSq) { throw Util::GenericException("insertAgentNeighbor not implemented yet for BenchmarkAgent"); }
 	void setParameters(SteerLib::Behaviour behave)
@@ -66,6 +68,11 @@ protected:
 	void _doEulerStep(const Util::Vector & steeringDecisionForce, float dt);
 
 	bool _enabled;
+	/// The context of the module that created this agent.
+	SimpleAIGlobals::SimpleAIContext * _context;
+	/// The engine and spatial database that this agent was given in reset().
+	SteerLib::EngineInterface * _engine;
+	SteerLib::GridDatabase2D * _spatialDatabase;
 	Util::Point __position;
 	Util::Vector _velocity;
 	Util::Vector _forward; // normalized version of velocity
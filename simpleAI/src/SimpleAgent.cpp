@@ -14,28 +14,34 @@
 #define MAX_SPEED 1.3f
 #define AGENT_MASS 1.0f
 
-SimpleAgent::SimpleAgent()
+SimpleAgent::SimpleAgent(SimpleAIGlobals::SimpleAIContext * context)
 {
+	_context = context;
 	_enabled = false;
+	_engine = NULL;
+	_spatialDatabase = NULL;
 }
 
 SimpleAgent::~SimpleAgent()
 {
 	if (_enabled) {
 		Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-		gSpatialDatabase->removeObject( this, bounds);
+		_spatialDatabase->removeObject( this, bounds);
 	}
 }
 
 void SimpleAgent::disable()
 {
 	Util::AxisAlignedBox bounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
-	gSpatialDatabase->removeObject( this, bounds);
+	_spatialDatabase->removeObject( this, bounds);
 	_enabled = false;
 }
 
 void SimpleAgent::reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo)
 {
+	_engine = engineInfo;
+	_spatialDatabase = engineInfo->getSpatialDatabase();
+
 	// compute the "old" bounding box of the agent before it is reset.  its OK that it will be invalid if the agent was previously disabled
 	// because the value is not used in that case.
 	Util::AxisAlignedBox oldBounds(__position.x-_radius, __position.x+_radius, 0.0f, 0.0f, __position.z-_radius, __position.z+_radius);
@@ -51,11 +57,11 @@ void SimpleAgent::reset(const SteerLib::AgentInitialConditions & initialConditio
 
 	if (!_enabled) {
 		// if the agent was not enabled, then it does not already exist in the database, so add it.
-		gSpatialDatabase->addObject( this, newBounds);
+		_spatialDatabase->addObject( this, newBounds);
 	}
 	else {
 		// if the agent was enabled, then the agent already existed in the database, so update it instead of adding it.
-		gSpatialDatabase->updateObject( this, oldBounds, newBounds);
+		_spatialDatabase->updateObject( this, oldBounds, newBounds);
 	}
 
 	_enabled = true;
@@ -70,7 +76,7 @@ void SimpleAgent::reset(const SteerLib::AgentInitialConditions & initialConditio
 			_goalQueue.push(initialConditions.goals[i]);
 			if (initialConditions.goals[i].targetIsRandom) {
 				// if the goal is random, we must randomly generate the goal.
-				_goalQueue.back().targetLocation = gSpatialDatabase->randomPositionWithoutCollisions(1.0f, true);
+				_goalQueue.back().targetLocation = _spatialDatabase->randomPositionWithoutCollisions(1.0f, true);
 			}
 		}
 		else {
@@ -88,7 +94,7 @@ void SimpleAgent::updateAI(float timeStamp, float dt, unsigned int frameNumber)
 {
 	// for this function, we assume that all goals are of type GOAL_TYPE_SEEK_STATIC_TARGET.
 	// the error check for this was performed in reset().
-	Util::AutomaticFunctionProfiler profileThisFunction( &SimpleAIGlobals::gPhaseProfilers->aiProfiler );
+	Util::AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.aiProfiler );
 
 	Util::Vector vectorToGoal = _goalQueue.front().targetLocation - __position;
 
@@ -119,13 +125,13 @@ void SimpleAgent::draw()
 {
 #ifdef ENABLE_GUI
 	// if the agent is selected, do some annotations just for demonstration
-	if (gEngine->isAgentSelected(this)) {
+	if (_engine->isAgentSelected(this)) {
 		Util::Ray ray;
 		ray.initWithUnitInterval(__position, _forward);
 		float t = 0.0f;
 		SteerLib::SpatialDatabaseItem * objectFound;
 		Util::DrawLib::drawLine(ray.pos, ray.eval(1.0f));
-		if (gSpatialDatabase->trace(ray, t, objectFound, this, false)) {
+		if (_spatialDatabase->trace(ray, t, objectFound, this, false)) {
 			Util::DrawLib::drawAgentDisc(__position, _forward, _radius, Util::gBlue);
 		}
 		else {
@@ -159,7 +165,7 @@ void SimpleAgent::_doEulerStep(const Util::Vector & steeringDecisionForce, float
 	// update the database with the new agent's setup
 	Util::AxisAlignedBox oldBounds(__position.x - _radius, __position.x + _radius, 0.0f, 0.0f, __position.z - _radius, __position.z + _radius);
 	Util::AxisAlignedBox newBounds(newPosition.x - _radius, newPosition.x + _radius, 0.0f, 0.0f, newPosition.z - _radius, newPosition.z + _radius);
-	gSpatialDatabase->updateObject( this, oldBounds, newBounds);
+	_spatialDatabase->updateObject( this, oldBounds, newBounds);
 
 	__position = newPosition;
 }
@@ -17,12 +17,11 @@
 #include "SteerLib.h"
 #include <vector>
 #include "SocialForces_Parameters.h"
+#include "SocialForcesBatch.h"
+#include "SocialForcesWalls.h"
 #include "Logger.h"
 
-
-// globally accessible to the sfAI plugin
-extern SteerLib::EngineInterface * gEngine;
-// extern SteerLib::GridDatabase2D * gSpatialDatabase;
+class SocialForcesAgent;
 
 
 /**
@@ -68,10 +67,21 @@ class SocialForcesAIModule : public SteerLib::ModuleInterface
 
         void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
         void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+        /// Only the batch mode computes forces before the agents are updated.
+        bool usesPreprocessFrame() { return _context.batch != NULL; }
+        bool usesPostprocessFrame() { return false; }
         std::vector<SteerLib::AgentInterface * > agents_;
 
     protected:
 
+        SteerLib::EngineInterface * _engine;
+        SocialForcesGlobals::SocialForcesAIContext _context;
+        /// The agents of this module, recycled across simulations.
+        Util::ObjectPool<SocialForcesAgent> _agentPool;
+        /// The agent-agent force kernel used when the "batch" option is set.
+        SocialForcesBatch _batch;
+        /// The edges of the obstacles, used by the obstacle forces of all agents.
+        SocialForcesWalls _walls;
         std::string logFilename; // = "pprAI.log";
         bool logStats; // = false;
         Logger * _rvoLogger;
@@ -38,7 +38,7 @@
 class SocialForcesAgent : public SteerLib::AgentInterface
 {
     public:
-        SocialForcesAgent();
+        SocialForcesAgent(SocialForcesGlobals::SocialForcesAIContext * context);
         ~SocialForcesAgent();
         void reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo);
         void updateAI(float timeStamp, float dt, unsigned int frameNumber);
@@ -56,6 +56,8 @@ class SocialForcesAgent : public SteerLib::AgentInterface
         void addGoal(const SteerLib::AgentGoalInfo & newGoal) { throw Util::GenericException("addGoals() not implemented yet for SimpleAgent"); }
         void clearGoals() { throw Util::GenericException("clearGoals() not implemented yet for SimpleAgent"); }
         void setParameters(SteerLib::Behaviour behave);
+        /// All forces are integrated with the dt given to updateAI(), so reduced-rate updates are safe.
+        bool supportsLevelOfDetail() { return true; }
         /// @name The SteerLib::SpatialDatabaseItemInterface
         /// @brief These functions are required so that the agent can be used by the SteerLib::GridDatabase2D spatial database;
         /// The Util namespace helper functions do the job nicely for basic circular agents.
@@ -82,6 +84,11 @@ class SocialForcesAgent : public SteerLib::AgentInterface
         void updateLocalTarget();
 
         bool _enabled;
+        /// The context of the module that created this agent.
+        SocialForcesGlobals::SocialForcesAIContext * _context;
+        /// The engine and spatial database that this agent was given in reset().
+        SteerLib::EngineInterface * _engine;
+        SteerLib::GridDatabase2D * _spatialDatabase;
         Util::Point _position;
         Util::Vector _velocity;
         Util::Vector _forward; // normalized version of velocity
@@ -112,12 +119,20 @@ class SocialForcesAgent : public SteerLib::AgentInterface
 
 
         void calcNextStep(float dt);
-        Util::Vector calcRepulsionForce(float dt);
-        Util::Vector calcProximityForce(float dt);
         Util::Vector calcGoalForce(Util::Vector,float);
 
-        Util::Vector calcAgentRepulsionForce(float dt);
-        Util::Vector calcWallRepulsionForce(float dt);
+        /// Collects the agents and obstacles within the query radius into _neighborAgents and _neighborObstacles; done once per updateAI().
+        void gatherNeighbors();
+        /// Computes the repulsion (body and sliding friction) and proximity (psychological) forces of all gathered neighbors in one pass.
+        void calcNeighborForces(float dt, Util::Vector & repulsionForce, Util::Vector & proximityForce);
+        /// Computes the repulsion and proximity forces of the gathered obstacles only; part of calcNeighborForces(), also used in batch mode.
+        void calcObstacleForces(float dt, Util::Vector & repulsionForce, Util::Vector & proximityForce);
+        /// Computes the goal, repulsion and proximity forces at the current position and velocity, from the gathered neighbors or the batch forces.
+        void calcForces(const Util::Vector & goalDirection, float dt, Util::Vector & prefForce, Util::Vector & repulsionForce, Util::Vector & proximityForce);
+        /// Moves the agent to the given state and returns its acceleration there; used for the intermediate stages of the integrators.
+        Util::Vector calcAccelerationAt(const Util::Point & position, const Util::Vector & velocity, const Util::Vector & goalDirection, float forceDt);
+        /// Advances _position and _velocity by dt with the integrator of the module, in adaptive substeps; acceleration is the one at the current state.
+        void integrate(float dt, float forceDt, const Util::Vector & goalDirection, const Util::Vector & acceleration);
 
         Util::Vector calcWallNormal(SteerLib::ObstacleInterface* obs);
         std::pair<Util::Point, Util::Point> calcWallPointsFromNormal(SteerLib::ObstacleInterface* obs, Util::Vector normal);
@@ -127,8 +142,18 @@ class SocialForcesAgent : public SteerLib::AgentInterface
         std::vector<Util::Point> _midTermPath;
         // holds the location of the best local target along the midtermpath
         Util::Point _currentLocalTarget;
+        // the neighbors found by gatherNeighbors(); members so that their storage is reused every frame
+        std::vector<SteerLib::AgentInterface*> _neighborAgents;
+        std::vector<SteerLib::ObstacleInterface*> _neighborObstacles;
+        // the agent-agent forces of the batch mode for this frame, without the dt factor; only valid if _hasBatchForces
+        bool _hasBatchForces;
+        Util::Vector _batchRepulsionForce;
+        Util::Vector _batchProximityForce;
+        // the substep the adaptive integrators ended the last frame with, the first guess for the next one; 0 before the first frame
+        float _substepSize;
 
         friend class SocialForcesAIModule;
+        friend class SocialForcesBatch;
 
         SteerLib::AStarPlanner astar;
 
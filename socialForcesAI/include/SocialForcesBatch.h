@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+
+#ifndef __SocialForces_BATCH__
+#define __SocialForces_BATCH__
+
+
+/// @file SocialForcesBatch.h
+/// @brief Declares the SocialForcesBatch class, the structure-of-arrays agent-agent force kernel of the sfAI batch mode.
+
+
+#include <vector>
+#include "SteerLib.h"
+#include "SocialForces_Parameters.h"
+
+
+class SocialForcesAgent;
+
+/**
+ * @brief Computes the agent-agent social forces of all agents of one module at once.
+ *
+ * When the sfAI module runs with the "batch" option, the module calls #update() once per frame
+ * before any agent is updated.  The batch copies the position, velocity and radius of every enabled agent
+ * into structure-of-arrays storage, sorted by the cell of a uniform grid whose cells are as large as the
+ * largest interaction distance.  Neighbor lists are then built from the 3x3 cells around each agent, and
+ * the proximity (psychological) and body/sliding friction forces are evaluated over the neighbor lists.
+ * On x86 processors that support AVX2 the force kernel processes eight neighbors at a time; the
+ * instruction set is detected at run-time, so the module is still built with the default compiler flags.
+ *
+ * The forces are the same terms SocialForcesAgent::calcNeighborForces() sums, with the parameters of each agent,
+ * but computed from the positions at the start of the frame (instead of the positions of the agents already updated this frame),
+ * using agents within the exact interaction distance (instead of all agents in overlapping spatial database cells),
+ * and with the exponential approximated by #fastExp().  The per-agent path remains the reference implementation.
+ *
+ * The forces are stored without the dt factor, so agents running at a reduced level of detail scale them by their own dt.
+ *
+ * In symmetric mode (#setSymmetric()) no neighbor lists are built.  Instead each unordered pair of agents is
+ * visited once, from the cell of one agent and the half of its surrounding cells that come after it (the
+ * "half shell": the next cell in its row and three cells in the next row), and equal and opposite forces are
+ * added to both agents.  The exponential is shared by the two agents unless their parameters differ.
+ * With more than one thread (#setNumThreads()) the grid rows are split into one stripe per thread;
+ * every stripe adds its forces into its own accumulation buffer, and the buffers are summed in stripe
+ * order afterwards, so the result does not depend on the thread scheduling.
+ *
+ * The batch also bins the obstacles into its grid, so that agents can find the obstacles near them without
+ * a spatial database query.
+ */
+class SocialForcesBatch
+{
+public:
+	SocialForcesBatch();
+	~SocialForcesBatch();
+
+	/// Gathers the state of all enabled agents, builds the neighbor lists and computes the agent-agent forces.
+	void update(const std::vector<SteerLib::AgentInterface*> & agents, SteerLib::EngineInterface * engine);
+	/// Forgets all agents and obstacles; called when the simulation is cleaned up.
+	void clear();
+
+	/// Returns the agent-agent forces computed for the agent with the given module id by the last #update(), without the dt factor; false if the agent was not part of it.
+	bool getAgentForces(size_t agentId, Util::Vector & repulsionForce, Util::Vector & proximityForce) const;
+	/// Appends the obstacles whose bounds overlap the given square to obstacles, in the same (pointer) order a spatial database query returns them.
+	void getObstaclesInRange(const Util::Point & position, float range, std::vector<SteerLib::ObstacleInterface*> & obstacles) const;
+
+	/// Returns the number of agents and the number of neighbor list entries in the last #update(); there are no neighbor lists in symmetric mode.
+	size_t getNumAgents() const { return _agents.size(); }
+	size_t getNumNeighborPairs() const { return _neighborIndices.size(); }
+	/// Enables or disables the AVX2 kernel; it is only enabled if the processor supports it.
+	void setUseAVX2(bool useAVX2);
+	/// Returns true if the force kernel uses AVX2.
+	bool isUsingAVX2() const { return _useAVX2; }
+	/// Enables or disables the symmetric (half shell) evaluation of each pair of agents.
+	void setSymmetric(bool symmetric) { _symmetric = symmetric; }
+	bool isSymmetric() const { return _symmetric; }
+	/// Sets the number of threads used by the symmetric evaluation; 1 (the default) computes the forces on the calling thread.
+	void setNumThreads(unsigned int numThreads);
+	unsigned int getNumThreads() const { return _numThreads; }
+
+	/**
+	 * @brief Approximates exp(x) for single precision floats.
+	 *
+	 * Uses exp(x) = 2^n * exp(r) with n = round(x/ln2), a two-part ln2 so that r = x - n*ln2 is exact
+	 * within |r| <= ln2/2, and a degree 6 Taylor polynomial for exp(r).  The relative error is below 3e-7
+	 * for x in [-87, 88]; arguments outside that range are clamped, so very negative x returns about 1.6e-38
+	 * instead of 0.  The AVX2 kernel evaluates the same operations eight lanes at a time.
+	 */
+	static float fastExp(float x);
+
+protected:
+	/// Computes the cell size and grid dimensions for this frame, and re-bins the obstacles if they changed.
+	void _prepareGrid(SteerLib::EngineInterface * engine, float maxInteractionDistance);
+	/// Returns the index of the cell that contains the given location; locations outside the grid are clamped to the border cells.
+	unsigned int _getCellIndex(float x, float z) const;
+	void _getCellCoords(float x, float z, int & cellX, int & cellZ) const;
+	/// Sorts the gathered agents by cell, builds _cellStart and the sorted structure-of-arrays.
+	void _sortAgentsByCell();
+	/// Builds the neighbor list of every agent from the 3x3 cells around it.
+	void _buildNeighborLists();
+	/// Computes the forces of every agent over its neighbor list, one neighbor at a time.
+	void _computeForcesScalar();
+	/// Computes the forces of every agent, eight neighbors at a time; only called if the processor supports AVX2.
+	void _computeForcesAVX2();
+	/// Adds the forces of the neighbors in _neighborIndices[first .. last) of sorted agent i to the given sums, one neighbor at a time.
+	void _accumulateForcesScalar(unsigned int i, unsigned int first, unsigned int last, float sums[4]);
+
+	/// The forces accumulated by one stripe of the symmetric evaluation, indexed like the sorted arrays.
+	struct ForceBuffer {
+		std::vector<float> repulsionX;
+		std::vector<float> repulsionZ;
+		std::vector<float> proximityX;
+		std::vector<float> proximityZ;
+	};
+
+	/// The data given to the task of one stripe: grid rows [firstRow, lastRow).
+	struct StripeTask {
+		SocialForcesBatch * batch;
+		unsigned int stripe;
+		int firstRow;
+		int lastRow;
+	};
+
+	/// Computes the forces of all pairs once, using the half shell cells; see the class documentation.
+	void _computeForcesSymmetric();
+	/// Task function that runs _computeStripe() for one StripeTask.
+	static void _computeStripeTask(unsigned int threadIndex, void * data);
+	/// Adds the forces of all pairs whose first agent is in grid rows [firstRow, lastRow) to the buffer of the stripe.
+	void _computeStripe(unsigned int stripe, int firstRow, int lastRow);
+	/// Adds the forces between sorted agent i and the agents [first, last) to both agents in the buffer, one pair at a time.
+	void _accumulatePairsScalar(unsigned int i, unsigned int first, unsigned int last, ForceBuffer & buffer);
+	/// Same as _accumulatePairsScalar(), eight pairs at a time; only called if the processor supports AVX2.
+	void _accumulatePairsAVX2(unsigned int i, unsigned int first, unsigned int last, ForceBuffer & buffer);
+
+	bool _useAVX2;
+	bool _symmetric;
+	unsigned int _numThreads;
+	/// The worker threads of the symmetric evaluation, NULL when it runs on one thread.
+	Util::ThreadedTaskManager * _threadPool;
+	std::vector<ForceBuffer> _stripeBuffers;
+	std::vector<StripeTask> _stripeTasks;
+
+	/// @name The uniform grid
+	//@{
+	float _originX;
+	float _originZ;
+	float _cellSize;
+	float _invCellSize;
+	int _numCellsX;
+	int _numCellsZ;
+	/// For each cell, the index of its first agent in the sorted arrays; one extra entry holds the number of agents.
+	std::vector<unsigned int> _cellStart;
+	//@}
+
+	/// @name The agents, sorted by cell
+	//@{
+	std::vector<SocialForcesAgent*> _agents;
+	std::vector<size_t> _agentIds;
+	std::vector<float> _positionX;
+	std::vector<float> _positionZ;
+	std::vector<float> _velocityX;
+	std::vector<float> _velocityZ;
+	std::vector<float> _radius;
+	/// The parameters of each agent that the kernel uses; agents may have different parameters after setParameters().
+	std::vector<float> _queryRadius;
+	std::vector<float> _agentA;
+	std::vector<float> _invAgentB;
+	std::vector<float> _personalSpaceThreshold;
+	std::vector<float> _agentBodyForce;
+	std::vector<float> _slidingFrictionForce;
+	std::vector<float> _repulsionX;
+	std::vector<float> _repulsionZ;
+	std::vector<float> _proximityX;
+	std::vector<float> _proximityZ;
+	/// Sorted index of each agent, indexed by module agent id; NOT_IN_BATCH for agents that were not gathered.
+	std::vector<unsigned int> _sortedIndexOfAgentId;
+	//@}
+
+	/// @name Neighbor lists in compressed form: the neighbors of sorted agent i are _neighborIndices[_neighborStart[i] .. _neighborStart[i+1]).
+	//@{
+	std::vector<unsigned int> _neighborStart;
+	std::vector<int> _neighborIndices;
+	//@}
+
+	/// @name Obstacles binned into the grid, the obstacles of cell c are _obstacles[_cellObstacles[_cellObstacleStart[c] .. _cellObstacleStart[c+1])].
+	//@{
+	std::vector<SteerLib::ObstacleInterface*> _obstacles;
+	std::vector<unsigned int> _cellObstacleStart;
+	std::vector<unsigned int> _cellObstacles;
+	//@}
+
+	/// Scratch storage of the unsorted gather and the counting sort, kept to reuse its memory.
+	std::vector<unsigned int> _unsortedCell;
+	std::vector<SocialForcesAgent*> _unsortedAgents;
+	std::vector<unsigned int> _cellFill;
+
+	static const unsigned int NOT_IN_BATCH = 0xffffffff;
+};
+
+
+#endif
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+
+#ifndef __SocialForces_WALLS__
+#define __SocialForces_WALLS__
+
+
+/// @file SocialForcesWalls.h
+/// @brief Declares the SocialForcesWalls class, the precomputed wall segments used by the sfAI obstacle forces.
+
+
+#include <vector>
+#include "SteerLib.h"
+
+
+/**
+ * @brief The edges and outward normals of all obstacles, precomputed once per simulation.
+ *
+ * SocialForcesAgent::calcObstacleForces() needs, for every obstacle near an agent, the closest point of the obstacle
+ * and the normal of the wall it lies on.  Finding them from the obstacle interface every frame means branching on the
+ * bounds of the obstacle, and only works for axis-aligned boxes.  Instead the module calls #build() in preprocessSimulation(),
+ * which stores the edges of every obstacle as segments with outward normals in flat arrays, and #getClosestWallPoint()
+ * then only has to loop over the segments of one obstacle.
+ *
+ * - Axis-aligned boxes (and any obstacle that does not return its vertices) use the four edges of their bounds, in the
+ *   same order and direction as SocialForcesAgent::calcWallPointsFromNormal(), so agents outside of them feel the same forces.
+ * - Oriented boxes and polygons use their actual edges.
+ * - Circles are stored as circles, with the normal pointing away from the center.
+ *
+ * Obstacles are looked up by binary search in an array sorted by pointer, the same order the engine keeps them in.
+ */
+class SocialForcesWalls
+{
+public:
+	SocialForcesWalls();
+
+	/// Precomputes the segments of all given obstacles, replacing any previous ones.
+	void build(const std::set<SteerLib::ObstacleInterface*> & obstacles);
+	/// Forgets all obstacles; called when the simulation is cleaned up.
+	void clear();
+
+	/**
+	 * @brief Finds the point of an obstacle closest to the given position.
+	 *
+	 * Returns false if the obstacle was not part of the last #build() (e.g. it was added during the simulation).
+	 * When several segments are equally close (the position is beyond a corner), the segment whose normal points most
+	 * towards the position is used.
+	 */
+	bool getClosestWallPoint(SteerLib::ObstacleInterface * obstacle, const Util::Point & position, Util::Point & closestPoint, Util::Vector & wallNormal, float & distance) const;
+
+	size_t getNumObstacles() const { return _obstacles.size(); }
+	size_t getNumSegments() const { return _segmentStartX.size(); }
+
+protected:
+	/// Appends one segment from (x1,z1) to (x2,z2) with the given outward normal; zero length segments are skipped.
+	void _addSegment(float x1, float z1, float x2, float z2, float normalX, float normalZ);
+	/// Appends the four edges of an axis-aligned box.
+	void _addBoxSegments(const Util::AxisAlignedBox & box);
+	/// Appends the edges of a closed polygon, with normals pointing away from its interior.
+	void _addPolygonSegments(const std::vector<Util::Vector> & vertices);
+
+	/// The obstacles, sorted by pointer; the segments of _obstacles[k] are [_firstSegment[k], _firstSegment[k+1]).
+	std::vector<SteerLib::ObstacleInterface*> _obstacles;
+	std::vector<unsigned int> _firstSegment;
+	/// The center and radius of obstacles stored as circles, a negative radius for all other obstacles.
+	std::vector<float> _circleX;
+	std::vector<float> _circleZ;
+	std::vector<float> _circleRadius;
+
+	/// @name The segments, from (startX,startZ) to (startX+deltaX,startZ+deltaZ)
+	//@{
+	std::vector<float> _segmentStartX;
+	std::vector<float> _segmentStartZ;
+	std::vector<float> _segmentDeltaX;
+	std::vector<float> _segmentDeltaZ;
+	std::vector<float> _segmentLengthSquared;
+	std::vector<float> _segmentNormalX;
+	std::vector<float> _segmentNormalZ;
+	//@}
+};
+
+
+#endif
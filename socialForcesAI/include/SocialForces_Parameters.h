@@ -30,6 +30,9 @@
 #define WALL_B 0.08f //  inverse proximity force importance
 #define WALL_A 25.0f //  proximity force importance
 #define FURTHEST_LOCAL_TARGET_DISTANCE 45
+#define INTEGRATOR_TIME_SCALE 0.05f // the frame dt the forces were tuned for (the default 20 fps); used by all integrators except "euler"
+#define INTEGRATOR_TOLERANCE 0.01f // meters, the largest error estimate accepted for one substep
+#define INTEGRATOR_MAX_SUBSTEPS 16
 
 #define MASS 1
 // #define WAYPOINT_THRESHOLD_MULTIPLIER 2.5
@@ -41,8 +44,26 @@
 // #define DRAW_ANNOTATIONS 1
 
 // #define _DEBUG_ 1
+class SocialForcesBatch;
+class SocialForcesWalls;
+
+
 namespace SocialForcesGlobals {
 
+	/// The integrators an agent can advance its velocity and position with, selected by the "integrator" module option.
+	enum SocialForcesIntegrator {
+		/// One explicit Euler step per frame, with the frame dt in the force terms; the original behavior and the default.
+		SF_INTEGRATOR_EULER,
+		/// Semi-implicit Euler: the goal force is integrated implicitly, the other forces explicitly, and the position with the new velocity.
+		SF_INTEGRATOR_SEMI_IMPLICIT_EULER,
+		/// Velocity Verlet, two force evaluations per substep.
+		SF_INTEGRATOR_VERLET,
+		/// Heun's method (second order Runge-Kutta), two force evaluations per substep.
+		SF_INTEGRATOR_RK2,
+		/// Classical fourth order Runge-Kutta, four force evaluations per substep.
+		SF_INTEGRATOR_RK4
+	};
+
 	struct PhaseProfilers {
 		Util::PerformanceProfiler aiProfiler;
 		Util::PerformanceProfiler drawProfiler;
@@ -54,38 +75,6 @@ namespace SocialForcesGlobals {
 		Util::PerformanceProfiler reactivePhaseProfiler;
 		Util::PerformanceProfiler steeringPhaseProfiler;
 	};
-
-
-	extern SteerLib::EngineInterface * gEngineInfo;
-	extern SteerLib::GridDatabase2D * gSpatialDatabase;
-	extern unsigned int gLongTermPlanningPhaseInterval;
-	extern unsigned int gMidTermPlanningPhaseInterval;
-	extern unsigned int gShortTermPlanningPhaseInterval;
-	extern unsigned int gPredictivePhaseInterval;
-	extern unsigned int gReactivePhaseInterval;
-	extern unsigned int gPerceptivePhaseInterval;
-	extern bool gUseDynamicPhaseScheduling;
-	extern bool gShowStats;
-	extern bool gShowAllStats;
-
-
-	// Adding a bunch of parameters so they can be changed via input
-	extern float sf_acceleration;
-	extern float sf_personal_space_threshold;
-	extern float sf_agent_repulsion_importance;
-	extern float sf_query_radius;
-	extern float sf_body_force;
-	extern float sf_agent_body_force;
-	extern float sf_sliding_friction_force;
-	extern float sf_agent_b;
-	extern float sf_agent_a;
-	extern float sf_wall_b;
-	extern float sf_wall_a;
-	extern float sf_max_speed;
-
-
-
-	extern PhaseProfilers * gPhaseProfilers;
 }
 
 
@@ -189,4 +178,48 @@ inline std::ostream &operator<<(std::ostream & out, const SocialForcesParameters
 
 
 
+namespace SocialForcesGlobals {
+
+	/**
+	 * @brief Options, default agent parameters and performance profilers of one SocialForcesAIModule instance.
+	 *
+	 * Each SimulationEngine creates its own instance of the module, so engines running in
+	 * different threads never share a context.  Agents are given the context of the module that created them.
+	 */
+	struct SocialForcesAIContext {
+		unsigned int longTermPlanningPhaseInterval;
+		unsigned int midTermPlanningPhaseInterval;
+		unsigned int shortTermPlanningPhaseInterval;
+		unsigned int predictivePhaseInterval;
+		unsigned int reactivePhaseInterval;
+		unsigned int perceptivePhaseInterval;
+		bool useDynamicPhaseScheduling;
+		bool showStats;
+		bool showAllStats;
+
+		/// The parameters new agents start with, set from the module options.
+		SocialForcesParameters parameters;
+
+		/// The agent-agent force kernel of the batch mode, NULL unless the module runs with the "batch" option.
+		SocialForcesBatch * batch;
+
+		/// The precomputed wall segments of the obstacles, built by the module in preprocessSimulation().
+		SocialForcesWalls * walls;
+
+		/// @name Integration
+		/// All integrators except SF_INTEGRATOR_EULER split each frame into adaptive substeps: a substep is halved while its
+		/// error estimate exceeds integratorTolerance (but not below dt / integratorMaxSubsteps), and doubled when the estimate is
+		/// well below it.  Their force terms use the fixed integratorTimeScale instead of the frame dt, so that the model does not
+		/// change when the frame dt does.
+		//@{
+		SocialForcesIntegrator integrator;
+		float integratorTimeScale;
+		float integratorTolerance;
+		unsigned int integratorMaxSubsteps;
+		//@}
+
+		PhaseProfilers phaseProfilers;
+	};
+}
+
 #endif /* SocialForces_PARAMETERS_H_ */
@@ -13,50 +13,13 @@
 #include "SimulationPlugin.h"
 #include "SocialForcesAIModule.h"
 #include "SocialForcesAgent.h"
+#include "SocialForcesBatch.h"
 
 
 #include "LogObject.h"
 #include "LogManager.h"
 
 
-// globally accessible to the sfAI plugin
-SteerLib::EngineInterface * gEngine;
-// SteerLib::GridDatabase2D * gSpatialDatabase;
-
-
-namespace SocialForcesGlobals
-{
-
-    SteerLib::EngineInterface* gEngineInfo;
-    SteerLib::GridDatabase2D*  gSpatialDatabase;
-	unsigned int gLongTermPlanningPhaseInterval;
-	unsigned int gMidTermPlanningPhaseInterval;
-	unsigned int gShortTermPlanningPhaseInterval;
-	unsigned int gPredictivePhaseInterval;
-	unsigned int gReactivePhaseInterval;
-	unsigned int gPerceptivePhaseInterval;
-	bool gUseDynamicPhaseScheduling;
-	bool gShowStats;
-	bool gShowAllStats;
-
-	// Adding a bunch of parameters so they can be changed via input
-	float sf_acceleration;
-	float sf_personal_space_threshold;
-	float sf_agent_repulsion_importance;
-	float sf_query_radius;
-	float sf_body_force;
-	float sf_agent_body_force;
-	float sf_sliding_friction_force;
-	float sf_agent_b;
-	float sf_agent_a;
-	float sf_wall_b;
-	float sf_wall_a;
-	float sf_max_speed;
-
-	PhaseProfilers * gPhaseProfilers;
-}
-
-
 using namespace SocialForcesGlobals;
 
 
@@ -74,28 +37,44 @@ PLUGIN_API void destroyModule( SteerLib::ModuleInterface*  module )
 
 void SocialForcesAIModule::init( const SteerLib::OptionDictionary & options, SteerLib::EngineInterface * engineInfo )
 {
-	gEngine = engineInfo;
-	gSpatialDatabase = engineInfo->getSpatialDatabase();
+	_engine = engineInfo;
 	_data = "";
 
-	gUseDynamicPhaseScheduling = false;
-	gShowStats = false;
+	_context.longTermPlanningPhaseInterval = 0;
+	_context.midTermPlanningPhaseInterval = 0;
+	_context.shortTermPlanningPhaseInterval = 0;
+	_context.predictivePhaseInterval = 0;
+	_context.reactivePhaseInterval = 0;
+	_context.perceptivePhaseInterval = 0;
+	_context.useDynamicPhaseScheduling = false;
+	_context.showStats = false;
 	logStats = false;
-	gShowAllStats = false;
+	_context.showAllStats = false;
+	_context.batch = NULL;
+	_context.walls = &_walls;
+	_context.integrator = SocialForcesGlobals::SF_INTEGRATOR_EULER;
+	_context.integratorTimeScale = INTEGRATOR_TIME_SCALE;
+	_context.integratorTolerance = INTEGRATOR_TOLERANCE;
+	_context.integratorMaxSubsteps = INTEGRATOR_MAX_SUBSTEPS;
+	bool useBatch = false;
+	bool batchOptionGiven = false;
+	bool useBatchSIMD = true;
+	bool useBatchSymmetric = false;
+	unsigned int numBatchThreads = 1;
 	logFilename = "sfAI.log";
 
-	sf_acceleration = ACCELERATION;
-	sf_personal_space_threshold = PERSONAL_SPACE_THRESHOLD;
-	sf_agent_repulsion_importance = AGENT_REPULSION_IMPORTANCE;
-	sf_query_radius = QUERY_RADIUS;
-	sf_body_force = BODY_FORCE;
-	sf_agent_body_force = AGENT_BODY_FORCE;
-	sf_sliding_friction_force = SLIDING_FRICTION_FORCE;
-	sf_agent_b = AGENT_B;
-	sf_agent_a = AGENT_A;
-	sf_wall_b = WALL_B;
-	sf_wall_a = WALL_A;
-	sf_max_speed = MAX_SPEED;
+	_context.parameters.sf_acceleration = ACCELERATION;
+	_context.parameters.sf_personal_space_threshold = PERSONAL_SPACE_THRESHOLD;
+	_context.parameters.sf_agent_repulsion_importance = AGENT_REPULSION_IMPORTANCE;
+	_context.parameters.sf_query_radius = QUERY_RADIUS;
+	_context.parameters.sf_body_force = BODY_FORCE;
+	_context.parameters.sf_agent_body_force = AGENT_BODY_FORCE;
+	_context.parameters.sf_sliding_friction_force = SLIDING_FRICTION_FORCE;
+	_context.parameters.sf_agent_b = AGENT_B;
+	_context.parameters.sf_agent_a = AGENT_A;
+	_context.parameters.sf_wall_b = WALL_B;
+	_context.parameters.sf_wall_a = WALL_A;
+	_context.parameters.sf_max_speed = MAX_SPEED;
 
 	std::string testcase = (*engineInfo->getModuleOptions("testCasePlayer").find("testcase")).second;
 	// TODO: Customize variables based on testcase.
@@ -106,57 +85,95 @@ void SocialForcesAIModule::init( const SteerLib::OptionDictionary & options, Ste
 		// std::cout << "option " << (*optionIter).first << " value " << value.str() << std::endl;
 		if ((*optionIter).first == "")
 		{
-			value >> gLongTermPlanningPhaseInterval;
+			value >> _context.longTermPlanningPhaseInterval;
 		}
 		else if ((*optionIter).first == "sf_acceleration")
 		{
-			value >> sf_acceleration;
-			std::cout << "set sf acceleration to " << sf_acceleration << std::endl;
+			value >> _context.parameters.sf_acceleration;
+			std::cout << "set sf acceleration to " << _context.parameters.sf_acceleration << std::endl;
 		}
 		else if ((*optionIter).first == "sf_personal_space_threshold")
 		{
-			value >> sf_personal_space_threshold;
+			value >> _context.parameters.sf_personal_space_threshold;
 		}
 		else if ((*optionIter).first == "sf_agent_repulsion_importance")
 		{
-			value >> sf_agent_repulsion_importance;
+			value >> _context.parameters.sf_agent_repulsion_importance;
 		}
 		else if ((*optionIter).first == "sf_query_radius")
 		{
-			value >> sf_query_radius;
+			value >> _context.parameters.sf_query_radius;
 		}
 		else if ((*optionIter).first == "sf_body_force")
 		{
-			value >> sf_body_force;
+			value >> _context.parameters.sf_body_force;
 		}
 		else if ((*optionIter).first == "sf_agent_body_force")
 		{
-			value >> sf_body_force;
+			value >> _context.parameters.sf_body_force;
 		}
 		else if ((*optionIter).first == "sf_sliding_friction_force")
 		{
-			value >> sf_sliding_friction_force;
-			// std::cout << "*************** set sf_sliding_friction_force to " << sf_sliding_friction_force << std::endl;
+			value >> _context.parameters.sf_sliding_friction_force;
+			// std::cout << "*************** set sf_sliding_friction_force to " << _context.parameters.sf_sliding_friction_force << std::endl;
 		}
 		else if ((*optionIter).first == "sf_agent_b")
 		{
-			value >> sf_agent_b;
+			value >> _context.parameters.sf_agent_b;
 		}
 		else if ((*optionIter).first == "sf_agent_a")
 		{
-			value >> sf_agent_a;
+			value >> _context.parameters.sf_agent_a;
 		}
 		else if ((*optionIter).first == "sf_wall_b")
 		{
-			value >> sf_wall_b;
+			value >> _context.parameters.sf_wall_b;
 		}
 		else if ((*optionIter).first == "sf_wall_a")
 		{
-			value >> sf_wall_a;
+			value >> _context.parameters.sf_wall_a;
 		}
 		else if ((*optionIter).first == "sf_max_speed")
 		{
-			value >> sf_max_speed;
+			value >> _context.parameters.sf_max_speed;
+		}
+		else if ((*optionIter).first == "batch")
+		{
+			useBatch = Util::getBoolFromString(value.str());
+			batchOptionGiven = true;
+		}
+		else if ((*optionIter).first == "batch_simd")
+		{
+			useBatchSIMD = Util::getBoolFromString(value.str());
+		}
+		else if ((*optionIter).first == "batch_symmetric")
+		{
+			useBatchSymmetric = Util::getBoolFromString(value.str());
+		}
+		else if ((*optionIter).first == "batch_threads")
+		{
+			value >> numBatchThreads;
+		}
+		else if ((*optionIter).first == "integrator")
+		{
+			if (value.str() == "euler") _context.integrator = SocialForcesGlobals::SF_INTEGRATOR_EULER;
+			else if (value.str() == "semi_implicit") _context.integrator = SocialForcesGlobals::SF_INTEGRATOR_SEMI_IMPLICIT_EULER;
+			else if (value.str() == "verlet") _context.integrator = SocialForcesGlobals::SF_INTEGRATOR_VERLET;
+			else if (value.str() == "rk2") _context.integrator = SocialForcesGlobals::SF_INTEGRATOR_RK2;
+			else if (value.str() == "rk4") _context.integrator = SocialForcesGlobals::SF_INTEGRATOR_RK4;
+			else throw Util::GenericException("unknown integrator \"" + value.str() + "\" given to the sfAI module; expected euler, semi_implicit, verlet, rk2 or rk4.");
+		}
+		else if ((*optionIter).first == "integrator_time_scale")
+		{
+			value >> _context.integratorTimeScale;
+		}
+		else if ((*optionIter).first == "integrator_tolerance")
+		{
+			value >> _context.integratorTolerance;
+		}
+		else if ((*optionIter).first == "integrator_max_substeps")
+		{
+			value >> _context.integratorMaxSubsteps;
 		}
 		else if ((*optionIter).first == "ailogFileName")
 		{
@@ -169,11 +186,11 @@ void SocialForcesAIModule::init( const SteerLib::OptionDictionary & options, Ste
 		}
 		else if ((*optionIter).first == "stats")
 		{
-			gShowStats = Util::getBoolFromString(value.str());
+			_context.showStats = Util::getBoolFromString(value.str());
 		}
 		else if ((*optionIter).first == "allstats")
 		{
-			gShowAllStats = Util::getBoolFromString(value.str());
+			_context.showAllStats = Util::getBoolFromString(value.str());
 		}
 		else
 		{
@@ -181,6 +198,20 @@ void SocialForcesAIModule::init( const SteerLib::OptionDictionary & options, Ste
 		}
 	}
 
+	if (_context.integratorTimeScale <= 0.0f || _context.integratorTolerance <= 0.0f || _context.integratorMaxSubsteps == 0) {
+		throw Util::GenericException("the sfAI integrator_time_scale, integrator_tolerance and integrator_max_substeps options must be positive.");
+	}
+
+	// the symmetric evaluation is part of the batch mode, so it also enables it, unless the batch mode was turned off.
+	if (useBatchSymmetric && batchOptionGiven && !useBatch) {
+		throw Util::GenericException("the sfAI batch_symmetric option needs the batch mode, but the batch option turns it off.");
+	}
+	_context.batch = (useBatch || useBatchSymmetric) ? &_batch : NULL;
+
+	_batch.setUseAVX2(useBatchSIMD);
+	_batch.setSymmetric(useBatchSymmetric);
+	_batch.setNumThreads(numBatchThreads);
+
 	if( logStats )
 	{
 
@@ -213,15 +244,14 @@ void SocialForcesAIModule::initializeSimulation()
 	//
 	// initialize the performance profilers
 	//
-	gPhaseProfilers = new PhaseProfilers;
-	gPhaseProfilers->aiProfiler.reset();
-	gPhaseProfilers->longTermPhaseProfiler.reset();
-	gPhaseProfilers->midTermPhaseProfiler.reset();
-	gPhaseProfilers->shortTermPhaseProfiler.reset();
-	gPhaseProfilers->perceptivePhaseProfiler.reset();
-	gPhaseProfilers->predictivePhaseProfiler.reset();
-	gPhaseProfilers->reactivePhaseProfiler.reset();
-	gPhaseProfilers->steeringPhaseProfiler.reset();
+	_context.phaseProfilers.aiProfiler.reset();
+	_context.phaseProfilers.longTermPhaseProfiler.reset();
+	_context.phaseProfilers.midTermPhaseProfiler.reset();
+	_context.phaseProfilers.shortTermPhaseProfiler.reset();
+	_context.phaseProfilers.perceptivePhaseProfiler.reset();
+	_context.phaseProfilers.predictivePhaseProfiler.reset();
+	_context.phaseProfilers.reactivePhaseProfiler.reset();
+	_context.phaseProfilers.steeringPhaseProfiler.reset();
 
 }
 
@@ -234,7 +264,8 @@ void SocialForcesAIModule::finish()
 
 void SocialForcesAIModule::preprocessSimulation()
 {
-    // nothing to do here
+	// the obstacles were created by initializeSimulation() of the test case player, and do not change during the simulation.
+	_walls.build(_engine->getObstacles());
 }
 
 
@@ -245,9 +276,9 @@ void SocialForcesAIModule::preprocessFrame(float timeStamp, float dt, unsigned i
 		// Adding in this extra one because it seemed sometimes agents would forget about obstacles.
 
 	}
-	if ( !agents_.empty() )
+	if ( _context.batch != NULL )
 	{
-
+		_batch.update(agents_, _engine);
 	}
 
 	/*
@@ -269,7 +300,7 @@ void SocialForcesAIModule::postprocessFrame(float timeStamp, float dt, unsigned
 
 SteerLib::AgentInterface * SocialForcesAIModule::createAgent()
 {
-	SocialForcesAgent * agent = new SocialForcesAgent;
+	SocialForcesAgent * agent = _agentPool.create(&_context);
 	agent->rvoModule = this;
 	agent->id_ = agents_.size();
 	agents_.push_back(agent);
@@ -306,8 +337,7 @@ void SocialForcesAIModule::destroyAgent( SteerLib::AgentInterface * agent )
 	}*/
 
 
-	// TODO this is going to be a memory leak for now.
-	delete agent;
+	_agentPool.destroy(dynamic_cast<SocialForcesAgent*>(agent));
 	/*
 	if (agent && &agents_ && (agents_.size() > 1))
 	{
@@ -328,34 +358,36 @@ void SocialForcesAIModule::destroyAgent( SteerLib::AgentInterface * agent )
 void SocialForcesAIModule::cleanupSimulation()
 {
 	agents_.clear();
+	_batch.clear();
+	_walls.clear();
 
 	if ( logStats )
 	{
 		LogObject rvoLogObject;
 
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getNumTimesExecuted());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTicksAccumulated());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getMinTicks());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getMaxTicks());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getMinExecutionTimeMills());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getMaxExecutionTimeMills());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getAverageExecutionTimeMills());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getTotalTime());
-		rvoLogObject.addLogData(gPhaseProfilers->aiProfiler.getTickFrequency());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getNumTimesExecuted());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTicksAccumulated());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getMinTicks());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxTicks());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getMinExecutionTimeMills());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getMaxExecutionTimeMills());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getAverageExecutionTimeMills());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getTotalTime());
+		rvoLogObject.addLogData(_context.phaseProfilers.aiProfiler.getTickFrequency());
 
 		_rvoLogger->writeLogObject(rvoLogObject);
 		_data = _data + _rvoLogger->logObjectToString(rvoLogObject);
 		_logData.push_back(rvoLogObject.copy());
 
 		// cleanup profileing metrics for next simulation/scenario
-		gPhaseProfilers->aiProfiler.reset();
-		gPhaseProfilers->longTermPhaseProfiler.reset();
-		gPhaseProfilers->midTermPhaseProfiler.reset();
-		gPhaseProfilers->shortTermPhaseProfiler.reset();
-		gPhaseProfilers->perceptivePhaseProfiler.reset();
-		gPhaseProfilers->predictivePhaseProfiler.reset();
-		gPhaseProfilers->reactivePhaseProfiler.reset();
-		gPhaseProfilers->steeringPhaseProfiler.reset();
+		_context.phaseProfilers.aiProfiler.reset();
+		_context.phaseProfilers.longTermPhaseProfiler.reset();
+		_context.phaseProfilers.midTermPhaseProfiler.reset();
+		_context.phaseProfilers.shortTermPhaseProfiler.reset();
+		_context.phaseProfilers.perceptivePhaseProfiler.reset();
+		_context.phaseProfilers.predictivePhaseProfiler.reset();
+		_context.phaseProfilers.reactivePhaseProfiler.reset();
+		_context.phaseProfilers.steeringPhaseProfiler.reset();
 	}
 
 }
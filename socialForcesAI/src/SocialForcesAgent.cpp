@@ -8,6 +8,8 @@
 #include <cmath>
 #include "SocialForcesAgent.h"
 #include "SocialForcesAIModule.h"
+#include "SocialForcesBatch.h"
+#include "SocialForcesWalls.h"
 #include "SocialForces_Parameters.h"
 // #include <math.h>
 
@@ -34,22 +36,16 @@ using namespace SteerLib;
 // #define _DEBUG_ENTROPY 1
 
 
-SocialForcesAgent::SocialForcesAgent()
+SocialForcesAgent::SocialForcesAgent(SocialForcesGlobals::SocialForcesAIContext * context)
 {
-	_SocialForcesParams.sf_acceleration = sf_acceleration;
-	_SocialForcesParams.sf_personal_space_threshold = sf_personal_space_threshold;
-	_SocialForcesParams.sf_agent_repulsion_importance = sf_agent_repulsion_importance;
-	_SocialForcesParams.sf_query_radius = sf_query_radius;
-	_SocialForcesParams.sf_body_force = sf_body_force;
-	_SocialForcesParams.sf_agent_body_force = sf_agent_body_force;
-	_SocialForcesParams.sf_sliding_friction_force = sf_sliding_friction_force;
-	_SocialForcesParams.sf_agent_b = sf_agent_b;
-	_SocialForcesParams.sf_agent_a = sf_agent_a;
-	_SocialForcesParams.sf_wall_b = sf_wall_b;
-	_SocialForcesParams.sf_wall_a = sf_wall_a;
-	_SocialForcesParams.sf_max_speed = sf_max_speed;
+	_context = context;
+	_SocialForcesParams = context->parameters;
 
 	_enabled = false;
+	_engine = NULL;
+	_spatialDatabase = NULL;
+	_hasBatchForces = false;
+	_substepSize = 0.0f;
 }
 
 
@@ -73,7 +69,7 @@ void SocialForcesAgent::disable()
 
 	//  1. remove from database
 	AxisAlignedBox b = AxisAlignedBox(_position.x - _radius, _position.x + _radius, 0.0f, 0.0f, _position.z - _radius, _position.z + _radius);
-	gSpatialDatabase->removeObject(dynamic_cast<SpatialDatabaseItemPtr>(this), b);
+	_spatialDatabase->removeObject(dynamic_cast<SpatialDatabaseItemPtr>(this), b);
 
 	std::cout << "agent" << id() << " has reached goal." << std::endl;
 
@@ -83,6 +79,9 @@ void SocialForcesAgent::disable()
 
 void SocialForcesAgent::reset(const SteerLib::AgentInitialConditions & initialConditions, SteerLib::EngineInterface * engineInfo)
 {
+	_engine = engineInfo;
+	_spatialDatabase = engineInfo->getSpatialDatabase();
+
 	// compute the "old" bounding box of the agent before it is reset.  its OK that it will be invalid if the agent was previously disabled
 	// because the value is not used in that case.
 	// std::cout << "resetting agent " << this << std::endl;
@@ -103,6 +102,7 @@ void SocialForcesAgent::reset(const SteerLib::AgentInitialConditions & initialCo
 	_forward = normalize(initialConditions.direction);
 	_radius = initialConditions.radius;
 	_velocity = initialConditions.speed * _forward;
+	_substepSize = 0.0f;
 	// std::cout << "inital colour of agent " << initialConditions.color << std::endl;
 	if ( initialConditions.colorSet == true )
 	{
@@ -119,14 +119,14 @@ void SocialForcesAgent::reset(const SteerLib::AgentInitialConditions & initialCo
 	if (!_enabled) {
 		// if the agent was not enabled, then it does not already exist in the database, so add it.
 		// std::cout
-		gSpatialDatabase->addObject( dynamic_cast<SpatialDatabaseItemPtr>(this), newBounds);
+		_spatialDatabase->addObject( dynamic_cast<SpatialDatabaseItemPtr>(this), newBounds);
 	}
 	else {
 		// if the agent was enabled, then the agent already existed in the database, so update it instead of adding it.
 		// std::cout << "new position is " << _position << std::endl;
 		// std::cout << "new bounds are " << newBounds << std::endl;
 		// std::cout << "reset update " << this << std::endl;
-		gSpatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
+		_spatialDatabase->updateObject( dynamic_cast<SpatialDatabaseItemPtr>(this), oldBounds, newBounds);
 		// engineInfo->getSpatialDatabase()->updateObject( this, oldBounds, newBounds);
 	}
 
@@ -152,7 +152,7 @@ void SocialForcesAgent::reset(const SteerLib::AgentInitialConditions & initialCo
 			{
 				// if the goal is random, we must randomly generate the goal.
 				// std::cout << "assigning random goal" << std::endl;
-				_goalQueue.back().targetLocation = gSpatialDatabase->randomPositionWithoutCollisions(1.0f, true);
+				_goalQueue.back().targetLocation = _spatialDatabase->randomPositionWithoutCollisions(1.0f, true);
 			}
 		}
 		else {
@@ -236,55 +236,25 @@ std::pair<float, Util::Point> minimum_distance(Util::Point l1, Util::Point l2, U
 }
 
 
-Util::Vector SocialForcesAgent::calcProximityForce(float dt)
+void SocialForcesAgent::gatherNeighbors()
 {
-	Util::Vector away = Util::Vector(0, 0, 0);
-	Util::Vector away_obs = Util::Vector(0, 0, 0);
+	_neighborAgents.clear();
+	_neighborObstacles.clear();
 
-	const float agent_a = _SocialForcesParams.sf_agent_a;
-	const float agent_b = _SocialForcesParams.sf_agent_b;
-	const float wall_a = _SocialForcesParams.sf_wall_a;
-	const float wall_b = _SocialForcesParams.sf_wall_b;
 	const float proximity_radius = _SocialForcesParams.sf_query_radius + _radius;
 	std::set<SteerLib::SpatialDatabaseItemPtr> neighbors;
-	gSpatialDatabase->getItemsInRange(neighbors, _position.x - proximity_radius, _position.x + proximity_radius,
+	_spatialDatabase->getItemsInRange(neighbors, _position.x - proximity_radius, _position.x + proximity_radius,
 												 _position.z - proximity_radius, _position.z + proximity_radius, dynamic_cast<SteerLib::SpatialDatabaseItemPtr>(this));
 
+	// the set keeps the same (pointer) order as before, so the forces are summed in the same order.
 	for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbor = neighbors.begin(); neighbor != neighbors.end(); neighbor++) {
 		if ((*neighbor)->isAgent()) {
-
-			AgentInterface *tmp_agent = dynamic_cast<AgentInterface *>(*neighbor);
-
-			if (id() != tmp_agent->id()) {
-				Util::Vector distanceVec = (position() - tmp_agent->position());
-				Util::Vector directionVec = normalize(distanceVec);
-				float distance = distanceVec.length();
-				float sumRadius = radius() + tmp_agent->radius();
-				float realDistance = sumRadius + _SocialForcesParams.sf_personal_space_threshold - distance;
-
-				float psychologicalForce = agent_a * exp((realDistance) / agent_b);
-				Util::Vector psychologicalForceVec = directionVec * psychologicalForce;
-				away = away + psychologicalForceVec * dt;
-			}
-
-		} else {
-			SteerLib::ObstacleInterface *obstacle = dynamic_cast<SteerLib::ObstacleInterface *>(*neighbor);
-
-			Util::Vector wall_normal = calcWallNormal(obstacle);
-			std::pair<Util::Point, Util::Point> line = calcWallPointsFromNormal(obstacle, wall_normal);
-			std::pair<float, Util::Point> min_stuff = minimum_distance(line.first, line.second, position());
-			
-			Util::Vector distanceVec = (position() - min_stuff.second);
-			Util::Vector directionVec = normalize(distanceVec);
-			float distance = distanceVec.length();
-			float realDistance = radius() + _SocialForcesParams.sf_personal_space_threshold - distance;
-			float psychologicalForce = agent_a * exp((realDistance) / agent_b);
-			Util::Vector psychologicalForceVec = wall_normal * psychologicalForce;
-			away_obs = away_obs + psychologicalForceVec * dt;
+			_neighborAgents.push_back(dynamic_cast<SteerLib::AgentInterface *>(*neighbor));
+		}
+		else {
+			_neighborObstacles.push_back(dynamic_cast<SteerLib::ObstacleInterface *>(*neighbor));
 		}
 	}
-
-	return away + away_obs;
 }
 
 
@@ -294,48 +264,37 @@ Vector SocialForcesAgent::calcGoalForce(Vector _goalDirection, float _dt)
 }
 
 
-Util::Vector SocialForcesAgent::calcRepulsionForce(float dt)
+void SocialForcesAgent::calcNeighborForces(float dt, Util::Vector & repulsionForce, Util::Vector & proximityForce)
 {
-#ifdef _DEBUG_
-	std::cout << "wall repulsion; " << calcWallRepulsionForce(dt) << " agent repulsion " <<
-			(_SocialForcesParams.sf_agent_repulsion_importance * calcAgentRepulsionForce(dt)) << std::endl;
-#endif
-	return calcWallRepulsionForce(dt) + (_SocialForcesParams.sf_agent_repulsion_importance * calcAgentRepulsionForce(dt));
-}
-
-Util::Vector SocialForcesAgent::calcAgentRepulsionForce(float dt)
-{
-    Util::Vector agent_repulsion_force = Util::Vector(0,0,0);
-
-	std::set<SteerLib::SpatialDatabaseItemPtr> _neighbors;
-	gEngine->getSpatialDatabase()->getItemsInRange(_neighbors, 
-		_position.x - (this->_radius + _SocialForcesParams.sf_query_radius),
-		_position.x + (this->_radius + _SocialForcesParams.sf_query_radius),
-		_position.z - (this->_radius + _SocialForcesParams.sf_query_radius),
-		_position.z + (this->_radius + _SocialForcesParams.sf_query_radius),
-		dynamic_cast<SteerLib::SpatialDatabaseItemPtr>(this));
+	Util::Vector away = Util::Vector(0, 0, 0);
+	Util::Vector away_obs = Util::Vector(0, 0, 0);
+	Util::Vector agent_repulsion_force = Util::Vector(0,0,0);
+	Util::Vector wall_repulsion_force = Util::Vector(0,0,0);
 
-	SteerLib::AgentInterface *tmp_agent;
+	const float agent_a = _SocialForcesParams.sf_agent_a;
+	const float agent_b = _SocialForcesParams.sf_agent_b;
 
-	for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbour = _neighbors.begin(); neighbour != _neighbors.end(); neighbour++)
-	{
-		if ((*neighbour)->isAgent())
-		{
-			tmp_agent = dynamic_cast<SteerLib::AgentInterface *>(* neighbour);
-		}
-		else
-		{
+	for (unsigned int i=0; i < _neighborAgents.size(); i++) {
+		SteerLib::AgentInterface *tmp_agent = _neighborAgents[i];
+		if (id() == tmp_agent->id()) {
 			continue;
 		}
 
+		Util::Vector distanceVec = (position() - tmp_agent->position());
+		Util::Vector directionVec = normalize(distanceVec);
+		float distance = distanceVec.length();
+		float sumRadius = radius() + tmp_agent->radius();
+
+		// proximity (psychological) force
+		float realDistance = sumRadius + _SocialForcesParams.sf_personal_space_threshold - distance;
+		float psychologicalForce = agent_a * exp((realDistance) / agent_b);
+		Util::Vector psychologicalForceVec = directionVec * psychologicalForce;
+		away = away + psychologicalForceVec * dt;
+
+		// repulsion (body and sliding friction) force, only when the agents overlap
 		float penetration = tmp_agent->computePenetration(this->position(), this->radius());
-		if (id() != tmp_agent->id() && penetration > 0.000001) {
-			Util::Vector distanceVec = (position() - tmp_agent->position());
-			Util::Vector directionVec = normalize(distanceVec);
+		if (penetration > 0.000001) {
 			Util::Vector perpendicularVec = Util::Vector(-distanceVec.z, 0.0f, distanceVec.x);
-			float distance = distanceVec.length();
-			float sumRadius = radius() + tmp_agent->radius();
-			float realDistance = sumRadius - distance;
 
 			float penetrationForce = _SocialForcesParams.sf_agent_body_force * penetration;
 			float velocityOfAgent = dot(normalize(velocity() - tmp_agent->velocity()), perpendicularVec);
@@ -348,53 +307,200 @@ Util::Vector SocialForcesAgent::calcAgentRepulsionForce(float dt)
 		}
 	}
 
-	return agent_repulsion_force;
+	calcObstacleForces(dt, wall_repulsion_force, away_obs);
+
+#ifdef _DEBUG_
+	std::cout << "wall repulsion; " << wall_repulsion_force << " agent repulsion " <<
+			(_SocialForcesParams.sf_agent_repulsion_importance * agent_repulsion_force) << std::endl;
+#endif
+	repulsionForce = wall_repulsion_force + (_SocialForcesParams.sf_agent_repulsion_importance * agent_repulsion_force);
+	proximityForce = away + away_obs;
 }
 
 
-Util::Vector SocialForcesAgent::calcWallRepulsionForce(float dt)
+void SocialForcesAgent::calcObstacleForces(float dt, Util::Vector & repulsionForce, Util::Vector & proximityForce)
 {
+	Util::Vector away_obs = Util::Vector(0, 0, 0);
 	Util::Vector wall_repulsion_force = Util::Vector(0,0,0);
 
-	const float proximity_radius = _SocialForcesParams.sf_query_radius + this->_radius;
-	
-	std::set<SteerLib::SpatialDatabaseItemPtr> neighbors;
-	gSpatialDatabase->getItemsInRange(neighbors,
-		_position.x - proximity_radius,
-		_position.x + proximity_radius,
-		_position.z - proximity_radius,
-		_position.z + proximity_radius,
-		dynamic_cast<SteerLib::SpatialDatabaseItemPtr>(this));
-
-	SteerLib::ObstacleInterface* tmp_ob;
+	const float agent_a = _SocialForcesParams.sf_agent_a;
+	const float agent_b = _SocialForcesParams.sf_agent_b;
 
-	for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbour = neighbors.begin(); neighbour!= neighbors.end(); neighbour++){
-		if ((*neighbour)->isAgent()){
-			continue;
+	for (unsigned int i=0; i < _neighborObstacles.size(); i++) {
+		SteerLib::ObstacleInterface *obstacle = _neighborObstacles[i];
+
+		// the precomputed segments also handle oriented boxes and polygons; obstacles added after preprocessSimulation() use their bounds,
+		// except polygons, which can answer exactly.
+		Util::Vector wall_normal;
+		std::pair<float, Util::Point> min_stuff;
+		bool precomputed = _context->walls->getClosestWallPoint(obstacle, position(), min_stuff.second, wall_normal, min_stuff.first);
+		PolygonObstacle * polygon = precomputed ? NULL : dynamic_cast<PolygonObstacle*>(obstacle);
+		if (polygon != NULL) {
+			min_stuff.first = fabsf(polygon->computeSignedDistance(position(), min_stuff.second, wall_normal));
+		}
+		else if (!precomputed) {
+			wall_normal = calcWallNormal(obstacle);
+			std::pair<Util::Point, Util::Point> line = calcWallPointsFromNormal(obstacle, wall_normal);
+			min_stuff = minimum_distance(line.first, line.second, position());
 		}
 
-		tmp_ob = dynamic_cast<SteerLib::ObstacleInterface*>(*neighbour);
-		
-		float penetration = tmp_ob->computePenetration(this->position(), this->radius());
-		if (penetration > 0.000001){
-			Util::Vector wall_normal = calcWallNormal(tmp_ob);
-			std::pair<Util::Point,Util::Point> line = calcWallPointsFromNormal(tmp_ob, wall_normal);
-			std::pair<float, Util::Point> min_stuff = minimum_distance(line.first, line.second, position());
-
-			Util::Vector distanceVec = (position() - min_stuff.second);
-			Util::Vector directionVec = normalize(distanceVec);
+		// proximity (psychological) force
+		Util::Vector distanceVec = (position() - min_stuff.second);
+		float distance = distanceVec.length();
+		float realDistance = radius() + _SocialForcesParams.sf_personal_space_threshold - distance;
+		float psychologicalForce = agent_a * exp((realDistance) / agent_b);
+		Util::Vector psychologicalForceVec = wall_normal * psychologicalForce;
+		away_obs = away_obs + psychologicalForceVec * dt;
+
+		// repulsion (body and sliding friction) force, only when the agent overlaps the wall
+		float penetration = obstacle->computePenetration(this->position(), this->radius());
+		if (penetration > 0.000001) {
 			Util::Vector perpendicularVec = Util::Vector(-wall_normal.z, 0.0f, wall_normal.x);
-			float distance = distanceVec.length();
-			float repulsionForce = _SocialForcesParams.sf_body_force * (min_stuff.first + radius());
+			float wallRepulsionForce = _SocialForcesParams.sf_body_force * (min_stuff.first + radius());
 			float slidingForce = _SocialForcesParams.sf_sliding_friction_force * penetration *  (dot(normalize(velocity()), perpendicularVec));
-			Util::Vector repulsionForceVec = repulsionForce * wall_normal;
+			Util::Vector repulsionForceVec = wallRepulsionForce * wall_normal;
 			Util::Vector slidingForceVec = slidingForce * perpendicularVec;
 
 			wall_repulsion_force = wall_repulsion_force + (repulsionForceVec + slidingForceVec) * dt;
 		}
 	}
-	
-	return wall_repulsion_force;
+
+	repulsionForce = wall_repulsion_force;
+	proximityForce = away_obs;
+}
+
+
+void SocialForcesAgent::calcForces(const Util::Vector & goalDirection, float dt, Util::Vector & prefForce, Util::Vector & repulsionForce, Util::Vector & proximityForce)
+{
+	prefForce = calcGoalForce( goalDirection, dt );
+
+	if (_hasBatchForces)
+	{
+		Util::Vector wallRepulsionForce;
+		Util::Vector wallProximityForce;
+		calcObstacleForces(dt, wallRepulsionForce, wallProximityForce);
+		repulsionForce = wallRepulsionForce + (_SocialForcesParams.sf_agent_repulsion_importance * (_batchRepulsionForce * dt));
+		proximityForce = _batchProximityForce * dt + wallProximityForce;
+	}
+	else
+	{
+		calcNeighborForces(dt, repulsionForce, proximityForce);
+	}
+}
+
+
+Util::Vector SocialForcesAgent::calcAccelerationAt(const Util::Point & position, const Util::Vector & velocity, const Util::Vector & goalDirection, float forceDt)
+{
+	_position = position;
+	_velocity = velocity;
+
+	Util::Vector prefForce;
+	Util::Vector repulsionForce;
+	Util::Vector proximityForce;
+	calcForces(goalDirection, forceDt, prefForce, repulsionForce, proximityForce);
+	return (prefForce + repulsionForce + proximityForce) / AGENT_MASS;
+}
+
+
+void SocialForcesAgent::integrate(float dt, float forceDt, const Util::Vector & goalDirection, const Util::Vector & acceleration)
+{
+	const float tolerance = _context->integratorTolerance;
+	const float minSubstep = dt / _context->integratorMaxSubsteps;
+	// the goal force relaxes the velocity towards the preferred velocity at this rate; it is the stiff term at large dt.
+	const float relaxationRate = MASS / (forceDt * AGENT_MASS);
+	// the explicit integrators become unstable on that term when a substep is longer than the relaxation time, and their
+	// error estimates do not always notice (e.g. RK4 and the midpoint method amplify it by the same factor at h = 4 / rate).
+	const float maxSubstep = (_context->integrator == SocialForcesGlobals::SF_INTEGRATOR_SEMI_IMPLICIT_EULER) ? dt : std::max(1.0f / relaxationRate, minSubstep);
+
+	// only the state of this agent moves between the stages; the neighbors are read as the engine leaves them, so the ones
+	// updated earlier in this frame are already at their new state (in the batch mode, the agent forces are from the start of the frame).
+	Util::Point x = _position;
+	Util::Vector v = _velocity;
+	Util::Vector a = acceleration;
+	float remaining = dt;
+	float substep = (_substepSize > 0.0f) ? _substepSize : dt;
+
+	while (remaining > 0.0f)
+	{
+		float h = std::max(std::min(std::min(substep, maxSubstep), remaining), std::min(minSubstep, remaining));
+		if (remaining - h < 0.01f * minSubstep)
+		{
+			h = remaining;
+		}
+
+		// each integrator also computes a lower order estimate of the same substep; their difference is the error estimate, in meters.
+		Util::Point newX;
+		Util::Vector newV;
+		float error;
+		switch (_context->integrator)
+		{
+		case SocialForcesGlobals::SF_INTEGRATOR_SEMI_IMPLICIT_EULER:
+		{
+			// v' = v + h * (a with the goal force evaluated at v'), solved for v'; then x' from v'.
+			newV = v + a * (h / (1.0f + h * relaxationRate));
+			newX = x + newV * h;
+			error = (newV - v).length() * h;
+			break;
+		}
+		case SocialForcesGlobals::SF_INTEGRATOR_VERLET:
+		{
+			newX = x + v * h + a * (0.5f * h * h);
+			Util::Vector a1 = calcAccelerationAt(newX, v + a * h, goalDirection, forceDt);
+			newV = v + (a + a1) * (0.5f * h);
+			error = (a1 - a).length() * (0.5f * h * h);
+			break;
+		}
+		case SocialForcesGlobals::SF_INTEGRATOR_RK2:
+		{
+			Util::Point x1 = x + v * h;
+			Util::Vector v1 = v + a * h;
+			Util::Vector a1 = calcAccelerationAt(x1, v1, goalDirection, forceDt);
+			newX = x + (v + v1) * (0.5f * h);
+			newV = v + (a + a1) * (0.5f * h);
+			error = (newX - x1).length() + (newV - v1).length() * h;
+			break;
+		}
+		default:
+		{
+			const float half = 0.5f * h;
+			Util::Vector v2 = v + a * half;
+			Util::Vector a2 = calcAccelerationAt(x + v * half, v2, goalDirection, forceDt);
+			Util::Vector v3 = v + a2 * half;
+			Util::Vector a3 = calcAccelerationAt(x + v2 * half, v3, goalDirection, forceDt);
+			Util::Vector v4 = v + a3 * h;
+			Util::Vector a4 = calcAccelerationAt(x + v3 * h, v4, goalDirection, forceDt);
+			newX = x + (v + 2.0f * v2 + 2.0f * v3 + v4) * (h / 6.0f);
+			newV = v + (a + 2.0f * a2 + 2.0f * a3 + a4) * (h / 6.0f);
+			// the midpoint method uses the second stage only
+			error = (newX - (x + v2 * h)).length() + (newV - (v + a2 * h)).length() * h;
+			break;
+		}
+		}
+
+		// written so that a NaN error is rejected as well
+		if (!(error <= tolerance) && h > minSubstep)
+		{
+			substep = std::max(0.5f * h, minSubstep);
+			continue;
+		}
+
+		x = newX;
+		v = clamp(newV, _SocialForcesParams.sf_max_speed);
+		v.y = 0.0f;
+		remaining -= h;
+		if (error < 0.25f * tolerance)
+		{
+			substep = std::max(substep, 2.0f * h);
+		}
+		if (remaining > 0.0f)
+		{
+			a = calcAccelerationAt(x, v, goalDirection, forceDt);
+		}
+	}
+
+	_substepSize = std::min(substep, dt);
+	_position = x;
+	_velocity = v;
 }
 
 
@@ -550,7 +656,7 @@ bool SocialForcesAgent::reachedCurrentWaypoint()
 	}
 	else
 	{
-		false;
+		return false;
 	}
 
 	// return (position() - _currentLocalTarget).lengthSquared() < (radius()*radius());
@@ -568,8 +674,8 @@ bool SocialForcesAgent::hasLineOfSightTo(Util::Point target)
 	lineOfSightTestRight.initWithUnitInterval(_position + _radius*_rightSide, target - _position);
 	lineOfSightTestLeft.initWithUnitInterval(_position + _radius*(_rightSide), target - _position);
 
-	return (!gSpatialDatabase->trace(lineOfSightTestRight,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true))
-		&& (!gSpatialDatabase->trace(lineOfSightTestLeft,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true));
+	return (!_spatialDatabase->trace(lineOfSightTestRight,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true))
+		&& (!_spatialDatabase->trace(lineOfSightTestLeft,dummyt, dummyObject, dynamic_cast<SpatialDatabaseItemPtr>(this),true));
 
 }
 
@@ -577,7 +683,7 @@ bool SocialForcesAgent::hasLineOfSightTo(Util::Point target)
 void SocialForcesAgent::updateAI(float timeStamp, float dt, unsigned int frameNumber)
 {
 	// std::cout << "_SocialForcesParams.rvo_max_speed " << _SocialForcesParams._SocialForcesParams.rvo_max_speed << std::endl;
-	Util::AutomaticFunctionProfiler profileThisFunction( &SocialForcesGlobals::gPhaseProfilers->aiProfiler );
+	Util::AutomaticFunctionProfiler profileThisFunction( &_context->phaseProfilers.aiProfiler );
 	if (!enabled())
 	{
 		return;
@@ -605,14 +711,30 @@ void SocialForcesAgent::updateAI(float timeStamp, float dt, unsigned int frameNu
 	}
 
     /*
-     *  Goal Force
+     *  Neighbors, from one query; all force evaluations of this frame use them
      */
-    Util::Vector prefForce = calcGoalForce( goalDirection, dt );
+	// batch mode: the agent-agent forces were computed for all agents by the module, only the obstacles are gathered here.
+	_hasBatchForces = _context->batch != NULL && _context->batch->getAgentForces(id_, _batchRepulsionForce, _batchProximityForce);
+	if (_hasBatchForces)
+	{
+		_neighborAgents.clear();
+		_neighborObstacles.clear();
+		_context->batch->getObstaclesInRange(_position, _SocialForcesParams.sf_query_radius + _radius, _neighborObstacles);
+	}
+	else
+	{
+		gatherNeighbors();
+	}
 
     /*
-     *  Repulsion Force
+     *  Goal, Repulsion and Proximity Forces
      */
-	Util::Vector repulsionForce = calcRepulsionForce(dt);
+	// explicit Euler scales the forces by the frame dt as it always did; the other integrators by the fixed time scale of the model.
+	const float forceDt = (_context->integrator == SocialForcesGlobals::SF_INTEGRATOR_EULER) ? dt : _context->integratorTimeScale;
+	Util::Vector prefForce;
+	Util::Vector repulsionForce;
+	Util::Vector proximityForce;
+	calcForces(goalDirection, forceDt, prefForce, repulsionForce, proximityForce);
 
 	if ( repulsionForce.x != repulsionForce.x)
 	{
@@ -620,11 +742,6 @@ void SocialForcesAgent::updateAI(float timeStamp, float dt, unsigned int frameNu
 		// repulsionForce = velocity() * 0;
 	}
 
-    /*
-     *  Proximity Force
-     */
-	Util::Vector proximityForce = calcProximityForce(dt);
-
 // #define _DEBUG_ 1
 #ifdef _DEBUG_
 	std::cout << "agent" << id() << " repulsion force " << repulsionForce << std::endl;
@@ -639,13 +756,20 @@ void SocialForcesAgent::updateAI(float timeStamp, float dt, unsigned int frameNu
 	}
 
 	Util::Vector acceleration = (prefForce + repulsionForce + proximityForce) / AGENT_MASS;
-	_velocity = velocity() + acceleration * dt;
-	_velocity = clamp(velocity(), _SocialForcesParams.sf_max_speed);
-	_velocity.y=0.0f;
+	if (_context->integrator == SocialForcesGlobals::SF_INTEGRATOR_EULER)
+	{
+		_velocity = velocity() + acceleration * dt;
+		_velocity = clamp(velocity(), _SocialForcesParams.sf_max_speed);
+		_velocity.y=0.0f;
+		_position = position() + (velocity() * dt);
+	}
+	else
+	{
+		integrate(dt, forceDt, goalDirection, acceleration);
+	}
 #ifdef _DEBUG_
 	std::cout << "agent" << id() << " speed is " << velocity().length() << std::endl;
 #endif
-	_position = position() + (velocity() * dt);
 	// A grid database update should always be done right after the new position of the agent is calculated
 	/*
 	 * Or when the agent is removed for example its true location will not reflect its location in the grid database.
@@ -654,7 +778,7 @@ void SocialForcesAgent::updateAI(float timeStamp, float dt, unsigned int frameNu
 	 */
 	// std::cout << "Updating agent" << this->id() << " at " << this->position() << std::endl;
 	Util::AxisAlignedBox newBounds(_position.x - _radius, _position.x + _radius, 0.0f, 0.0f, _position.z - _radius, _position.z + _radius);
-	gSpatialDatabase->updateObject( this, oldBounds, newBounds);
+	_spatialDatabase->updateObject( this, oldBounds, newBounds);
 
 /*
 	if ( ( !_waypoints.empty() ) && (_waypoints.front() - position()).length() < radius()*WAYPOINT_THRESHOLD_MULTIPLIER)
@@ -768,7 +892,7 @@ bool SocialForcesAgent::runLongTermPlanning()
 
 	std::cout << "agent: " << id() << ", " <<  pos << ", " << _goalQueue.front().targetLocation << std::endl;
 	
-	if(!astar.computePath(agentPath, pos, _goalQueue.front().targetLocation, gSpatialDatabase))
+	if(!astar.computePath(agentPath, pos, _goalQueue.front().targetLocation, _spatialDatabase))
 	{
 		std::cout << "no path found" << std::endl;
 		return false;
@@ -801,17 +925,17 @@ bool SocialForcesAgent::runLongTermPlanning2()
 
 	std::cout << "agent: " << id() << ", " <<  pos << ", " << _goalQueue.front().targetLocation << "\n" << std::endl;
 	
-	if(!astar.computePath(agentPath, pos, _goalQueue.front().targetLocation, gSpatialDatabase))
+	if(!astar.computePath(agentPath, pos, _goalQueue.front().targetLocation, _spatialDatabase))
 	{
 		return false;
 	}
 
-	if (gEngine->isAgentSelected(this))
+	if (_engine->isAgentSelected(this))
 	{
 		// std::cout << "agent" << this->id() << " is running planning again" << std::endl;
 	}
 
-	if (!gSpatialDatabase->findSmoothPath(pos, _goalQueue.front().targetLocation,
+	if (!_spatialDatabase->findSmoothPath(pos, _goalQueue.front().targetLocation,
 			agentPath, (unsigned int) 50000))
 	{
 		return false;
@@ -834,14 +958,14 @@ void SocialForcesAgent::draw()
 {
 #ifdef ENABLE_GUI
 	// if the agent is selected, do some annotations just for demonstration
-	if (gEngine->isAgentSelected(this))
+	if (_engine->isAgentSelected(this))
 	{
 		Util::Ray ray;
 		ray.initWithUnitInterval(_position, _forward);
 		float t = 0.0f;
 		SteerLib::SpatialDatabaseItem * objectFound;
 		Util::DrawLib::drawLine(ray.pos, ray.eval(1.0f));
-		if (gSpatialDatabase->trace(ray, t, objectFound, this, false))
+		if (_spatialDatabase->trace(ray, t, objectFound, this, false))
 		{
 			Util::DrawLib::drawAgentDisc(_position, _forward, _radius, Util::gBlue);
 		}
@@ -875,7 +999,7 @@ void SocialForcesAgent::draw()
 
 #ifdef DRAW_COLLISIONS
 	std::set<SteerLib::SpatialDatabaseItemPtr> _neighbors;
-	gSpatialDatabase->getItemsInRange(_neighbors, _position.x-(this->_radius * 3), _position.x+(this->_radius * 3),
+	_spatialDatabase->getItemsInRange(_neighbors, _position.x-(this->_radius * 3), _position.x+(this->_radius * 3),
 			_position.z-(this->_radius * 3), _position.z+(this->_radius * 3), dynamic_cast<SteerLib::SpatialDatabaseItemPtr>(this));
 
 	for (std::set<SteerLib::SpatialDatabaseItemPtr>::iterator neighbor = _neighbors.begin();  neighbor != _neighbors.end();  neighbor++)
@@ -915,7 +1039,7 @@ void SocialForcesAgent::draw()
 
 	for (int i=0; ( _waypoints.size() > 1 ) && (i < (_waypoints.size() - 1)); i++)
 	{
-		if ( gEngine->isAgentSelected(this) )
+		if ( _engine->isAgentSelected(this) )
 		{
 			DrawLib::drawLine(_waypoints.at(i), _waypoints.at(i+1), gYellow);
 		}
@@ -932,7 +1056,7 @@ void SocialForcesAgent::draw()
 
 	for (int i=0; ( _midTermPath.size() > 1 ) && (i < (_midTermPath.size() - 1)); i++)
 	{
-		if ( gEngine->isAgentSelected(this) )
+		if ( _engine->isAgentSelected(this) )
 		{
 			DrawLib::drawLine(_midTermPath.at(i), _midTermPath.at(i+1), gMagenta);
 		}
@@ -947,7 +1071,7 @@ void SocialForcesAgent::draw()
 
 	
 	// draw normals and closest points on walls
-	std::set<SteerLib::ObstacleInterface * > tmp_obs = gEngine->getObstacles();
+	std::set<SteerLib::ObstacleInterface * > tmp_obs = _engine->getObstacles();
 
 	for (std::set<SteerLib::ObstacleInterface * >::iterator tmp_o = tmp_obs.begin();  tmp_o != tmp_obs.end();  tmp_o++)
 	{
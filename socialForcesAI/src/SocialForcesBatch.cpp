@@ -0,0 +1,865 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+
+/// @file SocialForcesBatch.cpp
+/// @brief Implements the SocialForcesBatch class.
+
+
+#include <cmath>
+#include <algorithm>
+#include "SocialForcesBatch.h"
+#include "SocialForcesAgent.h"
+
+// The AVX2 kernel is compiled for x86 with per-function target attributes (gcc, clang) or plain intrinsics (msvc),
+// and only called after checking the processor at run-time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SF_BATCH_HAS_AVX2_KERNEL 1
+#define SF_BATCH_AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SF_BATCH_HAS_AVX2_KERNEL 1
+#define SF_BATCH_AVX2_FUNCTION
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+
+using namespace SteerLib;
+
+
+// constants of fastExp(): the clamping range, 1/ln2, ln2 split into an exactly representable part and the rest, and the Taylor coefficients.
+#define FAST_EXP_MIN -87.0f
+#define FAST_EXP_MAX 88.0f
+#define FAST_EXP_LOG2E 1.44269504088896341f
+#define FAST_EXP_LN2_HI 0.693359375f
+#define FAST_EXP_LN2_LO -2.12194440e-4f
+#define FAST_EXP_C2 (1.0f/2.0f)
+#define FAST_EXP_C3 (1.0f/6.0f)
+#define FAST_EXP_C4 (1.0f/24.0f)
+#define FAST_EXP_C5 (1.0f/120.0f)
+#define FAST_EXP_C6 (1.0f/720.0f)
+
+// neighbors are only included if they overlap; the same threshold calcNeighborForces() uses.
+#define MIN_PENETRATION 0.000001f
+
+// upper bound on the number of grid cells; the cell size grows if a huge world would need more.
+#define MAX_NUM_CELLS (1 << 22)
+
+
+const unsigned int SocialForcesBatch::NOT_IN_BATCH;
+
+
+static bool processorSupportsAVX2()
+{
+#if defined(SF_BATCH_HAS_AVX2_KERNEL) && defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(SF_BATCH_HAS_AVX2_KERNEL)
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesAVXState = ((info[2] & (1 << 27)) != 0) && ((_xgetbv(0) & 6) == 6);
+	bool hasFMA = (info[2] & (1 << 12)) != 0;
+	__cpuidex(info, 7, 0);
+	bool hasAVX2 = (info[1] & (1 << 5)) != 0;
+	return osSavesAVXState && hasFMA && hasAVX2;
+#else
+	return false;
+#endif
+}
+
+
+SocialForcesBatch::SocialForcesBatch()
+{
+	_useAVX2 = processorSupportsAVX2();
+	_symmetric = false;
+	_numThreads = 1;
+	_threadPool = NULL;
+	_originX = 0.0f;
+	_originZ = 0.0f;
+	_cellSize = 0.0f;
+	_invCellSize = 0.0f;
+	_numCellsX = 0;
+	_numCellsZ = 0;
+}
+
+
+SocialForcesBatch::~SocialForcesBatch()
+{
+	if (_threadPool != NULL) {
+		delete _threadPool;
+	}
+}
+
+
+void SocialForcesBatch::setNumThreads(unsigned int numThreads)
+{
+	if (numThreads == 0) {
+		throw Util::GenericException("SocialForcesBatch: the number of threads must be at least 1.");
+	}
+	if (numThreads == _numThreads) {
+		return;
+	}
+
+	if (_threadPool != NULL) {
+		delete _threadPool;
+		_threadPool = NULL;
+	}
+	_numThreads = numThreads;
+	if (_numThreads > 1) {
+		_threadPool = new Util::ThreadedTaskManager(_numThreads);
+	}
+}
+
+
+void SocialForcesBatch::setUseAVX2(bool useAVX2)
+{
+	_useAVX2 = useAVX2 && processorSupportsAVX2();
+}
+
+
+float SocialForcesBatch::fastExp(float x)
+{
+	x = std::min(std::max(x, FAST_EXP_MIN), FAST_EXP_MAX);
+	float n = std::floor(x * FAST_EXP_LOG2E + 0.5f);
+	float r = x - n * FAST_EXP_LN2_HI;
+	r = r - n * FAST_EXP_LN2_LO;
+
+	float p = FAST_EXP_C6;
+	p = p * r + FAST_EXP_C5;
+	p = p * r + FAST_EXP_C4;
+	p = p * r + FAST_EXP_C3;
+	p = p * r + FAST_EXP_C2;
+	p = p * r + 1.0f;
+	p = p * r + 1.0f;
+
+	// 2^n, built directly in the exponent bits; n is in [-126, 127] after clamping.
+	union { unsigned int i; float f; } scale;
+	scale.i = (unsigned int)((int)n + 127) << 23;
+	return p * scale.f;
+}
+
+
+void SocialForcesBatch::clear()
+{
+	_agents.clear();
+	_agentIds.clear();
+	_sortedIndexOfAgentId.clear();
+	_neighborStart.clear();
+	_neighborIndices.clear();
+	_obstacles.clear();
+	_cellObstacleStart.clear();
+	_cellObstacles.clear();
+	_cellSize = 0.0f;
+}
+
+
+void SocialForcesBatch::update(const std::vector<SteerLib::AgentInterface*> & agents, SteerLib::EngineInterface * engine)
+{
+	_unsortedAgents.clear();
+	float maxInteractionDistance = 0.0f;
+	float maxRadius = 0.0f;
+	float maxQueryRadius = 0.0f;
+	for (unsigned int i=0; i < agents.size(); i++) {
+		if (!agents[i]->enabled()) {
+			continue;
+		}
+		SocialForcesAgent * agent = static_cast<SocialForcesAgent*>(agents[i]);
+		_unsortedAgents.push_back(agent);
+		maxRadius = std::max(maxRadius, agent->_radius);
+		maxQueryRadius = std::max(maxQueryRadius, agent->_SocialForcesParams.sf_query_radius);
+	}
+	// two neighbors interact if they are closer than the query radius of one plus both radii.
+	maxInteractionDistance = maxQueryRadius + 2.0f * maxRadius;
+
+	_sortedIndexOfAgentId.assign(agents.size(), NOT_IN_BATCH);
+	_prepareGrid(engine, maxInteractionDistance);
+	_sortAgentsByCell();
+
+	unsigned int numAgents = (unsigned int)_agents.size();
+	_repulsionX.assign(numAgents, 0.0f);
+	_repulsionZ.assign(numAgents, 0.0f);
+	_proximityX.assign(numAgents, 0.0f);
+	_proximityZ.assign(numAgents, 0.0f);
+
+	if (_symmetric) {
+		_neighborIndices.clear();
+		_computeForcesSymmetric();
+		return;
+	}
+
+	_buildNeighborLists();
+	if (_useAVX2) {
+		_computeForcesAVX2();
+	}
+	else {
+		_computeForcesScalar();
+	}
+}
+
+
+bool SocialForcesBatch::getAgentForces(size_t agentId, Util::Vector & repulsionForce, Util::Vector & proximityForce) const
+{
+	if (agentId >= _sortedIndexOfAgentId.size() || _sortedIndexOfAgentId[agentId] == NOT_IN_BATCH) {
+		return false;
+	}
+	unsigned int i = _sortedIndexOfAgentId[agentId];
+	repulsionForce = Util::Vector(_repulsionX[i], 0.0f, _repulsionZ[i]);
+	proximityForce = Util::Vector(_proximityX[i], 0.0f, _proximityZ[i]);
+	return true;
+}
+
+
+void SocialForcesBatch::getObstaclesInRange(const Util::Point & position, float range, std::vector<SteerLib::ObstacleInterface*> & obstacles) const
+{
+	if (_cellObstacleStart.empty()) {
+		return;
+	}
+
+	int minX, minZ, maxX, maxZ;
+	_getCellCoords(position.x - range, position.z - range, minX, minZ);
+	_getCellCoords(position.x + range, position.z + range, maxX, maxZ);
+
+	size_t firstFound = obstacles.size();
+	for (int z = minZ; z <= maxZ; z++) {
+		for (int x = minX; x <= maxX; x++) {
+			unsigned int cell = (unsigned int)(z * _numCellsX + x);
+			for (unsigned int k = _cellObstacleStart[cell]; k < _cellObstacleStart[cell+1]; k++) {
+				SteerLib::ObstacleInterface * obstacle = _obstacles[_cellObstacles[k]];
+				const Util::AxisAlignedBox & bounds = obstacle->getBounds();
+				if (bounds.xmax >= position.x - range && bounds.xmin <= position.x + range &&
+					bounds.zmax >= position.z - range && bounds.zmin <= position.z + range) {
+					obstacles.push_back(obstacle);
+				}
+			}
+		}
+	}
+
+	// obstacles spanning several cells were found once per cell.
+	std::sort(obstacles.begin() + firstFound, obstacles.end());
+	obstacles.erase(std::unique(obstacles.begin() + firstFound, obstacles.end()), obstacles.end());
+}
+
+
+void SocialForcesBatch::_prepareGrid(SteerLib::EngineInterface * engine, float maxInteractionDistance)
+{
+	SteerLib::GridDatabase2D * spatialDatabase = engine->getSpatialDatabase();
+	const std::set<SteerLib::ObstacleInterface*> & obstacles = engine->getObstacles();
+
+	float cellSize = std::max(maxInteractionDistance, 0.01f);
+	float sizeX = spatialDatabase->getGridSizeX();
+	float sizeZ = spatialDatabase->getGridSizeZ();
+	while ((double)std::ceil(sizeX / cellSize) * (double)std::ceil(sizeZ / cellSize) > (double)MAX_NUM_CELLS) {
+		cellSize *= 2.0f;
+	}
+
+	// the grid only changes if an agent with a larger radius or query radius appeared, so usually this is a no-op.
+	if (cellSize == _cellSize && _obstacles.size() == obstacles.size() &&
+		_originX == spatialDatabase->getOriginX() && _originZ == spatialDatabase->getOriginZ()) {
+		return;
+	}
+
+	_cellSize = cellSize;
+	_invCellSize = 1.0f / cellSize;
+	_originX = spatialDatabase->getOriginX();
+	_originZ = spatialDatabase->getOriginZ();
+	_numCellsX = std::max(1, (int)std::ceil(sizeX / cellSize));
+	_numCellsZ = std::max(1, (int)std::ceil(sizeZ / cellSize));
+	unsigned int numCells = (unsigned int)(_numCellsX * _numCellsZ);
+
+	// obstacles are static, so they are binned only when the grid changes; first count, then fill.
+	_obstacles.assign(obstacles.begin(), obstacles.end());
+	_cellObstacleStart.assign(numCells + 1, 0);
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			for (unsigned int c = 0; c < numCells; c++) {
+				_cellObstacleStart[c+1] += _cellObstacleStart[c];
+			}
+			_cellObstacles.resize(_cellObstacleStart[numCells]);
+			_cellFill.assign(_cellObstacleStart.begin(), _cellObstacleStart.end() - 1);
+		}
+		for (unsigned int k = 0; k < _obstacles.size(); k++) {
+			const Util::AxisAlignedBox & bounds = _obstacles[k]->getBounds();
+			int minX, minZ, maxX, maxZ;
+			_getCellCoords(bounds.xmin, bounds.zmin, minX, minZ);
+			_getCellCoords(bounds.xmax, bounds.zmax, maxX, maxZ);
+			for (int z = minZ; z <= maxZ; z++) {
+				for (int x = minX; x <= maxX; x++) {
+					unsigned int cell = (unsigned int)(z * _numCellsX + x);
+					if (pass == 0) {
+						_cellObstacleStart[cell+1]++;
+					}
+					else {
+						_cellObstacles[_cellFill[cell]++] = k;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void SocialForcesBatch::_getCellCoords(float x, float z, int & cellX, int & cellZ) const
+{
+	cellX = (int)std::floor((x - _originX) * _invCellSize);
+	cellZ = (int)std::floor((z - _originZ) * _invCellSize);
+	cellX = std::min(std::max(cellX, 0), _numCellsX - 1);
+	cellZ = std::min(std::max(cellZ, 0), _numCellsZ - 1);
+}
+
+
+unsigned int SocialForcesBatch::_getCellIndex(float x, float z) const
+{
+	int cellX, cellZ;
+	_getCellCoords(x, z, cellX, cellZ);
+	return (unsigned int)(cellZ * _numCellsX + cellX);
+}
+
+
+void SocialForcesBatch::_sortAgentsByCell()
+{
+	unsigned int numAgents = (unsigned int)_unsortedAgents.size();
+	unsigned int numCells = (unsigned int)(_numCellsX * _numCellsZ);
+
+	// counting sort by cell; agents keep their module order within a cell.
+	_unsortedCell.resize(numAgents);
+	_cellStart.assign(numCells + 1, 0);
+	for (unsigned int i = 0; i < numAgents; i++) {
+		const Util::Point & p = _unsortedAgents[i]->_position;
+		_unsortedCell[i] = _getCellIndex(p.x, p.z);
+		_cellStart[_unsortedCell[i] + 1]++;
+	}
+	for (unsigned int c = 0; c < numCells; c++) {
+		_cellStart[c+1] += _cellStart[c];
+	}
+	_cellFill.assign(_cellStart.begin(), _cellStart.end() - 1);
+
+	_agents.resize(numAgents);
+	_agentIds.resize(numAgents);
+	_positionX.resize(numAgents);
+	_positionZ.resize(numAgents);
+	_velocityX.resize(numAgents);
+	_velocityZ.resize(numAgents);
+	_radius.resize(numAgents);
+	_queryRadius.resize(numAgents);
+	_agentA.resize(numAgents);
+	_invAgentB.resize(numAgents);
+	_personalSpaceThreshold.resize(numAgents);
+	_agentBodyForce.resize(numAgents);
+	_slidingFrictionForce.resize(numAgents);
+
+	for (unsigned int i = 0; i < numAgents; i++) {
+		SocialForcesAgent * agent = _unsortedAgents[i];
+		unsigned int s = _cellFill[_unsortedCell[i]]++;
+		const SocialForcesParameters & parameters = agent->_SocialForcesParams;
+
+		_agents[s] = agent;
+		_agentIds[s] = agent->id_;
+		_positionX[s] = agent->_position.x;
+		_positionZ[s] = agent->_position.z;
+		_velocityX[s] = agent->_velocity.x;
+		_velocityZ[s] = agent->_velocity.z;
+		_radius[s] = agent->_radius;
+		_queryRadius[s] = parameters.sf_query_radius;
+		_agentA[s] = parameters.sf_agent_a;
+		_invAgentB[s] = 1.0f / parameters.sf_agent_b;
+		_personalSpaceThreshold[s] = parameters.sf_personal_space_threshold;
+		_agentBodyForce[s] = parameters.sf_agent_body_force;
+		_slidingFrictionForce[s] = parameters.sf_sliding_friction_force;
+
+		if (agent->id_ < _sortedIndexOfAgentId.size()) {
+			_sortedIndexOfAgentId[agent->id_] = s;
+		}
+	}
+}
+
+
+void SocialForcesBatch::_buildNeighborLists()
+{
+	unsigned int numAgents = (unsigned int)_agents.size();
+	_neighborStart.resize(numAgents + 1);
+	_neighborIndices.clear();
+
+	for (unsigned int i = 0; i < numAgents; i++) {
+		_neighborStart[i] = (unsigned int)_neighborIndices.size();
+
+		const float x = _positionX[i];
+		const float z = _positionZ[i];
+		int cellX, cellZ;
+		_getCellCoords(x, z, cellX, cellZ);
+		int minX = std::max(cellX - 1, 0);
+		int maxX = std::min(cellX + 1, _numCellsX - 1);
+		int minZ = std::max(cellZ - 1, 0);
+		int maxZ = std::min(cellZ + 1, _numCellsZ - 1);
+
+		// agents of one cell row are contiguous in the sorted arrays, so each row of the 3x3 block is one range.
+		for (int cz = minZ; cz <= maxZ; cz++) {
+			unsigned int first = _cellStart[cz * _numCellsX + minX];
+			unsigned int last = _cellStart[cz * _numCellsX + maxX + 1];
+			for (unsigned int j = first; j < last; j++) {
+				if (j == i) {
+					continue;
+				}
+				float dx = x - _positionX[j];
+				float dz = z - _positionZ[j];
+				float range = _queryRadius[i] + _radius[i] + _radius[j];
+				if (dx*dx + dz*dz < range*range) {
+					_neighborIndices.push_back((int)j);
+				}
+			}
+		}
+	}
+	_neighborStart[numAgents] = (unsigned int)_neighborIndices.size();
+}
+
+
+void SocialForcesBatch::_accumulateForcesScalar(unsigned int i, unsigned int first, unsigned int last, float sums[4])
+{
+	const float x = _positionX[i];
+	const float z = _positionZ[i];
+	const float vx = _velocityX[i];
+	const float vz = _velocityZ[i];
+	const float r = _radius[i];
+
+	for (unsigned int k = first; k < last; k++) {
+		unsigned int j = (unsigned int)_neighborIndices[k];
+		float dx = x - _positionX[j];
+		float dz = z - _positionZ[j];
+		float distance = std::sqrt(dx*dx + dz*dz);
+		float invDistance = (distance > 0.0f) ? 1.0f / distance : 0.0f;
+		float directionX = dx * invDistance;
+		float directionZ = dz * invDistance;
+		float sumRadius = r + _radius[j];
+
+		// proximity (psychological) force
+		float psychologicalForce = _agentA[i] * fastExp((sumRadius + _personalSpaceThreshold[i] - distance) * _invAgentB[i]);
+		sums[2] += directionX * psychologicalForce;
+		sums[3] += directionZ * psychologicalForce;
+
+		// repulsion (body and sliding friction) force, only when the agents overlap
+		float penetration = sumRadius - distance;
+		if (penetration > MIN_PENETRATION) {
+			float dvx = vx - _velocityX[j];
+			float dvz = vz - _velocityZ[j];
+			float relativeSpeed = std::sqrt(dvx*dvx + dvz*dvz);
+			float invRelativeSpeed = (relativeSpeed > 0.0f) ? 1.0f / relativeSpeed : 0.0f;
+			// the perpendicular of the (unnormalized) distance vector, as in calcNeighborForces().
+			float perpendicularX = -dz;
+			float perpendicularZ = dx;
+			float velocityOfAgent = (dvx * perpendicularX + dvz * perpendicularZ) * invRelativeSpeed;
+
+			float penetrationForce = _agentBodyForce[i] * penetration;
+			float slidingForce = _slidingFrictionForce[i] * penetration * velocityOfAgent;
+			sums[0] += directionX * penetrationForce + perpendicularX * slidingForce;
+			sums[1] += directionZ * penetrationForce + perpendicularZ * slidingForce;
+		}
+	}
+}
+
+
+void SocialForcesBatch::_computeForcesScalar()
+{
+	unsigned int numAgents = (unsigned int)_agents.size();
+	for (unsigned int i = 0; i < numAgents; i++) {
+		float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		_accumulateForcesScalar(i, _neighborStart[i], _neighborStart[i+1], sums);
+		_repulsionX[i] = sums[0];
+		_repulsionZ[i] = sums[1];
+		_proximityX[i] = sums[2];
+		_proximityZ[i] = sums[3];
+	}
+}
+
+
+void SocialForcesBatch::_computeForcesSymmetric()
+{
+	unsigned int numAgents = (unsigned int)_agents.size();
+	unsigned int numStripes = std::min(_numThreads, (unsigned int)_numCellsZ);
+
+	_stripeBuffers.resize(numStripes);
+	_stripeTasks.resize(numStripes);
+	for (unsigned int s = 0; s < numStripes; s++) {
+		_stripeBuffers[s].repulsionX.assign(numAgents, 0.0f);
+		_stripeBuffers[s].repulsionZ.assign(numAgents, 0.0f);
+		_stripeBuffers[s].proximityX.assign(numAgents, 0.0f);
+		_stripeBuffers[s].proximityZ.assign(numAgents, 0.0f);
+		_stripeTasks[s].batch = this;
+		_stripeTasks[s].stripe = s;
+		_stripeTasks[s].firstRow = (int)((s * (unsigned int)_numCellsZ) / numStripes);
+		_stripeTasks[s].lastRow = (int)(((s+1) * (unsigned int)_numCellsZ) / numStripes);
+	}
+
+	if (_threadPool == NULL || numStripes == 1) {
+		for (unsigned int s = 0; s < numStripes; s++) {
+			_computeStripe(s, _stripeTasks[s].firstRow, _stripeTasks[s].lastRow);
+		}
+	}
+	else {
+		for (unsigned int s = 0; s < numStripes; s++) {
+			Util::Task task;
+			task.function = SocialForcesBatch::_computeStripeTask;
+			task.data = &_stripeTasks[s];
+			_threadPool->addTask(task, true);
+		}
+		_threadPool->waitForAllTasksToComplete();
+	}
+
+	// summed in stripe order, so the forces are the same for any thread scheduling.
+	for (unsigned int s = 0; s < numStripes; s++) {
+		const ForceBuffer & buffer = _stripeBuffers[s];
+		for (unsigned int i = 0; i < numAgents; i++) {
+			_repulsionX[i] += buffer.repulsionX[i];
+			_repulsionZ[i] += buffer.repulsionZ[i];
+			_proximityX[i] += buffer.proximityX[i];
+			_proximityZ[i] += buffer.proximityZ[i];
+		}
+	}
+}
+
+
+void SocialForcesBatch::_computeStripeTask(unsigned int threadIndex, void * data)
+{
+	StripeTask * task = (StripeTask *)data;
+	task->batch->_computeStripe(task->stripe, task->firstRow, task->lastRow);
+}
+
+
+void SocialForcesBatch::_computeStripe(unsigned int stripe, int firstRow, int lastRow)
+{
+	ForceBuffer & buffer = _stripeBuffers[stripe];
+
+	for (int cz = firstRow; cz < lastRow; cz++) {
+		for (int cx = 0; cx < _numCellsX; cx++) {
+			unsigned int cell = (unsigned int)(cz * _numCellsX + cx);
+
+			// the half shell: the rest of this cell and the next cell in the row are one contiguous range,
+			// and the three cells below in the next row are another.
+			unsigned int rowEnd = _cellStart[cz * _numCellsX + std::min(cx + 1, _numCellsX - 1) + 1];
+			unsigned int nextRowBegin = 0;
+			unsigned int nextRowEnd = 0;
+			if (cz + 1 < _numCellsZ) {
+				nextRowBegin = _cellStart[(cz + 1) * _numCellsX + std::max(cx - 1, 0)];
+				nextRowEnd = _cellStart[(cz + 1) * _numCellsX + std::min(cx + 1, _numCellsX - 1) + 1];
+			}
+
+			for (unsigned int i = _cellStart[cell]; i < _cellStart[cell+1]; i++) {
+				if (_useAVX2) {
+					_accumulatePairsAVX2(i, i + 1, rowEnd, buffer);
+					_accumulatePairsAVX2(i, nextRowBegin, nextRowEnd, buffer);
+				}
+				else {
+					_accumulatePairsScalar(i, i + 1, rowEnd, buffer);
+					_accumulatePairsScalar(i, nextRowBegin, nextRowEnd, buffer);
+				}
+			}
+		}
+	}
+}
+
+
+void SocialForcesBatch::_accumulatePairsScalar(unsigned int i, unsigned int first, unsigned int last, ForceBuffer & buffer)
+{
+	const float x = _positionX[i];
+	const float z = _positionZ[i];
+	const float vx = _velocityX[i];
+	const float vz = _velocityZ[i];
+	const float r = _radius[i];
+	float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (unsigned int j = first; j < last; j++) {
+		float dx = x - _positionX[j];
+		float dz = z - _positionZ[j];
+		float distanceSquared = dx*dx + dz*dz;
+		float sumRadius = r + _radius[j];
+		// each agent only feels the other one within its own interaction distance, as with the neighbor lists.
+		float rangeI = _queryRadius[i] + sumRadius;
+		float rangeJ = _queryRadius[j] + sumRadius;
+		bool affectsI = distanceSquared < rangeI*rangeI;
+		bool affectsJ = distanceSquared < rangeJ*rangeJ;
+		if (!affectsI && !affectsJ) {
+			continue;
+		}
+
+		float distance = std::sqrt(distanceSquared);
+		float invDistance = (distance > 0.0f) ? 1.0f / distance : 0.0f;
+		float directionX = dx * invDistance;
+		float directionZ = dz * invDistance;
+
+		// the body and sliding friction terms only need the relative speed if the agents overlap.
+		float penetration = sumRadius - distance;
+		bool overlaps = penetration > MIN_PENETRATION;
+		float velocityOfAgent = 0.0f;
+		if (overlaps) {
+			float dvx = vx - _velocityX[j];
+			float dvz = vz - _velocityZ[j];
+			float relativeSpeed = std::sqrt(dvx*dvx + dvz*dvz);
+			float invRelativeSpeed = (relativeSpeed > 0.0f) ? 1.0f / relativeSpeed : 0.0f;
+			velocityOfAgent = (dx * dvz - dz * dvx) * invRelativeSpeed;
+		}
+
+		float psychologicalForceI = 0.0f;
+		if (affectsI) {
+			psychologicalForceI = _agentA[i] * fastExp((sumRadius + _personalSpaceThreshold[i] - distance) * _invAgentB[i]);
+			sums[2] += directionX * psychologicalForceI;
+			sums[3] += directionZ * psychologicalForceI;
+			if (overlaps) {
+				float penetrationForce = _agentBodyForce[i] * penetration;
+				float slidingForce = _slidingFrictionForce[i] * penetration * velocityOfAgent;
+				sums[0] += directionX * penetrationForce - dz * slidingForce;
+				sums[1] += directionZ * penetrationForce + dx * slidingForce;
+			}
+		}
+
+		// agent j sees the opposite direction, perpendicular and relative velocity, so its forces are equal and opposite.
+		if (affectsJ) {
+			float psychologicalForceJ;
+			if (affectsI && _agentA[j] == _agentA[i] && _invAgentB[j] == _invAgentB[i] && _personalSpaceThreshold[j] == _personalSpaceThreshold[i]) {
+				psychologicalForceJ = psychologicalForceI;
+			}
+			else {
+				psychologicalForceJ = _agentA[j] * fastExp((sumRadius + _personalSpaceThreshold[j] - distance) * _invAgentB[j]);
+			}
+			buffer.proximityX[j] -= directionX * psychologicalForceJ;
+			buffer.proximityZ[j] -= directionZ * psychologicalForceJ;
+			if (overlaps) {
+				float penetrationForce = _agentBodyForce[j] * penetration;
+				float slidingForce = _slidingFrictionForce[j] * penetration * velocityOfAgent;
+				buffer.repulsionX[j] -= directionX * penetrationForce - dz * slidingForce;
+				buffer.repulsionZ[j] -= directionZ * penetrationForce + dx * slidingForce;
+			}
+		}
+	}
+
+	buffer.repulsionX[i] += sums[0];
+	buffer.repulsionZ[i] += sums[1];
+	buffer.proximityX[i] += sums[2];
+	buffer.proximityZ[i] += sums[3];
+}
+
+
+#ifdef SF_BATCH_HAS_AVX2_KERNEL
+
+/// fastExp() on eight lanes.
+SF_BATCH_AVX2_FUNCTION static inline __m256 fastExp8(__m256 x)
+{
+	x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(FAST_EXP_MIN)), _mm256_set1_ps(FAST_EXP_MAX));
+	__m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(FAST_EXP_LOG2E), _mm256_set1_ps(0.5f)));
+	__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(FAST_EXP_LN2_HI), x);
+	r = _mm256_fnmadd_ps(n, _mm256_set1_ps(FAST_EXP_LN2_LO), r);
+
+	__m256 p = _mm256_set1_ps(FAST_EXP_C6);
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(FAST_EXP_C5));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(FAST_EXP_C4));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(FAST_EXP_C3));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(FAST_EXP_C2));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+
+	__m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+	return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+}
+
+
+/// Adds the eight lanes of v.
+SF_BATCH_AVX2_FUNCTION static inline float horizontalSum8(__m256 v)
+{
+	__m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+	return _mm_cvtss_f32(sum);
+}
+
+
+SF_BATCH_AVX2_FUNCTION void SocialForcesBatch::_computeForcesAVX2()
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 minPenetration = _mm256_set1_ps(MIN_PENETRATION);
+
+	unsigned int numAgents = (unsigned int)_agents.size();
+	for (unsigned int i = 0; i < numAgents; i++) {
+		const __m256 x = _mm256_set1_ps(_positionX[i]);
+		const __m256 z = _mm256_set1_ps(_positionZ[i]);
+		const __m256 vx = _mm256_set1_ps(_velocityX[i]);
+		const __m256 vz = _mm256_set1_ps(_velocityZ[i]);
+		const __m256 r = _mm256_set1_ps(_radius[i]);
+		const __m256 agentA = _mm256_set1_ps(_agentA[i]);
+		const __m256 invAgentB = _mm256_set1_ps(_invAgentB[i]);
+		const __m256 personalSpaceThreshold = _mm256_set1_ps(_personalSpaceThreshold[i]);
+		const __m256 agentBodyForce = _mm256_set1_ps(_agentBodyForce[i]);
+		const __m256 slidingFrictionForce = _mm256_set1_ps(_slidingFrictionForce[i]);
+
+		__m256 repulsionX = zero;
+		__m256 repulsionZ = zero;
+		__m256 proximityX = zero;
+		__m256 proximityZ = zero;
+
+		unsigned int k = _neighborStart[i];
+		const unsigned int last = _neighborStart[i+1];
+		for ( ; k + 8 <= last; k += 8) {
+			__m256i j = _mm256_loadu_si256((const __m256i *)&_neighborIndices[k]);
+			__m256 dx = _mm256_sub_ps(x, _mm256_i32gather_ps(&_positionX[0], j, 4));
+			__m256 dz = _mm256_sub_ps(z, _mm256_i32gather_ps(&_positionZ[0], j, 4));
+			__m256 sumRadius = _mm256_add_ps(r, _mm256_i32gather_ps(&_radius[0], j, 4));
+
+			__m256 distance = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dz, dz)));
+			__m256 invDistance = _mm256_and_ps(_mm256_div_ps(one, distance), _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+			__m256 directionX = _mm256_mul_ps(dx, invDistance);
+			__m256 directionZ = _mm256_mul_ps(dz, invDistance);
+
+			// proximity (psychological) force
+			__m256 exponent = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(sumRadius, personalSpaceThreshold), distance), invAgentB);
+			__m256 psychologicalForce = _mm256_mul_ps(agentA, fastExp8(exponent));
+			proximityX = _mm256_fmadd_ps(directionX, psychologicalForce, proximityX);
+			proximityZ = _mm256_fmadd_ps(directionZ, psychologicalForce, proximityZ);
+
+			// repulsion (body and sliding friction) force; lanes where the agents do not overlap are masked to zero.
+			__m256 penetration = _mm256_sub_ps(sumRadius, distance);
+			__m256 overlaps = _mm256_cmp_ps(penetration, minPenetration, _CMP_GT_OQ);
+			if (_mm256_movemask_ps(overlaps) == 0) {
+				continue;
+			}
+			penetration = _mm256_and_ps(penetration, overlaps);
+
+			__m256 dvx = _mm256_sub_ps(vx, _mm256_i32gather_ps(&_velocityX[0], j, 4));
+			__m256 dvz = _mm256_sub_ps(vz, _mm256_i32gather_ps(&_velocityZ[0], j, 4));
+			__m256 relativeSpeed = _mm256_sqrt_ps(_mm256_fmadd_ps(dvx, dvx, _mm256_mul_ps(dvz, dvz)));
+			__m256 invRelativeSpeed = _mm256_and_ps(_mm256_div_ps(one, relativeSpeed), _mm256_cmp_ps(relativeSpeed, zero, _CMP_GT_OQ));
+			// the perpendicular is (-dz, dx), so dot(dv, perpendicular) = dx*dvz - dz*dvx.
+			__m256 velocityOfAgent = _mm256_mul_ps(_mm256_fmsub_ps(dx, dvz, _mm256_mul_ps(dz, dvx)), invRelativeSpeed);
+
+			__m256 penetrationForce = _mm256_mul_ps(agentBodyForce, penetration);
+			__m256 slidingForce = _mm256_mul_ps(_mm256_mul_ps(slidingFrictionForce, penetration), velocityOfAgent);
+			repulsionX = _mm256_fmadd_ps(directionX, penetrationForce, _mm256_fnmadd_ps(dz, slidingForce, repulsionX));
+			repulsionZ = _mm256_fmadd_ps(directionZ, penetrationForce, _mm256_fmadd_ps(dx, slidingForce, repulsionZ));
+		}
+
+		float sums[4];
+		sums[0] = horizontalSum8(repulsionX);
+		sums[1] = horizontalSum8(repulsionZ);
+		sums[2] = horizontalSum8(proximityX);
+		sums[3] = horizontalSum8(proximityZ);
+		_accumulateForcesScalar(i, k, last, sums);
+
+		_repulsionX[i] = sums[0];
+		_repulsionZ[i] = sums[1];
+		_proximityX[i] = sums[2];
+		_proximityZ[i] = sums[3];
+	}
+}
+
+
+SF_BATCH_AVX2_FUNCTION void SocialForcesBatch::_accumulatePairsAVX2(unsigned int i, unsigned int first, unsigned int last, ForceBuffer & buffer)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 minPenetration = _mm256_set1_ps(MIN_PENETRATION);
+
+	const __m256 x = _mm256_set1_ps(_positionX[i]);
+	const __m256 z = _mm256_set1_ps(_positionZ[i]);
+	const __m256 vx = _mm256_set1_ps(_velocityX[i]);
+	const __m256 vz = _mm256_set1_ps(_velocityZ[i]);
+	const __m256 r = _mm256_set1_ps(_radius[i]);
+	const __m256 queryRadiusI = _mm256_set1_ps(_queryRadius[i]);
+	const __m256 agentAI = _mm256_set1_ps(_agentA[i]);
+	const __m256 invAgentBI = _mm256_set1_ps(_invAgentB[i]);
+	const __m256 personalSpaceThresholdI = _mm256_set1_ps(_personalSpaceThreshold[i]);
+	const __m256 agentBodyForceI = _mm256_set1_ps(_agentBodyForce[i]);
+	const __m256 slidingFrictionForceI = _mm256_set1_ps(_slidingFrictionForce[i]);
+
+	__m256 repulsionX = zero;
+	__m256 repulsionZ = zero;
+	__m256 proximityX = zero;
+	__m256 proximityZ = zero;
+
+	// the other agents are a contiguous range of the sorted arrays, so they are loaded and stored without gathers.
+	unsigned int j = first;
+	for ( ; j + 8 <= last; j += 8) {
+		__m256 dx = _mm256_sub_ps(x, _mm256_loadu_ps(&_positionX[j]));
+		__m256 dz = _mm256_sub_ps(z, _mm256_loadu_ps(&_positionZ[j]));
+		__m256 distanceSquared = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dz, dz));
+		__m256 sumRadius = _mm256_add_ps(r, _mm256_loadu_ps(&_radius[j]));
+		__m256 rangeI = _mm256_add_ps(queryRadiusI, sumRadius);
+		__m256 rangeJ = _mm256_add_ps(_mm256_loadu_ps(&_queryRadius[j]), sumRadius);
+		__m256 affectsI = _mm256_cmp_ps(distanceSquared, _mm256_mul_ps(rangeI, rangeI), _CMP_LT_OQ);
+		__m256 affectsJ = _mm256_cmp_ps(distanceSquared, _mm256_mul_ps(rangeJ, rangeJ), _CMP_LT_OQ);
+		if (_mm256_movemask_ps(_mm256_or_ps(affectsI, affectsJ)) == 0) {
+			continue;
+		}
+
+		__m256 distance = _mm256_sqrt_ps(distanceSquared);
+		__m256 invDistance = _mm256_and_ps(_mm256_div_ps(one, distance), _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+		__m256 directionX = _mm256_mul_ps(dx, invDistance);
+		__m256 directionZ = _mm256_mul_ps(dz, invDistance);
+
+		// proximity (psychological) forces; the exponential is shared unless the parameters of the two agents differ.
+		__m256 agentAJ = _mm256_loadu_ps(&_agentA[j]);
+		__m256 invAgentBJ = _mm256_loadu_ps(&_invAgentB[j]);
+		__m256 personalSpaceThresholdJ = _mm256_loadu_ps(&_personalSpaceThreshold[j]);
+		__m256 psychologicalForceI = _mm256_mul_ps(agentAI, fastExp8(_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(sumRadius, personalSpaceThresholdI), distance), invAgentBI)));
+		__m256 psychologicalForceJ = psychologicalForceI;
+		__m256 sameParameters = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(agentAJ, agentAI, _CMP_EQ_OQ), _mm256_cmp_ps(invAgentBJ, invAgentBI, _CMP_EQ_OQ)),
+			_mm256_cmp_ps(personalSpaceThresholdJ, personalSpaceThresholdI, _CMP_EQ_OQ));
+		if (_mm256_movemask_ps(sameParameters) != 0xff) {
+			__m256 ownForceJ = _mm256_mul_ps(agentAJ, fastExp8(_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(sumRadius, personalSpaceThresholdJ), distance), invAgentBJ)));
+			psychologicalForceJ = _mm256_blendv_ps(ownForceJ, psychologicalForceI, sameParameters);
+		}
+		psychologicalForceI = _mm256_and_ps(psychologicalForceI, affectsI);
+		psychologicalForceJ = _mm256_and_ps(psychologicalForceJ, affectsJ);
+		proximityX = _mm256_fmadd_ps(directionX, psychologicalForceI, proximityX);
+		proximityZ = _mm256_fmadd_ps(directionZ, psychologicalForceI, proximityZ);
+		_mm256_storeu_ps(&buffer.proximityX[j], _mm256_fnmadd_ps(directionX, psychologicalForceJ, _mm256_loadu_ps(&buffer.proximityX[j])));
+		_mm256_storeu_ps(&buffer.proximityZ[j], _mm256_fnmadd_ps(directionZ, psychologicalForceJ, _mm256_loadu_ps(&buffer.proximityZ[j])));
+
+		// repulsion (body and sliding friction) forces, only where the agents overlap.
+		__m256 penetration = _mm256_sub_ps(sumRadius, distance);
+		__m256 overlaps = _mm256_cmp_ps(penetration, minPenetration, _CMP_GT_OQ);
+		if (_mm256_movemask_ps(overlaps) == 0) {
+			continue;
+		}
+		__m256 penetrationI = _mm256_and_ps(penetration, _mm256_and_ps(overlaps, affectsI));
+		__m256 penetrationJ = _mm256_and_ps(penetration, _mm256_and_ps(overlaps, affectsJ));
+
+		__m256 dvx = _mm256_sub_ps(vx, _mm256_loadu_ps(&_velocityX[j]));
+		__m256 dvz = _mm256_sub_ps(vz, _mm256_loadu_ps(&_velocityZ[j]));
+		__m256 relativeSpeed = _mm256_sqrt_ps(_mm256_fmadd_ps(dvx, dvx, _mm256_mul_ps(dvz, dvz)));
+		__m256 invRelativeSpeed = _mm256_and_ps(_mm256_div_ps(one, relativeSpeed), _mm256_cmp_ps(relativeSpeed, zero, _CMP_GT_OQ));
+		__m256 velocityOfAgent = _mm256_mul_ps(_mm256_fmsub_ps(dx, dvz, _mm256_mul_ps(dz, dvx)), invRelativeSpeed);
+
+		__m256 penetrationForceI = _mm256_mul_ps(agentBodyForceI, penetrationI);
+		__m256 slidingForceI = _mm256_mul_ps(_mm256_mul_ps(slidingFrictionForceI, penetrationI), velocityOfAgent);
+		repulsionX = _mm256_fmadd_ps(directionX, penetrationForceI, _mm256_fnmadd_ps(dz, slidingForceI, repulsionX));
+		repulsionZ = _mm256_fmadd_ps(directionZ, penetrationForceI, _mm256_fmadd_ps(dx, slidingForceI, repulsionZ));
+
+		__m256 penetrationForceJ = _mm256_mul_ps(_mm256_loadu_ps(&_agentBodyForce[j]), penetrationJ);
+		__m256 slidingForceJ = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(&_slidingFrictionForce[j]), penetrationJ), velocityOfAgent);
+		__m256 repulsionJX = _mm256_fmsub_ps(directionX, penetrationForceJ, _mm256_mul_ps(dz, slidingForceJ));
+		__m256 repulsionJZ = _mm256_fmadd_ps(directionZ, penetrationForceJ, _mm256_mul_ps(dx, slidingForceJ));
+		_mm256_storeu_ps(&buffer.repulsionX[j], _mm256_sub_ps(_mm256_loadu_ps(&buffer.repulsionX[j]), repulsionJX));
+		_mm256_storeu_ps(&buffer.repulsionZ[j], _mm256_sub_ps(_mm256_loadu_ps(&buffer.repulsionZ[j]), repulsionJZ));
+	}
+
+	buffer.repulsionX[i] += horizontalSum8(repulsionX);
+	buffer.repulsionZ[i] += horizontalSum8(repulsionZ);
+	buffer.proximityX[i] += horizontalSum8(proximityX);
+	buffer.proximityZ[i] += horizontalSum8(proximityZ);
+	_accumulatePairsScalar(i, j, last, buffer);
+}
+
+#else
+
+void SocialForcesBatch::_computeForcesAVX2()
+{
+	// never called: processorSupportsAVX2() is false when the kernel is not compiled.
+	_computeForcesScalar();
+}
+
+
+void SocialForcesBatch::_accumulatePairsAVX2(unsigned int i, unsigned int first, unsigned int last, ForceBuffer & buffer)
+{
+	_accumulatePairsScalar(i, first, last, buffer);
+}
+
+#endif
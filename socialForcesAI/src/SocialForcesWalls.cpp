@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+/// @file SocialForcesWalls.cpp
+/// @brief Implements the SocialForcesWalls class.
+
+#include <algorithm>
+#include <cmath>
+#include "SocialForcesWalls.h"
+
+using namespace Util;
+
+
+SocialForcesWalls::SocialForcesWalls()
+{
+}
+
+
+void SocialForcesWalls::clear()
+{
+	_obstacles.clear();
+	_firstSegment.clear();
+	_circleX.clear();
+	_circleZ.clear();
+	_circleRadius.clear();
+	_segmentStartX.clear();
+	_segmentStartZ.clear();
+	_segmentDeltaX.clear();
+	_segmentDeltaZ.clear();
+	_segmentLengthSquared.clear();
+	_segmentNormalX.clear();
+	_segmentNormalZ.clear();
+}
+
+
+void SocialForcesWalls::build(const std::set<SteerLib::ObstacleInterface*> & obstacles)
+{
+	clear();
+
+	std::vector<Util::Vector> vertices;
+	for (std::set<SteerLib::ObstacleInterface*>::const_iterator iter = obstacles.begin(); iter != obstacles.end(); ++iter) {
+		SteerLib::ObstacleInterface * obstacle = *iter;
+		const Util::AxisAlignedBox & box = obstacle->getBounds();
+
+		_obstacles.push_back(obstacle);
+		_firstSegment.push_back((unsigned int)_segmentStartX.size());
+
+		if (dynamic_cast<SteerLib::CircleObstacle*>(obstacle) != NULL) {
+			// the bounds of a circle are the square around it.
+			_circleX.push_back(0.5f * (box.xmin + box.xmax));
+			_circleZ.push_back(0.5f * (box.zmin + box.zmax));
+			_circleRadius.push_back(0.5f * (box.xmax - box.xmin));
+			continue;
+		}
+		_circleX.push_back(0.0f);
+		_circleZ.push_back(0.0f);
+		_circleRadius.push_back(-1.0f);
+
+		vertices.clear();
+		if (dynamic_cast<SteerLib::BoxObstacle*>(obstacle) == NULL) {
+			obstacle->returnVertices(vertices);
+		}
+		if (vertices.size() >= 3) {
+			_addPolygonSegments(vertices);
+		}
+		else {
+			_addBoxSegments(box);
+		}
+	}
+	_firstSegment.push_back((unsigned int)_segmentStartX.size());
+}
+
+
+void SocialForcesWalls::_addSegment(float x1, float z1, float x2, float z2, float normalX, float normalZ)
+{
+	float deltaX = x2 - x1;
+	float deltaZ = z2 - z1;
+	float lengthSquared = deltaX*deltaX + deltaZ*deltaZ;
+	if (lengthSquared == 0.0f) {
+		return;
+	}
+
+	_segmentStartX.push_back(x1);
+	_segmentStartZ.push_back(z1);
+	_segmentDeltaX.push_back(deltaX);
+	_segmentDeltaZ.push_back(deltaZ);
+	_segmentLengthSquared.push_back(lengthSquared);
+	_segmentNormalX.push_back(normalX);
+	_segmentNormalZ.push_back(normalZ);
+}
+
+
+void SocialForcesWalls::_addBoxSegments(const Util::AxisAlignedBox & box)
+{
+	// the x edges come first, so that beyond a corner where both edges are equally far the x edge wins the tie, as in calcWallNormal().
+	_addSegment(box.xmax, box.zmin, box.xmax, box.zmax, 1.0f, 0.0f);
+	_addSegment(box.xmin, box.zmin, box.xmin, box.zmax, -1.0f, 0.0f);
+	_addSegment(box.xmin, box.zmax, box.xmax, box.zmax, 0.0f, 1.0f);
+	_addSegment(box.xmin, box.zmin, box.xmax, box.zmin, 0.0f, -1.0f);
+}
+
+
+void SocialForcesWalls::_addPolygonSegments(const std::vector<Util::Vector> & vertices)
+{
+	// the sign of the area tells which side of the edges is outside, whichever way the vertices wind.
+	float twiceArea = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const Util::Vector & a = vertices[i];
+		const Util::Vector & b = vertices[(i + 1) % vertices.size()];
+		twiceArea += a.x * b.z - b.x * a.z;
+	}
+	float side = (twiceArea >= 0.0f) ? 1.0f : -1.0f;
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const Util::Vector & a = vertices[i];
+		const Util::Vector & b = vertices[(i + 1) % vertices.size()];
+		float deltaX = b.x - a.x;
+		float deltaZ = b.z - a.z;
+		float length = std::sqrt(deltaX*deltaX + deltaZ*deltaZ);
+		if (length == 0.0f) {
+			continue;
+		}
+		_addSegment(a.x, a.z, b.x, b.z, side * deltaZ / length, -side * deltaX / length);
+	}
+}
+
+
+bool SocialForcesWalls::getClosestWallPoint(SteerLib::ObstacleInterface * obstacle, const Util::Point & position, Util::Point & closestPoint, Util::Vector & wallNormal, float & distance) const
+{
+	std::vector<SteerLib::ObstacleInterface*>::const_iterator found = std::lower_bound(_obstacles.begin(), _obstacles.end(), obstacle);
+	if (found == _obstacles.end() || *found != obstacle) {
+		return false;
+	}
+	size_t k = found - _obstacles.begin();
+
+	if (_circleRadius[k] >= 0.0f) {
+		float offsetX = position.x - _circleX[k];
+		float offsetZ = position.z - _circleZ[k];
+		float centerDistance = std::sqrt(offsetX*offsetX + offsetZ*offsetZ);
+		wallNormal = (centerDistance > 0.0f) ? Util::Vector(offsetX / centerDistance, 0.0f, offsetZ / centerDistance) : Util::Vector(1.0f, 0.0f, 0.0f);
+		closestPoint = Util::Point(_circleX[k] + _circleRadius[k] * wallNormal.x, 0.0f, _circleZ[k] + _circleRadius[k] * wallNormal.z);
+		distance = fabsf(centerDistance - _circleRadius[k]);
+		return true;
+	}
+
+	unsigned int first = _firstSegment[k];
+	unsigned int last = _firstSegment[k+1];
+	if (first == last) {
+		return false;
+	}
+
+	// the same projection as minimum_distance() in SocialForcesAgent.cpp, compared by squared distance.
+	unsigned int best = first;
+	float bestDistanceSquared = 0.0f;
+	float bestFacing = 0.0f;
+	float bestX = 0.0f;
+	float bestZ = 0.0f;
+	for (unsigned int s = first; s < last; s++) {
+		float t = ((position.x - _segmentStartX[s]) * _segmentDeltaX[s] + (position.z - _segmentStartZ[s]) * _segmentDeltaZ[s]) / _segmentLengthSquared[s];
+		float x, z;
+		if (t < 0.0f) {
+			x = _segmentStartX[s];
+			z = _segmentStartZ[s];
+		}
+		else if (t > 1.0f) {
+			x = _segmentStartX[s] + _segmentDeltaX[s];
+			z = _segmentStartZ[s] + _segmentDeltaZ[s];
+		}
+		else {
+			x = _segmentStartX[s] + t * _segmentDeltaX[s];
+			z = _segmentStartZ[s] + t * _segmentDeltaZ[s];
+		}
+		float offsetX = position.x - x;
+		float offsetZ = position.z - z;
+		float distanceSquared = offsetX*offsetX + offsetZ*offsetZ;
+		float facing = offsetX * _segmentNormalX[s] + offsetZ * _segmentNormalZ[s];
+		if (s == first || distanceSquared < bestDistanceSquared || (distanceSquared == bestDistanceSquared && facing > bestFacing)) {
+			best = s;
+			bestDistanceSquared = distanceSquared;
+			bestFacing = facing;
+			bestX = x;
+			bestZ = z;
+		}
+	}
+
+	closestPoint = Util::Point(bestX, 0.0f, bestZ);
+	wallNormal = Util::Vector(_segmentNormalX[best], 0.0f, _segmentNormalZ[best]);
+	distance = std::sqrt(bestDistanceSquared);
+	return true;
+}
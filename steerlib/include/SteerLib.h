@@ -37,6 +37,7 @@
 #include "planning/BestFirstSearchPlanner.h"
 
 #include "simulation/Camera.h"
+#include "simulation/BatchSimulationRunner.h"
 #include "simulation/Clock.h"
 #include "simulation/SimulationOptions.h"
 #include "simulation/SimulationEngine.h"
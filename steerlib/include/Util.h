@@ -20,6 +20,7 @@
 #include "util/MemoryMapper.h"
 #include "util/Misc.h"
 #include "util/Mutex.h"
+#include "util/ObjectPool.h"
 #include "util/PerformanceProfiler.h"
 #include "util/StateMachine.h"
 #include "util/ThreadedTaskManager.h"
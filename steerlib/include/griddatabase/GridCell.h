@@ -46,8 +46,14 @@ namespace SteerLib {
 	class STEERLIB_API GridCell {
 
 	public:
+		GridCell() : _numItems(0), _capacity(0), _items(NULL), _grownItems(NULL), _traversalCost(0.0f) { }
+		~GridCell() { delete [] _grownItems; }
+
 		void init( unsigned int maxNumItems, SpatialDatabaseItemPtr * localBasePtr, float initialTraversalCost) {
+			delete [] _grownItems;
+			_grownItems = NULL;
 			_items = localBasePtr;
+			_capacity = maxNumItems;
 			for (unsigned int j=0; j < maxNumItems; j++) {
 				_items[j] = NULL;
 			}
@@ -55,23 +61,21 @@ namespace SteerLib {
 			_traversalCost = initialTraversalCost;
 		}
 
-		/// Adds an object reference to this cell.
-		inline void add(SpatialDatabaseItemPtr entry, unsigned int maxItems, float traversalCostToAdd) {
+		/// Adds an object reference to this cell; a full cell grows to make room.
+		inline void add(SpatialDatabaseItemPtr entry, float traversalCostToAdd) {
 
 			_gridCellMutex.lock();
 
 			/** 
-			 * If an exception is thrown in this function, it means, there are too many 
-			 * agents in one grid cell.  If you are certain its not a bug, you can increase 
-			 * the value of numItemsPerCell in the GridDatabase2D constructor, or increase 
-			 * the resolution of the grid. (Note that such changes may affect performance, too.)
+			 * A cell starts with the maxItemsPerGridCell slots given to init().  If more items
+			 * overlap it, the cell doubles its slots in storage of its own, and keeps them until
+			 * the database is destroyed.  Queries visit every slot of a cell, so crowded cells
+			 * cost more; if that happens often, increase maxItemsPerGridCell (in the config file)
+			 * or the resolution of the grid.
 			 */
 
-			if (_numItems >= maxItems)
-			{
-				_gridCellMutex.unlock();
-				std::cout << "The number of items in this cell is:" << _numItems << " The max number of items can be: " << maxItems << std::endl;
-				throw Util::GenericException("There are too many items in a single cell of the grid database.\nIn the next version, this will be handled robstly and not be an error.\nFor now, use a higher number for maxItemsPerGridCell (in the config file), or\nincrease the resolution of the grid (both of which may decrease performance).");
+			if (_numItems >= _capacity) {
+				_grow();
 			}
 			_numItems++;
 			unsigned int i=0;
@@ -86,7 +90,7 @@ namespace SteerLib {
 		}
 
 		/// Removes an object reference from this cell.
-		inline void remove(SpatialDatabaseItemPtr entry, unsigned int maxItems, float traversalCostToSubtract) {
+		inline void remove(SpatialDatabaseItemPtr entry, float traversalCostToSubtract) {
 
 			_gridCellMutex.lock();
 
@@ -108,8 +112,8 @@ namespace SteerLib {
 			}
 			_numItems--;
 			unsigned int i=0;
-			while ((_items[i] != entry) && (i<maxItems)) i++;
-			if (i >= maxItems) {
+			while ((i<_capacity) && (_items[i] != entry)) i++;
+			if (i >= _capacity) {
 				_gridCellMutex.unlock();
 				throw Util::GenericException("Tried to remove an object from a grid cell, but it did not exist there in the first place.");
 			}
@@ -123,6 +127,22 @@ namespace SteerLib {
 
 	private:
 
+		/// Moves the items of a full cell into storage of its own with twice the slots.
+		void _grow() {
+			unsigned int newCapacity = 2 * _capacity;
+			SpatialDatabaseItemPtr * newItems = new SpatialDatabaseItemPtr[newCapacity];
+			for (unsigned int j=0; j < newCapacity; j++) {
+				newItems[j] = (j < _capacity) ? _items[j] : NULL;
+			}
+			delete [] _grownItems;
+			_items = _grownItems = newItems;
+			_capacity = newCapacity;
+		}
+
+		// A cell may own the storage of its items, so it cannot be copied.
+		GridCell(const GridCell &);
+		GridCell & operator=(const GridCell &);
+
 		// The grid database is allowed to access the grid cell's private data directly.
 		friend class GridDatabase2D;
 		friend class GridDatabase2DPrivate;
@@ -130,9 +150,15 @@ namespace SteerLib {
 		/// The number of items currently referenced in this cell.
 		unsigned int _numItems;
 
-		/// An array of pointers of fixed length; the length is determined during GridDatabase initialization.
+		/// The number of slots in _items; it starts at the maxItemsPerGridCell of the database.
+		unsigned int _capacity;
+
+		/// An array of _capacity pointers, NULL where a slot is free; either the cell's part of the database's array, or _grownItems.
 		SpatialDatabaseItemPtr * _items;
 
+		/// The storage of a cell that outgrew its part of the database's array, or NULL.
+		SpatialDatabaseItemPtr * _grownItems;
+
 		/// Cost of traversing this grid cell
 		float _traversalCost;
 
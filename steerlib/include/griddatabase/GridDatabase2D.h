@@ -121,6 +121,8 @@ namespace SteerLib {
 		inline void getGridCoordinatesFromIndex(unsigned int cellIndex, unsigned int &xIndex, unsigned int & zIndex);
 		/// Returns the index of the GridCell that is indexed by 2-D integer coordinates (x,z).
 		inline unsigned int getCellIndexFromGridCoords(unsigned int x, unsigned int z) { return (x * _zNumCells) + z; }
+		/// Returns the Z-order (Morton) code of the GridCell where Point v is located: the bits of its grid coordinates interleaved, so that nearby cells mostly get nearby codes; 0xffffffff if v is outside the grid.
+		inline unsigned int getZOrderFromLocation( const Util::Point &v );
 		//@}
 
 		/// @name Database update functions
@@ -153,6 +155,8 @@ namespace SteerLib {
 		void getItemsInRange(std::set<SpatialDatabaseItemPtr> & neighborList, unsigned int xMinIndex, unsigned int xMaxIndex, unsigned int zMinIndex, unsigned int zMaxIndex, SpatialDatabaseItemPtr exclude);
 		/// Returns an STL set of objects in the specified range, culling agent objects to a hemisphere centered around the facingDirection.
 		void getItemsInVisualField(std::set<SpatialDatabaseItemPtr> & neighborList, float xmin, float xmax, float zmin, float zmax, SpatialDatabaseItemPtr exclude, const Util::Point & position, const Util::Vector & facingDirection, float radiusSquared);
+		/// Returns true if any agent other than exclude is positioned within radius of the given point; stops searching at the first one found.
+		bool hasAgentInRange(const Util::Point & position, float radius, SpatialDatabaseItemPtr exclude);
 		//@}
 
 		/// @name Ray tracing queries
@@ -225,6 +229,22 @@ namespace SteerLib {
 		result.z = (((float)z) + 0.5f)*_zCellSize + _zOrigin;
 	}
 
+	inline unsigned int GridDatabase2D::getZOrderFromLocation( const Util::Point &v ) {
+		int cellIndex = getCellIndexFromLocation(v.x, v.z);
+		if (cellIndex < 0) return 0xffffffff;
+		unsigned int x, z;
+		getGridCoordinatesFromIndex((unsigned int)cellIndex, x, z);
+		// spread the low 16 bits of each coordinate to the even bits, then put x on the even and z on the odd bits.
+		unsigned int code[2] = { x & 0xffff, z & 0xffff };
+		for (unsigned int i = 0; i < 2; i++) {
+			code[i] = (code[i] | (code[i] << 8)) & 0x00ff00ff;
+			code[i] = (code[i] | (code[i] << 4)) & 0x0f0f0f0f;
+			code[i] = (code[i] | (code[i] << 2)) & 0x33333333;
+			code[i] = (code[i] | (code[i] << 1)) & 0x55555555;
+		}
+		return code[0] | (code[1] << 1);
+	}
+
 	inline void GridDatabase2D::getGridCoordinatesFromIndex(unsigned int cellIndex, unsigned int &xIndex, unsigned int & zIndex) {
 		xIndex = cellIndex / _zNumCells; // integer division so that remainders also get truncated
 		zIndex = cellIndex - (xIndex * _zNumCells);
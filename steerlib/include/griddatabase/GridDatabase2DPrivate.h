@@ -15,6 +15,9 @@
 #include "util/Mutex.h"
 #include "griddatabase/GridCell.h"
 
+// forward declaration
+class MTRand;
+
 
 #ifdef _WIN32
 // on win32, there is an unfortunate conflict between exporting symbols for a
@@ -71,6 +74,9 @@ namespace SteerLib {
 
 		/// The state space interface used by the planner to plan paths through the database.
 		GridDatabasePlanningDomain * _planningDomain;
+
+		/// The random number generator used by the random position queries that do not provide their own; owned by each database so that simulations in different threads do not share it.
+		MTRand * _randomNumberGenerator;
 	};
 
 
@@ -79,6 +79,12 @@ namespace SteerLib {
 		virtual const std::queue<SteerLib::AgentGoalInfo> & agentGoals() const = 0;
 		//@}
 
+		/// @name Level of detail
+		//@{
+		/// Returns true if the engine may update this agent only every few frames while it is isolated or outside the region of interest (see the lod* engine options).  Such an agent must integrate with the dt given to updateAI(), which is then the simulation time since its previous update, rather than the clock's time-step.
+		virtual bool supportsLevelOfDetail() { return false; }
+		//@}
+
 		/// @name Some convenience functions so users can manipulate agents more explicitly
 		//@{
 		/// Adds a goal to the agent's existing list of goals
@@ -75,6 +75,8 @@ namespace SteerLib {
 		virtual SteerLib::GridDatabase2D * getSpatialDatabase() = 0;
 		/// Returns a reference to an STL vector containing a list of agents.
 		virtual const std::vector<SteerLib::AgentInterface*> & getAgents() = 0;
+		/// Returns the number of agents the engine still updates; agents are dropped from the update list when the engine finds them disabled at the start of a frame.
+		virtual unsigned int getNumActiveAgents() = 0;
 		/// Returns a reference to an STL set of selected agents.
 		virtual const std::set<SteerLib::AgentInterface*> & getSelectedAgents() = 0;
 		/// Returns a reference to an STL set containing a list of all obstacles.
@@ -141,6 +143,8 @@ namespace SteerLib {
 		virtual void addAgent(SteerLib::AgentInterface * newAgent, SteerLib::ModuleInterface * owner) = 0;
 		/// Removes an agent from the engine's data structures, without de-allocating it;  Whoever removed it is responsible for de-allocating it.
 		virtual void removeAgent(SteerLib::AgentInterface * agentToRemove) = 0;
+		/// Tells the engine that an agent was enabled again after being disabled, so that it is updated from the current frame on.  The engine stops updating an agent once it finds it disabled, and does not check it again until this is called.  Does nothing if the engine still updates the agent.
+		virtual void activateAgent(SteerLib::AgentInterface * agent) = 0;
 		/// Indicates that the given agent should be added to the set of "selected" agents.
 		virtual void selectAgent(SteerLib::AgentInterface * agent) = 0;
 		/// Indicates that the given agent should be removed from the set of selected agents; nothing will happen if the agent was not already selected.
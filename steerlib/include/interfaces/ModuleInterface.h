@@ -121,6 +121,10 @@ namespace SteerLib {
 		virtual void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber) { }
 		/// This update function is called once per frame after all agents are updated.
 		virtual void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber) { }
+		/// Returns false if preprocessFrame() does nothing for this module, so that the engine can skip calling it every frame; queried once in SimulationEngine::preprocessSimulation().
+		virtual bool usesPreprocessFrame() { return true; }
+		/// Returns false if postprocessFrame() does nothing for this module, so that the engine can skip calling it every frame; queried once in SimulationEngine::preprocessSimulation().
+		virtual bool usesPostprocessFrame() { return true; }
 		/// This function called when user interacts with the program using the keyboard, called if the engine did not already recognize the keypress.
 		virtual void processKeyboardInput(int key, int action ) { }
 		/// Uses OpenGL to draw any module-specific information to the screen; <b>WARNING:</b> this may be called multiple times per simulation step.
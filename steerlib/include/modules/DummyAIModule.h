@@ -86,6 +86,8 @@ namespace SteerLib {
 		LogData * getLogData() { return new LogData(); }
 		void init( const SteerLib::OptionDictionary & options, SteerLib::EngineInterface * engineInfo ) { }
 		void finish() { }
+		bool usesPreprocessFrame() { return false; }
+		bool usesPostprocessFrame() { return false; }
 
 		SteerLib::AgentInterface * createAgent() { return new DummyAgent; }
 		void destroyAgent( SteerLib::AgentInterface * agent ) { assert(agent!=NULL);  delete agent;  agent = NULL; }
@@ -55,6 +55,8 @@ namespace SteerLib {
 			_simulationMetrics->update( _engine->getSpatialDatabase(), _engine->getAgents(), timeStamp, dt);
 		}
 
+		bool usesPreprocessFrame() { return false; }
+
 		inline SteerLib::SimulationMetricsCollector * getSimulationMetrics() { return _simulationMetrics; }
 
 	protected:
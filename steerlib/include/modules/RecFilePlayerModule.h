@@ -90,6 +90,7 @@ namespace SteerLib
 		void initializeSimulation();
 		void cleanupSimulation();
 		void preprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
+		bool usesPostprocessFrame() { return false; }
 	protected:
 		SteerLib::EngineInterface * _engine;
 		SteerLib::RecFileReader * _simulationReader;
@@ -40,12 +40,21 @@ namespace SteerLib {
 		void preprocessSimulation();
 		void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
 		void postprocessSimulation();
+		bool usesPreprocessFrame() { return false; }
 
 	protected:
+		/// Copies the state of all agents into a rec file frame, writing it directly or handing it to the asynchronous writer.
+		void _recordFrame(float timeStamp, float dt);
+
 		SteerLib::EngineInterface * _engine;
 		SteerLib::RecFileWriter * _simulationWriter;
+		SteerLib::RecFileAsyncWriter * _asyncWriter;
+		/// The frame being filled in when recording synchronously; the asynchronous writer provides its own pooled buffers.
+		SteerLib::RecFileAgentInfo * _frameBuffer;
 		std::string _recFilename;
 
+		bool _useAsyncWriter;
+		unsigned int _numBufferedFrames;
 		bool _initialized;
 
 	};
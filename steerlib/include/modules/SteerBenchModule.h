@@ -66,6 +66,9 @@ namespace SteerLib {
 			// _benchmarkTechnique->update( _engine, timeStamp, dt);
 		}
 
+		/// postprocessFrame() currently only checks its assertion; benchmark techniques are updated in preprocessFrame().
+		bool usesPostprocessFrame() { return false; }
+
 		void reportBenchmarkResults () 
 		{
 			std::cout << "Benchmark score using the \"" << _techniqueName << "\" benchmark technique:  ";
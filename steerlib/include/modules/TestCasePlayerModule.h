@@ -15,6 +15,9 @@
 
 namespace SteerLib {
 
+	// forward declaration
+	class TestCaseReader;
+
 	class TestCasePlayerModule : public SteerLib::ModuleInterface
 	{
 	public:
@@ -27,6 +30,18 @@ namespace SteerLib {
 		void initializeSimulation();
 		void postprocessFrame(float timeStamp, float dt, unsigned int frameNumber);
 		void cleanupSimulation();
+		bool usesPreprocessFrame() { return false; }
+		/// postprocessFrame() only updates the Qt widget.
+		bool usesPostprocessFrame() {
+#if defined(ENABLE_GUI) && defined(ENABLE_QT)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		/// Uses an already parsed test case for the next simulation instead of reading the "testcase" file; the module does not take ownership of the reader, which must stay valid until initializeSimulation() returns.
+		void setTestCase(const SteerLib::TestCaseReader * testCase) { _sharedTestCase = testCase; }
 
 	protected:
 		SteerLib::EngineInterface * _engine;
@@ -34,6 +49,9 @@ namespace SteerLib {
 		std::string _aiModuleName;
 		std::string _aiModuleSearchPath;
 		SteerLib::ModuleInterface * _aiModule;
+		const SteerLib::TestCaseReader * _sharedTestCase;
+		/// The "obstaclemergegap" option, passed to TestCaseReader::setObstacleMergeGap(); negative to keep the boxes of the test case as they are.
+		float _obstacleMergeGap;
 
 		std::vector<SteerLib::ObstacleInterface *> _obstacles;
 
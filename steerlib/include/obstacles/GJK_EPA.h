@@ -18,11 +18,66 @@
 namespace SteerLib
 {
 
+	/**
+	 * @brief A polygon split into convex pieces once, for the allocation-free variant of GJK_EPA::intersect().
+	 *
+	 * A convex polygon is kept as a single piece, and any other polygon is triangulated.  The vertices of all pieces are
+	 * stored back to back, with the bounds of each piece, so that pairs of pieces that cannot overlap are skipped.
+	 * Build it with GJK_EPA::decompose().
+	 */
+	class STEERLIB_API ConvexDecomposition
+	{
+		public:
+			unsigned int getNumPieces() const { return (unsigned int)_pieceBounds.size(); }
+			const Util::Vector * getPieceVertices(unsigned int piece) const { return &_vertices[_pieceStart[piece]]; }
+			unsigned int getPieceSize(unsigned int piece) const { return _pieceStart[piece+1] - _pieceStart[piece]; }
+			const Util::AxisAlignedBox & getPieceBounds(unsigned int piece) const { return _pieceBounds[piece]; }
+			/// The bounds of all pieces.
+			const Util::AxisAlignedBox & getBounds() const { return _bounds; }
+
+		protected:
+			friend class GJK_EPA;
+			void _clear();
+			void _addPiece(const Util::Vector * vertices, unsigned int numVertices);
+
+			std::vector<Util::Vector> _vertices;
+			/// Piece k has the vertices [_pieceStart[k], _pieceStart[k+1]).
+			std::vector<unsigned int> _pieceStart;
+			std::vector<Util::AxisAlignedBox> _pieceBounds;
+			Util::AxisAlignedBox _bounds;
+	};
+
+
     class STEERLIB_API GJK_EPA
     {
         public:
 			GJK_EPA();
 
+			/// The most vertices the polytope of the allocation-free EPA holds; when it is full, the closest edge found so far is the result.
+			static const unsigned int MAX_POLYTOPE_SIZE = 32;
+			/// The most iterations the allocation-free GJK and EPA run before they give up.
+			static const unsigned int MAX_ITERATIONS = 64;
+
+			/**
+			 * @brief Splits a polygon into convex pieces, replacing the contents of decomposition.
+			 *
+			 * Decompose each static polygon once and keep the result, e.g. PolygonObstacle::getConvexDecomposition().
+			 */
+			static void decompose(const std::vector<Util::Vector>& shape, ConvexDecomposition& decomposition);
+
+			/**
+			 * @brief The allocation-free variant of intersect(), for shapes decomposed with decompose().
+			 *
+			 * Every pair of pieces whose bounds overlap is tested with GJK and EPA on fixed-size buffers, and the deepest
+			 * penetration is returned, as intersectConcave() does for triangles.  Unlike intersect(), a convex shape is
+			 * not triangulated when the other shape is concave, and GJK and EPA stop after MAX_ITERATIONS instead of
+			 * looping forever on degenerate input.  Nothing is allocated, so this is cheap enough to run every frame.
+			 */
+			static bool intersect(float& return_penetration_depth, Util::Vector& return_penetration_vector, const ConvexDecomposition& _shapeA, const ConvexDecomposition& _shapeB);
+
+			/// The allocation-free GJK and EPA on two convex shapes given as arrays of vertices.
+			static bool intersectConvex(float& return_penetration_depth, Util::Vector& return_penetration_vector, const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB);
+
             /*
              *
              *  DO NOT CHANGE THE FUNCTION DEFINITION FOR intersect()
@@ -241,6 +296,18 @@ namespace SteerLib
                   // Returns 1 if positive, 0 if zero, -1 if negative.
                   static int sign(float f);
 
+			/// @name The allocation-free variants of the helpers above, on arrays of vertices instead of std::vector.
+			//@{
+			static bool gjk(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, Util::Vector * simplex, unsigned int& simplexSize);
+			static bool simplexContainsOrigin(Util::Vector * simplex, unsigned int& simplexSize, Util::Vector& direction);
+			static Util::Vector getSimplexPointUsingDirection(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, const Util::Vector& direction);
+			static Util::Vector getShapeCenter(const Util::Vector * shape, unsigned int size);
+			static Util::Vector getFurthestPointInDirection(const Util::Vector * shape, unsigned int size, const Util::Vector& direction);
+			static void epa(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, Util::Vector * polytope, unsigned int polytopeSize, float& return_penetration_depth, Util::Vector& return_penetration_vector);
+			static void findClosestEdge(const Util::Vector * polytope, unsigned int polytopeSize, float& distance, Util::Vector& normal, int& index);
+			static bool originLiesOnSimplex(const Util::Vector * polytope, unsigned int polytopeSize, float& return_penetration_depth, Util::Vector& return_penetration_vector);
+			//@}
+
     }; // class GJK_EPA
 
 } // namespace SteerLib
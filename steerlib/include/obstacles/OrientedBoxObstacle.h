@@ -31,7 +31,14 @@ namespace SteerLib {
 		void draw(); // implementation in .cpp
 		const Util::AxisAlignedBox & getBounds() { return _bounds; }
 
-        virtual void returnVertices(std::vector<Util::Vector>& _out) { return; }
+        /// Returns the four rotated corners a, b, c, d, in order around the box.
+        virtual void returnVertices(std::vector<Util::Vector>& _out)
+        {
+            _out.push_back( _a );
+            _out.push_back( _b );
+            _out.push_back( _c );
+            _out.push_back( _d );
+        }
 
 		/// @name The SpatialDatabaseItem interface
 		/// @brief The OrientedBoxObstacle implementation of this interface represents a box that blocks line of sight if it is taller than 0.5 meter, and cannot be traversed.
@@ -14,6 +14,7 @@
 
 #include "interfaces/ObstacleInterface.h"
 #include "Globals.h"
+#include "obstacles/GJK_EPA.h"
 
 class STEERLIB_API PolygonObstacle : public SteerLib::ObstacleInterface {
 public:
@@ -26,21 +27,23 @@ public:
 	virtual void setBounds(const Util::AxisAlignedBox & bounds) { _bounds = bounds; }
 
 	/// @name The SpatialDatabaseItem interface
-	/// @brief The CircleObstacle implementation of this interface represents a box that blocks line of sight if it is taller than 0.5 meter, and cannot be traversed.
+	/// @brief The PolygonObstacle implementation of this interface tests the polygon itself, edge by edge; it blocks line of sight if it is taller than 0.7 meter, and cannot be traversed.
 	//@{
 	virtual bool isAgent() { return false; }
 	bool blocksLineOfSight() { return _blocksLineOfSight; }
 	float getTraversalCost() { return _traversalCost; }
 
-	virtual bool intersects(const Util::Ray &r, float &t) { return Util::rayIntersectsCircle2D(_centerPosition,_radius, r, t); }
-	virtual bool overlaps(const Util::Point & p, float radius) { return Util::circleOverlapsCircle2D(_centerPosition,_radius,p, radius); }
-	virtual float computePenetration(const Util::Point & p, float radius) { return Util::computeCircleCirclePenetration2D(_centerPosition, _radius, p, radius); }
+	virtual bool intersects(const Util::Ray &r, float &t);
+	virtual bool overlaps(const Util::Point & p, float radius) { return _circleMayOverlap(p, radius) && (computeSignedDistance(p) < radius); }
+	/// Returns how much the polygon penetrates the circle, from 0.0 to the radius; clamped to the radius when the center is inside, as computeBoxCirclePenetration2D() does for boxes.
+	virtual float computePenetration(const Util::Point & p, float radius);
 	virtual std::pair<std::vector<Util::Point>,std::vector<size_t> > getStaticGeometry();
 	virtual std::vector<Util::Point> get2DStaticGeometry()
 	{
 		return _points;
 	}
 
+	/// The center and radius of the circle around the polygon.
 	Util::Point position() { return this->_centerPosition; }
 	float radius() { return this->_radius; }
 
@@ -52,7 +55,33 @@ public:
 
 	//@}
 
+	/**
+	 * @brief Returns the distance from a point to the boundary of the polygon, negative if the point is inside.
+	 *
+	 * closestPoint is set to the closest point of the boundary, and normal to the unit vector at closestPoint that points
+	 * out of the polygon, i.e. the direction that pushes a circle at the point away from the polygon.  Works on concave
+	 * polygons too; the inside is decided by the even-odd rule.
+	 */
+	float computeSignedDistance(const Util::Point & p, Util::Point & closestPoint, Util::Vector & normal) const;
+	float computeSignedDistance(const Util::Point & p) const { Util::Point closestPoint; Util::Vector normal; return computeSignedDistance(p, closestPoint, normal); }
+
+	/**
+	 * @brief The batched computePenetration(): the penetration of the polygon into each of count circles.
+	 *
+	 * Circles whose bounds do not reach the bounds of the polygon cost four comparisons, so callers that test many
+	 * circles against the same polygon can hand all of them over at once; computePenetration() is the case of one circle.
+	 */
+	void computePenetrations(const Util::Point * centers, const float * radii, size_t count, float * penetrations) const;
+
+	/// The convex pieces of the polygon, decomposed once when the obstacle is created, for GJK_EPA::intersect().
+	const SteerLib::ConvexDecomposition & getConvexDecomposition() const { return _convexDecomposition; }
+
 protected:
+	/// Returns false if the circle is certainly outside the bounds of the polygon.
+	bool _circleMayOverlap(const Util::Point & p, float radius) const {
+		return (p.x + radius > _bounds.xmin) && (p.x - radius < _bounds.xmax) && (p.z + radius > _bounds.zmin) && (p.z - radius < _bounds.zmax);
+	}
+
 	float _radius;
 	Util::Point _centerPosition;
 
@@ -62,6 +91,11 @@ protected:
 	std::vector<Util::Point> _points;
     std::vector<Util::Vector> _vectors;
 	bool isConvex_;
+	SteerLib::ConvexDecomposition _convexDecomposition;
+	/// Edge i goes from _points[i] along _edgeDirection[i] to the next point; its outward unit normal is _edgeNormal[i].
+	std::vector<Util::Vector> _edgeDirection;
+	std::vector<float> _edgeLengthSquared;
+	std::vector<Util::Vector> _edgeNormal;
 
 };
 
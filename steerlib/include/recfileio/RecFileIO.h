@@ -226,6 +226,8 @@ namespace SteerLib {
 		bool isRecording() { return _opened; }
 		/// Returns true if the RecFileWriter is currently writing a frame; this is true between startFrame() and finishFrame() calls.
 		bool isWritingFrame() { return _writingFrame; }
+		/// Returns the number of agents in each frame, or 0 if no recording is in progress.
+		unsigned int getNumAgents() { return (_header != NULL) ? _header->numAgents : 0; }
 		//@}
 
 		/// @name Operations to write the rec file
@@ -239,6 +241,9 @@ namespace SteerLib {
 		/// Finishes the current frame being recorded.
 		void finishFrame();
 
+		/// Writes a complete frame in one call, copying all agents from an array of getNumAgents() entries; equivalent to startFrame(), setAgentInfoForCurrentFrame() for every agent, and finishFrame().
+		void writeFrame( float timeStamp, float timePassedSinceLastFrame, const RecFileAgentInfo * agentsInFrame );
+
 		/// Sets the agent's info for the frame that is currently being recorded, must be called between startFrame() and finishFrame();
 		void setAgentInfoForCurrentFrame( unsigned int agentIndex, float posx, float posy, float posz, float dirx, float diry, float dirz, float goalx, float goaly, float goalz, float radius, bool enabled );
 		/// Sets the agent's info for the frame that is currently being recorded, must be called between startFrame() and finishFrame();
@@ -257,6 +262,97 @@ namespace SteerLib {
 	};
 
 
+	/**
+	 * @brief Writes %SteerSuite rec files from a background thread, so that disk stalls do not stall the simulation.
+	 *
+	 * This class produces exactly the same rec files as RecFileWriter.  The difference is that frames are
+	 * copied into a ring of pooled snapshot buffers, and a dedicated writer thread drains the ring to disk.
+	 *
+	 * <h3> How to use this class </h3>
+	 *   -# Instantiate the class, specifying how many frames may be buffered before the simulation has to wait for the disk.
+	 *   -# Call startRecording(), as with RecFileWriter.
+	 *   -# For each frame, call startFrame(), fill in the returned array with the info of every agent, and then call finishFrame().
+	 *   -# Call finishRecording(), which waits for all buffered frames to be written before finishing the file.
+	 *
+	 * <h3> Notes </h3>
+	 *
+	 * If all snapshot buffers are still waiting to be written, startFrame() waits until the writer thread has
+	 * written the oldest one.  These stalls are counted, and can be queried with getNumStalls() and getTotalStallTime().
+	 *
+	 * Obstacles and camera views are only written at the end of the recording, so they can be added at any time
+	 * before finishRecording().
+	 *
+	 * @see
+	 *  - RecFileWriter, which writes frames synchronously
+	 *  - Util::ThreadedTaskManager, which provides the writer thread
+	 */
+	class STEERLIB_API RecFileAsyncWriter : public RecFileAsyncWriterPrivate {
+	public:
+		/// @name Constructors and destructors
+		//@{
+		/// Creates the writer thread; at most numBufferedFrames frames can be waiting to be written at any time.
+		RecFileAsyncWriter( unsigned int numBufferedFrames );
+		~RecFileAsyncWriter();
+		//@}
+
+		/// @name Meta data queries
+		//@{
+		/// Returns the filename being written to
+		const std::string & getFilename() { return _writer->getFilename(); }
+		/// Returns true if a recording is in progress; this is true between startRecording() and finishRecording() calls.
+		bool isOpen() { return _writer->isOpen(); }
+		/// Returns true if a recording is in progress; this is true between startRecording() and finishRecording() calls.
+		bool isRecording() { return _writer->isRecording(); }
+		/// Returns true if a frame is being filled in; this is true between startFrame() and finishFrame() calls.
+		bool isWritingFrame() { return _writingFrame; }
+		/// Returns the number of agents in each frame, i.e. the size of the array returned by startFrame().
+		unsigned int getNumAgents() { return _numAgents; }
+		//@}
+
+		/// @name Operations to write the rec file
+		//@{
+		/// Starts a new rec file to be recorded, optionally associated with a test case name, and allocates the snapshot buffers.
+		void startRecording(size_t numAgents, const std::string & filename, const std::string & testCaseName = "");
+		/// Waits for all buffered frames to be written, and then finishes the rec file.
+		void finishRecording();
+		/// Starts a new frame, returning the snapshot array that should be filled with the info of all agents before calling finishFrame().
+		RecFileAgentInfo * startFrame( float timeStamp, float timePassedSinceLastFrame );
+		/// Hands the current frame over to the writer thread.
+		void finishFrame();
+		/// Waits until all frames handed to the writer thread so far have been written.
+		void flush();
+
+		/// Adds an obstacle's info to the recording.
+		void addObstacleBoundingBox( float xmin, float xmax, float ymin, float ymax, float zmin, float zmax );
+		/// Adds an obstacle's info to the recording.
+		inline void addObstacleBoundingBox( const Util::AxisAlignedBox & bb ) { addObstacleBoundingBox(bb.xmin, bb.xmax, bb.ymin, bb.ymax, bb.zmin, bb.zmax); }
+
+		/// Adds a suggested camera view to the recording.
+		void addCameraView( float origx, float origy, float origz, float lookatx, float lookaty, float lookatz);
+		/// Adds a suggested camera view to the recording.
+		inline void addCameraView( const Util::Point & pos, const Util::Point & lookat ) { addCameraView( pos.x, pos.y, pos.z, lookat.x, lookat.y, lookat.z ); }
+		//@}
+
+		/// @name Back-pressure statistics
+		//@{
+		/// Returns the number of snapshot buffers in the ring.
+		unsigned int getNumBufferedFrames() { return (unsigned int)_ring.size(); }
+		/// Returns the largest number of frames that were waiting to be written at the same time.
+		unsigned int getMaxQueuedFrames() { return _maxQueuedFrames; }
+		/// Returns the number of times startFrame() had to wait for the writer thread because the ring was full.
+		long long getNumStalls() { return _stallProfiler.getNumTimesExecuted(); }
+		/// Returns the total time (in seconds) that startFrame() spent waiting for the writer thread.
+		float getTotalStallTime() { return _stallProfiler.getTotalTime(); }
+		/// Outputs a human-readable form of these statistics.
+		void displayStatistics(std::ostream & out);
+		//@}
+
+	protected:
+		/// The task run on the writer thread for each queued snapshot.
+		static void _writeSnapshot( unsigned int threadIndex, void * data );
+	};
+
+
 } // end namespace SteerLib
 
 #endif
@@ -17,6 +17,9 @@
 #include <vector>
 #include "Globals.h"
 #include "util/MemoryMapper.h"
+#include "util/Mutex.h"
+#include "util/ThreadedTaskManager.h"
+#include "util/PerformanceProfiler.h"
 
 #ifdef _WIN32
 // on win32, there is an unfortunate conflict between exporting symbols for a
@@ -244,6 +247,52 @@ namespace SteerLib {
 	};
 
 
+	// forward declarations
+	class STEERLIB_API RecFileWriter;
+	class STEERLIB_API RecFileAsyncWriter;
+
+	/**
+	 * @brief One pooled frame snapshot in the ring buffer of the RecFileAsyncWriter class.
+	 *
+	 * The agent array is allocated once when recording starts, and is re-used for every frame that passes through this slot.
+	 */
+	struct RecFileFrameSnapshot {
+		/// The time stamp of the frame held in this snapshot.
+		float timeStamp;
+		/// The time between the previous frame and this frame.
+		float timePassedSinceLastFrame;
+		/// The info of all agents for this frame.
+		RecFileAgentInfo * agents;
+		/// True from the time the frame is handed to the writer thread until it has been written to disk.
+		bool queued;
+		/// The writer that owns this snapshot, used by the writer thread.
+		RecFileAsyncWriter * owner;
+	};
+
+	/**
+	 * @brief The protected data and member functions used by the RecFileAsyncWriter class.
+	 *
+	 * This class should not be used directly.  Instead, use the RecFileAsyncWriter public interface that
+	 * inherits from this class.
+	 */
+	class STEERLIB_API RecFileAsyncWriterPrivate {
+	protected:
+		/// Protected constructor enforces that users cannot publically instantiate this class.
+		RecFileAsyncWriterPrivate() { }
+
+		RecFileWriter * _writer;
+		Util::ThreadedTaskManager * _writerThread;
+		Util::Mutex _ringLock;
+		std::vector<RecFileFrameSnapshot> _ring;
+		unsigned int _currentSlot;
+		unsigned int _numQueuedFrames;
+		unsigned int _maxQueuedFrames;
+		unsigned int _numAgents;
+		bool _writingFrame;
+		Util::PerformanceProfiler _stallProfiler;
+	};
+
+
 } // end namespace SteerLib
 
 #ifdef _WIN32
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+#ifndef __STEERLIB_BATCH_SIMULATION_RUNNER_H__
+#define __STEERLIB_BATCH_SIMULATION_RUNNER_H__
+
+/// @file BatchSimulationRunner.h
+/// @brief Declares the SteerLib::BatchSimulationRunner class.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+#include "Globals.h"
+#include "simulation/SimulationOptions.h"
+#include "simulation/SimulationEngine.h"
+#include "interfaces/EngineControllerInterface.h"
+#include "testcaseio/TestCaseIO.h"
+#include "util/GenericException.h"
+#include "util/Mutex.h"
+#include "util/ThreadedTaskManager.h"
+
+#ifdef _WIN32
+// see steerlib/util/DrawLib.h for explanation
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+#endif
+
+namespace SteerLib {
+
+	/// One simulation to be run by the SteerLib::BatchSimulationRunner.
+	struct STEERLIB_API BatchSimulationJob {
+		/// The XML test case; it is searched for the same way the testCasePlayer module does.
+		std::string testCaseFilename;
+		/// Name of the AI module that controls the agents.
+		std::string aiModuleName;
+		/// Options given to the AI module, in the same "name=value,name=value" form used on the steersim command line.
+		std::string aiModuleOptions;
+		/// Seed for the random initial conditions of the test case.
+		unsigned int randomSeed;
+	};
+
+	/// The outcome of one SteerLib::BatchSimulationJob.
+	struct STEERLIB_API BatchSimulationResult {
+		unsigned int jobIndex;
+		/// Index of the worker thread that ran the job.
+		unsigned int threadIndex;
+		bool succeeded;
+		/// The exception message if the job did not succeed.
+		std::string errorMessage;
+		unsigned int numFramesSimulated;
+		float simulatedTime;
+		/// Real time in seconds spent initializing, simulating and cleaning up this job.
+		float realTime;
+		size_t numAgents;
+		/// Number of agents that were still enabled when the simulation ended.
+		size_t numUnfinishedAgents;
+	};
+
+	/**
+	 * @brief Runs many independent simulations in parallel, each one in its own SimulationEngine.
+	 *
+	 * Jobs are added with #addJob() or #addJobsFromFile(), and #run() executes all of them on a
+	 * Util::ThreadedTaskManager.  Every worker thread owns one SimulationEngine that it keeps for
+	 * consecutive jobs using the same AI module and options, so modules are loaded and the spatial
+	 * database is allocated only when the AI configuration changes.  Each distinct (test case, seed)
+	 * pair is parsed once, and the parsed SteerLib::TestCaseReader is shared read-only by all jobs
+	 * that use it.
+	 *
+	 * Results are written to the output stream as soon as each job finishes, so they appear in
+	 * completion order rather than job order; #getResults() returns them in job order afterwards.
+	 *
+	 * <h3> Job files </h3>
+	 * Each non-empty line that does not start with '#' describes one job:
+	 * \code
+	 * <testcase> <aiModule>[,option=value,...] [seed]
+	 * \endcode
+	 * If the seed is omitted, the TestCaseReader default seed (2) is used.
+	 *
+	 * <b>Note:</b> AI modules must not keep simulation state in global variables, otherwise
+	 * concurrent engines in the same process will interfere with each other.
+	 */
+	class STEERLIB_API BatchSimulationRunner {
+	public:
+		/// The options are copied; every job starts from them, adding the testCasePlayer and its AI module.
+		BatchSimulationRunner(const SteerLib::SimulationOptions & baseOptions, unsigned int numThreads);
+		~BatchSimulationRunner();
+
+		/// Adds one job to the batch.
+		void addJob(const SteerLib::BatchSimulationJob & job);
+		/// Adds all jobs described by a job file; see the class documentation for the format.
+		void addJobsFromFile(const std::string & filename);
+		/// Returns the number of jobs added so far.
+		unsigned int getNumJobs() { return (unsigned int)_jobs.size(); }
+
+		/// Runs all jobs, streaming one line per finished job to out; returns the number of jobs that failed.
+		unsigned int run(std::ostream & out);
+		/// Returns the results of the last run(), indexed by job.
+		const std::vector<SteerLib::BatchSimulationResult> & getResults() { return _results; }
+
+	protected:
+		/// The engine owned by one worker thread; also the engine controller given to that engine.
+		class Worker : public SteerLib::EngineControllerInterface {
+		public:
+			Worker() : engine(NULL) { }
+			SteerLib::SimulationEngine * engine;
+			SteerLib::SimulationOptions options;
+			/// AI module name and options the current engine was initialized with.
+			std::string aiConfiguration;
+
+			/// @name The EngineControllerInterface
+			/// @brief Batch workers do not support any of the engine controls.
+			//@{
+			virtual bool isStartupControlSupported() { return false; }
+			virtual bool isPausingControlSupported() { return false; }
+			virtual bool isPaused() { return false; }
+			virtual void loadSimulation() { throw Util::GenericException("BatchSimulationRunner does not support loadSimulation()."); }
+			virtual void unloadSimulation() { throw Util::GenericException("BatchSimulationRunner does not support unloadSimulation()."); }
+			virtual void startSimulation() { throw Util::GenericException("BatchSimulationRunner does not support startSimulation()."); }
+			virtual void stopSimulation() { throw Util::GenericException("BatchSimulationRunner does not support stopSimulation()."); }
+			virtual void pauseSimulation() { throw Util::GenericException("BatchSimulationRunner does not support pauseSimulation()."); }
+			virtual void unpauseSimulation() { throw Util::GenericException("BatchSimulationRunner does not support unpauseSimulation()."); }
+			virtual void togglePausedState() { throw Util::GenericException("BatchSimulationRunner does not support togglePausedState()."); }
+			virtual void pauseAndStepOneFrame() { throw Util::GenericException("BatchSimulationRunner does not support pauseAndStepOneFrame()."); }
+			//@}
+		};
+
+		/// The data given to each task; jobs refer to their shared test case by index.
+		struct TaskData {
+			BatchSimulationRunner * runner;
+			unsigned int index;
+		};
+
+		/// Task function that parses one distinct (test case, seed) pair.
+		static void _parseTestCase(unsigned int threadIndex, void * data);
+		/// Task function that runs one job on the calling worker thread's engine.
+		static void _runJob(unsigned int threadIndex, void * data);
+
+		/// Returns the path of an existing test case file, trying the same locations as the testCasePlayer module.
+		std::string _findTestCase(const std::string & testCaseFilename);
+		/// Makes sure the worker has an engine initialized for the given job, re-creating it if the AI configuration differs.
+		void _prepareWorker(Worker & worker, const SteerLib::BatchSimulationJob & job);
+		/// Finishes and deletes the worker's engine, if it has one.
+		void _releaseWorker(Worker & worker);
+		/// Writes one result line to the output stream; thread-safe.
+		void _reportResult(const SteerLib::BatchSimulationResult & result);
+
+		SteerLib::SimulationOptions _baseOptions;
+		unsigned int _numThreads;
+		Util::ThreadedTaskManager * _threadPool;
+
+		std::vector<SteerLib::BatchSimulationJob> _jobs;
+		std::vector<SteerLib::BatchSimulationResult> _results;
+		std::vector<Worker> _workers;
+
+		/// Distinct test cases used by the jobs, and the index of the test case used by each job.
+		std::vector<std::string> _testCasePaths;
+		std::vector<unsigned int> _testCaseSeeds;
+		std::vector<SteerLib::TestCaseReader *> _testCases;
+		std::vector<std::string> _testCaseErrors;
+		std::vector<unsigned int> _jobTestCaseIndex;
+
+		/// Protects the output stream and the count of finished jobs.
+		Util::Mutex _outputLock;
+		std::ostream * _out;
+		unsigned int _numJobsFinished;
+	};
+
+} // end namespace SteerLib
+
+#ifdef _WIN32
+#pragma warning( pop )
+#endif
+
+#endif
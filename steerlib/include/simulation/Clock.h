@@ -180,6 +180,8 @@ namespace SteerLib {
 		void reset();
 		/// Advances the simulation and real-time clocks by one step.
 		void advanceSimulationAndUpdateRealTime();
+		/// Advances only the simulation clock by one fixed step, without waiting for or measuring real-time; used when running headless.
+		void advanceSimulation();
 		/// BackTracks the simulation and real-time clocks by one step.
 		void backupSimulationAndUpdateRealTime();
 		/// Advances only real-time clock, but not the simulation clock.
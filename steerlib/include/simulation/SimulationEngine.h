@@ -15,6 +15,7 @@
 
 #include "interfaces/EngineInterface.h"
 #include "util/StateMachine.h"
+#include <unordered_map>
 
 #define KEY_PRESSED 1
 
@@ -73,6 +74,8 @@ namespace SteerLib {
 	 *         update(true) can be used when the simulation is "paused".  It will update real-time clock and camera, but
 	 *         it will not update any modules, and is not considered a "simulation step".
 	 *      -# When updateSimulation() returns false, or when you decide to finish the simulation, call postprocessSimulation().
+	 *         Engine drivers that never draw anything can call updateHeadless() instead of update(false); it runs
+	 *         many steps per call and skips the real-time clock and camera entirely.
 	 *      -# clean up the simulation by calling cleanupSimulation().
 	 *   -# Once you are done, call finish() to clean up the engine, and de-allocate it.
 	 *
@@ -155,6 +158,8 @@ namespace SteerLib {
 		void postprocessSimulation();
 		/// Updates the camera, clock, all modules, and all agents; returns false if the simulation is done; if isPaused is true, the simulation will update the camera and other real-time aspects, but will not simulate anything.
 		bool update( bool advanceRealTimeOnly );
+		/// Runs up to numFrames simulation steps (all remaining steps if numFrames is 0) without touching the real-time clock or the camera; returns false if the simulation is done.  Every step uses the fixed frame rate, regardless of the clock mode.
+		bool updateHeadless( unsigned int numFrames );
 		/// stops execution
 		void stop();
 		//@}
@@ -174,6 +179,7 @@ namespace SteerLib {
 		//@{
 		virtual SteerLib::GridDatabase2D * getSpatialDatabase() { return _spatialDatabase; }
 		virtual const std::vector<SteerLib::AgentInterface*> & getAgents() { return _agents; }
+		virtual unsigned int getNumActiveAgents() { return (unsigned int)_activeAgents.size(); }
 		virtual const std::set<SteerLib::AgentInterface*> & getSelectedAgents() { return _selectedAgents; }
 		virtual const std::set<SteerLib::ObstacleInterface*> & getObstacles() { return _obstacles; }
 		virtual SteerLib::ModuleInterface * getModule(const std::string & moduleName);
@@ -205,6 +211,7 @@ namespace SteerLib {
 		virtual void destroyAllAgentsFromModule(SteerLib::ModuleInterface * owner);
 		virtual void addAgent(SteerLib::AgentInterface * newAgent, SteerLib::ModuleInterface * owner);
 		virtual void removeAgent(SteerLib::AgentInterface * agentToRemove);
+		virtual void activateAgent(SteerLib::AgentInterface * agent);
 		virtual void selectAgent(SteerLib::AgentInterface * agent) { if (agent != NULL) _selectedAgents.insert(agent); }
 		virtual void unselectAgent(SteerLib::AgentInterface * agent) { if (agent != NULL) _selectedAgents.erase(agent); }
 		virtual void unselectAllAgents() { _selectedAgents.clear(); }
@@ -226,6 +233,27 @@ namespace SteerLib {
 
 	protected:
 
+		/// The module that owns an agent, and where the agent is stored in _activeAgents; kept in _agentEntries, parallel to _agents.
+		struct AgentEntry {
+			SteerLib::ModuleInterface * owner;
+			/// NOT_ACTIVE if the agent is not in _activeAgents.
+			unsigned int activeIndex;
+		};
+		static const unsigned int NOT_ACTIVE = 0xffffffff;
+
+		/// When an active agent is next updated; kept in _activeAgentSchedules, parallel to _activeAgents.
+		struct AgentSchedule {
+			/// Cached AgentInterface::supportsLevelOfDetail().
+			bool supportsLevelOfDetail;
+			/// Offsets the frames on which this agent is updated at reduced rate, so that those updates are spread evenly over the frames.
+			unsigned int phase;
+			unsigned int nextUpdateFrame;
+			/// Simulation time of the previous update, or a negative number if the agent was not updated yet.
+			float lastUpdateTime;
+			/// Where the agent is stored in _agents and _agentEntries.
+			unsigned int agentIndex;
+		};
+
 		/// Clears all data structures and initializes values to dummy values; however, does not de-allocate data, so this should only be used inside of init().
 		void _reset();
 		/// Runs one step of the simulation
@@ -240,6 +268,20 @@ namespace SteerLib {
 		bool _unloadModule(SteerLib::ModuleInterface * moduleToDestroy, bool recursivelyUnloadDependencies, bool errorIfCannotUnload );
 		/// Helper function to initialize and start the engine state machine that makes sure the engine is always in a valid state.
 		void _setupStateMachine();
+		/// Adds an agent to _agents and _activeAgents, and records where it is stored.
+		void _insertAgent(SteerLib::AgentInterface * newAgent, SteerLib::ModuleInterface * owner);
+		/// Removes the agent at agentIndex of _agents from _agents and _activeAgents in constant time, using the indices stored in its entry; returns the module that owns it.
+		SteerLib::ModuleInterface * _eraseAgent(unsigned int agentIndex);
+		/// Appends the agent at agentIndex of _agents to _activeAgents, with a fresh level-of-detail schedule.
+		void _pushActiveAgent(unsigned int agentIndex);
+		/// Swaps the agent at activeIndex of _activeAgents out of _activeAgents.
+		void _deactivateAgent(unsigned int activeIndex);
+		/// Returns where an agent is stored in _agents, or throws with the given message if the engine has no record of it.
+		unsigned int _findAgentIndex(SteerLib::AgentInterface * agent, const char * errorMessage);
+		/// Sorts _activeAgents (and their schedules) by the Z-order of the grid cell each agent is in.
+		void _reorderActiveAgents();
+		/// Returns true if the agent is isolated or outside the region of interest, so it only needs to be updated every lodUpdateInterval frames.
+		bool _canUseLowDetail(SteerLib::AgentInterface * agent);
 
 	#ifdef ENABLE_GUI
 		void _drawEnvironment();
@@ -271,13 +313,28 @@ namespace SteerLib {
 		std::vector<SteerLib::ModuleInterface*> _modulesInExecutionOrder;
 		/// maps the name of a conflicting module to the module that declared it a conflict.
 		std::multimap<std::string, std::string> _moduleConflicts;
+		/// the modules (in order of execution) whose preprocessFrame() and postprocessFrame() are called each frame; updated by preprocessSimulation().
+		std::vector<SteerLib::ModuleInterface*> _modulesWithPreprocessFrame;
+		std::vector<SteerLib::ModuleInterface*> _modulesWithPostprocessFrame;
 		//@}
 
 		/// @name Data structures to keep track of agents
 		//@{
 		std::vector<SteerLib::AgentInterface*> _agents;
+		/// Parallel to _agents.
+		std::vector<AgentEntry> _agentEntries;
+		/// Where each agent is stored in _agents; only looked up when an agent is given to the engine from outside.
+		std::unordered_map<SteerLib::AgentInterface*, unsigned int> _agentIndices;
+		/// The agents that are updated every frame, in no particular order; disabled agents are swapped out when a frame finds them, and only activateAgent() brings them back.
+		std::vector<SteerLib::AgentInterface*> _activeAgents;
+		std::vector<AgentSchedule> _activeAgentSchedules;
+		/// Counts agents added to _activeAgents, to stagger their level-of-detail phases.
+		unsigned int _numAgentActivations;
 		std::set<SteerLib::AgentInterface*> _selectedAgents;
-		std::map<SteerLib::AgentInterface*, SteerLib::ModuleInterface*> _agentOwners;
+		/// Scratch storage of _reorderActiveAgents(), kept to reuse its memory.
+		std::vector< std::pair<unsigned int, unsigned int> > _reorderKeys;
+		std::vector<SteerLib::AgentInterface*> _reorderedAgents;
+		std::vector<AgentSchedule> _reorderedSchedules;
 		//@}
 
 		/// @name Other objects managed by the engine
@@ -261,6 +261,10 @@ namespace SteerLib {
 			float minVariableDt;
 			float maxVariableDt;
 			std::string clockMode;
+			unsigned int lodUpdateInterval;
+			float lodNeighborRadius;
+			Util::AxisAlignedBox lodRegionOfInterest;
+			unsigned int agentReorderInterval;
 		};
 
 		struct GridDatabaseOptions {
@@ -290,6 +294,7 @@ namespace SteerLib {
 		};
 
 		struct CommandLineEngineDriverOptions {
+			bool headless;
 		};
 
 		struct GLFWEngineDriverOptions {
@@ -47,6 +47,18 @@ namespace SteerLib {
 	 * number generator.  Goals can also be random, but are NOT resolved here, since we cannot predict run-time conditions to
 	 * determine valid random goals at intialization.
 	 *
+	 * Besides SteerSuite XML test cases, #readTestCaseFromFile() reads the grid maps (".map") and scenarios (".scen") of the
+	 * MovingAI pathfinding benchmarks directly.  The map is centered on the origin with one unit per cell, every run of
+	 * blocked cells in a row becomes a box obstacle, and every problem of a scenario becomes an agent that seeks its goal cell.
+	 *
+	 * Test cases converted from grid maps describe walls as thousands of thin boxes, one per row segment of the map.  After
+	 * the obstacles are initialized, axis-aligned boxes with the same height that share a side, or that are separated by a
+	 * gap no wider than #setObstacleMergeGap(), are merged into maximal rectangles: first along x, then along z, repeated
+	 * until nothing changes.  Boxes are merged only when their union is exactly a box (up to the gap), so the space they
+	 * occupy stays the same.  Other obstacles are kept as they are, and the obstacles that remain keep their order.  The gap
+	 * is 0 by default, which leaves free space alone; maps converted with slivers between their rows, such as the
+	 * dragon_age test cases, need a small gap like 0.05 to merge.
+	 *
 	 * If the test case is large, this class may consume a large amount of memory.  It is a good idea to de-allocate it
 	 * as soon as you finish initializing your own data.
 	 *
@@ -58,8 +70,12 @@ namespace SteerLib {
 	class STEERLIB_API TestCaseReader : public TestCaseReaderPrivate {
 	public:
 		TestCaseReader();
-		/// Parses the specified XML test case; after this function returns the class contains all initialized information about the test case.
+		/// Parses the specified XML test case, or MovingAI map or scenario; after this function returns the class contains all initialized information about the test case.
 		void readTestCaseFromFile( const std::string & testCaseFilename );
+		/// Re-seeds the random number generator used to resolve random initial conditions; call this before #readTestCaseFromFile().  The default seed is 2.
+		void setRandomSeed( unsigned int seed );
+		/// Sets the widest gap between two axis-aligned boxes that are merged into one when the test case is read; call this before #readTestCaseFromFile().  A negative gap keeps every box as it is.  The default is 0, which merges only boxes that touch or overlap.
+		void setObstacleMergeGap( float gap ) { _obstacleMergeGap = gap; }
 
 		/// @name General queries about the test case
 		//@{
@@ -67,6 +83,8 @@ namespace SteerLib {
 		inline size_t getNumAgents() const { return _initializedAgents.size(); }
 		/// Returns the total number of obstacles specified by the test case.
 		inline size_t getNumObstacles() const { return _initializedObstacles.size(); }
+		/// Returns the number of obstacles the test case specifies, before adjacent boxes were merged.
+		inline size_t getNumObstaclesBeforeMerging() const { return _numObstaclesBeforeMerging; }
 		/// Returns the total number of suggested camera views specified by the test case.
 		inline size_t getNumCameraViews() const { return _cameraViews.size(); }
 		/// Returns the test case name (not the filename) specified by the test case.
@@ -78,9 +96,9 @@ namespace SteerLib {
 		/// Returns a human-readable string desciribing the criteria for passing a particular test case; In the future this criteria may become more elaborate and automated.
 		inline const std::string & getPassingCriteria() { return _header.passingCriteria; }
 		/// Returns a data structure containing information about one suggested camera view.
-		inline const CameraView & getCameraView(unsigned int cameraIndex) { return _cameraViews[cameraIndex]; }
+		inline const CameraView & getCameraView(unsigned int cameraIndex) const { return _cameraViews[cameraIndex]; }
 		/// Returns a data structure containing information about all suggested camera view.
-		inline const std::vector<CameraView> & getCameraViews() { return _cameraViews; }
+		inline const std::vector<CameraView> & getCameraViews() const { return _cameraViews; }
 		/// Returns the world boundaries specified by the test case.
 		inline const Util::AxisAlignedBox & getWorldBounds() const { return _header.worldBounds; }
 		#ifdef VARIABLE_SPAWN_TIME
@@ -307,7 +307,7 @@ namespace SteerLib {
 	class STEERLIB_API TestCaseReaderPrivate {
 	protected:
 		/// Protected constructor enforces that users cannot publically instantiate this class.
-		TestCaseReaderPrivate() { }
+		TestCaseReaderPrivate() : _obstacleMergeGap(0.0f), _numObstaclesBeforeMerging(0) { }
 
 
 		/// @name Helper functions for parsing
@@ -338,6 +338,10 @@ namespace SteerLib {
 		void _parseInitialConditions(const ticpp::Element * subRoot, RawAgentInfo & newAgent);
 		/// Parses the sequence of goals specified in an agent or agent region.
 		void _parseGoalSequence(const ticpp::Element * subRoot, std::vector<AgentGoalInfo> & goals);
+		/// Reads a MovingAI benchmark map: the header follows from the size of the map, and each run of blocked cells in a row becomes a box obstacle.
+		void _parseMovingAIMap(const std::string & mapFilename, std::vector<bool> & passable, unsigned int & width, unsigned int & height);
+		/// Reads a MovingAI benchmark scenario and the map it uses; each problem of the scenario becomes an agent that seeks the goal cell from the start cell.
+		void _parseMovingAIScenario(const std::string & scenarioFilename);
 		/// Reads a bounding-box data type from a SteerSuite test case.
 		Util::AxisAlignedBox _getBoundsFromXMLElement(const ticpp::Element * subRoot);
 		/// Reads a 3 element vector from a SteerSuite test case, or indicates that it should be randomly generated.
@@ -356,6 +360,8 @@ namespace SteerLib {
 		//@{
 		void _initObstacleInitialConditions( SteerLib::ObstacleInitialConditions & o, const Util::AxisAlignedBox & bounds );
 		void _initAgentInitialConditions( SteerLib::AgentInitialConditions & a, const SteerLib::RawAgentInfo & agent );
+		/// Merges the axis-aligned boxes in _initializedObstacles that touch, or are at most _obstacleMergeGap apart, into larger boxes.
+		void _mergeBoxObstacles();
 		//@}
 
 
@@ -369,6 +375,10 @@ namespace SteerLib {
 		std::vector<AgentInitialConditions> _initializedAgents;
 		/// Initial conditions of all obstacles
 		std::vector<ObstacleInitialConditions*> _initializedObstacles;
+		/// The widest gap between two boxes that #_mergeBoxObstacles() closes; negative if boxes are not merged.
+		float _obstacleMergeGap;
+		/// The number of obstacles in _initializedObstacles before boxes were merged.
+		size_t _numObstaclesBeforeMerging;
 
 		/// Temporary data of agents while parsing the test case
 		std::vector<RawAgentInfo> _rawAgents;
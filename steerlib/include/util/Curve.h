@@ -42,11 +42,22 @@ namespace Util {
 		float time;
 	};
 
+	/* The cubic polynomial of a Curve between two control points: p(u) = c0 + u*(c1 + u*(c2 + u*c3)), where u is the time
+	** since the first of the two points.
+	*/
+
+	struct CurveSegment
+	{
+		Vector coefficients[4];
+	};
+
 	/* Class for implementing an animation curve. From within any module, class or function, a Curve object can be created.
 	** Control points must be passed to this class as CurvePoint objects (one by one, or together in a vector).
 	** Any animatable parameter setpoints, can be used to create a vector of CurvePoints and then used to instantiate a Curve object.
 	** Curve object, after instantiation, is completely independant and can be used separatly.
-	** Any family of curves can be implemented within calculatePoint member function, and no other part of the class needs to be altered.
+	** Any family of curves can be implemented within computeSegments member function, and no other part of the class needs to be altered.
+	** Whenever the control points or the type change, the curve is converted once into one cubic polynomial per segment, so that
+	** calculatePoint only has to find the segment (a binary search over the times) and evaluate it.
 	*/
 
 	class UTIL_API Curve
@@ -59,7 +70,7 @@ namespace Util {
 		~Curve() {}
 
 		// Get and set type
-		void setType(int curveType) { type = curveType; }
+		void setType(int curveType) { type = curveType; computeSegments(); }
 		int getType() { return type; }
 
 		// Add one control point to the vector controlPoints
@@ -87,17 +98,26 @@ namespace Util {
 		// Type of curve
 		int type;
 
+		// The times of the control points, in the same (sorted) order, searched by findTimeInterval
+		std::vector<float> times;
+
+		// segments[i] is the polynomial between controlPoints[i] and controlPoints[i+1]
+		std::vector<CurveSegment> segments;
+
 		// Check Roboustness
 		bool checkRobust();
 
 		// Find the current time interval (i.e. index of the next control point to follow according to current time)
 		bool findTimeInterval(unsigned int& nextPoint, float time);
 
-		// Implement Hermite curve
-		Point useHermiteCurve(const unsigned int nextPoint, const float time);
+		// Compute times and segments from controlPoints, for the current type of curve
+		void computeSegments();
+
+		// Compute the polynomial of one segment, given the tangents (per unit of time) at both of its control points
+		void computeHermiteSegment(const unsigned int nextPoint, const Vector& startTangent, const Vector& endTangent);
 
-		// Implement Catmull-Rom curve
-		Point useCatmullCurve(const unsigned int nextPoint, const float time);
+		// Calculate the position at the given time on the segment that ends at nextPoint
+		Point evaluateSegment(const unsigned int nextPoint, const float time);
 	};
 }
 
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+#ifndef __UTIL_OBJECT_POOL_H__
+#define __UTIL_OBJECT_POOL_H__
+
+/// @file ObjectPool.h
+/// @brief Declares Util::ObjectPool, a typed pool that allocates objects contiguously and recycles their storage.
+
+#include <new>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+namespace Util {
+
+	/**
+	 * @brief A pool of objects of one type, allocated in contiguous chunks and recycled.
+	 *
+	 * AI modules use it to allocate their agents: createAgent() calls #create() instead of <code>new</code>, and destroyAgent()
+	 * calls #destroy() instead of <code>delete</code>.  The pool keeps its chunks when objects are destroyed, so the agents of the next
+	 * simulation reuse the same memory instead of going back to the allocator.  Whenever the pool becomes empty (e.g. after
+	 * all agents of a simulation were destroyed), its free slots are put back in address order, so the agents created next are
+	 * again contiguous and in creation order.
+	 *
+	 * Objects are constructed in place; pointers to them stay valid until they are destroyed, because chunks never move.
+	 * Only objects of exactly type T may be given to #destroy() (not objects of a derived type), and the pool is not thread-safe.
+	 */
+	template <typename T, unsigned int ChunkSize = 256>
+	class ObjectPool {
+	public:
+		ObjectPool() : _numObjects(0) { }
+		/// Destroys any objects that are still alive and releases the chunks.
+		~ObjectPool() {
+			destroyAll();
+			for (size_t i = 0; i < _chunks.size(); i++) {
+				::operator delete(_chunks[i]);
+			}
+		}
+
+		/// Constructs a new object in the pool with the given constructor arguments.
+		template <typename... Args>
+		T * create(Args&&... args) {
+			unsigned int slot = _takeFreeSlot();
+			T * object;
+			try {
+				object = new (_getSlotAddress(slot)) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				_freeSlots.push_back(slot);
+				throw;
+			}
+			_alive[slot] = true;
+			_numObjects++;
+			return object;
+		}
+
+		/// Destroys an object created by this pool and recycles its storage; NULL is ignored.
+		void destroy(T * object) {
+			if (object == NULL) return;
+			unsigned int slot = _getSlotIndex(object);
+			assert(_alive[slot]);
+			object->~T();
+			_alive[slot] = false;
+			_freeSlots.push_back(slot);
+			_numObjects--;
+			if (_numObjects == 0) {
+				_resetFreeSlots();
+			}
+		}
+
+		/// Destroys all objects at once; the storage is kept for reuse.
+		void destroyAll() {
+			for (unsigned int slot = 0; slot < _alive.size(); slot++) {
+				if (_alive[slot]) {
+					_getSlotAddress(slot)->~T();
+					_alive[slot] = false;
+				}
+			}
+			_numObjects = 0;
+			_resetFreeSlots();
+		}
+
+		/// Returns the number of objects alive.
+		size_t size() const { return _numObjects; }
+		/// Returns the number of objects the pool can hold without allocating another chunk.
+		size_t capacity() const { return _alive.size(); }
+
+	protected:
+		T * _getSlotAddress(unsigned int slot) {
+			return reinterpret_cast<T*>(_chunks[slot / ChunkSize]) + (slot % ChunkSize);
+		}
+
+		unsigned int _getSlotIndex(T * object) {
+			for (unsigned int chunk = 0; chunk < _chunks.size(); chunk++) {
+				T * first = reinterpret_cast<T*>(_chunks[chunk]);
+				if ((object >= first) && (object < first + ChunkSize)) {
+					return chunk * ChunkSize + (unsigned int)(object - first);
+				}
+			}
+			assert(false && "object was not created by this pool");
+			return 0;
+		}
+
+		unsigned int _takeFreeSlot() {
+			if (_freeSlots.empty()) {
+				// ::operator new returns memory aligned for any fundamental type, and sizeof(T) is a multiple of T's alignment.
+				unsigned int firstSlot = (unsigned int)_alive.size();
+				_chunks.push_back(::operator new(sizeof(T) * ChunkSize));
+				_alive.resize(firstSlot + ChunkSize, false);
+				for (unsigned int slot = firstSlot + ChunkSize; slot > firstSlot; slot--) {
+					_freeSlots.push_back(slot - 1);
+				}
+			}
+			unsigned int slot = _freeSlots.back();
+			_freeSlots.pop_back();
+			return slot;
+		}
+
+		/// Refills the free list so that the lowest slots are taken first; only called when no object is alive.
+		void _resetFreeSlots() {
+			_freeSlots.resize(_alive.size());
+			for (unsigned int i = 0; i < _freeSlots.size(); i++) {
+				_freeSlots[i] = (unsigned int)_freeSlots.size() - 1 - i;
+			}
+		}
+
+		std::vector<void*> _chunks;
+		/// Whether each slot holds an object; slot s is in chunk s / ChunkSize.
+		std::vector<bool> _alive;
+		/// The free slots, taken from the back.
+		std::vector<unsigned int> _freeSlots;
+		size_t _numObjects;
+
+	private:
+		ObjectPool(const ObjectPool &);
+		ObjectPool & operator=(const ObjectPool &);
+	};
+
+} // namespace Util
+
+#endif
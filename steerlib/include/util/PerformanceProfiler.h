@@ -97,12 +97,14 @@ namespace Util {
 	 * With this class, PerformanceProfiler::stop() is automatically invoked when the function 
 	 * returns, no matter where the function returns from.
 	 *
+	 * A NULL profiler is allowed and ignored, for code that is only profiled on some of its call paths.
+	 *
 	 */
 	class UTIL_API AutomaticFunctionProfiler
 	{
 	public:
-		AutomaticFunctionProfiler(PerformanceProfiler * pp) { _pp = pp; _pp->start(); }
-		~AutomaticFunctionProfiler() { _pp->stop(); }
+		AutomaticFunctionProfiler(PerformanceProfiler * pp) { _pp = pp; if (_pp != NULL) _pp->start(); }
+		~AutomaticFunctionProfiler() { if (_pp != NULL) _pp->stop(); }
 	private:
 		PerformanceProfiler * _pp;
 	};
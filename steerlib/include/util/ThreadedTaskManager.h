@@ -85,6 +85,8 @@ namespace Util {
 		void wakeUpAllSleepingWorkerThreads() throw();
 		/// Waits (if needed, the current thread sleeps) until all existing tasks are complete.
 		void waitForAllTasksToComplete();
+		/// Waits (if needed, the current thread sleeps) until at most maxNumTasksLeft of the existing tasks are not complete yet.
+		void waitForTasksToComplete(unsigned int maxNumTasksLeft);
 	protected:
 		/// The main function executed by every worker thread; loops infinitely taking tasks off the queue until the ThreadedTaskManager is destroyed.
 		void _runWorkerThread() throw();
@@ -105,7 +107,7 @@ namespace Util {
 #endif
 		}
 		/// Wakes up any sleeping (non-worker) threads that are waiting for all existing tasks in the queue to finish. <em>Assumes lock is already acquired when called</em>.
-		void _broadcastAllTasksCompleted() throw();
+		void _broadcastTaskCompleted() throw();
 		/// Used by worker threads; sleeps until there are tasks on the queue; <em>Assumes lock is already acquired when called</em>.
 		void _waitUntilQueueHasTasksOrShutdown() throw();
 		/// Used in the destructor; waits for all threads to terminate; <em>Lock CANNOT be acquired when called</em>.
@@ -127,6 +129,8 @@ namespace Util {
 		bool _shuttingDown;
 		/// Flag to indicate if all existing tasks are completed.
 		bool _allTasksCompleted;
+		/// The number of tasks left at which a completing task wakes up waitForTasksToComplete(); 0 if nobody waits for only some of the tasks.
+		unsigned int _wakeUpWaitersAtNumTasksLeft;
 
 		/// @name platform-specific data
 		/// @brief The following are platform-dependent declarations.
@@ -138,7 +142,7 @@ namespace Util {
 		CRITICAL_SECTION _taskManagerLock;
 #ifdef USE_VISTA_THREADS
 		CONDITION_VARIABLE _queueHasTasksCondition;
-		CONDITION_VARIABLE _allTasksCompletedCondition;
+		CONDITION_VARIABLE _taskCompletedCondition;
 #endif
 #else
 		/// The static C wrapper for #_runWorkerThread().
@@ -146,7 +150,7 @@ namespace Util {
 		std::vector<pthread_t> _threads;
 		pthread_mutex_t _taskManagerLock;
 		pthread_cond_t _queueHasTasksCondition;
-		pthread_cond_t _allTasksCompletedCondition;
+		pthread_cond_t _taskCompletedCondition;
 #endif
 		//@}
 		
@@ -0,0 +1,394 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+/// @file BatchSimulationRunner.cpp
+/// @brief Implements the SteerLib::BatchSimulationRunner class.
+
+#include <fstream>
+#include <sstream>
+#include "simulation/BatchSimulationRunner.h"
+#include "modules/TestCasePlayerModule.h"
+#include "util/GenericException.h"
+#include "util/PerformanceProfiler.h"
+#include "util/Misc.h"
+
+using namespace std;
+using namespace SteerLib;
+using namespace Util;
+
+//
+// constructor
+//
+BatchSimulationRunner::BatchSimulationRunner(const SimulationOptions & baseOptions, unsigned int numThreads)
+{
+	if (numThreads == 0) {
+		throw GenericException("BatchSimulationRunner: the number of threads must be at least 1.");
+	}
+
+	_baseOptions = baseOptions;
+	_numThreads = numThreads;
+	_threadPool = new ThreadedTaskManager(numThreads);
+	_workers.resize(numThreads);
+	_out = NULL;
+	_numJobsFinished = 0;
+}
+
+
+//
+// destructor
+//
+BatchSimulationRunner::~BatchSimulationRunner()
+{
+	for (unsigned int i=0; i < _workers.size(); i++) {
+		_releaseWorker(_workers[i]);
+	}
+	for (unsigned int i=0; i < _testCases.size(); i++) {
+		if (_testCases[i] != NULL) delete _testCases[i];
+	}
+	delete _threadPool;
+}
+
+
+//
+// addJob()
+//
+void BatchSimulationRunner::addJob(const BatchSimulationJob & job)
+{
+	if (job.testCaseFilename == "") {
+		throw GenericException("BatchSimulationRunner::addJob(): the job does not specify a test case.");
+	}
+	if (job.aiModuleName == "") {
+		throw GenericException("BatchSimulationRunner::addJob(): the job for test case " + job.testCaseFilename + " does not specify an AI module.");
+	}
+	_jobs.push_back(job);
+}
+
+
+//
+// addJobsFromFile()
+//
+void BatchSimulationRunner::addJobsFromFile(const std::string & filename)
+{
+	ifstream jobFile(filename.c_str());
+	if (!jobFile.is_open()) {
+		throw GenericException("BatchSimulationRunner: could not open job file " + filename + ".");
+	}
+
+	string line;
+	unsigned int lineNumber = 0;
+	while (getline(jobFile, line)) {
+		lineNumber++;
+
+		stringstream lineStream(line);
+		string testCase, aiConfiguration;
+		if (!(lineStream >> testCase)) continue;  // empty line
+		if (testCase[0] == '#') continue;
+
+		if (!(lineStream >> aiConfiguration)) {
+			throw GenericException("BatchSimulationRunner: " + filename + ", line " + toString(lineNumber) + ": expected an AI module after the test case.");
+		}
+
+		BatchSimulationJob job;
+		job.testCaseFilename = testCase;
+		job.aiModuleName = aiConfiguration.substr(0, aiConfiguration.find(','));
+		job.aiModuleOptions = (aiConfiguration.find(',') == string::npos) ? "" : aiConfiguration.substr(aiConfiguration.find(',')+1);
+		job.randomSeed = 2;
+
+		string seed;
+		if (lineStream >> seed) {
+			stringstream seedStream(seed);
+			string leftOver;
+			if (!(seedStream >> job.randomSeed) || (seedStream >> leftOver)) {
+				throw GenericException("BatchSimulationRunner: " + filename + ", line " + toString(lineNumber) + ": invalid random seed \"" + seed + "\".");
+			}
+		}
+
+		string leftOver;
+		if (lineStream >> leftOver) {
+			throw GenericException("BatchSimulationRunner: " + filename + ", line " + toString(lineNumber) + ": unexpected text \"" + leftOver + "\" after the random seed.");
+		}
+
+		addJob(job);
+	}
+}
+
+
+//
+// run()
+//
+unsigned int BatchSimulationRunner::run(std::ostream & out)
+{
+	_out = &out;
+	_numJobsFinished = 0;
+
+	// release test cases from a previous run
+	for (unsigned int i=0; i < _testCases.size(); i++) {
+		if (_testCases[i] != NULL) delete _testCases[i];
+	}
+	_testCasePaths.clear();
+	_testCaseSeeds.clear();
+	_testCases.clear();
+	_testCaseErrors.clear();
+	_jobTestCaseIndex.resize(_jobs.size());
+
+	// find the distinct (test case, seed) pairs; jobs that share one also share the parsed test case.
+	map< pair<string, unsigned int>, unsigned int > testCaseIndices;
+	for (unsigned int i=0; i < _jobs.size(); i++) {
+		pair<string, unsigned int> key(_jobs[i].testCaseFilename, _jobs[i].randomSeed);
+		map< pair<string, unsigned int>, unsigned int >::iterator iter = testCaseIndices.find(key);
+		if (iter == testCaseIndices.end()) {
+			unsigned int index = (unsigned int)_testCasePaths.size();
+			testCaseIndices[key] = index;
+			_testCasePaths.push_back(key.first);
+			_testCaseSeeds.push_back(key.second);
+			_jobTestCaseIndex[i] = index;
+		}
+		else {
+			_jobTestCaseIndex[i] = iter->second;
+		}
+	}
+	_testCases.resize(_testCasePaths.size(), NULL);
+	_testCaseErrors.resize(_testCasePaths.size());
+
+	// parse all test cases in parallel
+	vector<TaskData> parseTasks(_testCasePaths.size());
+	for (unsigned int i=0; i < parseTasks.size(); i++) {
+		parseTasks[i].runner = this;
+		parseTasks[i].index = i;
+		Task task;
+		task.function = BatchSimulationRunner::_parseTestCase;
+		task.data = &parseTasks[i];
+		_threadPool->addTask(task, true);
+	}
+	_threadPool->waitForAllTasksToComplete();
+
+	// run all jobs in parallel
+	_results.clear();
+	_results.resize(_jobs.size());
+	vector<TaskData> jobTasks(_jobs.size());
+	for (unsigned int i=0; i < jobTasks.size(); i++) {
+		jobTasks[i].runner = this;
+		jobTasks[i].index = i;
+		Task task;
+		task.function = BatchSimulationRunner::_runJob;
+		task.data = &jobTasks[i];
+		_threadPool->addTask(task, true);
+	}
+	_threadPool->waitForAllTasksToComplete();
+
+	for (unsigned int i=0; i < _workers.size(); i++) {
+		_releaseWorker(_workers[i]);
+	}
+
+	unsigned int numFailures = 0;
+	for (unsigned int i=0; i < _results.size(); i++) {
+		if (!_results[i].succeeded) numFailures++;
+	}
+
+	_out = NULL;
+	return numFailures;
+}
+
+
+//
+// _parseTestCase(): runs on a worker thread; errors are kept and reported by every job that uses the test case.
+//
+void BatchSimulationRunner::_parseTestCase(unsigned int threadIndex, void * data)
+{
+	TaskData * taskData = (TaskData *)data;
+	BatchSimulationRunner * runner = taskData->runner;
+	unsigned int index = taskData->index;
+
+	TestCaseReader * testCase = NULL;
+	try {
+		string testCasePath = runner->_findTestCase(runner->_testCasePaths[index]);
+		testCase = new TestCaseReader();
+		testCase->setRandomSeed(runner->_testCaseSeeds[index]);
+		testCase->readTestCaseFromFile(testCasePath);
+		runner->_testCases[index] = testCase;
+	}
+	catch (std::exception & e) {
+		if (testCase != NULL) delete testCase;
+		runner->_testCaseErrors[index] = e.what();
+	}
+	catch (...) {
+		if (testCase != NULL) delete testCase;
+		runner->_testCaseErrors[index] = "Unknown exception while reading test case " + runner->_testCasePaths[index] + ".";
+	}
+}
+
+
+//
+// _runJob(): runs on a worker thread, using that thread's engine.
+//
+void BatchSimulationRunner::_runJob(unsigned int threadIndex, void * data)
+{
+	TaskData * taskData = (TaskData *)data;
+	BatchSimulationRunner * runner = taskData->runner;
+	unsigned int jobIndex = taskData->index;
+
+	const BatchSimulationJob & job = runner->_jobs[jobIndex];
+	BatchSimulationResult & result = runner->_results[jobIndex];
+	Worker & worker = runner->_workers[threadIndex];
+
+	result.jobIndex = jobIndex;
+	result.threadIndex = threadIndex;
+	result.succeeded = false;
+	result.numFramesSimulated = 0;
+	result.simulatedTime = 0.0f;
+	result.realTime = 0.0f;
+	result.numAgents = 0;
+	result.numUnfinishedAgents = 0;
+
+	PerformanceProfiler timer;
+	timer.reset();
+	timer.start();
+
+	try {
+		unsigned int testCaseIndex = runner->_jobTestCaseIndex[jobIndex];
+		if (runner->_testCases[testCaseIndex] == NULL) {
+			throw GenericException(runner->_testCaseErrors[testCaseIndex]);
+		}
+
+		runner->_prepareWorker(worker, job);
+		SimulationEngine * engine = worker.engine;
+
+		TestCasePlayerModule * testCasePlayer = dynamic_cast<TestCasePlayerModule*>(engine->getModule("testCasePlayer"));
+		if (testCasePlayer == NULL) {
+			throw GenericException("BatchSimulationRunner: the testCasePlayer module was not loaded.");
+		}
+		testCasePlayer->setTestCase(runner->_testCases[testCaseIndex]);
+
+		engine->initializeSimulation();
+		engine->preprocessSimulation();
+		// batch workers never draw, so the whole simulation runs in one headless update.
+		engine->updateHeadless(0);
+		engine->postprocessSimulation();
+
+		result.numFramesSimulated = engine->getClock().getCurrentFrameNumber();
+		result.simulatedTime = engine->getClock().getCurrentSimulationTime();
+		const vector<AgentInterface*> & agents = engine->getAgents();
+		result.numAgents = agents.size();
+		for (unsigned int i=0; i < agents.size(); i++) {
+			if (agents[i]->enabled()) result.numUnfinishedAgents++;
+		}
+
+		engine->cleanupSimulation();
+		testCasePlayer->setTestCase(NULL);
+		result.succeeded = true;
+	}
+	catch (std::exception & e) {
+		result.errorMessage = e.what();
+	}
+	catch (...) {
+		result.errorMessage = "Unknown exception.";
+	}
+
+	if (!result.succeeded) {
+		// the engine may be in any state after an exception, so the next job on this thread starts with a new one.
+		runner->_releaseWorker(worker);
+	}
+
+	timer.stop();
+	result.realTime = timer.getTotalTime();
+
+	runner->_reportResult(result);
+}
+
+
+//
+// _findTestCase()
+//
+std::string BatchSimulationRunner::_findTestCase(const std::string & testCaseFilename)
+{
+	const string & searchPath = _baseOptions.engineOptions.testCaseSearchPath;
+
+	if (fileCanBeOpened(testCaseFilename)) {
+		return testCaseFilename;
+	}
+	else if (fileCanBeOpened(searchPath + testCaseFilename)) {
+		return searchPath + testCaseFilename;
+	}
+	else if (fileCanBeOpened(testCaseFilename + ".xml")) {
+		return testCaseFilename + ".xml";
+	}
+	else if (fileCanBeOpened(searchPath + testCaseFilename + ".xml")) {
+		return searchPath + testCaseFilename + ".xml";
+	}
+
+	throw GenericException("Could not find test case " + testCaseFilename + ".");
+}
+
+
+//
+// _prepareWorker()
+//
+void BatchSimulationRunner::_prepareWorker(Worker & worker, const BatchSimulationJob & job)
+{
+	string aiConfiguration = job.aiModuleName + "," + job.aiModuleOptions;
+	if ((worker.engine != NULL) && (worker.aiConfiguration == aiConfiguration)) {
+		return;
+	}
+
+	_releaseWorker(worker);
+
+	worker.options = _baseOptions;
+	worker.options.engineOptions.numThreads = 1;
+	worker.options.engineOptions.startupModules.insert("testCasePlayer");
+	worker.options.engineOptions.startupModules.insert(job.aiModuleName);
+	worker.options.engineOptions.startupModules.erase("recFilePlayer");
+	worker.options.moduleOptionsDatabase["testCasePlayer"]["testcase"] = job.testCaseFilename;
+	worker.options.moduleOptionsDatabase["testCasePlayer"]["ai"] = job.aiModuleName;
+	worker.options.mergeModuleOptions(job.aiModuleName, job.aiModuleOptions);
+
+	// the engine keeps a pointer to worker.options, which stays valid because _workers is never resized during run().
+	worker.engine = new SimulationEngine();
+	worker.aiConfiguration = aiConfiguration;
+	worker.engine->init(&worker.options, &worker);
+}
+
+
+//
+// _releaseWorker(): must not throw, because it is used while handling errors.
+//
+void BatchSimulationRunner::_releaseWorker(Worker & worker)
+{
+	if (worker.engine == NULL) return;
+
+	try {
+		worker.engine->finish();
+	}
+	catch (...) {
+		// the engine is deleted regardless.
+	}
+
+	delete worker.engine;
+	worker.engine = NULL;
+	worker.aiConfiguration = "";
+}
+
+
+//
+// _reportResult()
+//
+void BatchSimulationRunner::_reportResult(const BatchSimulationResult & result)
+{
+	const BatchSimulationJob & job = _jobs[result.jobIndex];
+
+	_outputLock.lock();
+	_numJobsFinished++;
+	(*_out) << "[" << _numJobsFinished << "/" << _jobs.size() << "] job " << result.jobIndex << " (thread " << result.threadIndex << "): "
+		<< job.testCaseFilename << " " << job.aiModuleName << " seed=" << job.randomSeed << " - ";
+	if (result.succeeded) {
+		(*_out) << result.numFramesSimulated << " frames, " << result.simulatedTime << " s simulated, "
+			<< result.numAgents << " agents, " << result.numUnfinishedAgents << " unfinished, "
+			<< result.realTime << " s real time\n";
+	}
+	else {
+		(*_out) << "FAILED: " << result.errorMessage << "\n";
+	}
+	_out->flush();
+	_outputLock.unlock();
+}
@@ -89,6 +89,15 @@ void Clock::advanceSimulationAndUpdateRealTime()
 
 }
 
+void Clock::advanceSimulation()
+{
+	// headless runs do not follow real-time at all, so every clock mode steps at the fixed frame rate,
+	// and the real-time counters and fps measurement are left alone.
+	_simulationDt = _fixedTicksPerFrame;
+	_totalSimulationTime += _simulationDt;
+	_simulationFrameNumber++;
+}
+
 //For use with the Authoring toolkit to go back and forth in time.
 /**
  * Only work for fix-fast timer
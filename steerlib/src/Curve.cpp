@@ -14,9 +14,14 @@
 
 using namespace Util;
 
+namespace {
+	bool controlPointTimeLess(const CurvePoint& a, const CurvePoint& b) { return a.time < b.time; }
+}
+
 Curve::Curve(const CurvePoint& startPoint, int curveType) : type(curveType)
 {
 	controlPoints.push_back(startPoint);
+	computeSegments();
 }
 
 Curve::Curve(const std::vector<CurvePoint>& inputPoints, int curveType) : type(curveType)
@@ -65,16 +70,9 @@ void Curve::drawCurve(Color curveColor, float curveThickness, int window)
 // Sort controlPoints vector in ascending order: min-first
 void Curve::sortControlPoints()
 {
-	//================DELETE THIS PART AND THEN START CODING===================
-	static bool flag = false;
-	if (!flag)
-	{
-		//std::cerr << "ERROR>>>>Member function sortControlPoints is not implemented!" << std::endl;
-		flag = true;
-	}
-	//=========================================================================
-
-	return;
+	// stable, so that of two control points with the same time, the one added last is reached
+	std::stable_sort(controlPoints.begin(), controlPoints.end(), controlPointTimeLess);
+	computeSegments();
 }
 
 // Calculate the position on curve corresponding to the given time, outputPoint is the resulting position
@@ -84,103 +82,110 @@ bool Curve::calculatePoint(Point& outputPoint, float time)
 	if (!checkRobust())
 		return false;
 
-	// Define temporary parameters for calculation
-	unsigned int nextPoint;
-	float normalTime, intervalTime;
-
 	// Find the current interval in time, supposing that controlPoints is sorted (sorting is done whenever control points are added)
+	unsigned int nextPoint;
 	if (!findTimeInterval(nextPoint, time))
 		return false;
 
 	// Calculate position at t = time on curve
-	if (type == hermiteCurve)
-	{
-		outputPoint = useHermiteCurve(nextPoint, time);
-	}
-	else if (type == catmullCurve)
-	{
-		outputPoint = useCatmullCurve(nextPoint, time);
-	}
-
-	// Return
+	outputPoint = evaluateSegment(nextPoint, time);
 	return true;
 }
 
 // Check Roboustness
 bool Curve::checkRobust()
 {
-	//================DELETE THIS PART AND THEN START CODING===================
-	static bool flag = false;
-	if (!flag)
-	{
-		std::cerr << "ERROR>>>>Member function checkRobust is not implemented!" << std::endl;
-		flag = true;
-	}
-	//=========================================================================
-
-
-	return true;
+	return (controlPoints.size() >= 2);
 }
 
 // Find the current time interval (i.e. index of the next control point to follow according to current time)
 bool Curve::findTimeInterval(unsigned int& nextPoint, float time)
 {
-	//================DELETE THIS PART AND THEN START CODING===================
-	static bool flag = false;
-	if (!flag)
-	{
-		std::cerr << "ERROR>>>>Member function findTimeInterval is not implemented!" << std::endl;
-		flag = true;
-	}
-	//=========================================================================
-
+	// the curve ends at its last control point
+	if (time > times.back())
+		return false;
 
+	// the first control point later than time; before the first control point, the curve stays at it
+	nextPoint = (unsigned int)(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+	if (nextPoint == 0)
+		nextPoint = 1;
+	else if (nextPoint == times.size())
+		nextPoint = (unsigned int)times.size() - 1;
 	return true;
 }
 
-// Implement Hermite curve
-Point Curve::useHermiteCurve(const unsigned int nextPoint, const float time)
+// Compute times and segments from controlPoints, for the current type of curve
+void Curve::computeSegments()
 {
-	Point newPosition;
-	float normalTime, intervalTime;
+	times.resize(controlPoints.size());
+	for (unsigned int i = 0; i < controlPoints.size(); i++)
+		times[i] = controlPoints[i].time;
 
-	//================DELETE THIS PART AND THEN START CODING===================
-	static bool flag = false;
-	if (!flag)
+	segments.resize(controlPoints.empty() ? 0 : controlPoints.size() - 1);
+	for (unsigned int nextPoint = 1; nextPoint < controlPoints.size(); nextPoint++)
 	{
-		std::cerr << "ERROR>>>>Member function useHermiteCurve is not implemented!" << std::endl;
-		flag = true;
+		if (type == catmullCurve)
+		{
+			// Catmull-Rom: the tangent at a control point is the slope between its neighbors; one-sided at the end points
+			Vector tangents[2];
+			for (unsigned int k = 0; k < 2; k++)
+			{
+				unsigned int point = nextPoint - 1 + k;
+				unsigned int before = (point == 0) ? 0 : point - 1;
+				unsigned int after = (point + 1 == controlPoints.size()) ? point : point + 1;
+				float intervalTime = times[after] - times[before];
+				tangents[k] = (intervalTime > 0.f) ? (controlPoints[after].position - controlPoints[before].position) / intervalTime : Vector(0.f, 0.f, 0.f);
+			}
+			computeHermiteSegment(nextPoint, tangents[0], tangents[1]);
+		}
+		else
+		{
+			computeHermiteSegment(nextPoint, controlPoints[nextPoint - 1].tangent, controlPoints[nextPoint].tangent);
+		}
 	}
-	//=========================================================================
-
-
-	// Calculate time interval, and normal time required for later curve calculations
-
-	// Calculate position at t = time on Hermite curve
-
-	// Return result
-	return newPosition;
 }
 
-// Implement Catmull-Rom curve
-Point Curve::useCatmullCurve(const unsigned int nextPoint, const float time)
+// Compute the polynomial of one segment, given the tangents (per unit of time) at both of its control points
+void Curve::computeHermiteSegment(const unsigned int nextPoint, const Vector& startTangent, const Vector& endTangent)
 {
-	Point newPosition;
-
-	//================DELETE THIS PART AND THEN START CODING===================
-	static bool flag = false;
-	if (!flag)
+	const Point& startPosition = controlPoints[nextPoint - 1].position;
+	const Point& endPosition = controlPoints[nextPoint].position;
+	float intervalTime = times[nextPoint] - times[nextPoint - 1];
+
+	// the Hermite basis, expanded in powers of the time u since the start of the segment
+	Vector c0 = startPosition - Point(0.f, 0.f, 0.f);
+	Vector c1 = startTangent;
+	Vector c2(0.f, 0.f, 0.f);
+	Vector c3(0.f, 0.f, 0.f);
+	if (intervalTime > 0.f)
 	{
-		std::cerr << "ERROR>>>>Member function useCatmullCurve is not implemented!" << std::endl;
-		flag = true;
+		Vector delta = endPosition - startPosition;
+		c2 = 3.f * delta / (intervalTime * intervalTime) - (2.f * startTangent + endTangent) / intervalTime;
+		c3 = -2.f * delta / (intervalTime * intervalTime * intervalTime) + (startTangent + endTangent) / (intervalTime * intervalTime);
+	}
+	else
+	{
+		// two control points at the same time: the later one is reached
+		c0 = endPosition - Point(0.f, 0.f, 0.f);
+		c1 = Vector(0.f, 0.f, 0.f);
 	}
-	//=========================================================================
-
 
-	// Calculate time interval, and normal time required for later curve calculations
+	CurveSegment& segment = segments[nextPoint - 1];
+	segment.coefficients[0] = c0;
+	segment.coefficients[1] = c1;
+	segment.coefficients[2] = c2;
+	segment.coefficients[3] = c3;
+}
 
-	// Calculate position at t = time on Catmull-Rom curve
-	
-	// Return result
-	return newPosition;
+// Calculate the position at the given time on the segment that ends at nextPoint
+Point Curve::evaluateSegment(const unsigned int nextPoint, const float time)
+{
+	const CurveSegment& segment = segments[nextPoint - 1];
+	float u = time - times[nextPoint - 1];
+	if (u < 0.f)
+		u = 0.f;
+
+	// Horner's rule
+	Vector result = segment.coefficients[0] + u * (segment.coefficients[1] + u * (segment.coefficients[2] + u * segment.coefficients[3]));
+	return Point(result.x, result.y, result.z);
 }
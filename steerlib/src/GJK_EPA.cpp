@@ -7,6 +7,7 @@
 
 #include "obstacles/GJK_EPA.h"
 #include "obstacles/triangulate.h"
+#include <algorithm>
 
 
 SteerLib::GJK_EPA::GJK_EPA()
@@ -320,3 +321,266 @@ bool SteerLib::GJK_EPA::triangulatePolygon(const std::vector<Util::Vector>& shap
 	}
 	return false;
 }
+
+
+//
+// The allocation-free variant: the same algorithms as above, on arrays of vertices and fixed-size simplex and polytope buffers.
+//
+
+void SteerLib::ConvexDecomposition::_clear()
+{
+	_vertices.clear();
+	_pieceStart.assign(1, 0);
+	_pieceBounds.clear();
+	_bounds = Util::AxisAlignedBox();
+}
+
+void SteerLib::ConvexDecomposition::_addPiece(const Util::Vector * vertices, unsigned int numVertices)
+{
+	Util::AxisAlignedBox pieceBounds;
+	for (unsigned int i = 0; i < numVertices; i++) {
+		_vertices.push_back(vertices[i]);
+		pieceBounds.xmin = std::min(pieceBounds.xmin, vertices[i].x);
+		pieceBounds.xmax = std::max(pieceBounds.xmax, vertices[i].x);
+		pieceBounds.zmin = std::min(pieceBounds.zmin, vertices[i].z);
+		pieceBounds.zmax = std::max(pieceBounds.zmax, vertices[i].z);
+	}
+	_pieceStart.push_back((unsigned int)_vertices.size());
+	_pieceBounds.push_back(pieceBounds);
+
+	_bounds.xmin = std::min(_bounds.xmin, pieceBounds.xmin);
+	_bounds.xmax = std::max(_bounds.xmax, pieceBounds.xmax);
+	_bounds.zmin = std::min(_bounds.zmin, pieceBounds.zmin);
+	_bounds.zmax = std::max(_bounds.zmax, pieceBounds.zmax);
+}
+
+void SteerLib::GJK_EPA::decompose(const std::vector<Util::Vector>& shape, ConvexDecomposition& decomposition)
+{
+	decomposition._clear();
+	if (shape.empty()) {
+		return;
+	}
+	if (isConvex(shape)) {
+		decomposition._addPiece(&shape[0], (unsigned int)shape.size());
+		return;
+	}
+	std::vector<Util::Vector> triangles;
+	triangulatePolygon(shape, triangles);
+	for (size_t i = 0; i + 3 <= triangles.size(); i += 3) {
+		decomposition._addPiece(&triangles[i], 3);
+	}
+}
+
+static inline bool boundsOverlap(const Util::AxisAlignedBox & a, const Util::AxisAlignedBox & b)
+{
+	return (a.xmin <= b.xmax) && (b.xmin <= a.xmax) && (a.zmin <= b.zmax) && (b.zmin <= a.zmax);
+}
+
+bool SteerLib::GJK_EPA::intersect(float& return_penetration_depth, Util::Vector& return_penetration_vector, const ConvexDecomposition& _shapeA, const ConvexDecomposition& _shapeB)
+{
+	if ((_shapeA.getNumPieces() == 0) || (_shapeB.getNumPieces() == 0) || !boundsOverlap(_shapeA.getBounds(), _shapeB.getBounds())) {
+		return false;
+	}
+	if ((_shapeA.getNumPieces() == 1) && (_shapeB.getNumPieces() == 1)) {
+		return intersectConvex(return_penetration_depth, return_penetration_vector, _shapeA.getPieceVertices(0), _shapeA.getPieceSize(0), _shapeB.getPieceVertices(0), _shapeB.getPieceSize(0));
+	}
+
+	// the deepest penetration of any two pieces, as in intersectConcave().
+	Util::Vector maxPenetrationVec;
+	float maxPenetrationDepth = 0;
+	for (unsigned int pieceA = 0; pieceA < _shapeA.getNumPieces(); pieceA++) {
+		for (unsigned int pieceB = 0; pieceB < _shapeB.getNumPieces(); pieceB++) {
+			if (!boundsOverlap(_shapeA.getPieceBounds(pieceA), _shapeB.getPieceBounds(pieceB))) {
+				continue;
+			}
+			float penetration_depth;
+			Util::Vector penetration_vector;
+			if (intersectConvex(penetration_depth, penetration_vector, _shapeA.getPieceVertices(pieceA), _shapeA.getPieceSize(pieceA), _shapeB.getPieceVertices(pieceB), _shapeB.getPieceSize(pieceB))
+				&& penetration_depth > maxPenetrationDepth) {
+				maxPenetrationDepth = penetration_depth;
+				maxPenetrationVec = penetration_vector;
+			}
+		}
+	}
+	if (maxPenetrationDepth > 0) {
+		return_penetration_depth = maxPenetrationDepth;
+		return_penetration_vector = maxPenetrationVec;
+		return true;
+	}
+	return false;
+}
+
+bool SteerLib::GJK_EPA::intersectConvex(float& return_penetration_depth, Util::Vector& return_penetration_vector, const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB)
+{
+	if ((sizeA == 0) || (sizeB == 0)) {
+		return false;
+	}
+	// GJK leaves its simplex at the start of the polytope, which EPA then expands.
+	Util::Vector polytope[MAX_POLYTOPE_SIZE];
+	unsigned int polytopeSize = 0;
+	bool retval = gjk(shapeA, sizeA, shapeB, sizeB, polytope, polytopeSize);
+
+	if (retval) {
+		// There is a collision
+		epa(shapeA, sizeA, shapeB, sizeB, polytope, polytopeSize, return_penetration_depth, return_penetration_vector);
+	}
+
+	return retval;
+}
+
+bool SteerLib::GJK_EPA::gjk(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, Util::Vector * simplex, unsigned int& simplexSize)
+{
+	Util::Vector centerA = getShapeCenter(shapeA, sizeA);
+	Util::Vector centerB = getShapeCenter(shapeB, sizeB);
+	Util::Vector direction = centerB - centerA;
+	simplexSize = 0;
+	simplex[simplexSize++] = getSimplexPointUsingDirection(shapeA, sizeA, shapeB, sizeB, direction);
+	direction = -direction;
+	// the simplex never holds more than 3 points: simplexContainsOrigin() drops one whenever it has 3.
+	for (unsigned int iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+		simplex[simplexSize++] = getSimplexPointUsingDirection(shapeA, sizeA, shapeB, sizeB, direction);
+		if (dot(simplex[simplexSize-1], direction) <= 0) return false;
+		else if (simplexContainsOrigin(simplex, simplexSize, direction)) {
+			if (simplexSize < 3) {
+				// The simplex will have 2 points in this case (2 points have already been added)
+				simplex[simplexSize++] = getSimplexPointUsingDirection(shapeA, sizeA, shapeB, sizeB, direction);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SteerLib::GJK_EPA::simplexContainsOrigin(Util::Vector * simplex, unsigned int& simplexSize, Util::Vector& direction)
+{
+	Util::Vector ptA = simplex[simplexSize-1];
+	Util::Vector aToOrigin = -ptA;
+	if (simplexSize == 3) {
+		Util::Vector ptB = simplex[1];
+		Util::Vector ptC = simplex[0];
+		Util::Vector aToB = ptB - ptA;
+		Util::Vector aToC = ptC - ptA;
+		Util::Vector abPerp = aToB * dot(aToB, aToC) - aToC * (dot(aToB, aToB));
+		Util::Vector acPerp = aToC * dot(aToC, aToB) - aToB * (dot(aToC, aToC));
+		if (dot(abPerp, aToOrigin) > 0) {
+			// drop C
+			simplex[0] = simplex[1];
+			simplex[1] = simplex[2];
+			simplexSize = 2;
+			direction = abPerp;
+		}
+		else if (dot(acPerp, aToOrigin) > 0) {
+			// drop B
+			simplex[1] = simplex[2];
+			simplexSize = 2;
+			direction = acPerp;
+		}
+		else return true;
+	}
+	else {
+		Util::Vector ptB = simplex[0];
+		Util::Vector aToB = ptB - ptA;
+		Util::Vector abPerp = aToOrigin * dot(aToB, aToB) - aToB * dot(aToB, aToOrigin);
+		direction = abPerp;
+		if (dot(abPerp, aToOrigin) == 0) {
+			float aToBDotaToOrigin = dot(aToB, aToOrigin);
+			if (aToBDotaToOrigin >= 0 && aToBDotaToOrigin < dot(aToB, aToB)) return true;
+		}
+	}
+	return false;
+}
+
+Util::Vector SteerLib::GJK_EPA::getSimplexPointUsingDirection(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, const Util::Vector& direction)
+{
+	return getFurthestPointInDirection(shapeA, sizeA, direction) - getFurthestPointInDirection(shapeB, sizeB, -direction);
+}
+
+Util::Vector SteerLib::GJK_EPA::getShapeCenter(const Util::Vector * shape, unsigned int size)
+{
+	Util::Vector retVal(0, 0, 0);
+	for (unsigned int i = 0; i < size; i++) {
+		retVal[0] += shape[i][0];
+		retVal[2] += shape[i][2];
+	}
+	retVal[0] = retVal[0] / (float)size;
+	retVal[2] = retVal[2] / (float)size;
+	return retVal;
+}
+
+Util::Vector SteerLib::GJK_EPA::getFurthestPointInDirection(const Util::Vector * shape, unsigned int size, const Util::Vector& direction)
+{
+	float farthestDistance = dot(shape[0], direction);
+	unsigned int farthestIndex = 0;
+	for (unsigned int i = 1; i < size; i++) {
+		float dotProd = dot(shape[i], direction);
+		if (dotProd > farthestDistance) {
+			farthestDistance = dotProd;
+			farthestIndex = i;
+		}
+	}
+	return shape[farthestIndex];
+}
+
+bool SteerLib::GJK_EPA::originLiesOnSimplex(const Util::Vector * polytope, unsigned int polytopeSize, float& return_penetration_depth, Util::Vector& return_penetration_vector)
+{
+	for (unsigned int i = 0; i < polytopeSize; i++) {
+		unsigned int j = i + 1 == polytopeSize ? 0 : i + 1;
+		if (edgeContainsOrigin(polytope[i], polytope[j])) {
+			containedOriginPenetrationFromEdge(polytope[i], polytope[j], return_penetration_depth, return_penetration_vector);
+			return true;
+		}
+	}
+	return false;
+}
+
+void SteerLib::GJK_EPA::epa(const Util::Vector * shapeA, unsigned int sizeA, const Util::Vector * shapeB, unsigned int sizeB, Util::Vector * polytope, unsigned int polytopeSize, float& return_penetration_depth, Util::Vector& return_penetration_vector)
+{
+	float TOLERANCE = 0.00001;
+
+	for (unsigned int iteration = 0; ; iteration++)
+	{
+		if (originLiesOnSimplex(polytope, polytopeSize, return_penetration_depth, return_penetration_vector)) {
+			return;
+		}
+		float distance;
+		Util::Vector normal;
+		int index;
+		findClosestEdge(polytope, polytopeSize, distance, normal, index);
+
+		Util::Vector supportPoint = getSimplexPointUsingDirection(shapeA, sizeA, shapeB, sizeB, normal);
+
+		// when the polytope is full or the iterations run out, the closest edge so far is the answer.
+		double d = supportPoint * normal;
+		if ((d - distance < TOLERANCE) || (polytopeSize == MAX_POLYTOPE_SIZE) || (iteration + 1 >= MAX_ITERATIONS)) {
+			return_penetration_vector = normal;
+			return_penetration_depth = d;
+			return;
+		}
+		for (unsigned int i = polytopeSize; i > (unsigned int)index; i--) {
+			polytope[i] = polytope[i-1];
+		}
+		polytope[index] = supportPoint;
+		polytopeSize++;
+	}
+}
+
+void SteerLib::GJK_EPA::findClosestEdge(const Util::Vector * polytope, unsigned int polytopeSize, float& distance, Util::Vector& normal, int& index)
+{
+	distance = FLT_MAX;
+	index = 0;
+	for (unsigned int i = 0; i < polytopeSize; i++) {
+		unsigned int j = i + 1 == polytopeSize ? 0 : i + 1;
+		const Util::Vector & a = polytope[i];
+		Util::Vector e = polytope[j] - a;
+		Util::Vector n = tripleProduct(e, a, e);
+
+		Util::Vector n_norm = n / n.norm();
+
+		double d = n_norm * a;
+		if (d < distance) {
+			distance = d;
+			normal = n_norm;
+			index = j;
+		}
+	}
+}
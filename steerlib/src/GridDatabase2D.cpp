@@ -49,6 +49,7 @@ GridDatabase2D::GridDatabase2D(float xmin, float xmax, float zmin, float zmax, u
 
 	_allocateDatabase();
 	_planningDomain = new GridDatabasePlanningDomain(this);
+	_randomNumberGenerator = new MTRand(2);
 }
 
 
@@ -72,6 +73,7 @@ GridDatabase2D::GridDatabase2D(const Point & origin2D, float xExtent, float zExt
 
 	_allocateDatabase();
 	_planningDomain = new GridDatabasePlanningDomain(this);
+	_randomNumberGenerator = new MTRand(2);
 }
 
 
@@ -83,6 +85,7 @@ GridDatabase2D::~GridDatabase2D()
 	delete [] _basePtr;
 	delete [] _cells;
 	delete _planningDomain;
+	delete _randomNumberGenerator;
 }
 
 
@@ -127,7 +130,7 @@ float _roundClose(float f)
 //
 // _clampSpatialBoundsToIndexRange - converts a bounding box to a valid range of indices in the database.
 //                                  if the bounding box is entirely outside of the space covered by the
-//                                  database, returns false.
+//                                  database, or only touches its boundary, returns false.
 //
 // because it is inline, if this function ever needs to become public, place it in the .h file instead.
 //
@@ -136,7 +139,7 @@ inline bool GridDatabase2DPrivate::_clampSpatialBoundsToIndexRange(float xmin, f
 	// clamp and convert xmin to xMinIndex
 	if (xmin < _xOrigin)
 		xMinIndex = 0;
-	else if (xmin > _xOrigin + _xGridSize)
+	else if (xmin >= _xOrigin + _xGridSize)
 		return false;
 	else
 		xMinIndex = (unsigned int)floor(_roundClose(((xmin - _xOrigin) * _xInvGridSize) * _xNumCells));
@@ -144,7 +147,7 @@ inline bool GridDatabase2DPrivate::_clampSpatialBoundsToIndexRange(float xmin, f
 	// clamp and convert zmin to zMinIndex
 	if (zmin < _zOrigin)
 		zMinIndex = 0;
-	else if (zmin > _zOrigin + _zGridSize)
+	else if (zmin >= _zOrigin + _zGridSize)
 		return false;
 	else
 		zMinIndex = (unsigned int)floor(_roundClose(((zmin - _zOrigin) * _zInvGridSize) * _zNumCells));
@@ -152,7 +155,7 @@ inline bool GridDatabase2DPrivate::_clampSpatialBoundsToIndexRange(float xmin, f
 	// clamp and convert xmax to xMaxIndex
 	if (xmax >= _xOrigin + _xGridSize)
 		xMaxIndex = _xNumCells-1; // subtract one because xMaxIndex is included in the spatial bounds.
-	else if (xmax < _xOrigin)
+	else if (xmax <= _xOrigin)
 		return false;
 	else
 		xMaxIndex = (unsigned int)ceil(_roundClose(((xmax - _xOrigin) * _xInvGridSize) * _xNumCells))-1;
@@ -160,7 +163,7 @@ inline bool GridDatabase2DPrivate::_clampSpatialBoundsToIndexRange(float xmin, f
 	// clamp and convert zmax to zMaxIndex
 	if (zmax >= _zOrigin + _zGridSize)
 		zMaxIndex = _zNumCells-1;  // subtract one because zMaxIndex is included in the spatial bounds.
-	else if (zmax < _zOrigin)
+	else if (zmax <= _zOrigin)
 		return false;
 	else
 		zMaxIndex = (unsigned int)ceil(_roundClose(((zmax  - _zOrigin) * _zInvGridSize) * _zNumCells))-1;
@@ -192,7 +195,7 @@ void GridDatabase2D::addObject( SpatialDatabaseItemPtr item, const AxisAlignedBo
 	for (unsigned int i=xMinIndex; i<=xMaxIndex; i++) {
 		cellIndex = getCellIndexFromGridCoords(i,zMinIndex);
 		for (unsigned int j=zMinIndex; j<=zMaxIndex; j++) {
-			_cells[cellIndex].add(item,_maxItemsPerCell, item->getTraversalCost());
+			_cells[cellIndex].add(item, item->getTraversalCost());
 			// std::cout << "CellIndex is: " << cellIndex << std::endl;
 			cellIndex++;
 		}
@@ -224,7 +227,7 @@ void GridDatabase2D::removeObject( SpatialDatabaseItemPtr item, const AxisAligne
 	for (unsigned int i=xMinIndex; i<=xMaxIndex; i++) {
 		cellIndex = getCellIndexFromGridCoords(i,zMinIndex);
 		for (unsigned int j=zMinIndex; j<=zMaxIndex; j++) {
-			_cells[cellIndex].remove(item, _maxItemsPerCell, item->getTraversalCost());
+			_cells[cellIndex].remove(item, item->getTraversalCost());
 			cellIndex++;
 		}
 	}
@@ -262,11 +265,11 @@ void GridDatabase2D::getItemsInRange(set<SpatialDatabaseItemPtr> & neighborList,
 	for (unsigned int i=xMinIndex; i<=xMaxIndex; i++) {
 		cellIndex = (i * _zNumCells) + zMinIndex;
 		
-		GridCell gridCell = _cells[cellIndex];
+		GridCell & gridCell = _cells[cellIndex];
 		SpatialDatabaseItemPtr *itemPtrArr = gridCell._items;
 
 		for (unsigned int j=zMinIndex; j<=zMaxIndex; j++) {
-			for (unsigned int k=0; k < _maxItemsPerCell; k++) {
+			for (unsigned int k=0; k < gridCell._capacity; k++) {
 				SpatialDatabaseItemPtr itemPtr = itemPtrArr[k];
 
 				if ((itemPtr!=NULL) && (itemPtr!=exclude)) {
@@ -289,6 +292,37 @@ void GridDatabase2D::getItemsInRange(set<SpatialDatabaseItemPtr> & neighborList,
 	getItemsInRange(neighborList,xMinIndex,xMaxIndex,zMinIndex,zMaxIndex,exclude);
 }
 
+//
+// hasAgentInRange()
+//
+bool GridDatabase2D::hasAgentInRange(const Point & position, float radius, SpatialDatabaseItemPtr exclude)
+{
+	unsigned int xMinIndex=0, xMaxIndex=0, zMinIndex=0, zMaxIndex=0;
+	_clampSpatialBoundsToIndexRange(position.x-radius, position.x+radius, position.z-radius, position.z+radius, xMinIndex, xMaxIndex, zMinIndex, zMaxIndex);
+
+	float radiusSquared = radius*radius;
+	for (unsigned int i=xMinIndex; i<=xMaxIndex; i++) {
+		int cellIndex = getCellIndexFromGridCoords(i,zMinIndex);
+		for (unsigned int j=zMinIndex; j<=zMaxIndex; j++) {
+			if (_cells[cellIndex]._numItems != 0) {
+				for (unsigned int k=0; k < _cells[cellIndex]._capacity; k++) {
+					SpatialDatabaseItemPtr item = _cells[cellIndex]._items[k];
+					if ((item==NULL) || (item==exclude) || (!item->isAgent()))
+						continue;
+
+					// AgentInterface derives only from SpatialDatabaseItem, so isAgent() makes the static_cast safe.
+					Vector offset = static_cast<AgentInterface*>(item)->position() - position;
+					if (offset.lengthSquared() <= radiusSquared)
+						return true;
+				}
+			}
+			cellIndex++;
+		}
+	}
+
+	return false;
+}
+
 //
 // getItemsInVisualField()
 //
@@ -302,7 +336,7 @@ void GridDatabase2D::getItemsInVisualField(set<SpatialDatabaseItemPtr> & neighbo
 	for (unsigned int i=xMinIndex; i<=xMaxIndex; i++) {
 		cellIndex = getCellIndexFromGridCoords(i,zMinIndex);
 		for (unsigned int j=zMinIndex; j<=zMaxIndex; j++) {
-			for (unsigned int k=0; k < _maxItemsPerCell; k++) {
+			for (unsigned int k=0; k < _cells[cellIndex]._capacity; k++) {
 				SpatialDatabaseItemPtr possiblyVisibleObject = _cells[cellIndex]._items[k];
 
 
@@ -495,7 +529,7 @@ bool GridDatabase2D::trace(const Ray & r, float & t, SpatialDatabaseItemPtr &hit
 		hitObject = NULL;
 		float mostRecent_maxt = min(maxt,min(txfar,tzfar)); // this way no intersection will be valid unless it was within this grid cell
 
-		for (unsigned int i=0; i<_maxItemsPerCell; i++)
+		for (unsigned int i=0; i<_cells[currentBin]._capacity; i++)
 		{
 
 			if ((_cells[currentBin]._items[i] != NULL) && (_cells[currentBin]._items[i] != exclude)) // && (_cells[currentBin]._numItems > i))
@@ -630,7 +664,7 @@ bool GridDatabase2D::hasLineOfSight(const Ray & r, SpatialDatabaseItemPtr exclud
 		validIntersectionFound = false;
 		float mostRecent_maxt = min(maxt,min(txfar,tzfar)); // this way no intersection will be valid unless it was within this grid cell
 
-		for (unsigned int i=0; i<_maxItemsPerCell; i++) {
+		for (unsigned int i=0; i<_cells[currentBin]._capacity; i++) {
 			if ((_cells[currentBin]._items[i] != NULL) && (_cells[currentBin]._items[i] != exclude1) 
 				&& (_cells[currentBin]._items[i] != exclude2) && (_cells[currentBin]._items[i]->blocksLineOfSight())) {
 
@@ -711,8 +745,7 @@ Point GridDatabase2D::randomPositionWithoutCollisions(float radius, bool exclude
 
 Point GridDatabase2D::randomPositionInRegionWithoutCollisions(const AxisAlignedBox & region, float radius, bool excludeAgents)
 {
-	static MTRand _randomNumberGenerator(2);
-	return randomPositionInRegionWithoutCollisions(region, radius, excludeAgents, _randomNumberGenerator);
+	return randomPositionInRegionWithoutCollisions(region, radius, excludeAgents, *_randomNumberGenerator);
 }
 
 Point GridDatabase2D::randomPositionInRegionWithoutCollisions(const AxisAlignedBox & region, float radius, bool excludeAgents,  MTRand & randomNumberGenerator)
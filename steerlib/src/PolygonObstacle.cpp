@@ -11,6 +11,7 @@
 
 #include "obstacles/PolygonObstacle.h"
 #include "util/DrawLib.h"
+#include <algorithm>
 
 PolygonObstacle::PolygonObstacle(std::vector<Util::Point> points, float traversalCost)
 {
@@ -23,20 +24,62 @@ PolygonObstacle::PolygonObstacle(std::vector<Util::Point> points, float traversa
         _vectors.push_back( Util::Vector( _points[i].x, _points[i].y, _points[i].z ) );
     }
 
-	_centerPosition = Util::Point(0,0,0);
-	_radius = 0.0;
+	// the bounds, and the circle around the polygon, centered on the bounds.
 	float ymin = 0.0;
 	float ymax = 1.0;
-	_bounds.ymin = ymin;
-	_bounds.ymax = ymax;
-	_bounds.xmin = _centerPosition.x - _radius;
-	_bounds.xmax = _centerPosition.x + _radius;
-	_bounds.zmin = _centerPosition.z - _radius;
-	_bounds.zmax = _centerPosition.z + _radius;
+	_bounds = Util::AxisAlignedBox(0.0f, 0.0f, ymin, ymax, 0.0f, 0.0f);
+	if (!_points.empty())
+	{
+		_bounds.xmin = _bounds.xmax = _points[0].x;
+		_bounds.zmin = _bounds.zmax = _points[0].z;
+	}
+	for ( size_t i = 1 ; i < _points.size() ; ++i )
+	{
+		_bounds.xmin = std::min(_bounds.xmin, _points[i].x);
+		_bounds.xmax = std::max(_bounds.xmax, _points[i].x);
+		_bounds.zmin = std::min(_bounds.zmin, _points[i].z);
+		_bounds.zmax = std::max(_bounds.zmax, _points[i].z);
+	}
+	_centerPosition = Util::Point(0.5f * (_bounds.xmin + _bounds.xmax), 0.0f, 0.5f * (_bounds.zmin + _bounds.zmax));
+	_radius = 0.0;
+	for ( size_t i = 0 ; i < _points.size() ; ++i )
+	{
+		_radius = std::max(_radius, (_points[i] - _centerPosition).length());
+	}
+	_blocksLineOfSight = (_bounds.ymax > 0.7) ? true : false;
+
+	// the edges; the sign of the area tells which side of the edges is outside, whichever way the vertices wind.
+	float twiceArea = 0.0f;
+	for ( size_t i = 0 ; i < _points.size() ; ++i )
+	{
+		const Util::Point & a = _points[i];
+		const Util::Point & b = _points[(i + 1) % _points.size()];
+		twiceArea += a.x * b.z - b.x * a.z;
+	}
+	float side = (twiceArea >= 0.0f) ? 1.0f : -1.0f;
+	for ( size_t i = 0 ; i < _points.size() ; ++i )
+	{
+		Util::Vector direction = _points[(i + 1) % _points.size()] - _points[i];
+		direction.y = 0.0f;
+		float lengthSquared = direction.lengthSquared();
+		_edgeDirection.push_back(direction);
+		_edgeLengthSquared.push_back(lengthSquared);
+		if (lengthSquared > 0.0f)
+		{
+			float length = sqrtf(lengthSquared);
+			_edgeNormal.push_back(Util::Vector(side * direction.z / length, 0.0f, -side * direction.x / length));
+		}
+		else
+		{
+			_edgeNormal.push_back(Util::Vector(0.0f, 0.0f, 0.0f));
+		}
+	}
 
 	// TODO make parameter
 	isConvex_ = true;
 
+	SteerLib::GJK_EPA::decompose(_vectors, _convexDecomposition);
+
 }
 
 PolygonObstacle::~PolygonObstacle()
@@ -81,3 +124,120 @@ std::pair<std::vector<Util::Point>,std::vector<size_t> > PolygonObstacle::getSta
 	std::vector<size_t> vs;
 	return std::make_pair(ps, vs);
 }
+
+bool PolygonObstacle::intersects(const Util::Ray &r, float &t)
+{
+	// the closest edge the ray crosses within (mint, maxt).
+	bool hit = false;
+	float closestT = r.maxt;
+	for ( size_t i = 0 ; i < _points.size() ; ++i )
+	{
+		const Util::Vector & e = _edgeDirection[i];
+		float denominator = r.dir.x * e.z - r.dir.z * e.x;
+		if (denominator == 0.0f)
+		{
+			continue;
+		}
+		float offsetX = _points[i].x - r.pos.x;
+		float offsetZ = _points[i].z - r.pos.z;
+		float rayT = (offsetX * e.z - offsetZ * e.x) / denominator;
+		float edgeT = (offsetX * r.dir.z - offsetZ * r.dir.x) / denominator;
+		if ((edgeT >= 0.0f) && (edgeT <= 1.0f) && (rayT > r.mint) && (rayT < closestT))
+		{
+			closestT = rayT;
+			hit = true;
+		}
+	}
+	if (hit)
+	{
+		t = closestT;
+	}
+	return hit;
+}
+
+float PolygonObstacle::computeSignedDistance(const Util::Point & p, Util::Point & closestPoint, Util::Vector & normal) const
+{
+	if (_points.empty())
+	{
+		closestPoint = p;
+		normal = Util::Vector(1.0f, 0.0f, 0.0f);
+		return FLT_MAX;
+	}
+
+	bool inside = false;
+	size_t best = 0;
+	float bestDistanceSquared = FLT_MAX;
+	float bestX = 0.0f;
+	float bestZ = 0.0f;
+	for ( size_t i = 0 ; i < _points.size() ; ++i )
+	{
+		const Util::Point & a = _points[i];
+		const Util::Vector & e = _edgeDirection[i];
+
+		// even-odd rule: count the edges crossed by the ray from p towards +x.
+		if ((a.z > p.z) != (a.z + e.z > p.z))
+		{
+			float crossingX = a.x + (p.z - a.z) * e.x / e.z;
+			if (p.x < crossingX)
+			{
+				inside = !inside;
+			}
+		}
+
+		float t = 0.0f;
+		if (_edgeLengthSquared[i] > 0.0f)
+		{
+			t = ((p.x - a.x) * e.x + (p.z - a.z) * e.z) / _edgeLengthSquared[i];
+			t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+		}
+		float x = a.x + t * e.x;
+		float z = a.z + t * e.z;
+		float distanceSquared = (p.x - x) * (p.x - x) + (p.z - z) * (p.z - z);
+		if (distanceSquared < bestDistanceSquared)
+		{
+			best = i;
+			bestDistanceSquared = distanceSquared;
+			bestX = x;
+			bestZ = z;
+		}
+	}
+
+	float distance = sqrtf(bestDistanceSquared);
+	closestPoint = Util::Point(bestX, 0.0f, bestZ);
+	if (distance > 0.0f)
+	{
+		normal = Util::Vector(p.x - bestX, 0.0f, p.z - bestZ) / distance;
+		if (inside)
+		{
+			normal = -normal;
+		}
+	}
+	else
+	{
+		normal = _edgeNormal[best];
+	}
+	return inside ? -distance : distance;
+}
+
+float PolygonObstacle::computePenetration(const Util::Point & p, float radius)
+{
+	float penetration;
+	computePenetrations(&p, &radius, 1, &penetration);
+	return penetration;
+}
+
+void PolygonObstacle::computePenetrations(const Util::Point * centers, const float * radii, size_t count, float * penetrations) const
+{
+	for ( size_t i = 0 ; i < count ; ++i )
+	{
+		penetrations[i] = 0.0f;
+		if (!_circleMayOverlap(centers[i], radii[i]))
+		{
+			continue;
+		}
+		// clamping the penetration when the center is inside, see computeBoxCirclePenetration2D().
+		float distance = computeSignedDistance(centers[i]);
+		float penetration = (distance < 0.0f) ? radii[i] : radii[i] - distance;
+		penetrations[i] = (penetration > 0) ? penetration : 0.0f;
+	}
+}
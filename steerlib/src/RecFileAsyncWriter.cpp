@@ -0,0 +1,231 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+/// @file RecFileAsyncWriter.cpp
+/// @brief Implements the SteerLib::RecFileAsyncWriter class.
+
+#include <iostream>
+#include "util/GenericException.h"
+#include "util/Misc.h"
+#include "recfileio/RecFileIO.h"
+
+using namespace std;
+using namespace SteerLib;
+using namespace Util;
+
+//
+// constructor
+//
+RecFileAsyncWriter::RecFileAsyncWriter( unsigned int numBufferedFrames )
+{
+	if (numBufferedFrames == 0) {
+		throw GenericException("RecFileAsyncWriter: the number of buffered frames must be at least 1.");
+	}
+
+	_writer = new RecFileWriter();
+	_writerThread = new ThreadedTaskManager(1);
+	_ring.resize(numBufferedFrames);
+	for (unsigned int i=0; i < _ring.size(); i++) {
+		_ring[i].agents = NULL;
+		_ring[i].queued = false;
+		_ring[i].owner = this;
+	}
+	_currentSlot = 0;
+	_numQueuedFrames = 0;
+	_maxQueuedFrames = 0;
+	_numAgents = 0;
+	_writingFrame = false;
+	_stallProfiler.reset();
+}
+
+
+//
+// destructor
+// frames that were already handed to the writer thread are still written before the thread is destroyed.
+//
+RecFileAsyncWriter::~RecFileAsyncWriter()
+{
+	flush();
+	delete _writerThread;
+	delete _writer;
+
+	for (unsigned int i=0; i < _ring.size(); i++) {
+		if (_ring[i].agents != NULL) delete [] _ring[i].agents;
+	}
+	_ring.clear();
+}
+
+
+//
+// startRecording(): opens the rec file and allocates one agent array per snapshot buffer.
+//
+void RecFileAsyncWriter::startRecording(size_t numAgents, const std::string & filename, const std::string & testCaseName)
+{
+	// throws if a recording is already in progress, before any snapshot buffers are touched.
+	_writer->startRecording(numAgents, filename, testCaseName);
+
+	for (unsigned int i=0; i < _ring.size(); i++) {
+		if (_ring[i].agents != NULL) delete [] _ring[i].agents;
+		// value-initialized, so that the padding inside each RecFileAgentInfo is written as zeros.
+		_ring[i].agents = new RecFileAgentInfo[numAgents]();
+		_ring[i].queued = false;
+	}
+
+	_numAgents = (unsigned int)numAgents;
+	_currentSlot = 0;
+	_numQueuedFrames = 0;
+	_maxQueuedFrames = 0;
+	_writingFrame = false;
+	_stallProfiler.reset();
+}
+
+
+//
+// finishRecording(): drains the ring, then writes the headers and tables exactly like RecFileWriter.
+//
+void RecFileAsyncWriter::finishRecording()
+{
+	if (!isOpen()) {
+		throw GenericException("RecFileAsyncWriter::finishRecording(): no recording in progress to be finished.");
+	}
+
+	flush();
+	_writingFrame = false;
+	_writer->finishRecording();
+}
+
+
+//
+// startFrame(): returns the next free snapshot buffer, waiting for the writer thread if the ring is full.
+//
+RecFileAgentInfo * RecFileAsyncWriter::startFrame( float timeStamp, float timePassedSinceLastFrame )
+{
+	if (!isOpen()) {
+		throw GenericException("RecFileAsyncWriter::startFrame(): no recording is in progress.  Make sure to use startRecording() and finishRecording() appropriately.");
+	}
+
+	if ( _writingFrame ) {
+		throw GenericException("RecFileAsyncWriter::startFrame(): writing a frame is already in progress.  Make sure to call finishFrame() before starting the next frame.");
+	}
+
+	RecFileFrameSnapshot & snapshot = _ring[_currentSlot];
+
+	_ringLock.lock();
+	bool ringIsFull = snapshot.queued;
+	_ringLock.unlock();
+
+	if (ringIsFull) {
+		// back-pressure: the disk is not keeping up, so the simulation has to wait for the writer thread.
+		// the writer thread writes snapshots in order, and this one is the oldest, so it is free once one frame is written.
+		_stallProfiler.start();
+		_writerThread->waitForTasksToComplete((unsigned int)_ring.size() - 1);
+		_stallProfiler.stop();
+	}
+
+	snapshot.timeStamp = timeStamp;
+	snapshot.timePassedSinceLastFrame = timePassedSinceLastFrame;
+	_writingFrame = true;
+
+	return snapshot.agents;
+}
+
+
+//
+// finishFrame(): queues the current snapshot for the writer thread.
+//
+void RecFileAsyncWriter::finishFrame()
+{
+	if (!isOpen()) {
+		throw GenericException("RecFileAsyncWriter::finishFrame(): no recording is in progress.  Make sure to use startRecording() and finishRecording() appropriately.");
+	}
+
+	if (!_writingFrame ) {
+		throw GenericException("RecFileAsyncWriter::finishFrame(): no frame was started.");
+	}
+
+	RecFileFrameSnapshot & snapshot = _ring[_currentSlot];
+
+	_ringLock.lock();
+	snapshot.queued = true;
+	_numQueuedFrames++;
+	if (_numQueuedFrames > _maxQueuedFrames) _maxQueuedFrames = _numQueuedFrames;
+	_ringLock.unlock();
+
+	// there is only one writer thread, so snapshots are written in the order they were queued.
+	Task writeTask;
+	writeTask.function = RecFileAsyncWriter::_writeSnapshot;
+	writeTask.data = &snapshot;
+	try {
+		_writerThread->addTask(writeTask, true);
+	}
+	catch (std::exception &e) {
+		// the frame was not queued after all; give the slot back, so that the next startFrame() can use it again.
+		_ringLock.lock();
+		snapshot.queued = false;
+		_numQueuedFrames--;
+		_ringLock.unlock();
+		_writingFrame = false;
+		throw;
+	}
+
+	_currentSlot = (_currentSlot + 1) % _ring.size();
+	_writingFrame = false;
+}
+
+
+//
+// flush()
+//
+void RecFileAsyncWriter::flush()
+{
+	_writerThread->waitForAllTasksToComplete();
+}
+
+
+//
+// addObstacleBoundingBox(): obstacles are only written by finishRecording(), after the ring is drained.
+//
+void RecFileAsyncWriter::addObstacleBoundingBox( float xmin, float xmax, float ymin, float ymax, float zmin, float zmax )
+{
+	_writer->addObstacleBoundingBox(xmin, xmax, ymin, ymax, zmin, zmax);
+}
+
+
+//
+// addCameraView(): camera views are only written by finishRecording(), after the ring is drained.
+//
+void RecFileAsyncWriter::addCameraView( float origx, float origy, float origz, float lookatx, float lookaty, float lookatz )
+{
+	_writer->addCameraView(origx, origy, origz, lookatx, lookaty, lookatz);
+}
+
+
+//
+// displayStatistics()
+//
+void RecFileAsyncWriter::displayStatistics(std::ostream & out)
+{
+	out << "       Snapshot buffers: " << getNumBufferedFrames() << std::endl;
+	out << "   Max frames in flight: " << getMaxQueuedFrames() << std::endl;
+	out << "    Stalls on full ring: " << getNumStalls() << std::endl;
+	out << "       Total stall time: " << getTotalStallTime() << " seconds" << std::endl;
+}
+
+
+//
+// _writeSnapshot(): runs on the writer thread.
+//
+void RecFileAsyncWriter::_writeSnapshot( unsigned int threadIndex, void * data )
+{
+	RecFileFrameSnapshot * snapshot = (RecFileFrameSnapshot *)data;
+	RecFileAsyncWriter * owner = snapshot->owner;
+
+	owner->_writer->writeFrame(snapshot->timeStamp, snapshot->timePassedSinceLastFrame, snapshot->agents);
+
+	owner->_ringLock.lock();
+	snapshot->queued = false;
+	owner->_numQueuedFrames--;
+	owner->_ringLock.unlock();
+}
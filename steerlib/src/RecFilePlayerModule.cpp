@@ -200,7 +200,9 @@ void RecFilePlayerModule::preprocessFrame(float timeStamp, float dt, unsigned in
 
 	    agent->setPosition(_simulationReader->getAgentLocationAtTime(i,(float)_currentTimeToPlayback));
 		agent->setForward(_simulationReader->getAgentOrientationAtTime(i,(float)_currentTimeToPlayback));
+		bool wasEnabled = agent->enabled();
 		agent->setEnabled(_simulationReader->isAgentEnabledAtTime(i,(float)_currentTimeToPlayback));
+		if (!wasEnabled && agent->enabled()) _engine->activateAgent(agent);
 		agent->setRadius(_simulationReader->getAgentRadiusAtTime(i,(float)_currentTimeToPlayback));
 		agent->setCurrentGoal(newGoal);
 		// Somewhat good approximation of
@@ -85,7 +85,7 @@ void RecFileWriter::startRecording(size_t numAgents, const std::string & filenam
 	// we do not know the number of frames that will be written to the file.
 	//
 	_header = new RecFileHeader();
-	_agentsInCurrentFrame = new RecFileAgentInfo[numAgents];
+	_agentsInCurrentFrame = new RecFileAgentInfo[numAgents]();
 	_frameTable.clear();
 	_obstacleList.clear();
 	_cameraList.clear();
@@ -266,6 +266,17 @@ void RecFileWriter::finishFrame()
 }
 
 
+//
+// writeFrame(): writes an entire frame directly from the caller's array of agent info
+//
+void RecFileWriter::writeFrame( float timeStamp, float timePassedSinceLastFrame, const RecFileAgentInfo * agentsInFrame )
+{
+	startFrame(timeStamp, timePassedSinceLastFrame);
+	_playbackFile.write((const char*)agentsInFrame, _header->frameSize);
+	_writingFrame = false;
+}
+
+
 //
 // setAgentInfoForCurrentFrame()
 //
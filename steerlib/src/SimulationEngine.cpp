@@ -46,9 +46,15 @@ void SimulationEngine::_reset()
 	_moduleMetaInfoByReference.clear();
 	_modulesInExecutionOrder.clear();
 	_moduleConflicts.clear();
+	_modulesWithPreprocessFrame.clear();
+	_modulesWithPostprocessFrame.clear();
 	_agents.clear();
+	_activeAgents.clear();
+	_activeAgentSchedules.clear();
+	_numAgentActivations = 0;
 	_selectedAgents.clear();
-	_agentOwners.clear();
+	_agentEntries.clear();
+	_agentIndices.clear();
 	_commands.clear();
 	_obstacles.clear();
 	//_clock reset ???;
@@ -165,12 +171,14 @@ void SimulationEngine::finish()
 
 	// if modules did not clean up agents (they should), we can compensate user-friendly here.
 	if (_agents.size() != 0) {
-		std::vector<SteerLib::AgentInterface*>::iterator agentIterator;
-		for (agentIterator = _agents.begin(); agentIterator != _agents.end(); ++agentIterator) {
-			_agentOwners[(*agentIterator)]->destroyAgent(*agentIterator);
+		for (unsigned int i = 0; i < _agents.size(); i++) {
+			_agentEntries[i].owner->destroyAgent(_agents[i]);
 		}
 		_agents.clear();
-		_agentOwners.clear();
+		_activeAgents.clear();
+		_activeAgentSchedules.clear();
+		_agentEntries.clear();
+		_agentIndices.clear();
 	}
 	_selectedAgents.clear();
 
@@ -208,6 +216,10 @@ void SimulationEngine::initializeSimulation()
 
 	_clock.reset();
 
+	// the same engine may be used for several simulations in a row (e.g. by the BatchSimulationRunner)
+	_numFramesSimulated = 0;
+	_stop = false;
+
 	// iterate over all modules asking them to initialize.
 	std::vector<SteerLib::ModuleInterface*>::iterator iter;
 	for ( iter = _modulesInExecutionOrder.begin(); iter != _modulesInExecutionOrder.end();  ++iter ) {
@@ -246,6 +258,14 @@ void SimulationEngine::preprocessSimulation()
 		(*iter)->preprocessSimulation();
 	}
 
+	// modules cannot be loaded or unloaded while a simulation is running, so the per-frame hooks are resolved once here.
+	_modulesWithPreprocessFrame.clear();
+	_modulesWithPostprocessFrame.clear();
+	for ( iter = _modulesInExecutionOrder.begin(); iter != _modulesInExecutionOrder.end();  ++iter ) {
+		if ((*iter)->usesPreprocessFrame()) _modulesWithPreprocessFrame.push_back(*iter);
+		if ((*iter)->usesPostprocessFrame()) _modulesWithPostprocessFrame.push_back(*iter);
+	}
+
 	_engineState.transitionToState(ENGINE_STATE_SIMULATION_READY_FOR_UPDATE);
 }
 
@@ -282,6 +302,10 @@ bool SimulationEngine::update( bool advanceRealTimeOnly )
 		_clock.advanceSimulationAndUpdateRealTime();
 		_camera.update(_clock.getCurrentRealTime(), _clock.getRealDt());
 
+		//Call animate for camera
+		if (_options->guiOptions.animateCamera)
+			_camera.animate(_clock.getCurrentSimulationTime(), _clock.getSimulationDt(), _clock.getCurrentFrameNumber());
+
 		// Run the actual simulation step, taking the appropriate action based on its return value.
 		if (_simulateOneStep() == true) {
 			return true;
@@ -304,37 +328,79 @@ bool SimulationEngine::update( bool advanceRealTimeOnly )
 
 //========================================
 
+bool SimulationEngine::updateHeadless( unsigned int numFrames )
+{
+	if (_engineState.getCurrentState() != SimulationEngine::ENGINE_STATE_SIMULATION_READY_FOR_UPDATE) {
+		throw GenericException("Cannot run the next simulation step, the engine is not in the correct state.");
+	}
+
+	for (unsigned int i=0; (numFrames == 0) || (i < numFrames); i++) {
+		_clock.advanceSimulation();
+		if (_simulateOneStep() == false) {
+			_engineState.transitionToState(ENGINE_STATE_SIMULATION_NO_MORE_UPDATES_ALLOWED);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//========================================
+
 bool SimulationEngine::_simulateOneStep()
 {
-	unsigned int numDisabledAgents = 0;
 	float currentSimulationTime = _clock.getCurrentSimulationTime();
 	float simulatonDt = _clock.getSimulationDt();
 	unsigned int currentFrameNumber = _clock.getCurrentFrameNumber();
 
-	//Call animate for camera
-	if (_options->guiOptions.animateCamera)
-		_camera.animate(currentSimulationTime, simulatonDt, currentFrameNumber);
-
-	// call preprocess for all modules
+	// call preprocess for all modules that use it
 	std::vector<SteerLib::ModuleInterface*>::iterator moduleIterator;
-	for ( moduleIterator = _modulesInExecutionOrder.begin(); moduleIterator != _modulesInExecutionOrder.end();  ++moduleIterator ) {
+	for ( moduleIterator = _modulesWithPreprocessFrame.begin(); moduleIterator != _modulesWithPreprocessFrame.end();  ++moduleIterator ) {
 		(*moduleIterator)->preprocessFrame(currentSimulationTime, simulatonDt, currentFrameNumber);
 	}
 
-	// call updateAI for all agents
-	std::vector<SteerLib::AgentInterface*>::iterator agentIterator;
-	for ( agentIterator = _agents.begin(); agentIterator != _agents.end(); ++agentIterator )
+	// periodically restore the spatial coherence of the update order, which the swap-n-pop removals and the agents' motion erode.
+	unsigned int agentReorderInterval = _options->engineOptions.agentReorderInterval;
+	if ((agentReorderInterval != 0) && (currentFrameNumber % agentReorderInterval == 0)) {
+		_reorderActiveAgents();
+	}
+
+	// call updateAI for all active agents; an agent found disabled is replaced by the last active agent,
+	// which is then updated in the same slot, so finished agents cost nothing in later frames.
+	unsigned int lodUpdateInterval = _options->engineOptions.lodUpdateInterval;
+	unsigned int agentIndex = 0;
+	while (agentIndex < _activeAgents.size())
 	{
-		if ((*agentIterator)->enabled()){
-			(*agentIterator)->updateAI(currentSimulationTime, simulatonDt, currentFrameNumber);
+		SteerLib::AgentInterface * agent = _activeAgents[agentIndex];
+		if (!agent->enabled()) {
+			_deactivateAgent(agentIndex);
+			continue;
 		}
-		else {
-			numDisabledAgents++;
+
+		AgentSchedule & schedule = _activeAgentSchedules[agentIndex];
+		if ((lodUpdateInterval <= 1) || (!schedule.supportsLevelOfDetail)) {
+			agent->updateAI(currentSimulationTime, simulatonDt, currentFrameNumber);
 		}
+		else if (currentFrameNumber >= schedule.nextUpdateFrame) {
+			// the agent's time-step covers all the frames it skipped.
+			float agentDt = (schedule.lastUpdateTime < 0.0f) ? simulatonDt : currentSimulationTime - schedule.lastUpdateTime;
+			// decided before updateAI(), because the agent may create or destroy agents and move the schedule in memory.
+			bool lowDetail = _canUseLowDetail(agent);
+			schedule.lastUpdateTime = currentSimulationTime;
+			if (lowDetail) {
+				// the next frame on which (frame + phase) is a multiple of the interval.
+				schedule.nextUpdateFrame = currentFrameNumber + lodUpdateInterval - ((currentFrameNumber + schedule.phase) % lodUpdateInterval);
+			}
+			else {
+				schedule.nextUpdateFrame = currentFrameNumber + 1;
+			}
+			agent->updateAI(currentSimulationTime, agentDt, currentFrameNumber);
+		}
+		agentIndex++;
 	}
 
-	// call postprocess for all modules
-	for ( moduleIterator = _modulesInExecutionOrder.begin(); moduleIterator != _modulesInExecutionOrder.end();  ++moduleIterator ) {
+	// call postprocess for all modules that use it
+	for ( moduleIterator = _modulesWithPostprocessFrame.begin(); moduleIterator != _modulesWithPostprocessFrame.end();  ++moduleIterator ) {
 		(*moduleIterator)->postprocessFrame(currentSimulationTime, simulatonDt, currentFrameNumber);
 	}
 
@@ -347,7 +413,7 @@ bool SimulationEngine::_simulateOneStep()
 
 	// indicate that we're done (return false) if all agents were disabled in this frame.
 	// Disabling exit when all agents have finished simulating. 
-	if (numDisabledAgents == _agents.size())
+	if (_activeAgents.empty())
 		return false;
 
 	// Force stop by some other module
@@ -499,7 +565,7 @@ void SimulationEngine::_drawObstacles()
 void SimulationEngine::_drawAgents()
 {
 	std::vector<SteerLib::AgentInterface*>::iterator agentIterator;
-	for ( agentIterator = _agents.begin(); agentIterator != _agents.end(); ++agentIterator ) {
+	for ( agentIterator = _activeAgents.begin(); agentIterator != _activeAgents.end(); ++agentIterator ) {
 		if ((*agentIterator)->enabled()){
 			(*agentIterator)->draw();
 		}
@@ -938,8 +1004,7 @@ SteerLib::AgentInterface * SimulationEngine::createAgent(const SteerLib::AgentIn
 
 	if (newAgent != NULL) {
 		newAgent->reset(initialConditions,this);
-		_agents.push_back(newAgent);
-		_agentOwners[newAgent] = owner;
+		_insertAgent(newAgent, owner);
 	}
 
 	return newAgent;
@@ -949,41 +1014,12 @@ SteerLib::AgentInterface * SimulationEngine::createAgent(const SteerLib::AgentIn
 
 void SimulationEngine::destroyAgent(SteerLib::AgentInterface * agentToDestroy)
 {
-	/// @todo
-	///   - this removal method is not entirely robust, and makes un-wise assumptions
-	///     fix it after changing _agents data type from std::vector to std::set
 	if (agentToDestroy != NULL)
 	{
-
 		// find the module that owns this agent; this also implicitly makes sure agent actually was known to the engine.
-		SteerLib::ModuleInterface * module =  NULL;
-		std::map<SteerLib::AgentInterface*, SteerLib::ModuleInterface*>::iterator moduleIter;
-		moduleIter = _agentOwners.find(agentToDestroy);
-		if (moduleIter == _agentOwners.end())
-		{
-			throw GenericException("Cannot destroy agent because the engine did not have a record of the agent.  Are you sure you used SimulationEngine::createAgent() or SimulationEngine::addAgent()?");
-		}
-		else {
-			module = (*moduleIter).second;
-		}
-
-		// remove the agent from the list of _agents
-		// this is unnecessarily costly because we use std::vector, and we must iterate through the entire list to find it
-		// but for now it seems like an acceptable trade-off because this is not in a performace-critical place, and 
-		// the ability to index into _agents is important in some other places.
-		std::vector<SteerLib::AgentInterface*>::iterator agentIter;
-		agentIter = std::find( _agents.begin(), _agents.end(), agentToDestroy);
-		// if this assertion happens, we have a bug, since we expected that the agent will be in both _agentOwners and _agents.
-		assert(agentIter != _agents.end());
+		unsigned int agentIndex = _findAgentIndex(agentToDestroy, "Cannot destroy agent because the engine did not have a record of the agent.  Are you sure you used SimulationEngine::createAgent() or SimulationEngine::addAgent()?");
 
-		// the swap-n-pop method avoids a linear-time cost for removing something in the array
-		// but does not preserve the order of agents.
-		swap((*agentIter), _agents.back());
-		_agents.pop_back();
-
-
-		// remove the agent from the list of owners
-		_agentOwners.erase(agentToDestroy);
+		SteerLib::ModuleInterface * module = _eraseAgent(agentIndex);
 
 		// destroy the agent
 		module->destroyAgent(agentToDestroy);
@@ -1002,7 +1038,7 @@ void SimulationEngine::destroyAllAgentsFromModule(SteerLib::ModuleInterface * ow
 #endif
 	for (int i = _agents.size()-1; i >= 0; i--)
 	{
-		if (_agentOwners[_agents[i]] == owner)
+		if (_agentEntries[i].owner == owner)
 		{
 #ifdef _DEBUG
 	std::cout << "Destroying agent\n";
@@ -1017,31 +1053,153 @@ void SimulationEngine::destroyAllAgentsFromModule(SteerLib::ModuleInterface * ow
 void SimulationEngine::addAgent(SteerLib::AgentInterface * newAgent, SteerLib::ModuleInterface * owner)
 {
 	// make sure the agent does not already exist in the engine's data structures.
-	if (_agentOwners.find(newAgent) != _agentOwners.end()) {
+	if (_agentIndices.find(newAgent) != _agentIndices.end()) {
 		throw GenericException("Cannot add agent, agent already exists.\n");
 	}
 
-	_agents.push_back(newAgent);
-	_agentOwners[newAgent] = owner;
+	_insertAgent(newAgent, owner);
 }
 
 //========================================
 
 void SimulationEngine::removeAgent(SteerLib::AgentInterface * agentToRemove)
 {
-	std::vector<SteerLib::AgentInterface*>::iterator agentIter;
-	agentIter = std::find( _agents.begin(), _agents.end(), agentToRemove);
-	if (agentIter == _agents.end()) {
-		throw GenericException("Cannot remove agent because the engine did not have a record of the agent.  Are you sure you used SimulationEngine::createAgent() or SimulationEngine::addAgent()?");
+	unsigned int agentIndex = _findAgentIndex(agentToRemove, "Cannot remove agent because the engine did not have a record of the agent.  Are you sure you used SimulationEngine::createAgent() or SimulationEngine::addAgent()?");
+	_eraseAgent(agentIndex);
+}
+
+//========================================
+
+void SimulationEngine::activateAgent(SteerLib::AgentInterface * agent)
+{
+	unsigned int agentIndex = _findAgentIndex(agent, "Cannot activate agent because the engine did not have a record of the agent.  Are you sure you used SimulationEngine::createAgent() or SimulationEngine::addAgent()?");
+	if (_agentEntries[agentIndex].activeIndex == NOT_ACTIVE) {
+		_pushActiveAgent(agentIndex);
+	}
+}
+
+//========================================
+
+unsigned int SimulationEngine::_findAgentIndex(SteerLib::AgentInterface * agent, const char * errorMessage)
+{
+	std::unordered_map<SteerLib::AgentInterface*, unsigned int>::iterator indexIter = _agentIndices.find(agent);
+	if (indexIter == _agentIndices.end()) {
+		throw GenericException(errorMessage);
+	}
+	return (*indexIter).second;
+}
+
+//========================================
+
+void SimulationEngine::_insertAgent(SteerLib::AgentInterface * newAgent, SteerLib::ModuleInterface * owner)
+{
+	// new agents always start in the active list; if they are disabled, the next frame swaps them out again.
+	unsigned int agentIndex = (unsigned int)_agents.size();
+	AgentEntry entry;
+	entry.owner = owner;
+	entry.activeIndex = NOT_ACTIVE;
+	_agents.push_back(newAgent);
+	_agentEntries.push_back(entry);
+	_agentIndices[newAgent] = agentIndex;
+	_pushActiveAgent(agentIndex);
+}
+
+//========================================
+
+void SimulationEngine::_pushActiveAgent(unsigned int agentIndex)
+{
+	AgentSchedule schedule;
+	schedule.supportsLevelOfDetail = _agents[agentIndex]->supportsLevelOfDetail();
+	schedule.phase = _numAgentActivations++;
+	schedule.nextUpdateFrame = 0;
+	schedule.lastUpdateTime = -1.0f;
+	schedule.agentIndex = agentIndex;
+
+	_agentEntries[agentIndex].activeIndex = (unsigned int)_activeAgents.size();
+	_activeAgents.push_back(_agents[agentIndex]);
+	_activeAgentSchedules.push_back(schedule);
+}
+
+//========================================
+
+SteerLib::ModuleInterface * SimulationEngine::_eraseAgent(unsigned int agentIndex)
+{
+	if (_agentEntries[agentIndex].activeIndex != NOT_ACTIVE) {
+		_deactivateAgent(_agentEntries[agentIndex].activeIndex);
 	}
 
 	// the swap-n-pop method avoids a linear-time cost for removing something in the array
-	// but does not preserve the order of agents.
-	swap((*agentIter), _agents.back());
+	// but does not preserve the order of agents.  the moved agent's schedule, if it has one, follows it to its new index.
+	SteerLib::AgentInterface * agent = _agents[agentIndex];
+	SteerLib::ModuleInterface * owner = _agentEntries[agentIndex].owner;
+	SteerLib::AgentInterface * lastAgent = _agents.back();
+	_agents[agentIndex] = lastAgent;
+	_agentEntries[agentIndex] = _agentEntries.back();
+	if (_agentEntries[agentIndex].activeIndex != NOT_ACTIVE) {
+		_activeAgentSchedules[_agentEntries[agentIndex].activeIndex].agentIndex = agentIndex;
+	}
+	_agentIndices[lastAgent] = agentIndex;
 	_agents.pop_back();
+	_agentEntries.pop_back();
+	_agentIndices.erase(agent);
+
+	return owner;
+}
+
+//========================================
+
+void SimulationEngine::_deactivateAgent(unsigned int activeIndex)
+{
+	// swap-n-pop; the last active agent may be the agent itself, so its entry is updated before this one.
+	unsigned int agentIndex = _activeAgentSchedules[activeIndex].agentIndex;
+	_activeAgents[activeIndex] = _activeAgents.back();
+	_activeAgentSchedules[activeIndex] = _activeAgentSchedules.back();
+	_agentEntries[_activeAgentSchedules[activeIndex].agentIndex].activeIndex = activeIndex;
+	_activeAgents.pop_back();
+	_activeAgentSchedules.pop_back();
+	_agentEntries[agentIndex].activeIndex = NOT_ACTIVE;
+}
+
+//========================================
+
+void SimulationEngine::_reorderActiveAgents()
+{
+	// sorted by (code, old index), so agents in the same cell keep their relative order and the result is deterministic.
+	_reorderKeys.resize(_activeAgents.size());
+	for (unsigned int i = 0; i < _activeAgents.size(); i++) {
+		_reorderKeys[i] = std::make_pair(_spatialDatabase->getZOrderFromLocation(_activeAgents[i]->position()), i);
+	}
+	std::sort(_reorderKeys.begin(), _reorderKeys.end());
+
+	_reorderedAgents.resize(_activeAgents.size());
+	_reorderedSchedules.resize(_activeAgentSchedules.size());
+	for (unsigned int i = 0; i < _reorderKeys.size(); i++) {
+		unsigned int oldIndex = _reorderKeys[i].second;
+		_reorderedAgents[i] = _activeAgents[oldIndex];
+		_reorderedSchedules[i] = _activeAgentSchedules[oldIndex];
+		_agentEntries[_reorderedSchedules[i].agentIndex].activeIndex = i;
+	}
+	_activeAgents.swap(_reorderedAgents);
+	_activeAgentSchedules.swap(_reorderedSchedules);
+}
+
+//========================================
+
+bool SimulationEngine::_canUseLowDetail(SteerLib::AgentInterface * agent)
+{
+	const Util::AxisAlignedBox & region = _options->engineOptions.lodRegionOfInterest;
+	if (region.xmin <= region.xmax) {
+		Util::Point p = agent->position();
+		if ((p.x < region.xmin) || (p.x > region.xmax) || (p.z < region.zmin) || (p.z > region.zmax))
+			return true;
+	}
+
+	float radius = _options->engineOptions.lodNeighborRadius;
+	if (radius > 0.0f) {
+		return !_spatialDatabase->hasAgentInRange(agent->position(), radius, agent);
+	}
 
-	// remove the agent from the list of owners
-	_agentOwners.erase(agentToRemove);
+	return false;
 }
 
 /*
@@ -148,6 +148,10 @@ using namespace Util;
 #define DEFAULT_MIN_VARIABLE_DT 0.001f
 #define DEFAULT_MAX_VARIABLE_DT 0.2f
 #define DEFAULT_CLOCK_MODE "fixed-fast"
+#define DEFAULT_LOD_UPDATE_INTERVAL 1
+#define DEFAULT_LOD_NEIGHBOR_RADIUS 0.0f
+#define DEFAULT_LOD_REGION_OF_INTEREST AxisAlignedBox()
+#define DEFAULT_AGENT_REORDER_INTERVAL 0
 
 //====================================
 // GRID DATABASE DEFAULTS
@@ -159,6 +163,11 @@ using namespace Util;
 #define DEFAULT_NUM_GRID_CELLS_Z 200
 #define DEFAULT_DRAW_GRID true
 
+//====================================
+// COMMAND-LINE ENGINE DRIVER DEFAULTS
+//====================================
+#define DEFAULT_HEADLESS false
+
 //====================================
 // GLFW ENGINE DRIVER DEFAULTS
 //====================================
@@ -233,6 +242,10 @@ SimulationOptions::SimulationOptions()
 	engineOptions.minVariableDt = DEFAULT_MIN_VARIABLE_DT;
 	engineOptions.maxVariableDt = DEFAULT_MAX_VARIABLE_DT;
 	engineOptions.clockMode = DEFAULT_CLOCK_MODE;
+	engineOptions.lodUpdateInterval = DEFAULT_LOD_UPDATE_INTERVAL;
+	engineOptions.lodNeighborRadius = DEFAULT_LOD_NEIGHBOR_RADIUS;
+	engineOptions.lodRegionOfInterest = DEFAULT_LOD_REGION_OF_INTEREST;
+	engineOptions.agentReorderInterval = DEFAULT_AGENT_REORDER_INTERVAL;
 
 	// grid database options
 	gridDatabaseOptions.maxItemsPerGridCell = DEFAULT_MAX_ITEMS_PER_GRID_CELL;
@@ -258,6 +271,9 @@ SimulationOptions::SimulationOptions()
 	guiOptions.lineWidth = DEFAULT_LINE_WIDTH;
 	guiOptions.animateCamera = DEFAULT_ANIMATE_CAMERA;
 
+	// command-line engine driver options
+	commandLineEngineDriverOptions.headless = DEFAULT_HEADLESS;
+
 	// glfw engine driver options
 	glfwEngineDriverOptions.pausedOnStart = DEFAULT_CLOCK_PAUSED_ON_START;
 	glfwEngineDriverOptions.windowSizeX = DEFAULT_WINDOW_SIZE_X;
@@ -404,7 +420,7 @@ void SimulationOptions::_setupXMLStructure( Util::XMLParser & xmlOpts )
 	root->createChildTag("modules", "Module-specific options.  Any options specified on the command-line will override the options specified here.  Modules specified here will not necessarily be loaded when started; for that use the startupModules option for the engine.", XML_DATA_TYPE_CONTAINER, NULL, &_moduleOptionsXMLParser );
 
 	// option sub-groups
-	engineDriversTag->createChildTag("commandLine", "Options for the command-line engine driver (currently there are no options for the command-line)");
+	XMLTag * commandLineEngineDriverTag = engineDriversTag->createChildTag("commandLine", "Options for the command-line engine driver");
 	XMLTag * glfwEngineDriverTag = engineDriversTag->createChildTag("glfw", "Options for the GLFW engine driver");
 	engineDriversTag->createChildTag("qt", "Options for the Qt engine driver (config for qt not implemented yet!)");
 
@@ -440,6 +456,10 @@ void SimulationOptions::_setupXMLStructure( Util::XMLParser & xmlOpts )
 	engineTag->createChildTag("minVariableDt", "The minimum time-step allowed when the clock is in \"variable-real-time\" mode.  If the proposed time-step is smaller, this value will be used instead, effectively limiting the max frame rate.", XML_DATA_TYPE_FLOAT, &engineOptions.minVariableDt);
 	engineTag->createChildTag("maxVariableDt", "The maximum time-step allowed when the clock is in \"variable-real-time\" mode.  If the proposed time-step is larger, this value will be used instead, at the expense of breaking synchronization between simulation time and real-time.", XML_DATA_TYPE_FLOAT, &engineOptions.maxVariableDt);
 	engineTag->createChildTag("clockMode", "can be either \"fixed-fast\" (fixed simulation frame rate, running as fast as possible), \"fixed-real-time\" (fixed simulation frame rate, running in real-time), or \"variable-real-time\" (variable simulation frame rate in real-time).", XML_DATA_TYPE_STRING, &engineOptions.clockMode);
+	engineTag->createChildTag("lodUpdateInterval", "Agents that support level of detail are updated only every lodUpdateInterval frames (with a correspondingly larger time-step) while they have no other agent within lodNeighborRadius, or while they are outside of lodRegionOfInterest.  1 disables level of detail.", XML_DATA_TYPE_UNSIGNED_INT, &engineOptions.lodUpdateInterval);
+	engineTag->createChildTag("lodNeighborRadius", "Agents with no other agent within this distance are updated at reduced rate; 0 disables the neighbor test.", XML_DATA_TYPE_FLOAT, &engineOptions.lodNeighborRadius);
+	engineTag->createChildTag("lodRegionOfInterest", "Agents outside of this region are updated at reduced rate; an empty region (xmin > xmax) disables the region test.", XML_DATA_TYPE_BOUNDING_BOX, &engineOptions.lodRegionOfInterest);
+	engineTag->createChildTag("agentReorderInterval", "Every agentReorderInterval frames the active agents are sorted by the Z-order of their grid cell, so that agents close to each other are updated one after another.  0 disables the reordering.", XML_DATA_TYPE_UNSIGNED_INT, &engineOptions.agentReorderInterval);
 
 	// grid database options
 	gridDatabaseTag->createChildTag("maxItemsPerGridCell", "Max number of items a grid cell can contain", XML_DATA_TYPE_UNSIGNED_INT, &gridDatabaseOptions.maxItemsPerGridCell);
@@ -449,6 +469,9 @@ void SimulationOptions::_setupXMLStructure( Util::XMLParser & xmlOpts )
 	gridDatabaseTag->createChildTag("numCellsZ", "Number of cells in the grid along the Z axis", XML_DATA_TYPE_UNSIGNED_INT, &gridDatabaseOptions.numGridCellsZ);
 	gridDatabaseTag->createChildTag("draw", "Draws the grid if \"true\".", XML_DATA_TYPE_BOOLEAN, &gridDatabaseOptions.drawGrid);
 
+	// command-line engine driver options
+	commandLineEngineDriverTag->createChildTag("headless", "Runs the simulation in a tight loop that never updates the real-time clock or camera, and reports frames per second at the end, if \"true\".  Every frame uses the fixed frame rate, regardless of the clock mode.", XML_DATA_TYPE_BOOLEAN, &commandLineEngineDriverOptions.headless);
+
 	// GLFW engine driver options
 	glfwEngineDriverTag->createChildTag("startWithClockPaused", "Starts the clock paused if \"true\".", XML_DATA_TYPE_BOOLEAN, &glfwEngineDriverOptions.pausedOnStart);
 	glfwEngineDriverTag->createChildTag("windowSizeX", "Width of the openGL window in pixels", XML_DATA_TYPE_UNSIGNED_INT, &glfwEngineDriverOptions.windowSizeX);
@@ -8,6 +8,8 @@
 
 #include "modules/SimulationRecorderModule.h"
 #include "simulation/SimulationOptions.h"
+#include "util/Misc.h"
+#include <string.h>
 
 using namespace SteerLib;
 
@@ -16,6 +18,10 @@ void SimulationRecorderModule::init( const SteerLib::OptionDictionary & options,
 	_recFilename = "";
 	_engine = engineInfo;
 	_simulationWriter = NULL;
+	_asyncWriter = NULL;
+	_frameBuffer = NULL;
+	_useAsyncWriter = false;
+	_numBufferedFrames = 32;
 
 	// parse the options
 	SteerLib::OptionDictionary::const_iterator optionIter;
@@ -25,6 +31,12 @@ void SimulationRecorderModule::init( const SteerLib::OptionDictionary & options,
 		else if ((*optionIter).first == "recfile") {
 			_recFilename = (*optionIter).second;
 		}
+		else if ((*optionIter).first == "async") {
+			_useAsyncWriter = Util::getBoolFromString((*optionIter).second);
+		}
+		else if ((*optionIter).first == "bufferframes") {
+			std::istringstream((*optionIter).second) >> _numBufferedFrames;
+		}
 	}
 
 	//if (_recFilename == "") {
@@ -41,8 +53,6 @@ void SimulationRecorderModule::preprocessSimulation() {
 
 	if (_initialized) return; 
 
-	_simulationWriter = new SteerLib::RecFileWriter();
-
 	// note, these are aliases (using the &)
 	const std::vector<SteerLib::AgentInterface*> & agents = _engine->getAgents();
 	const std::set<SteerLib::ObstacleInterface*> & obstacles = _engine->getObstacles();
@@ -50,14 +60,27 @@ void SimulationRecorderModule::preprocessSimulation() {
 	// if the simulation is reading a usual test case, then this filename is stored in 
 	// the recfile so that initial conditions can be validated.
 	// otherwise, the recfile is not associated with any test case filename.
+	std::string testCaseName = "";
 	if (_engine->isModuleLoaded("testCasePlayer"))
-		_simulationWriter->startRecording(agents.size(), _recFilename,  (*_engine->getModuleOptions("testCasePlayer").find("testcase")).second );
-	else
-		_simulationWriter->startRecording(agents.size(), _recFilename);
+		testCaseName = (*_engine->getModuleOptions("testCasePlayer").find("testcase")).second;
+
+	if (_useAsyncWriter) {
+		_asyncWriter = new SteerLib::RecFileAsyncWriter(_numBufferedFrames);
+		_asyncWriter->startRecording(agents.size(), _recFilename, testCaseName);
+	}
+	else {
+		_simulationWriter = new SteerLib::RecFileWriter();
+		_simulationWriter->startRecording(agents.size(), _recFilename, testCaseName);
+		// value-initialized, so that the padding inside each RecFileAgentInfo is written as zeros.
+		_frameBuffer = new SteerLib::RecFileAgentInfo[agents.size()]();
+	}
 
 	std::set<SteerLib::ObstacleInterface*>::const_iterator obstacleIter;
 	for (obstacleIter = obstacles.begin(); obstacleIter != obstacles.end(); ++obstacleIter) {
-		_simulationWriter->addObstacleBoundingBox((*obstacleIter)->getBounds());
+		if (_useAsyncWriter)
+			_asyncWriter->addObstacleBoundingBox((*obstacleIter)->getBounds());
+		else
+			_simulationWriter->addObstacleBoundingBox((*obstacleIter)->getBounds());
 	}
 
 	// Technically, the number of frames is one more than the number of simulation steps taken.
@@ -66,25 +89,7 @@ void SimulationRecorderModule::preprocessSimulation() {
 	if ((_engine->getClock().getCurrentFrameNumber() != 0) || (_engine->getClock().getCurrentSimulationTime() != 0.0f)) {
 		throw Util::GenericException("The simulationRecorder module made a bad assumption that simulation time was 0.0 during initialization; apparently this needs to be fixed.");
 	}
-	_simulationWriter->startFrame(_engine->getClock().getCurrentSimulationTime(), 0.0f);
-	for (unsigned int i=0; i<agents.size(); i++) {
-		// These values must be strictly initialized, just in case the agent is not enabled.
-		// This is necessary so that two rec files will be exactly the same if the simulations were exactly the same.
-		Util::Point pos(0.0f, 0.0f, 0.0f);
-		Util::Vector dir(0.0f, 0.0f, 0.0f);
-		Util::Point goal(0.0f, 0.0f, 0.0f);
-		float radius = 0;
-		bool enabled = agents[i]->enabled();
-		if (enabled) {
-			pos =  agents[i]->position();
-			dir =  agents[i]->forward();
-			assert(dir.lengthSquared() != 0.0f);
-			goal = agents[i]->currentGoal().targetLocation;
-			radius = agents[i]->radius();
-		}
-		_simulationWriter->setAgentInfoForCurrentFrame(i,pos.x, pos.y, pos.z, dir.x, dir.y, dir.z, goal.x, goal.y, goal.z, radius, enabled);
-	}
-	_simulationWriter->finishFrame();
+	_recordFrame(_engine->getClock().getCurrentSimulationTime(), 0.0f);
 
 
 	_initialized = true;
@@ -94,12 +99,67 @@ void SimulationRecorderModule::preprocessSimulation() {
 
 void SimulationRecorderModule::postprocessFrame(float timeStamp, float dt, unsigned int frameNumber) {
 
+	_recordFrame(_engine->getClock().getCurrentSimulationTime(), dt);
+
+}
+
+void SimulationRecorderModule::postprocessSimulation() {
+
+	if (!_initialized ) return;
+
+	if (_useAsyncWriter) {
+		assert(_asyncWriter->isOpen() && _asyncWriter->isRecording());
+
+		if (_asyncWriter->isWritingFrame()) {
+			_asyncWriter->finishFrame();
+		}
+
+		// flushes all frames still buffered in the ring before finishing the file.
+		_asyncWriter->finishRecording();
+		std::cout << "simulationRecorder: asynchronous writer statistics:\n";
+		_asyncWriter->displayStatistics(std::cout);
+		delete _asyncWriter;
+		_asyncWriter = NULL;
+	}
+	else {
+		assert(_simulationWriter->isOpen() && _simulationWriter->isRecording());
+
+		if (_simulationWriter->isWritingFrame()) {
+			_simulationWriter->finishFrame();
+		}
+
+		_simulationWriter->finishRecording();
+		delete _simulationWriter;
+		_simulationWriter = NULL;
+		delete [] _frameBuffer;
+		_frameBuffer = NULL;
+	}
+#ifdef _DEBUG
+	std::cout << "Wrote " << _engine->getClock().getCurrentFrameNumber()+1 << " frames. (one extra frame for initial conditions)" << std::endl;
+#endif
+}
+
+
+void SimulationRecorderModule::_recordFrame(float timeStamp, float dt) {
+
 	// note, this is an alias (using the &)
 	const std::vector<SteerLib::AgentInterface *>  & agents = _engine->getAgents();
 
-	//std::cout << " coming here \n";
+	SteerLib::RecFileAgentInfo * frame;
+	unsigned int numAgentsRecorded;
+	if (_useAsyncWriter) {
+		frame = _asyncWriter->startFrame(timeStamp, dt);
+		numAgentsRecorded = _asyncWriter->getNumAgents();
+	}
+	else {
+		frame = _frameBuffer;
+		numAgentsRecorded = _simulationWriter->getNumAgents();
+	}
+
+	if ( agents.size() > numAgentsRecorded ) {
+		throw Util::GenericException("SimulationRecorderModule: there are " + Util::toString(agents.size()) + " agents, but the recording was started with only " + Util::toString(numAgentsRecorded) + " agents.");
+	}
 
-	_simulationWriter->startFrame(_engine->getClock().getCurrentSimulationTime(), dt);
 	for (unsigned int i=0; i<agents.size(); i++) {
 		// These values must be strictly initialized, just in case the agent is not enabled.
 		// This is necessary so that two rec files will be exactly the same if the simulations were exactly the same.
@@ -111,30 +171,29 @@ void SimulationRecorderModule::postprocessFrame(float timeStamp, float dt, unsig
 		if (enabled) {
 			pos =  agents[i]->position();
 			dir =  agents[i]->forward();
-			//assert(dir.lengthSquared() != 0.0f);
 			goal = agents[i]->currentGoal().targetLocation;
 			radius = agents[i]->radius();
 		}
-		_simulationWriter->setAgentInfoForCurrentFrame(i,pos.x, pos.y, pos.z, dir.x, dir.y, dir.z, goal.x, goal.y, goal.z, radius, enabled);
+		frame[i].pos.x = pos.x;
+		frame[i].pos.y = pos.y;
+		frame[i].pos.z = pos.z;
+		frame[i].dir.x = dir.x;
+		frame[i].dir.y = dir.y;
+		frame[i].dir.z = dir.z;
+		frame[i].goal.x = goal.x;
+		frame[i].goal.y = goal.y;
+		frame[i].goal.z = goal.z;
+		frame[i].radius = radius;
+		frame[i].enabled = enabled;
 	}
-	_simulationWriter->finishFrame();
-
-}
-
-void SimulationRecorderModule::postprocessSimulation() {
 
-	if (!_initialized ) return;
-
-	assert(_simulationWriter->isOpen() && _simulationWriter->isRecording());
-
-	if (_simulationWriter->isWritingFrame()) {
-		_simulationWriter->finishFrame();
+	// agents removed since the recording started leave slots at the end; they are recorded as disabled, with all values zero.
+	for (unsigned int i=(unsigned int)agents.size(); i<numAgentsRecorded; i++) {
+		memset(&frame[i], 0, sizeof(SteerLib::RecFileAgentInfo));
 	}
 
-	_simulationWriter->finishRecording();
-#ifdef _DEBUG
-	std::cout << "Wrote " << _engine->getClock().getCurrentFrameNumber()+1 << " frames. (one extra frame for initial conditions)" << std::endl;
-#endif
-	delete _simulationWriter;
+	if (_useAsyncWriter)
+		_asyncWriter->finishFrame();
+	else
+		_simulationWriter->writeFrame(timeStamp, dt, frame);
 }
-
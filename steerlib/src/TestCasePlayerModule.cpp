@@ -10,6 +10,7 @@
 #include "testcaseio/TestCaseIO.h"
 #include "util/Misc.h"
 #include <iostream>
+#include <sstream>
 
 using namespace SteerLib;
 
@@ -21,6 +22,8 @@ void TestCasePlayerModule::init( const SteerLib::OptionDictionary & options, Ste
 	_aiModuleName = "";
 	_aiModuleSearchPath = "";
 	_aiModule = NULL;
+	_sharedTestCase = NULL;
+	_obstacleMergeGap = 0.0f;
 	_obstacles.clear();
 
 	// parse command line options
@@ -32,6 +35,9 @@ void TestCasePlayerModule::init( const SteerLib::OptionDictionary & options, Ste
 		else if ((*optionIter).first == "ai") {
 			_aiModuleName = (*optionIter).second;
 		}
+		else if ((*optionIter).first == "obstaclemergegap") {
+			std::istringstream((*optionIter).second) >> _obstacleMergeGap;
+		}
 		else {
 			throw Util::GenericException("unrecognized option \"" + Util::toString((*optionIter).first) + "\" given to testCasePlayer module.");
 		}
@@ -72,30 +78,40 @@ void TestCasePlayerModule::init( const SteerLib::OptionDictionary & options, Ste
 
 void TestCasePlayerModule::initializeSimulation() {
 
-	SteerLib::TestCaseReader * testCaseReader;
+	// a test case that was already parsed elsewhere is used as-is, and is not deleted here.
+	const SteerLib::TestCaseReader * testCaseReader = _sharedTestCase;
+	SteerLib::TestCaseReader * ownTestCaseReader = NULL;
 
-	std::string testCasePath;
+	if (testCaseReader == NULL) {
+		std::string testCasePath;
 
-	// try to find the test case in several ways:
-	if (Util::fileCanBeOpened(_testCaseFilename)) {
-		testCasePath = _testCaseFilename;
-	}
-	else if (Util::fileCanBeOpened( _engine->getTestCaseSearchPath() + _testCaseFilename )) {
-		testCasePath = _engine->getTestCaseSearchPath() + _testCaseFilename;
-	}
-	else if (Util::fileCanBeOpened(_testCaseFilename + ".xml")) {
-		testCasePath = _testCaseFilename + ".xml";
-	}
-	else if (Util::fileCanBeOpened( _engine->getTestCaseSearchPath() + _testCaseFilename + ".xml" )) {
-		testCasePath = _engine->getTestCaseSearchPath() + _testCaseFilename + ".xml";
-	}
-	else {
-		throw Util::GenericException("Could not find test case " + _testCaseFilename + ".");
-	}
+		// try to find the test case in several ways:
+		if (Util::fileCanBeOpened(_testCaseFilename)) {
+			testCasePath = _testCaseFilename;
+		}
+		else if (Util::fileCanBeOpened( _engine->getTestCaseSearchPath() + _testCaseFilename )) {
+			testCasePath = _engine->getTestCaseSearchPath() + _testCaseFilename;
+		}
+		else if (Util::fileCanBeOpened(_testCaseFilename + ".xml")) {
+			testCasePath = _testCaseFilename + ".xml";
+		}
+		else if (Util::fileCanBeOpened( _engine->getTestCaseSearchPath() + _testCaseFilename + ".xml" )) {
+			testCasePath = _engine->getTestCaseSearchPath() + _testCaseFilename + ".xml";
+		}
+		else {
+			throw Util::GenericException("Could not find test case " + _testCaseFilename + ".");
+		}
+
+		// open the test case
+		ownTestCaseReader = new SteerLib::TestCaseReader();
+		ownTestCaseReader->setObstacleMergeGap(_obstacleMergeGap);
+		ownTestCaseReader->readTestCaseFromFile(testCasePath);
+		testCaseReader = ownTestCaseReader;
 
-	// open the test case
-	testCaseReader = new SteerLib::TestCaseReader();
-	testCaseReader->readTestCaseFromFile(testCasePath);
+		if (testCaseReader->getNumObstacles() < testCaseReader->getNumObstaclesBeforeMerging()) {
+			std::cout << "merged " << testCaseReader->getNumObstaclesBeforeMerging() << " obstacles of the test case into " << testCaseReader->getNumObstacles() << "\n";
+		}
+	}
 
 	//Create the obstacles
 	for (unsigned int i=0; i < testCaseReader->getNumObstacles(); i++) {
@@ -130,7 +146,7 @@ void TestCasePlayerModule::initializeSimulation() {
 
 	engineCamera.addControlPoints(controlPoints);
 
-	delete testCaseReader;
+	if (ownTestCaseReader != NULL) delete ownTestCaseReader;
 
 
 #ifdef ENABLE_GUI
@@ -22,6 +22,11 @@ TestCaseReader::TestCaseReader()
 	_randomNumberGenerator.seed(2);
 }
 
+void TestCaseReader::setRandomSeed( unsigned int seed )
+{
+	_randomNumberGenerator.seed(seed);
+}
+
 void TestCaseReader::readTestCaseFromFile( const std::string & testCaseFilename )
 {
 	_header.description = "";
@@ -34,20 +39,31 @@ void TestCaseReader::readTestCaseFromFile( const std::string & testCaseFilename
 	//
 	// first, parse the test case and get the raw data from it
 	//
-	ticpp::Document doc(testCaseFilename);
-	doc.LoadFile();
-	ticpp::Element * root = doc.FirstChildElement();
-	std::string rootTagName = root->Value();
-
-	// if the root tag doesn't match our expected root tag, its an error.
-	if (rootTagName != "SteerBenchTestCase" &&
-			( rootTagName != "SteerSuiteSubSpace" ) )
-	{
-		throw GenericException("XML file " + testCaseFilename + " does not seem to be a Valid SteerSuite test case.\n");
+	if (endsWith(testCaseFilename, ".scen")) {
+		// MovingAI benchmark scenarios are read directly, instead of being converted to XML first.
+		_parseMovingAIScenario(testCaseFilename);
+	}
+	else if (endsWith(testCaseFilename, ".map")) {
+		std::vector<bool> passable;
+		unsigned int width, height;
+		_parseMovingAIMap(testCaseFilename, passable, width, height);
+	}
+	else {
+		ticpp::Document doc(testCaseFilename);
+		doc.LoadFile();
+		ticpp::Element * root = doc.FirstChildElement();
+		std::string rootTagName = root->Value();
+
+		// if the root tag doesn't match our expected root tag, its an error.
+		if (rootTagName != "SteerBenchTestCase" &&
+				( rootTagName != "SteerSuiteSubSpace" ) )
+		{
+			throw GenericException("XML file " + testCaseFilename + " does not seem to be a Valid SteerSuite test case.\n");
+		}
+
+		// recursively parse each tag.
+		_parseTestCaseDOM( root );
 	}
-	
-	// recursively parse each tag.
-	_parseTestCaseDOM( root );
 
 
 	// 
@@ -78,6 +94,9 @@ void TestCaseReader::readTestCaseFromFile( const std::string & testCaseFilename
 		testCaseDB->addObject(_rawObstacles[i], _rawObstacles[i]->obstacleBounds);
 	}
 
+	// merge the thin boxes of imported maps; the temporary database keeps the raw obstacles, which cover the same space.
+	_mergeBoxObstacles();
+
 
 	// Then add all non-random agents, making sure they don't overlap anything.
 	// "non-random" is for position; random directions and goals are OK.
@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2009-2014 Shawn Singh, Glen Berseth, Mubbasir Kapadia, Petros Faloutsos, Glenn Reinman
+// See license.txt for complete license.
+//
+
+/// @file TestCaseReaderMovingAI.cpp
+/// @brief Helper functions to read the grid maps and scenarios of the MovingAI pathfinding benchmarks.
+
+#include "testcaseio/TestCaseIO.h"
+#include "util/Misc.h"
+#include "util/GenericException.h"
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace SteerLib;
+using namespace Util;
+
+// a little less than half a cell, so that agents fit through corridors that are one cell wide.
+#define MOVINGAI_AGENT_RADIUS 0.4f
+#define MOVINGAI_AGENT_DESIRED_SPEED 1.3f
+#define MOVINGAI_GOAL_TIME_DURATION 1000.0f
+#define MOVINGAI_OBSTACLE_HEIGHT 1.0f
+
+
+//
+// only ground, and swamp which ground can enter, are passable; trees, water and out of bounds cells are walls.
+//
+static inline bool isPassableTerrain(char terrain)
+{
+	return (terrain == '.') || (terrain == 'G') || (terrain == 'S');
+}
+
+//
+// removes the carriage return that files written on Windows leave at the end of each line.
+//
+static inline void stripCarriageReturn(std::string & line)
+{
+	if (!line.empty() && (line[line.size()-1] == '\r')) {
+		line.erase(line.size()-1);
+	}
+}
+
+//
+// returns the directory portion of a path, including its trailing separator, or "" if there is none.
+//
+static std::string directoryOf(const std::string & path)
+{
+	for (size_t i = path.size(); i > 0; i--) {
+		if (isForwardSlash(path[i-1]) || isBackSlash(path[i-1])) {
+			return path.substr(0, i);
+		}
+	}
+	return "";
+}
+
+
+void TestCaseReaderPrivate::_parseMovingAIMap(const std::string & mapFilename, std::vector<bool> & passable, unsigned int & width, unsigned int & height)
+{
+	std::ifstream mapFile(mapFilename.c_str());
+	if (!mapFile.is_open()) {
+		throw GenericException("Could not open MovingAI map " + mapFilename + ".");
+	}
+
+	// the header is a few "keyword value" lines, followed by the line "map".
+	width = 0;
+	height = 0;
+	std::string line;
+	while (std::getline(mapFile, line)) {
+		stripCarriageReturn(line);
+		std::istringstream lineStream(line);
+		std::string keyword;
+		lineStream >> keyword;
+		if (keyword == "map") {
+			break;
+		}
+		else if (keyword == "width") {
+			lineStream >> width;
+		}
+		else if (keyword == "height") {
+			lineStream >> height;
+		}
+		else if ((keyword != "type") && (keyword != "")) {
+			throw GenericException("Unexpected keyword \"" + keyword + "\" in the header of MovingAI map " + mapFilename + ".");
+		}
+	}
+	if ((width == 0) || (height == 0)) {
+		throw GenericException("MovingAI map " + mapFilename + " does not specify its width and height.");
+	}
+
+	// the map is centered on the origin, one unit per cell; row y of the map is along z, column x along x.
+	float originX = -0.5f * (float)width;
+	float originZ = -0.5f * (float)height;
+	_header.version = "1.0";
+	_header.name = basename(mapFilename, ".map");
+	_header.description = "MovingAI benchmark map " + basename(mapFilename, "");
+	_header.passingCriteria = "";
+	_header.worldBounds = AxisAlignedBox(originX, -originX, 0.0f, 0.0f, originZ, -originZ);
+
+	// every run of blocked cells in a row becomes one box; readTestCaseFromFile() merges the boxes of consecutive rows afterwards.
+	passable.assign(width * height, false);
+	for (unsigned int y = 0; y < height; y++) {
+		if (!std::getline(mapFile, line)) {
+			throw GenericException("MovingAI map " + mapFilename + " ends after " + toString(y) + " of its " + toString(height) + " rows.");
+		}
+		stripCarriageReturn(line);
+		if (line.size() < width) {
+			throw GenericException("Row " + toString(y) + " of MovingAI map " + mapFilename + " is shorter than the width of the map.");
+		}
+
+		unsigned int x = 0;
+		while (x < width) {
+			if (isPassableTerrain(line[x])) {
+				passable[y * width + x] = true;
+				x++;
+				continue;
+			}
+
+			unsigned int runStart = x;
+			while ((x < width) && !isPassableTerrain(line[x])) {
+				x++;
+			}
+
+			RawBoxObstacleInfo *obst = new RawBoxObstacleInfo;
+			obst->isObstacleRandom = false;
+			obst->obstacleBounds = AxisAlignedBox(originX + runStart, originX + x, 0.0f, MOVINGAI_OBSTACLE_HEIGHT, originZ + y, originZ + y + 1);
+			obst->height = 0.0f;
+			obst->regionBounds = _header.worldBounds;
+			obst->size = 0.0f;
+			_rawObstacles.push_back(obst);
+		}
+	}
+}
+
+
+void TestCaseReaderPrivate::_parseMovingAIScenario(const std::string & scenarioFilename)
+{
+	std::ifstream scenarioFile(scenarioFilename.c_str());
+	if (!scenarioFile.is_open()) {
+		throw GenericException("Could not open MovingAI scenario " + scenarioFilename + ".");
+	}
+
+	std::vector<bool> passable;
+	unsigned int mapWidth = 0;
+	unsigned int mapHeight = 0;
+	std::string mapName;
+
+	// the scenario is read one problem at a time; the map is read when the first problem names it.
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(scenarioFile, line)) {
+		lineNumber++;
+		stripCarriageReturn(line);
+		if (line.empty() || ((lineNumber == 1) && (line.compare(0, 7, "version") == 0))) {
+			continue;
+		}
+
+		// bucket, map, map width, map height, start x, start y, goal x, goal y, optimal length; separated by tabs.
+		std::istringstream lineStream(line);
+		unsigned int bucket;
+		std::string problemMapName;
+		unsigned int scenarioWidth, scenarioHeight, startX, startY, goalX, goalY;
+		lineStream >> bucket >> std::ws;
+		std::getline(lineStream, problemMapName, '\t');
+		lineStream >> scenarioWidth >> scenarioHeight >> startX >> startY >> goalX >> goalY;
+		if (lineStream.fail() || (scenarioWidth == 0) || (scenarioHeight == 0)) {
+			throw GenericException("Could not parse line " + toString(lineNumber) + " of MovingAI scenario " + scenarioFilename + ".");
+		}
+
+		if (mapName.empty()) {
+			// the map is usually given relative to the benchmark suite; look for it next to the scenario as well.
+			std::string scenarioDirectory = directoryOf(scenarioFilename);
+			std::string mapFilename;
+			if (fileCanBeOpened(scenarioDirectory + problemMapName)) {
+				mapFilename = scenarioDirectory + problemMapName;
+			}
+			else if (fileCanBeOpened(scenarioDirectory + basename(problemMapName, ""))) {
+				mapFilename = scenarioDirectory + basename(problemMapName, "");
+			}
+			else if (endsWith(scenarioFilename, ".map.scen") && fileCanBeOpened(scenarioFilename.substr(0, scenarioFilename.size() - 5))) {
+				mapFilename = scenarioFilename.substr(0, scenarioFilename.size() - 5);
+			}
+			else {
+				throw GenericException("Could not find MovingAI map " + problemMapName + " of scenario " + scenarioFilename + ".");
+			}
+			mapName = problemMapName;
+			_parseMovingAIMap(mapFilename, passable, mapWidth, mapHeight);
+			_header.description = "MovingAI benchmark scenario " + basename(scenarioFilename, "");
+		}
+		else if (problemMapName != mapName) {
+			throw GenericException("Line " + toString(lineNumber) + " of MovingAI scenario " + scenarioFilename + " uses map " + problemMapName + ", but the scenario started with map " + mapName + ".");
+		}
+
+		// problems may be given for a scaled version of the map.
+		startX = (unsigned int)(((unsigned long long)startX * mapWidth) / scenarioWidth);
+		goalX = (unsigned int)(((unsigned long long)goalX * mapWidth) / scenarioWidth);
+		startY = (unsigned int)(((unsigned long long)startY * mapHeight) / scenarioHeight);
+		goalY = (unsigned int)(((unsigned long long)goalY * mapHeight) / scenarioHeight);
+		if ((startX >= mapWidth) || (goalX >= mapWidth) || (startY >= mapHeight) || (goalY >= mapHeight)) {
+			throw GenericException("The problem on line " + toString(lineNumber) + " of MovingAI scenario " + scenarioFilename + " is outside the map.");
+		}
+		if (!passable[startY * mapWidth + startX] || !passable[goalY * mapWidth + goalX]) {
+			throw GenericException("The problem on line " + toString(lineNumber) + " of MovingAI scenario " + scenarioFilename + " starts or ends in a blocked cell.");
+		}
+
+		// agents start at the center of the start cell and seek the center of the goal cell.
+		Point start(_header.worldBounds.xmin + startX + 0.5f, 0.0f, _header.worldBounds.zmin + startY + 0.5f);
+		Point goal(_header.worldBounds.xmin + goalX + 0.5f, 0.0f, _header.worldBounds.zmin + goalY + 0.5f);
+
+		RawAgentInfo newAgent;
+		newAgent.name = "problem-" + toString(_rawAgents.size());
+		newAgent.isPositionRandom = false;
+		newAgent.isDirectionRandom = false;
+		newAgent.isColorRandom = false;
+		newAgent.colorSet = false;
+		newAgent.regionBounds = _header.worldBounds;
+		newAgent.position = start;
+		newAgent.direction = ((startX == goalX) && (startY == goalY)) ? Vector(1.0f, 0.0f, 0.0f) : normalize(goal - start);
+		newAgent.color = Util::Color(-1,-1,-1);
+		newAgent.radius = MOVINGAI_AGENT_RADIUS;
+		newAgent.speed = 0.0f;
+
+		AgentGoalInfo newGoal;
+		newGoal.goalType = GOAL_TYPE_SEEK_STATIC_TARGET;
+		newGoal.targetIsRandom = false;
+		newGoal.targetLocation = goal;
+		newGoal.targetDirection = Vector(1.0f, 0.0f, 0.0f);
+		newGoal.targetName = "";
+		newGoal.desiredSpeed = MOVINGAI_AGENT_DESIRED_SPEED;
+		newGoal.timeDuration = MOVINGAI_GOAL_TIME_DURATION;
+		newGoal.flowType = "";
+		newGoal.targetTangent = Vector(0.f, 0.f, 0.f);
+		newGoal.targetTime = 0;
+		newAgent.goals.push_back(newGoal);
+
+		_rawAgents.push_back(newAgent);
+	}
+
+	if (mapName.empty()) {
+		throw GenericException("MovingAI scenario " + scenarioFilename + " does not contain any problems.");
+	}
+}
@@ -11,6 +11,9 @@
 #include "util/Geometry.h"
 #include "util/Misc.h"
 #include "util/GenericException.h"
+#include <algorithm>
+#include <set>
+#include <typeinfo>
 
 using namespace std;
 using namespace SteerLib;
@@ -914,3 +917,107 @@ void TestCaseReaderPrivate::_initAgentInitialConditions( AgentInitialConditions
 	a.goals = agent.goals;  // note, this is a STL vector being copied into another STL vector.
 }
 
+
+//
+// BoxMergeOrder - sorts boxes so that the boxes that may merge along one axis are next to each other:
+// by height, then by their extent along the other axis, then by where they start along the merge axis.
+//
+struct BoxMergeOrder {
+	BoxMergeOrder(bool alongX) : _alongX(alongX) { }
+	bool operator()(const BoxObstacleInitialConditions * a, const BoxObstacleInitialConditions * b) const {
+		if (a->ymin != b->ymin) return a->ymin < b->ymin;
+		if (a->ymax != b->ymax) return a->ymax < b->ymax;
+		if (_alongX) {
+			if (a->zmin != b->zmin) return a->zmin < b->zmin;
+			if (a->zmax != b->zmax) return a->zmax < b->zmax;
+			return a->xmin < b->xmin;
+		}
+		else {
+			if (a->xmin != b->xmin) return a->xmin < b->xmin;
+			if (a->xmax != b->xmax) return a->xmax < b->xmax;
+			return a->zmin < b->zmin;
+		}
+	}
+	bool _alongX;
+};
+
+//
+// merges each run of boxes that have the same extent across the merge axis, and overlap or leave at most a gap along it;
+// the boxes that are merged into another one are deleted.  Returns the number of boxes that were removed.
+//
+static size_t mergeBoxesAlongAxis(std::vector<BoxObstacleInitialConditions*> & boxes, bool alongX, float gap)
+{
+	if (boxes.empty()) {
+		return 0;
+	}
+
+	std::sort(boxes.begin(), boxes.end(), BoxMergeOrder(alongX));
+
+	size_t numKept = 0;
+	for (size_t i = 1; i < boxes.size(); i++) {
+		BoxObstacleInitialConditions * current = boxes[numKept];
+		BoxObstacleInitialConditions * next = boxes[i];
+		bool sameSection = (current->ymin == next->ymin) && (current->ymax == next->ymax);
+		if (alongX) {
+			sameSection = sameSection && (current->zmin == next->zmin) && (current->zmax == next->zmax);
+		}
+		else {
+			sameSection = sameSection && (current->xmin == next->xmin) && (current->xmax == next->xmax);
+		}
+
+		if (sameSection && alongX && (next->xmin <= current->xmax + gap)) {
+			current->xmax = std::max(current->xmax, next->xmax);
+			delete next;
+		}
+		else if (sameSection && !alongX && (next->zmin <= current->zmax + gap)) {
+			current->zmax = std::max(current->zmax, next->zmax);
+			delete next;
+		}
+		else {
+			boxes[++numKept] = next;
+		}
+	}
+	numKept++;
+
+	size_t numRemoved = boxes.size() - numKept;
+	boxes.resize(numKept);
+	return numRemoved;
+}
+
+void TestCaseReaderPrivate::_mergeBoxObstacles()
+{
+	_numObstaclesBeforeMerging = _initializedObstacles.size();
+	if (_obstacleMergeGap < 0.0f) {
+		return;
+	}
+
+	std::vector<BoxObstacleInitialConditions*> boxes;
+	std::vector<bool> isBox(_initializedObstacles.size(), false);
+	for (unsigned int i=0; i<_initializedObstacles.size(); i++) {
+		if (typeid(*_initializedObstacles[i]) == typeid(BoxObstacleInitialConditions)) {
+			boxes.push_back(static_cast<BoxObstacleInitialConditions*>(_initializedObstacles[i]));
+			isBox[i] = true;
+		}
+	}
+
+	// merging rows can line up columns that merge, and the other way around, so alternate until neither merges anything.
+	size_t numRemoved = 0;
+	size_t numRemovedThisRound;
+	do {
+		numRemovedThisRound = mergeBoxesAlongAxis(boxes, true, _obstacleMergeGap);
+		numRemovedThisRound += mergeBoxesAlongAxis(boxes, false, _obstacleMergeGap);
+		numRemoved += numRemovedThisRound;
+	} while (numRemovedThisRound > 0);
+
+	// a merged box is the first box of its run, grown; drop the boxes merged into it and keep the order of the rest.
+	if (numRemoved > 0) {
+		std::set<ObstacleInitialConditions*> keptBoxes(boxes.begin(), boxes.end());
+		size_t numKept = 0;
+		for (unsigned int i=0; i<_initializedObstacles.size(); i++) {
+			if (!isBox[i] || (keptBoxes.count(_initializedObstacles[i]) > 0)) {
+				_initializedObstacles[numKept++] = _initializedObstacles[i];
+			}
+		}
+		_initializedObstacles.resize(numKept);
+	}
+}
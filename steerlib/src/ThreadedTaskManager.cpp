@@ -37,6 +37,7 @@ ThreadedTaskManager::ThreadedTaskManager(unsigned int numThreads)
 	_threads.clear();
 	_shuttingDown = false;
 	_allTasksCompleted = true;
+	_wakeUpWaitersAtNumTasksLeft = 0;
 
 	_initializeSynchronizationObjects();
 
@@ -73,7 +74,7 @@ ThreadedTaskManager::~ThreadedTaskManager()
 #else
 	pthread_mutex_destroy(&_taskManagerLock);
 	pthread_cond_destroy(&_queueHasTasksCondition);
-	pthread_cond_destroy(&_allTasksCompletedCondition);
+	pthread_cond_destroy(&_taskCompletedCondition);
 #endif
 }
 
@@ -112,7 +113,7 @@ void ThreadedTaskManager::waitForAllTasksToComplete()
 #ifdef USE_VISTA_THREADS
 	_lock();
 	while (!_allTasksCompleted) {
-		SleepConditionVariableCS( &_allTasksCompletedCondition, &_taskManagerLock, INFINITE);
+		SleepConditionVariableCS( &_taskCompletedCondition, &_taskManagerLock, INFINITE);
 	}
 	_unlock();
 #else
@@ -121,15 +122,38 @@ void ThreadedTaskManager::waitForAllTasksToComplete()
 #else
 	_lock();
 	while (!_allTasksCompleted) {
-		pthread_cond_wait(&_allTasksCompletedCondition, &_taskManagerLock);
+		pthread_cond_wait(&_taskCompletedCondition, &_taskManagerLock);
 	}
 	_unlock();
 #endif
 }
 
+void ThreadedTaskManager::waitForTasksToComplete(unsigned int maxNumTasksLeft)
+{
+	_lock();
+	while (_numTasksLeft > maxNumTasksLeft) {
+		_wakeUpWaitersAtNumTasksLeft = maxNumTasksLeft;
+#ifdef _WIN32
+#ifdef USE_VISTA_THREADS
+		SleepConditionVariableCS( &_taskCompletedCondition, &_taskManagerLock, INFINITE);
+#else
+		assert(false); // we should be throwing an informative GenericException during initialization instead of reaching here.
+#endif
+#else
+		pthread_cond_wait(&_taskCompletedCondition, &_taskManagerLock);
+#endif
+	}
+	_wakeUpWaitersAtNumTasksLeft = 0;
+	_unlock();
+}
+
 void ThreadedTaskManager::_runWorkerThread() throw()
 {
+	// the constructor holds the lock until all threads are created, so _threads is complete once we get it.
+	_lock();
 	unsigned int threadIndex = _getIndexOfCurrentWorkerThread();
+	_unlock();
+
 	while(true) {
 
 		// acquire the lock
@@ -173,10 +197,13 @@ void ThreadedTaskManager::_runWorkerThread() throw()
 		// decrement the number of tasks there are.
 		_numTasksLeft--;
 
-		// if all threads are completed, broadcast that.
+		// if all threads are completed, broadcast that; also when someone waits for only some of the tasks, and enough are done.
 		if (_numTasksLeft == 0) {
 			_allTasksCompleted = true;
-			_broadcastAllTasksCompleted();
+			_broadcastTaskCompleted();
+		}
+		else if (_numTasksLeft <= _wakeUpWaitersAtNumTasksLeft) {
+			_broadcastTaskCompleted();
 		}
 
 		// release the lock
@@ -198,16 +225,16 @@ void ThreadedTaskManager::wakeUpAllSleepingWorkerThreads() throw()
 #endif
 }
 
-void ThreadedTaskManager::_broadcastAllTasksCompleted() throw()
+void ThreadedTaskManager::_broadcastTaskCompleted() throw()
 {
 #ifdef _WIN32
 #ifdef USE_VISTA_THREADS
-	WakeAllConditionVariable(&_allTasksCompletedCondition);
+	WakeAllConditionVariable(&_taskCompletedCondition);
 #else
 	assert(false); // we should be throwing an informative GenericException during initialization instead of reaching here.
 #endif
 #else
-	pthread_cond_broadcast(&_allTasksCompletedCondition);
+	pthread_cond_broadcast(&_taskCompletedCondition);
 #endif
 }
 
@@ -292,7 +319,7 @@ void ThreadedTaskManager::_initializeSynchronizationObjects()
 	InitializeCriticalSection(& _taskManagerLock);
 #ifdef USE_VISTA_THREADS
 	InitializeConditionVariable( & _queueHasTasksCondition );
-	InitializeConditionVariable( & _allTasksCompletedCondition );
+	InitializeConditionVariable( & _taskCompletedCondition );
 #endif
 #else
 	unsigned int returnValue;
@@ -307,7 +334,7 @@ void ThreadedTaskManager::_initializeSynchronizationObjects()
 		throw GenericException("pthread_cond_init failed with return value " + toString(returnValue));
 	}
 
-	returnValue = pthread_cond_init(&_allTasksCompletedCondition,NULL);
+	returnValue = pthread_cond_init(&_taskCompletedCondition,NULL);
 	if (returnValue != 0) {
 		throw GenericException("pthread_cond_init failed with return value " + toString(returnValue));
 	}
@@ -194,7 +194,11 @@ void XMLTag::parse(const ticpp::Element * subRoot, bool throwIfUnrecognizedTag )
 			case XML_DATA_TYPE_BOUNDING_BOX:
 				{
 					ticpp::Iterator<ticpp::Element> childElem;
-					float bounds[6];
+					// bounds that are not given keep their current values.
+					float bounds[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+					if (_target != NULL) {
+						for (unsigned int i=0; i < 6; i++) bounds[i] = ((float*)(_target))[i];
+					}
 					for (childElem = childElem.begin(subRoot); childElem != childElem.end(); ++childElem ) {
 						if (childElem->Value() == "xmin") {
 							childElem->GetText(&bounds[0]);
@@ -42,6 +42,8 @@ public:
 
 protected:
 	bool _alreadyInitialized;
+	/// Runs the simulation with SteerLib::SimulationEngine::updateHeadless() and reports frames per second.
+	bool _headless;
 	SteerLib::SimulationEngine * _engine;
 
 private:
@@ -23,6 +23,7 @@ using namespace Util;
 CommandLineEngineDriver::CommandLineEngineDriver()
 {
 	_alreadyInitialized = false;
+	_headless = false;
 	_engine = NULL;
 }
 
@@ -38,6 +39,8 @@ void CommandLineEngineDriver::init(SteerLib::SimulationOptions * options)
 
 	_alreadyInitialized = true;
 
+	_headless = options->commandLineEngineDriverOptions.headless;
+
 	_engine = new SimulationEngine();
 	_engine->init(options, this);
 }
@@ -61,10 +64,27 @@ void CommandLineEngineDriver::run()
 	if (verbose) std::cout << "\rPreprocessing...\n";
 	_engine->preprocessSimulation();
 
-	// loop until the engine tells us its done
-	while (!done) {
-		if (verbose) std::cout << "\rFrame Number:   " << _engine->getClock().getCurrentFrameNumber();
-		done = !_engine->update(false);
+	if (_headless) {
+		// a single call runs every frame; only the total real time is measured.
+		PerformanceProfiler timer;
+		timer.reset();
+		timer.start();
+		_engine->updateHeadless(0);
+		timer.stop();
+
+		unsigned int numFrames = _engine->getClock().getCurrentFrameNumber();
+		float realTime = timer.getTotalTime();
+		std::cout << "Headless: " << numFrames << " frames in " << realTime << " seconds (";
+		if (realTime > 0.0f) std::cout << (float)numFrames / realTime;
+		else std::cout << "-";
+		std::cout << " frames per second)." << std::endl;
+	}
+	else {
+		// loop until the engine tells us its done
+		while (!done) {
+			if (verbose) std::cout << "\rFrame Number:   " << _engine->getClock().getCurrentFrameNumber();
+			done = !_engine->update(false);
+		}
 	}
 
 	if (verbose) std::cout << "\rFrame Number:   " << _engine->getClock().getCurrentFrameNumber() << std::endl;
@@ -422,6 +422,7 @@ void initializeOptionsFromCommandLine( int argc, char **argv, SimulationOptions
 	bool qtSpecified = false;
 	bool glfwSpecified = false;
 	bool commandLineSpecified = false;
+	bool headlessSpecified = false;
 	bool animateCamera = false;
 
 	std::string engineDriverName = "";
@@ -445,6 +446,7 @@ void initializeOptionsFromCommandLine( int argc, char **argv, SimulationOptions
 	opts.addOption("-GLFW", NULL, OPTION_DATA_TYPE_NO_DATA, 0, &glfwSpecified, true);
 	opts.addOption("-commandLine", NULL, OPTION_DATA_TYPE_NO_DATA, 0, &commandLineSpecified, true);
 	opts.addOption("-commandline", NULL, OPTION_DATA_TYPE_NO_DATA, 0, &commandLineSpecified, true);
+	opts.addOption("-headless", NULL, OPTION_DATA_TYPE_NO_DATA, 0, &headlessSpecified, true);
 	opts.addOption("-engineDriver", &engineDriverName, OPTION_DATA_TYPE_STRING);
 	opts.addOption("-enginedriver", &engineDriverName, OPTION_DATA_TYPE_STRING);
 	opts.addOption("-generateConfig", &generateConfigFilename, OPTION_DATA_TYPE_STRING);
@@ -512,6 +514,12 @@ void initializeOptionsFromCommandLine( int argc, char **argv, SimulationOptions
 		else if (engineDriverName == "commandline") commandLineSpecified = true;
 	}
 
+	// headless mode is only provided by the command-line engine driver.
+	if (headlessSpecified) {
+		commandLineSpecified = true;
+		simulationOptions.commandLineEngineDriverOptions.headless = true;
+	}
+
 	unsigned int numGUIOptionsSpecified = 0;
 
 	//
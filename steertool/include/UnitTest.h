@@ -135,4 +135,53 @@ protected:
 	Util::StateMachine _stateMachine;
 };
 
+/**
+ * @brief Unit test for running several SimulationEngine instances in the same process.
+ *
+ * Two engines, each with a differently configured social forces AI module, simulate the same
+ * test case: first one after the other, then at the same time on two threads.  Every engine and
+ * its module instances own all of their state, so the concurrent runs must end with exactly the
+ * same frame counts and agent positions as the sequential runs.
+ */
+class ConcurrentEnginesTest
+{
+public:
+	ConcurrentEnginesTest() { }
+	~ConcurrentEnginesTest() { }
+	void runTest();
+
+protected:
+	/// Configuration and outcome of one simulation.
+	struct EngineRun {
+		std::string aiModuleOptions;
+		unsigned int numFramesSimulated;
+		std::vector<Util::Point> finalPositions;
+		std::string errorMessage;
+	};
+
+	/// A controller that does not support any of the engine controls, for engines driven directly by the test.
+	class TestEngineController : public SteerLib::EngineControllerInterface {
+	public:
+		bool isStartupControlSupported() { return false; }
+		bool isPausingControlSupported() { return false; }
+		bool isPaused() { return false; }
+		void loadSimulation() { }
+		void unloadSimulation() { }
+		void startSimulation() { }
+		void stopSimulation() { }
+		void pauseSimulation() { }
+		void unpauseSimulation() { }
+		void togglePausedState() { }
+		void pauseAndStepOneFrame() { }
+	};
+
+	static void _runEngineTask( unsigned int threadIndex, void * data );
+	static void _runEngine( EngineRun & run );
+	void _verifyRunsMatch( const EngineRun & sequentialRun, const EngineRun & concurrentRun );
+
+	static const unsigned int NUM_ENGINES = 2;
+	static const unsigned int NUM_FRAMES = 300;
+};
+
+
 #endif
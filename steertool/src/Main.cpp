@@ -28,6 +28,10 @@ int main(int argc, char** argv)
 		std::string validationFileName = "";
 		std::string infoFileName = "";
 		std::string testCaseSearchPath = "";
+		std::string moduleSearchPath = "";
+		std::string batchFileName = "";
+		unsigned int numBatchThreads = 1;
+		unsigned int numBatchFrames = 0;
 
 		std::string endianFileNames[2];
 		endianFileNames[0] = "";
@@ -45,6 +49,13 @@ int main(int argc, char** argv)
 		opts.addOption("-swapEndian", endianFileNames, OPTION_DATA_TYPE_STRING, 2);
 		opts.addOption("-testcasepath", &testCaseSearchPath, OPTION_DATA_TYPE_STRING);
 		opts.addOption("-testCasePath", &testCaseSearchPath, OPTION_DATA_TYPE_STRING);
+		opts.addOption("-modulepath", &moduleSearchPath, OPTION_DATA_TYPE_STRING);
+		opts.addOption("-modulePath", &moduleSearchPath, OPTION_DATA_TYPE_STRING);
+		opts.addOption("-batch", &batchFileName, OPTION_DATA_TYPE_STRING);
+		opts.addOption("-numthreads", &numBatchThreads, OPTION_DATA_TYPE_UNSIGNED_INT);
+		opts.addOption("-numThreads", &numBatchThreads, OPTION_DATA_TYPE_UNSIGNED_INT);
+		opts.addOption("-numframes", &numBatchFrames, OPTION_DATA_TYPE_UNSIGNED_INT);
+		opts.addOption("-numFrames", &numBatchFrames, OPTION_DATA_TYPE_UNSIGNED_INT);
 
 		opts.parse(argc, argv, true, true);
 		
@@ -66,7 +77,7 @@ int main(int argc, char** argv)
 				std::cout << "   Number of agents: " << recFile.getNumAgents() << "\n";
 				std::cout << "Number of obstacles: " << recFile.getNumObstacles() << "\n";
 			}
-			else if (endsWith(infoFileName, ".xml")) {
+			else if (endsWith(infoFileName, ".xml") || endsWith(infoFileName, ".scen") || endsWith(infoFileName, ".map")) {
 				SteerLib::TestCaseReader testCase;
 				testCase.readTestCaseFromFile(infoFileName);
 				std::cout << "           filename: " << basename(infoFileName,"") << "\n";
@@ -74,7 +85,7 @@ int main(int argc, char** argv)
 				std::cout << "     Test case name: " << testCase.getTestCaseName() << "\n";
 				std::cout << "        Description: " << testCase.getDescription() << "\n";
 				std::cout << "   Number of agents: " << testCase.getNumAgents() << "\n";
-				std::cout << "Number of obstacles: " << testCase.getNumObstacles() << "\n";
+				std::cout << "Number of obstacles: " << testCase.getNumObstacles() << " (" << testCase.getNumObstaclesBeforeMerging() << " before merging boxes)\n";
 				std::cout << "      X-axis bounds: " << testCase.getWorldBounds().xmin << " to " << testCase.getWorldBounds().xmax << "\n";
 				std::cout << "      Y-axis bounds: " << testCase.getWorldBounds().ymin << " to " << testCase.getWorldBounds().ymax << "\n";
 				std::cout << "      Z-axis bounds: " << testCase.getWorldBounds().zmin << " to " << testCase.getWorldBounds().zmax << "\n";
@@ -84,6 +95,22 @@ int main(int argc, char** argv)
 			}
 
 
+		}
+		else if (batchFileName != "") {
+			SteerLib::SimulationOptions simulationOptions;
+			if (testCaseSearchPath != "") simulationOptions.engineOptions.testCaseSearchPath = testCaseSearchPath;
+			if (moduleSearchPath != "") simulationOptions.engineOptions.moduleSearchPath = moduleSearchPath;
+			if (numBatchFrames != 0) simulationOptions.engineOptions.numFramesToSimulate = numBatchFrames;
+
+			SteerLib::BatchSimulationRunner runner(simulationOptions, numBatchThreads);
+			runner.addJobsFromFile(batchFileName);
+			std::cout << "Running " << runner.getNumJobs() << " simulations on " << numBatchThreads << " thread(s).\n";
+
+			unsigned int numFailures = runner.run(std::cout);
+			std::cout << (runner.getNumJobs() - numFailures) << " of " << runner.getNumJobs() << " simulations succeeded.\n";
+			if (numFailures > 0) {
+				exit(1);
+			}
 		}
 		else if (endianFileNames[0] != "") {
 			throw GenericException("Swapping endian-ness is not implemented yet.");
@@ -93,7 +120,8 @@ int main(int argc, char** argv)
 				+ std::string("    -test <testName> - performs a hard-coded unit test\n")
 				+ std::string("    -validate <filename> - validates a recording against the corresponding XML test case\n")
 				+ std::string("    -info <filename> - outputs human-readable information of the recording or XML test case\n")
-				+ std::string("    -swapendian <inputFilename> <outputFilename> - changes the endian-ness of a rec file\n"));
+				+ std::string("    -swapendian <inputFilename> <outputFilename> - changes the endian-ness of a rec file\n")
+				+ std::string("    -batch <jobFilename> [-numthreads <n>] [-numframes <n>] - runs the simulations listed in a job file in parallel, without recording\n"));
 		}
 
 	}
@@ -37,6 +37,10 @@ void runUnitTest(const std::string & unitTestName)
 		StateMachineTest FSMTest;
 		FSMTest.runTest();
 	}
+	else if (caseInsensitiveTestName == "concurrentengines") {
+		ConcurrentEnginesTest concurrentEnginesTest;
+		concurrentEnginesTest.runTest();
+	}
 	else {
 		throw GenericException("Unknown name for unit test, \"" + unitTestName + "\"");
 	}
@@ -699,3 +703,108 @@ unsigned int StateMachineTest::TestFSMCallback::handleUnknownTransition(unsigned
 
 	return currentState;
 }
+
+
+
+void ConcurrentEnginesTest::_runEngineTask( unsigned int threadIndex, void * data )
+{
+	EngineRun * run = (EngineRun *)data;
+	try {
+		_runEngine(*run);
+	}
+	catch (std::exception &e) {
+		run->errorMessage = e.what();
+	}
+	catch (...) {
+		run->errorMessage = "Unknown exception.";
+	}
+}
+
+void ConcurrentEnginesTest::_runEngine( EngineRun & run )
+{
+	SimulationOptions options;
+	options.engineOptions.numThreads = 1;
+	options.engineOptions.numFramesToSimulate = NUM_FRAMES;
+	options.engineOptions.startupModules.insert("testCasePlayer");
+	options.engineOptions.startupModules.insert("sfAI");
+	options.moduleOptionsDatabase["testCasePlayer"]["testcase"] = "circle-20";
+	options.moduleOptionsDatabase["testCasePlayer"]["ai"] = "sfAI";
+	options.mergeModuleOptions("sfAI", run.aiModuleOptions);
+
+	TestEngineController controller;
+	SimulationEngine * engine = new SimulationEngine();
+	engine->init(&options, &controller);
+
+	engine->initializeSimulation();
+	engine->preprocessSimulation();
+	while (engine->update(false)) {
+		// update() returns false when the simulation is done.
+	}
+	engine->postprocessSimulation();
+
+	run.numFramesSimulated = engine->getClock().getCurrentFrameNumber();
+	run.finalPositions.clear();
+	const std::vector<AgentInterface*> & agents = engine->getAgents();
+	for (unsigned int i=0; i < agents.size(); i++) {
+		run.finalPositions.push_back(agents[i]->position());
+	}
+
+	engine->cleanupSimulation();
+	engine->finish();
+	delete engine;
+}
+
+void ConcurrentEnginesTest::_verifyRunsMatch( const EngineRun & sequentialRun, const EngineRun & concurrentRun )
+{
+	if (concurrentRun.errorMessage != "") {
+		throw GenericException("Concurrent engine with options \"" + concurrentRun.aiModuleOptions + "\" failed:\n" + concurrentRun.errorMessage);
+	}
+	if (concurrentRun.numFramesSimulated != sequentialRun.numFramesSimulated) {
+		std::cerr << "FAILED: " << concurrentRun.numFramesSimulated << " frames simulated concurrently, but " << sequentialRun.numFramesSimulated << " frames sequentially.\n";
+		throw GenericException("Unit test for concurrent engines failed.");
+	}
+	if (concurrentRun.finalPositions.size() != sequentialRun.finalPositions.size()) {
+		throw GenericException("Unit test for concurrent engines failed: different number of agents.");
+	}
+	for (unsigned int i=0; i < sequentialRun.finalPositions.size(); i++) {
+		if (concurrentRun.finalPositions[i] != sequentialRun.finalPositions[i]) {
+			std::cerr << "FAILED: agent " << i << " ended at " << concurrentRun.finalPositions[i] << " concurrently, but at " << sequentialRun.finalPositions[i] << " sequentially.\n";
+			throw GenericException("Unit test for concurrent engines failed.");
+		}
+	}
+}
+
+void ConcurrentEnginesTest::runTest()
+{
+	// the two engines use different module options, so any state shared between them changes the results.
+	EngineRun sequentialRuns[NUM_ENGINES];
+	EngineRun concurrentRuns[NUM_ENGINES];
+	sequentialRuns[0].aiModuleOptions = "";
+	sequentialRuns[1].aiModuleOptions = "sf_max_speed=1.0,sf_query_radius=1.5";
+
+	std::cout << "Running " << NUM_ENGINES << " engines sequentially..." << std::endl;
+	for (unsigned int i=0; i < NUM_ENGINES; i++) {
+		_runEngine(sequentialRuns[i]);
+		concurrentRuns[i].aiModuleOptions = sequentialRuns[i].aiModuleOptions;
+	}
+
+	if (sequentialRuns[0].finalPositions == sequentialRuns[1].finalPositions) {
+		throw GenericException("Unit test for concurrent engines is not meaningful: both module configurations gave the same results.");
+	}
+
+	std::cout << "Running " << NUM_ENGINES << " engines concurrently..." << std::endl;
+	ThreadedTaskManager taskManager(NUM_ENGINES);
+	for (unsigned int i=0; i < NUM_ENGINES; i++) {
+		Task newTask;
+		newTask.function = ConcurrentEnginesTest::_runEngineTask;
+		newTask.data = &concurrentRuns[i];
+		taskManager.addTask(newTask, true);
+	}
+	taskManager.waitForAllTasksToComplete();
+
+	for (unsigned int i=0; i < NUM_ENGINES; i++) {
+		_verifyRunsMatch(sequentialRuns[i], concurrentRuns[i]);
+	}
+
+	std::cout << "Concurrent engines produced the same results as sequential engines." << std::endl;
+}